@@ -34,6 +34,8 @@
 #include "losstst_svc.h"
 #include "ble_log.h"
 #include "lcd_ui.h"
+#include "test_mode.h"
+#include "gatt_db.h"
 #include "sl_simple_button_instances.h"
 #include "cmsis_os2.h"
 #include <stdio.h>
@@ -56,85 +58,212 @@ static osEventFlagsId_t button_event_flags = NULL;
 #define BTN1_PRESSED_FLAG  (1U << 1)  // Button 1 pressed event
 
 // BLE Log characteristic handle
-// Log Output characteristic value handle (0x1b = 27) from gatt_db.c
-#define BLE_LOG_CHARACTERISTIC_HANDLE  27  
+#define BLE_LOG_CHARACTERISTIC_HANDLE  gattdb_log_output
 static uint8_t current_connection = 0xFF;
 /* ================== Global Variables ================== */
 
-/* Task state flags */
-bool task_ENVMON = false;
-bool task_SENDER = false;
-bool task_SCANNER = false;
-bool task_NUMCAST = false;
-bool task_delay = false;
-
 /* Test parameters */
 test_param_t round_test_parm;
 
 /* ================== Helper Functions ================== */
 
 /**
- * @brief Check if reschedule is needed
- * 
- * Monitors task trigger changes from external sources (UART commands, etc.)
+ * @brief Abort callback shared by all test modes
  * 
- * @param update If true, update internal state after detecting change
- * @return 1: config changed, 2: task trigger set, -2: task trigger cleared, 0: no change
+ * A mode aborts when the task trigger changes (LCD Stop Task, UART, ...).
  */
-static int is_re_sche(int update)
+static bool tst_mode_abort(void)
 {
-    int result = 0;
-    static int16_t extscr_tgr_stamp = 0;
-    
-    /* Get maximum of all task triggers */
-    int16_t tgr_val = sender_task_tgr(0);
-    if (scanner_task_tgr(0) > tgr_val) tgr_val = scanner_task_tgr(0);
-    if (numcst_task_tgr(0) > tgr_val) tgr_val = numcst_task_tgr(0);
-    if (envmon_task_tgr(0) > tgr_val) tgr_val = envmon_task_tgr(0);
-    
-    if (extscr_tgr_stamp == 0 && tgr_val != 0) {
-        /* Task trigger activated */
-        result = 2;
-        if (update) {
-            extscr_tgr_stamp = tgr_val;
-        }
-    } 
-    else if (extscr_tgr_stamp != 0 && tgr_val == 0) {
-        /* Task trigger cleared */
-        result = -2;
-        if (update) {
-            extscr_tgr_stamp = tgr_val;
-        }
-    } 
-    /* Note: Silicon Labs version doesn't have DIP switch support */
-    /* Nordic's poll_cfg_switch() and load_parm_dipswitch() are not ported */
-    
-    return result;
+    return test_mode_resched(0);
+}
+
+/* ================== Test Mode Hooks ================== */
+
+/**
+ * @brief Stop the BLE4 advertising set before a burst test
+ */
+static void tst_stop_ble4(void)
+{
+    update_adv(3, NULL, NULL, NULL);
 }
 
 /**
- * @brief Abort callbacks for each test mode
+ * @brief Print the loss split of a finished scanner round
  */
-static bool tst_sender_abort(void)
+static void tst_scanner_loss_report(void)
 {
-    return is_re_sche(0);
+    static const char *phy_names[] = {"2M", "1M", "S8", "BLE4"};
+    losstst_rxq_stats_t rxq;
+    losstst_prio_stats_t prio;
+    wallclock_stamp_t stamp;
+    int source;
+    
+    source = losstst_time_get(&stamp);
+    if (source >= 0) {
+        wallclock_date_t date;
+        
+        wallclock_to_date(stamp.sec, &date);
+        DEBUG_PRINT("[SCAN] Round end %04u-%02u-%02u %02u:%02u:%02u.%03u UTC (%s)\n",
+                    date.year, date.month, date.day, date.hour, date.min, date.sec,
+                    stamp.ms, wallclock_source_name((uint8_t)source));
+    }
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        losstst_result_t result;
+        
+        if (losstst_get_result(idx, &result) != 0 || result.exp == 0) {
+            continue;
+        }
+        DEBUG_PRINT("[SCAN] %s: %u/%u, RF loss %u, host loss %u\n", phy_names[idx],
+                    result.rcv, result.exp, result.rf_lost, result.host_lost);
+    }
+    if (losstst_get_rxq_stats(&rxq) == 0) {
+        DEBUG_PRINT("[SCAN] Queue %u: %lu reports, drains %lu (full %lu, max %u), ctrl rx %u crc %u fail %u\n",
+                    rxq.queue_depth, (unsigned long)rxq.reports, (unsigned long)rxq.drains,
+                    (unsigned long)rxq.sat_drains, rxq.max_drain,
+                    rxq.ctrl_rx, rxq.ctrl_crc, rxq.ctrl_fail);
+    }
+    if (losstst_get_prio_stats(&prio) == 0) {
+        uint8_t ctrl = losstst_ctrl_active();
+        
+        DEBUG_PRINT("[SCAN] Priorities %s, early abort %s, adaptivity %s: %u pre-emptions in %u scan windows\n",
+                    losstst_prio_name(prio.profile),
+                    (ctrl & LOSSTST_CTRL_EARLY_ABORT) ? "on" : "off",
+                    (ctrl & LOSSTST_CTRL_ADAPTIVITY) ? "on" : "off",
+                    prio.ctrl_fail, prio.scan_windows);
+    }
 }
 
-static bool tst_scanner_abort(void)
+/**
+ * @brief Scanner step: a soak run evaluates each round and keeps scanning
+ */
+static int tst_scanner_step(void)
 {
-    return is_re_sche(0);
+    int err = losstst_scanner();
+    
+    if (err > 0 || tst_mode_abort()) {
+        return err;
+    }
+    
+    tst_scanner_loss_report();
+    losstst_link_fit_round();
+    losstst_store_round();
+    if (round_test_parm.soak) {
+        losstst_soak_round();
+        return 1;
+    }
+    return err;
 }
 
-static bool tst_numcast_abort(void)
+/**
+ * @brief Scanner teardown: show the result screen of the run
+ */
+static void tst_scanner_teardown(int result)
 {
-    return is_re_sche(0);
+    (void)result;
+    
+    if (round_test_parm.channel_sweep) {
+        lcd_ui_show_channel_per();
+    }
+    else {
+        lcd_ui_show_link_fit();
+    }
 }
 
-static bool tst_envmon_abort(void)
+/**
+ * @brief Resources the application holds outside the test modes
+ *
+ * The log link and the connection advertising (set 5) stay up during
+ * tests; Tput runs beside the log link, so only a throughput connection
+ * counts, and it lives until its close event. The time beacon keeps its
+ * set once allocated.
+ */
+static uint8_t tst_res_in_use(void)
 {
-    return is_re_sche(0);
+    uint8_t res = 0;
+
+    if (losstst_tput_connected()) {
+        res |= TEST_MODE_RES_CONNECTION;
+    }
+    if (0xff != advertising_set_handle || losstst_time_beacon_alloc()) {
+        res |= TEST_MODE_RES_ADV_EXTRA;
+    }
+    return res;
 }
 
+/**
+ * @brief Test mode table, in trigger priority order
+ */
+static const test_mode_t test_modes[] = {
+    {
+        .name = "Sender",
+        .trigger = sender_task_tgr,
+        .setup = sender_setup,
+        .step = losstst_sender,
+        .abort = tst_mode_abort,
+        .settle = tst_stop_ble4,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_ADV_STATUS,
+        .prio = LOSSTST_PRIO_ADV_EXCLUSIVE,
+        .settle_ms = {1000, 3000},
+    },
+    {
+        .name = "Scanner",
+        .trigger = scanner_task_tgr,
+        .setup = scanner_setup,
+        .step = tst_scanner_step,
+        .abort = tst_mode_abort,
+        .settle = tst_stop_ble4,
+        .teardown = tst_scanner_teardown,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_ADV_STATUS | TEST_MODE_RES_SCANNER,
+        .prio = LOSSTST_PRIO_SCAN_EXCLUSIVE,
+        .settle_ms = {1000, 1000},
+    },
+    {
+        .name = "NumCast",
+        .trigger = numcst_task_tgr,
+        .setup = numcast_setup,
+        .step = losstst_numcast,
+        .abort = tst_mode_abort,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_SCANNER,
+        .prio = LOSSTST_PRIO_SHARED,
+    },
+    {
+        .name = "EnvMon",
+        .trigger = envmon_task_tgr,
+        .setup = envmon_setup,
+        .step = losstst_envmon,
+        .abort = tst_mode_abort,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_SCANNER,
+        .prio = LOSSTST_PRIO_SCAN_EXCLUSIVE,
+    },
+    {
+        .name = "Ping",
+        .trigger = ping_task_tgr,
+        .setup = ping_setup,
+        .step = losstst_ping,
+        .abort = tst_mode_abort,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_SCANNER,
+        .prio = LOSSTST_PRIO_SHARED,
+    },
+    {
+        .name = "Tput",
+        .trigger = tput_task_tgr,
+        .setup = tput_setup,
+        .step = losstst_tput,
+        .abort = tst_mode_abort,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_SCANNER | TEST_MODE_RES_CONNECTION,
+        .prio = LOSSTST_PRIO_LOG_FRIENDLY,
+    },
+    {
+        .name = "Generator",
+        .trigger = gen_task_tgr,
+        .setup = gen_setup,
+        .step = losstst_generator,
+        .abort = tst_mode_abort,
+        .resources = TEST_MODE_RES_ADV_SETS | TEST_MODE_RES_ADV_STATUS,
+        .prio = LOSSTST_PRIO_ADV_EXCLUSIVE,
+    },
+};
+
 /**
  * @brief Load test parameters from configuration
  * 
@@ -150,10 +279,13 @@ static void load_parm_cfg(void)
     round_test_parm.interval_idx = enum_adv_interval_idx(0);   // enum_adv_interval_idx(0)
     
     /* Abort callbacks */
-    round_test_parm.envmon_abort = tst_envmon_abort;
-    round_test_parm.sender_abort = tst_sender_abort;
-    round_test_parm.scanner_abort = tst_scanner_abort;
-    round_test_parm.numcast_abort = tst_numcast_abort;
+    round_test_parm.envmon_abort = tst_mode_abort;
+    round_test_parm.sender_abort = tst_mode_abort;
+    round_test_parm.scanner_abort = tst_mode_abort;
+    round_test_parm.numcast_abort = tst_mode_abort;
+    round_test_parm.ping_abort = tst_mode_abort;
+    round_test_parm.tput_abort = tst_mode_abort;
+    round_test_parm.gen_abort = tst_mode_abort;
     
     /* PHY selection - default to all enabled */
     round_test_parm.phy_2m = get_cfg_phy_sel(0);      // get_cfg_phy_sel(0)
@@ -169,6 +301,25 @@ static void load_parm_cfg(void)
     /* Other settings */
     round_test_parm.non_ANONYMOUS = get_cfg_NON_ANONYMOUS(); // get_cfg_NON_ANONYMOUS()
     round_test_parm.ignore_rcv_resp = get_uni_cast_method(); // get_uni_cast_method()
+    
+    /* Burst scheduling - default alternates Coded and uncoded cycles */
+    round_test_parm.concurrent_burst = false;
+    round_test_parm.short_countdown = false;
+    round_test_parm.channel_sweep = false;
+    round_test_parm.soak = false;
+    
+    /* Scheduler priorities - each test mode brings its own profile */
+    round_test_parm.prio_profile = LOSSTST_PRIO_AUTO;
+    round_test_parm.ctrl_switches = losstst_ctrl_default();
+    
+    /* Throughput test - default measures (sink) */
+    round_test_parm.tput_source = false;
+    
+    /* Traffic generator - 20 devices at 100 ms, full legacy-size payload */
+    round_test_parm.gen_devices = 20;
+    round_test_parm.gen_interval_ms = 100;
+    round_test_parm.gen_payload = 26;
+    round_test_parm.gen_duty = 100;
 }
 
 void app_init(void)
@@ -194,12 +345,28 @@ void app_init(void)
         /* Continue anyway - some features may still work */
     }
     
+    /* Mount the result store on the serial flash */
+    err = losstst_store_init();
+    if (err) {
+        /* Rounds are still reported, just not stored */
+    }
+    
+    /* Bring back the wall clock of the last run (a lower bound) */
+    err = losstst_time_init();
+    if (err) {
+        /* Results are stamped once a phone or a time beacon sets the clock */
+    }
+    
     /* Initialize external peripherals if needed */
     // extscr_init();  // External screen/UART interface
     
     /* Load default parameters */
     load_parm_cfg();
     
+    /* Register test modes */
+    err = test_mode_register(test_modes, sizeof(test_modes) / sizeof(test_modes[0]), tst_res_in_use);
+    app_assert(err == 0, "Invalid test mode table");
+    
     /* Show startup screen with loaded configuration */
     lcd_ui_show_startup(&round_test_parm);
 }
@@ -229,183 +396,12 @@ void app_process_action(void)
         }
     }
     
-    static uint32_t uptime_barrier_ms = 0;
-    bool re_sche = false;
+    /* Time beacon and clock checkpoint */
+    losstst_time_poll();
     
-    /* One-time initialization delay */
-    // if (!initialized) {
-    //     uptime_barrier_ms = sl_sleeptimer_get_tick_count() + 2000;
-        
-    //     /* Wait for initial startup delay */
-    //     if (sl_sleeptimer_get_tick_count() < uptime_barrier_ms) {
-    //         return;
-    //     }
-    //     initialized = true;
-    // }
+    /* ========== Test Mode Scheduling ========== */
+    test_mode_run(&round_test_parm);
     
-    /* ========== Task Selection Phase ========== */
-    if (!task_ENVMON && !task_SCANNER && !task_SENDER && !task_NUMCAST) {
-        /* No task active - check for task triggers */
-        
-        /* Note: DIP switch logic (poll_cfg_switch, load_parm_dipswitch) not ported */
-        /* Silicon Labs version uses UART/external commands only */
-        
-        if (sender_task_tgr(0)) {
-            task_ENVMON = false;
-            task_SENDER = true;
-            task_SCANNER = false;
-            task_NUMCAST = false;
-            // 不调用 load_parm_cfg()，保留用户在 LCD 上的设置
-            task_delay = false;
-        }
-        else if (scanner_task_tgr(0)) {
-            task_ENVMON = false;
-            task_SENDER = false;
-            task_SCANNER = true;
-            task_NUMCAST = false;
-            // 不调用 load_parm_cfg()，保留用户在 LCD 上的设置
-            task_delay = false;
-        }
-        else if (numcst_task_tgr(0)) {
-            task_ENVMON = false;
-            task_SENDER = false;
-            task_SCANNER = false;
-            task_NUMCAST = true;
-            // 不调用 load_parm_cfg()，保留用户在 LCD 上的设置
-            task_delay = false;
-        }
-        else if (envmon_task_tgr(0)) {
-            task_ENVMON = true;
-            task_SENDER = false;
-            task_SCANNER = false;
-            task_NUMCAST = false;
-            // 不调用 load_parm_cfg()，保留用户在 LCD 上的设置
-            task_delay = false;
-        }
-        else {
-            task_ENVMON = false;
-            task_SENDER = false;
-            task_SCANNER = false;
-            task_NUMCAST = false;
-        }
-        
-        /* ========== Task Setup Phase ========== */
-        if (task_SCANNER || task_SENDER || task_NUMCAST || task_ENVMON) {
-            // Range test 使用 advertising sets 0-4
-            // Connection advertising (set 5) 继续运行，允许 BLE log 访问
-            // Silicon Labs BLE stack 支持多个 advertising sets 同时运行
-        }
-        if (task_SCANNER) {
-            blocking_adv(0);
-            blocking_adv(1);
-            blocking_adv(2);
-            blocking_adv(3);
-            scanner_setup(&round_test_parm);
-        }
-        else if (task_SENDER) {
-            blocking_adv(0);
-            blocking_adv(1);
-            blocking_adv(2);
-            blocking_adv(3);
-            sender_setup(&round_test_parm);
-        }
-        else if (task_NUMCAST) {
-            blocking_adv(0);
-            blocking_adv(1);
-            blocking_adv(2);
-            blocking_adv(3);
-            numcast_setup(&round_test_parm);
-            is_re_sche(true);
-            return;
-        }
-        else if (task_ENVMON) {
-            blocking_adv(0);
-            blocking_adv(1);
-            blocking_adv(2);
-            blocking_adv(3);
-            envmon_setup(&round_test_parm);
-            is_re_sche(true);
-            return;
-        }
-        
-        /* Wait period after setup */
-        is_re_sche(true);
-        uptime_barrier_ms = sl_sleeptimer_get_tick_count() + 1000;
-        
-        do {
-            sl_sleeptimer_delay_millisecond(10);
-            re_sche = is_re_sche(false);
-            if (re_sche) break;
-        } while (sl_sleeptimer_get_tick_count() < uptime_barrier_ms);
-        
-        if (re_sche) {
-            task_SCANNER = false;
-            task_SENDER = false;
-            task_NUMCAST = false;
-            return;
-        }
-        
-        /* Skip to execution if no task selected */
-        if (!task_SCANNER && !task_SENDER) {
-            return;
-        }
-        
-        /* Stop BLE4 advertising before test */
-        update_adv(3, NULL, NULL, NULL);
-        
-        /* Additional delay before starting test */
-        if (task_delay) {
-            uptime_barrier_ms = sl_sleeptimer_get_tick_count() + 
-                               (task_SCANNER ? 1000 : 20000);
-        }
-        else {
-            uptime_barrier_ms = sl_sleeptimer_get_tick_count() + 
-                               (task_SCANNER ? 1000 : 3000);
-        }
-        
-        do {
-            sl_sleeptimer_delay_millisecond(10);
-            re_sche = is_re_sche(false);
-            if (re_sche) break;
-        } while (sl_sleeptimer_get_tick_count() < uptime_barrier_ms);
-        
-        if (re_sche) {
-            task_SCANNER = false;
-            task_SENDER = false;
-            task_NUMCAST = false;
-            return;
-        }
-    }
-    
-    /* ========== Task Execution Phase ========== */
-    if (task_ENVMON) {
-        int err = losstst_envmon();
-        if (err <= 0) {
-            task_ENVMON = false;
-            envmon_task_tgr(-envmon_task_tgr(0));
-        }
-    }
-    else if (task_SENDER) {
-        int err = losstst_sender();
-        if (err <= 0) {
-            task_SENDER = false;
-            sender_task_tgr(-sender_task_tgr(0));
-        }
-    }
-    else if (task_SCANNER) {
-        int err = losstst_scanner();
-        if (err <= 0) {
-            task_SCANNER = false;
-            scanner_task_tgr(-scanner_task_tgr(0));
-        }
-    }
-    else if (task_NUMCAST) {
-        int err = losstst_numcast();
-        if (err <= 0) {
-            task_NUMCAST = false;
-            numcst_task_tgr(-numcst_task_tgr(0));
-        }
-    }
     // 若所有 range test 任务都结束
     // Connection advertising (set 5) 继续运行，无需额外操作
   }
@@ -421,6 +417,12 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
 {
   sl_status_t sc;
 
+    // The throughput test owns its connection; keep it off the log link
+    if (losstst_tput_event(evt)) {
+        app_proceed();
+        return;
+    }
+
     switch (SL_BT_MSG_ID(evt->header)) {
     // -------------------------------
     // This event indicates the device has started and the radio is ready.
@@ -487,6 +489,14 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
         ///////////////////////////////////////////////////////////////////////////
         // Add additional event handlers here as your application requires!      //
         ///////////////////////////////////////////////////////////////////////////
+    case sl_bt_evt_gatt_server_attribute_value_id:
+        // Phone sets the wall clock (Current Time characteristic)
+        if (gattdb_current_time == evt->data.evt_gatt_server_attribute_value.attribute) {
+            int err = losstst_time_set(evt->data.evt_gatt_server_attribute_value.value.data,
+                                       evt->data.evt_gatt_server_attribute_value.value.len);
+            DEBUG_PRINT("[TIME] Set by phone: %d\n", err);
+        }
+        break;
     case sl_bt_evt_advertiser_timeout_id:
         // 手动调用我们的处理函数
         losstst_adv_sent_handler(evt->data.evt_advertiser_timeout.handle);
@@ -497,6 +507,7 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
         
         sl_bt_scanner_process_legacy_report(
             &scan_evt->address,
+            scan_evt->address_type,
             scan_evt->rssi,
             scan_evt->data.data,
             scan_evt->data.len
@@ -509,6 +520,7 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
         
         sl_bt_scanner_process_extended_report(
             &scan_evt->address,
+            scan_evt->address_type,
             scan_evt->rssi,
             scan_evt->tx_power,
             scan_evt->primary_phy,
@@ -23,12 +23,22 @@ GATT_DATA(const uint16_t gattdb_uuidtable_16_map[]) =
   0x2b2a,
   0x2b29,
   0x2902,
+  0x2a2b,
 };
 
 GATT_DATA(const uint8_t gattdb_uuidtable_128_map[]) =
 {
   0x34, 0x8e, 0x04, 0x8d, 0x91, 0x1b, 0x80, 0xb1, 0xda, 0x4a, 0xd4, 0x17, 0x08, 0x5e, 0x9b, 0xc7, 
 };
+GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_30) = {
+  .properties = 0x08,
+  .max_len = 10,
+  .data = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, },
+};
+GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_28) = {
+  .len = 2,
+  .data = { 0x05, 0x18, }
+};
 GATT_DATA(sli_bt_gattdb_attribute_chrvalue_t gattdb_attribute_field_26) = {
   .properties = 0x12,
   .max_len = 244,
@@ -132,15 +142,18 @@ GATT_DATA(const sli_bt_gattdb_attribute_t gattdb_attributes_map[]) = {
   { .handle = 0x1a, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x12, .char_uuid = 0x8000 } },
   { .handle = 0x1b, .uuid = 0x8000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x02, .dynamicdata = &gattdb_attribute_field_26 },
   { .handle = 0x1c, .uuid = 0x000d, .permissions = 0x803, .caps = 0xffff, .state = 0x00, .datatype = 0x03, .configdata = { .flags = 0x01, .clientconfig_index = 0x01 } },
+  { .handle = 0x1d, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_28 },
+  { .handle = 0x1e, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x000e } },
+  { .handle = 0x1f, .uuid = 0x000e, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x01, .dynamicdata = &gattdb_attribute_field_30 },
 };
 
 GATT_HEADER(const sli_bt_gattdb_t gattdb) = {
   .attributes = gattdb_attributes_map,
-  .attribute_table_size = 28,
-  .attribute_num = 28,
+  .attribute_table_size = 31,
+  .attribute_num = 31,
   .uuid16 = gattdb_uuidtable_16_map,
-  .uuid16_table_size = 14,
-  .uuid16_num = 14,
+  .uuid16_table_size = 15,
+  .uuid16_num = 15,
   .uuid128 = gattdb_uuidtable_128_map,
   .uuid128_table_size = 1,
   .uuid128_num = 1,
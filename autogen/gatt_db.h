@@ -20,6 +20,8 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_hardware_revision_string       20
 #define gattdb_firmware_revision_string       22
 #define gattdb_system_id                      24
+#define gattdb_log_output                     27
+#define gattdb_current_time                   31
 
 #define gattdb_generic_attribute_len          2
 #define gattdb_service_changed_char_len       4
@@ -32,6 +34,8 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_hardware_revision_string_len   5
 #define gattdb_firmware_revision_string_len   8
 #define gattdb_system_id_len                  8
+#define gattdb_log_output_len                 244
+#define gattdb_current_time_len               10
 
 
 #endif // __GATT_DB_H
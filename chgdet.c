@@ -0,0 +1,143 @@
+/**
+ * @file chgdet.c
+ * @brief Change Point Detection for Soak Runs
+ *
+ * Implementation of chgdet.h. The baseline of the CUSUM is learned with
+ * Welford's update, so no samples are stored.
+ */
+
+#include "chgdet.h"
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Restart a CUSUM detector with x as first baseline sample
+ */
+static void chgdet_cusum_restart(chgdet_cusum_t *st, float x)
+{
+    st->n = 1;
+    st->mean = x;
+    st->m2 = 0.0f;
+    st->sd = 0.0f;
+    st->s_hi = 0.0f;
+    st->s_lo = 0.0f;
+}
+
+void chgdet_cusum_init(chgdet_cusum_t *st, float k, float h, float sd_floor, uint16_t warmup)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->k = k;
+    st->h = h;
+    st->sd_floor = sd_floor;
+    st->warmup = (warmup < 2) ? 2 : warmup;
+}
+
+int chgdet_cusum_update(chgdet_cusum_t *st, float x)
+{
+    float z;
+
+    if (st == NULL) {
+        return CHGDET_NONE;
+    }
+
+    if (0 == st->n) {
+        chgdet_cusum_restart(st, x);
+        return CHGDET_NONE;
+    }
+
+    /* Learn the baseline */
+    if (st->n < st->warmup) {
+        float d = x - st->mean;
+
+        st->n++;
+        st->mean += d / st->n;
+        st->m2 += d * (x - st->mean);
+        if (st->n == st->warmup) {
+            st->sd = sqrtf(st->m2 / (st->n - 1));
+            if (st->sd < st->sd_floor) {
+                st->sd = st->sd_floor;
+            }
+        }
+        return CHGDET_NONE;
+    }
+
+    if (st->n < UINT16_MAX) {
+        st->n++;
+    }
+
+    z = (st->sd > 0.0f) ? (x - st->mean) / st->sd : 0.0f;
+    st->s_hi = fmaxf(0.0f, st->s_hi + z - st->k);
+    st->s_lo = fmaxf(0.0f, st->s_lo - z - st->k);
+
+    if (st->s_hi > st->h) {
+        chgdet_cusum_restart(st, x);
+        return CHGDET_UP;
+    }
+    if (st->s_lo > st->h) {
+        chgdet_cusum_restart(st, x);
+        return CHGDET_DOWN;
+    }
+    return CHGDET_NONE;
+}
+
+/**
+ * @brief Restart a Page-Hinkley detector with x as first sample
+ */
+static void chgdet_ph_restart(chgdet_ph_t *st, float x)
+{
+    st->n = 1;
+    st->mean = x;
+    st->m_up = 0.0f;
+    st->m_up_min = 0.0f;
+    st->m_dn = 0.0f;
+    st->m_dn_max = 0.0f;
+}
+
+void chgdet_ph_init(chgdet_ph_t *st, float delta, float lambda, uint16_t min_n)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->delta = delta;
+    st->lambda = lambda;
+    st->min_n = min_n;
+}
+
+int chgdet_ph_update(chgdet_ph_t *st, float x)
+{
+    if (st == NULL) {
+        return CHGDET_NONE;
+    }
+
+    if (0 == st->n) {
+        chgdet_ph_restart(st, x);
+        return CHGDET_NONE;
+    }
+
+    st->n++;
+    st->mean += (x - st->mean) / st->n;
+
+    st->m_up += x - st->mean - st->delta;
+    st->m_up_min = fminf(st->m_up_min, st->m_up);
+    st->m_dn += x - st->mean + st->delta;
+    st->m_dn_max = fmaxf(st->m_dn_max, st->m_dn);
+
+    if (st->n < st->min_n) {
+        return CHGDET_NONE;
+    }
+    if (st->m_up - st->m_up_min > st->lambda) {
+        chgdet_ph_restart(st, x);
+        return CHGDET_UP;
+    }
+    if (st->m_dn_max - st->m_dn > st->lambda) {
+        chgdet_ph_restart(st, x);
+        return CHGDET_DOWN;
+    }
+    return CHGDET_NONE;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file chgdet.h
+ * @brief Change Point Detection for Soak Runs
+ *
+ * Sequential detectors that flag a shift of the mean of a per-round
+ * metric (packet error rate, mean RSSI) with constant memory.
+ *
+ * Features:
+ * - Two-sided CUSUM on values standardised by a learned baseline
+ * - Two-sided Page-Hinkley test on raw values
+ * - Baseline is re-learned after every alarm, so a detector follows
+ *   the link to its new operating point
+ *
+ * @note No Bluetooth stack dependency, so detection delay and false alarm
+ *       rate can be checked on a host build with synthetic step changes
+ */
+
+#ifndef CHGDET_H
+#define CHGDET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alarm direction returned by the update functions */
+#define CHGDET_NONE     0
+#define CHGDET_UP       1       /* Mean increased */
+#define CHGDET_DOWN     (-1)    /* Mean decreased */
+
+/**
+ * @brief Two-sided CUSUM state
+ *
+ * The first warmup samples estimate mean and standard deviation of the
+ * baseline. After that each sample is standardised and accumulated;
+ * an alarm fires when either sum exceeds h.
+ */
+typedef struct {
+    float k;                   /**< Slack (baseline standard deviations) */
+    float h;                   /**< Decision threshold (baseline standard deviations) */
+    float sd_floor;            /**< Lower bound of the standard deviation (metric units) */
+    uint16_t warmup;           /**< Samples used to learn the baseline (>=2) */
+    uint16_t n;                /**< Samples seen since the last (re)start */
+    float mean;                /**< Baseline mean */
+    float m2;                  /**< Sum of squared deviations while learning */
+    float sd;                  /**< Baseline standard deviation */
+    float s_hi;                /**< Upper cumulative sum */
+    float s_lo;                /**< Lower cumulative sum */
+} chgdet_cusum_t;
+
+/**
+ * @brief Two-sided Page-Hinkley state
+ *
+ * Cumulates the deviation from the running mean minus a tolerance delta
+ * and alarms when it departs from its extreme by more than lambda.
+ */
+typedef struct {
+    float delta;               /**< Tolerated change of the mean (metric units) */
+    float lambda;              /**< Decision threshold (metric units) */
+    uint16_t min_n;            /**< Samples before an alarm may fire */
+    uint32_t n;                /**< Samples seen since the last (re)start */
+    float mean;                /**< Running mean */
+    float m_up;                /**< Cumulative sum for an increase */
+    float m_up_min;            /**< Minimum of m_up */
+    float m_dn;                /**< Cumulative sum for a decrease */
+    float m_dn_max;            /**< Maximum of m_dn */
+} chgdet_ph_t;
+
+/**
+ * @brief Initialise a CUSUM detector
+ *
+ * @param st Detector state
+ * @param k Slack in baseline standard deviations (typ. 0.5)
+ * @param h Threshold in baseline standard deviations (typ. 4-5)
+ * @param sd_floor Smallest standard deviation assumed, keeps a flat
+ *                 baseline (e.g. PER 0 every round) from alarming on noise
+ * @param warmup Samples to learn the baseline (values below 2 are raised to 2)
+ */
+void chgdet_cusum_init(chgdet_cusum_t *st, float k, float h, float sd_floor, uint16_t warmup);
+
+/**
+ * @brief Feed one sample to a CUSUM detector
+ *
+ * @param st Detector state
+ * @param x Sample
+ * @return CHGDET_UP, CHGDET_DOWN or CHGDET_NONE; after an alarm the
+ *         detector restarts learning with x as first sample
+ */
+int chgdet_cusum_update(chgdet_cusum_t *st, float x);
+
+/**
+ * @brief Initialise a Page-Hinkley detector
+ *
+ * @param st Detector state
+ * @param delta Tolerated change of the mean (metric units)
+ * @param lambda Threshold (metric units)
+ * @param min_n Samples before an alarm may fire
+ */
+void chgdet_ph_init(chgdet_ph_t *st, float delta, float lambda, uint16_t min_n);
+
+/**
+ * @brief Feed one sample to a Page-Hinkley detector
+ *
+ * @param st Detector state
+ * @param x Sample
+ * @return CHGDET_UP, CHGDET_DOWN or CHGDET_NONE; after an alarm the
+ *         detector restarts with x as first sample
+ */
+int chgdet_ph_update(chgdet_ph_t *st, float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHGDET_H
@@ -2,4 +2,16 @@ target_sources(bt_soc_empty_micriumos PRIVATE
 	"../ble_log.c"
 	"../lcd_ui.c"
 	"../losstst_svc.c"
+	"../tput_stats.c"
+	"../gen_plan.c"
+	"../chgdet.c"
+	"../linkfit.c"
+	"../test_mode.c"
+	"../rptq.c"
+	"../rstore.c"
+	"../mx25.c"
+	"../wallclock.c"
+	"../topk.c"
+	"../rjournal.c"
+	"../scan_phase.c"
 )
@@ -0,0 +1,61 @@
+/**
+ * @file bench.h
+ * @brief Host Microbenchmark Harness
+ *
+ * Minimal C counterpart of Google Benchmark for the host build. A
+ * benchmark is a function that runs the measured operation a given
+ * number of times; the harness grows the count until one run takes at
+ * least the minimum time, repeats the run and reports the fastest one.
+ *
+ * Output is the Google Benchmark JSON format (context and benchmarks
+ * with name, iterations, real_time, cpu_time and time_unit), so the
+ * usual tools and tools/bench_compare.py read it.
+ *
+ * Options (Google Benchmark names):
+ * - --benchmark_filter=<substring>     Run matching benchmarks only
+ * - --benchmark_out=<file>             Write the JSON there
+ * - --benchmark_format=json|console    stdout format (default console)
+ * - --benchmark_repetitions=<n>        Runs per benchmark (default 5)
+ * - --benchmark_min_time=<seconds>     Minimum run time (default 0.02)
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Name of the calibration benchmark the comparison is normalised to */
+#define BENCH_CALIBRATION   "calibration/lcg"
+
+/**
+ * @brief Benchmark definition
+ */
+typedef struct {
+    const char *name;                   /**< "group/case" */
+    void (*setup)(void);                /**< Called once before timing (optional) */
+    void (*run)(uint32_t iters);        /**< Runs the operation iters times */
+} bench_t;
+
+/**
+ * @brief Keep a result alive
+ *
+ * Results that are otherwise unused are folded in here so the compiler
+ * cannot drop the measured code.
+ */
+extern volatile uint32_t bench_sink;
+
+/* Suites, one table per source file, terminated by a NULL name */
+extern const bench_t bench_modules[];
+extern const bench_t bench_glib[];
+extern const bench_t bench_nvm3[];
+extern const bench_t bench_losstst[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
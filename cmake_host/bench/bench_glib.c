@@ -0,0 +1,121 @@
+/**
+ * @file bench_glib.c
+ * @brief Microbenchmarks of the GLIB drawing used by lcd_ui.c
+ *
+ * Runs on the real DMD memory LCD frame buffer (dmd_memlcd.c) of the
+ * 128 x 128 board display, with the SPI transfer stubbed out.
+ */
+
+#include "bench.h"
+
+#include "glib.h"
+
+static GLIB_Context_t ctx;
+static uint8_t *frame;
+
+static void glib_setup(void)
+{
+    static bool init;
+
+    if (!init) {
+        DMD_init(0);
+        init = true;
+    }
+    GLIB_contextInit(&ctx);
+    ctx.backgroundColor = White;
+    ctx.foregroundColor = Black;
+    GLIB_setFont(&ctx, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+    GLIB_clear(&ctx);
+    DMD_getFrameBuffer((void **)&frame);
+}
+
+/* A history plot: short segments across the screen */
+static void glib_sparkline_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        for (int32_t x = 0; x + 4 < 128; x += 4) {
+            GLIB_drawLine(&ctx, x, 64 + (x * 7 % 50) - 25, x + 4, 64 + ((x + 4) * 7 % 50) - 25);
+        }
+    }
+    bench_sink += frame[64 * 16];
+}
+
+/* Long lines in all octants through the centre */
+static void glib_line_long_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        int32_t k = (int32_t)(i & 31) * 4;
+        GLIB_drawLine(&ctx, k, 0, 127 - k, 127);
+        GLIB_drawLine(&ctx, 0, 127 - k, 127, k);
+    }
+    bench_sink += frame[64 * 16];
+}
+
+/* Long line crossing a clipping region away from the origin */
+static void glib_line_clipped_run(uint32_t iters)
+{
+    GLIB_Rectangle_t region = { 20, 30, 99, 109 };
+
+    GLIB_setClippingRegion(&ctx, &region);
+    GLIB_applyClippingRegion(&ctx);
+    for (uint32_t i = 0; i < iters; i++) {
+        int32_t k = (int32_t)(i & 31) * 4;
+        GLIB_drawLine(&ctx, -20, k, 150, 127 - k);
+    }
+    GLIB_resetClippingRegion(&ctx);
+    GLIB_applyClippingRegion(&ctx);
+    bench_sink += frame[64 * 16];
+}
+
+static const int32_t star[] = {
+    64, 4, 78, 48, 124, 48, 86, 76, 100, 122, 64, 94, 28, 122, 42, 76, 4, 48, 50, 48
+};
+
+static void glib_polygon_filled_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        ctx.foregroundColor = (i & 1) ? White : Black;
+        GLIB_drawPolygonFilled(&ctx, 10, star);
+    }
+    ctx.foregroundColor = Black;
+    bench_sink += frame[64 * 16];
+}
+
+static void glib_polygon_outline_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        GLIB_drawPolygon(&ctx, 10, star);
+    }
+    bench_sink += frame[64 * 16];
+}
+
+/* One status line of the narrow font, as the result screens */
+static void glib_string_run(uint32_t iters)
+{
+    static const char line[] = "Loss 12.5% RSSI -71";
+
+    for (uint32_t i = 0; i < iters; i++) {
+        GLIB_drawString(&ctx, line, sizeof(line) - 1, 0, (int32_t)(i & 7) * 16, false);
+    }
+    bench_sink += frame[0];
+}
+
+static void glib_clear_update_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        GLIB_clear(&ctx);
+        DMD_updateDisplay();
+    }
+    bench_sink += frame[0];
+}
+
+const bench_t bench_glib[] = {
+    { "glib/line_sparkline",    glib_setup, glib_sparkline_run },
+    { "glib/line_long",         glib_setup, glib_line_long_run },
+    { "glib/line_clipped",      glib_setup, glib_line_clipped_run },
+    { "glib/polygon_filled",    glib_setup, glib_polygon_filled_run },
+    { "glib/polygon_outline",   glib_setup, glib_polygon_outline_run },
+    { "glib/string_narrow",     glib_setup, glib_string_run },
+    { "glib/clear_update",      glib_setup, glib_clear_update_run },
+    { NULL, NULL, NULL },
+};
@@ -0,0 +1,123 @@
+/**
+ * @file bench_losstst.c
+ * @brief Microbenchmarks of the loss test service
+ *
+ * The service on the stand-in stack of the host tests. Reports go in
+ * through sl_bt_scanner_process_extended_report(), as the scan handler
+ * passes them: a burst packet is parsed and folded into the RSSI
+ * statistics of its flow, a packet of some other advertiser runs through
+ * every parser of the active modes before it is dropped. The envmon pass
+ * recomputes the RSSI statistics of all PHYs from the full record.
+ */
+
+#include "bench.h"
+
+#include "losstst_svc.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define BENCH_BURST_LEN     250     /* Packets per flow, the pre_cnt countdown */
+#define BENCH_FLOWS         200     /* Valid flows are 1..201 */
+
+static const test_param_t param = {
+    .interval_idx = 0,
+    .count_idx = 0,
+    .phy_2m = true,
+    .phy_1m = true,
+    .prio_profile = LOSSTST_PRIO_AUTO,
+};
+
+static const bd_addr sender = { { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 } };
+
+/* Stop whatever mode the previous benchmark left running */
+static void losstst_idle(void)
+{
+    static bool init_done;
+
+    if (!init_done) {
+        losstst_init();
+        init_done = true;
+    }
+    scanner_task_tgr(-scanner_task_tgr(0));
+    envmon_task_tgr(-envmon_task_tgr(0));
+}
+
+static void scanner_bench_setup(void)
+{
+    losstst_idle();
+    scanner_task_tgr(1);
+    scanner_setup(&param);
+    /* The first step opens the round */
+    losstst_scanner();
+}
+
+static void envmon_bench_setup(void)
+{
+    losstst_idle();
+    envmon_task_tgr(1);
+    envmon_setup(&param);
+}
+
+/* Parsers: one report */
+
+static uint32_t burst_pkt;
+
+static void report_burst_run(uint32_t iters)
+{
+    uint8_t ad[3 + 2 + 16] = { 2, 0x01, 0x06, 17, 0xFF, 0xFF, 0xFF, 0xAB, 0xBA };
+
+    memcpy(&ad[13], "\xF8\xF9\xFA\xF5\xFC\xFD\xFE\x01", 8);
+    for (uint32_t i = 0; i < iters; i++, burst_pkt++) {
+        /* A new flow after every burst, as the sender does */
+        uint16_t pre_cnt = (uint16_t)(BENCH_BURST_LEN - burst_pkt % BENCH_BURST_LEN);
+
+        ad[9] = (uint8_t)pre_cnt;
+        ad[10] = (uint8_t)(pre_cnt >> 8);
+        ad[11] = (uint8_t)(1 + (burst_pkt / BENCH_BURST_LEN) % BENCH_FLOWS);
+        sl_bt_scanner_process_extended_report(&sender, 0, (int8_t)(-40 - (int)(i & 15)), 0,
+                                              sl_bt_gap_phy_1m, sl_bt_gap_phy_2m, ad, sizeof(ad));
+    }
+    bench_sink += burst_pkt;
+}
+
+/* Someone else's advertising, as a scan in a crowded place sees it */
+static void report_foreign_run(uint32_t iters)
+{
+    static const uint8_t ad[] = {
+        2, 0x01, 0x06, 3, 0x03, 0x0F, 0x18, 9, 0xFF, 0x4C, 0x00, 0x10, 0x05, 0x01, 0x18, 0x2A, 0x3B
+    };
+    bd_addr addr = { { 0x00, 0xA0, 0xB0, 0xC0, 0xD0, 0xE0 } };
+
+    for (uint32_t i = 0; i < iters; i++) {
+        addr.addr[0] = (uint8_t)i;
+        sl_bt_scanner_process_extended_report(&addr, 0, (int8_t)(-60 - (int)(i & 15)), 0,
+                                              sl_bt_gap_phy_1m, sl_bt_gap_phy_2m, ad, sizeof(ad));
+    }
+    bench_sink += addr.addr[0];
+}
+
+/* RSSI statistics: one envmon pass over a full record */
+
+static void envmon_rssi_setup(void)
+{
+    envmon_bench_setup();
+    report_foreign_run(4096);
+    /* The first pass also logs the top list */
+    losstst_envmon();
+}
+
+static void envmon_rssi_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        bench_sink += (uint32_t)losstst_envmon();
+    }
+}
+
+const bench_t bench_losstst[] = {
+    { "losstst/report_burst",   scanner_bench_setup, report_burst_run },
+    { "losstst/report_foreign", scanner_bench_setup, report_foreign_run },
+    { "losstst/report_envmon",  envmon_bench_setup,  report_foreign_run },
+    { "losstst/envmon_rssi",    envmon_rssi_setup,   envmon_rssi_run },
+    { NULL, NULL, NULL },
+};
@@ -0,0 +1,238 @@
+/**
+ * @file bench_main.c
+ * @brief Host Microbenchmark Harness
+ *
+ * Implementation of bench.h: option parsing, timing and JSON output.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_ITERS     (1u << 30)
+
+volatile uint32_t bench_sink;
+
+typedef struct {
+    const char *name;
+    uint32_t iters;
+    double real_ns;             /**< Per iteration, fastest repetition */
+    double cpu_ns;
+} bench_result_t;
+
+static const bench_t *const suites[] = {
+    bench_modules,
+    bench_glib,
+    bench_nvm3,
+    bench_losstst,
+};
+
+static uint32_t calib_state = 1;
+
+/**
+ * @brief Calibration: a fixed chain of dependent multiply-adds
+ *
+ * Its time follows the speed of the machine and compiler, not the code
+ * under test, so dividing by it makes results of different hosts
+ * comparable.
+ */
+static void calibration_run(uint32_t iters)
+{
+    uint32_t x = calib_state;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        for (int k = 0; k < 64; k++) {
+            x = x * 1664525u + 1013904223u;
+        }
+    }
+    calib_state = x;
+    bench_sink += x;
+}
+
+static const bench_t calibration = { BENCH_CALIBRATION, NULL, calibration_run };
+
+static double clock_ns(clockid_t id)
+{
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Time one benchmark
+ *
+ * The iteration count is grown until a run takes min_time, then reps runs
+ * with that count are timed and the fastest is kept: timing noise only
+ * ever adds time.
+ */
+static void bench_measure(const bench_t *b, double min_time_ns, int reps, bench_result_t *res)
+{
+    uint32_t iters = 1;
+    double real = 0.0;
+    double cpu = 0.0;
+
+    if (b->setup) {
+        b->setup();
+    }
+    for (;;) {
+        double t0 = clock_ns(CLOCK_MONOTONIC);
+        b->run(iters);
+        real = clock_ns(CLOCK_MONOTONIC) - t0;
+        if (real >= min_time_ns || iters >= BENCH_MAX_ITERS) {
+            break;
+        }
+        /* Aim 20 % above the minimum, at most 10x per step */
+        double scale = (real > 0.0) ? (min_time_ns * 1.2 / real) : 10.0;
+        if (scale > 10.0) {
+            scale = 10.0;
+        }
+        if (scale < 2.0) {
+            scale = 2.0;
+        }
+        iters = ((double)iters * scale > BENCH_MAX_ITERS) ? BENCH_MAX_ITERS
+                                                          : (uint32_t)((double)iters * scale);
+    }
+
+    res->name = b->name;
+    res->iters = iters;
+    res->real_ns = 0.0;
+    res->cpu_ns = 0.0;
+    for (int r = 0; r < reps; r++) {
+        double t0 = clock_ns(CLOCK_MONOTONIC);
+        double c0 = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+        b->run(iters);
+        real = (clock_ns(CLOCK_MONOTONIC) - t0) / iters;
+        cpu = (clock_ns(CLOCK_PROCESS_CPUTIME_ID) - c0) / iters;
+        if (0 == r || real < res->real_ns) {
+            res->real_ns = real;
+            res->cpu_ns = cpu;
+        }
+    }
+}
+
+static void bench_write_json(FILE *f, const bench_result_t *res, int n, int reps)
+{
+    char host[64] = "";
+    char date[32] = "";
+    time_t now = time(NULL);
+
+    gethostname(host, sizeof(host) - 1);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n", date);
+    fprintf(f, "    \"host_name\": \"%s\",\n", host);
+    fprintf(f, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(f, "    \"repetitions\": %d,\n", reps);
+    fprintf(f, "    \"calibration\": \"%s\",\n", BENCH_CALIBRATION);
+#ifdef BENCH_BUILD_TYPE
+    fprintf(f, "    \"library_build_type\": \"%s\"\n", BENCH_BUILD_TYPE);
+#else
+    fprintf(f, "    \"library_build_type\": \"unknown\"\n");
+#endif
+    fprintf(f, "  },\n  \"benchmarks\": [\n");
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"name\": \"%s\",\n", res[i].name);
+        fprintf(f, "      \"run_type\": \"iteration\",\n");
+        fprintf(f, "      \"iterations\": %lu,\n", (unsigned long)res[i].iters);
+        fprintf(f, "      \"real_time\": %.4f,\n", res[i].real_ns);
+        fprintf(f, "      \"cpu_time\": %.4f,\n", res[i].cpu_ns);
+        fprintf(f, "      \"time_unit\": \"ns\"\n");
+        fprintf(f, "    }%s\n", (i + 1 < n) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static const char *opt_value(const char *arg, const char *opt)
+{
+    size_t len = strlen(opt);
+
+    if (0 == strncmp(arg, opt, len) && '=' == arg[len]) {
+        return arg + len + 1;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    const char *out = NULL;
+    int json = 0;
+    int reps = 5;
+    double min_time_ns = 0.02 * 1e9;
+    const char *v;
+
+    for (int i = 1; i < argc; i++) {
+        if ((v = opt_value(argv[i], "--benchmark_filter"))) {
+            filter = v;
+        } else if ((v = opt_value(argv[i], "--benchmark_out"))) {
+            out = v;
+        } else if ((v = opt_value(argv[i], "--benchmark_out_format"))) {
+            /* JSON is the only file format */
+        } else if ((v = opt_value(argv[i], "--benchmark_format"))) {
+            json = (0 == strcmp(v, "json"));
+        } else if ((v = opt_value(argv[i], "--benchmark_repetitions"))) {
+            reps = atoi(v);
+        } else if ((v = opt_value(argv[i], "--benchmark_min_time"))) {
+            min_time_ns = atof(v) * 1e9;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (reps < 1) {
+        reps = 1;
+    }
+
+    int total = 1;
+    for (size_t s = 0; s < sizeof(suites) / sizeof(suites[0]); s++) {
+        for (const bench_t *b = suites[s]; b->name; b++) {
+            total++;
+        }
+    }
+    bench_result_t *res = calloc((size_t)total, sizeof(*res));
+    if (!res) {
+        return 1;
+    }
+
+    /* Calibration always runs: the comparison needs it */
+    int n = 0;
+    bench_measure(&calibration, min_time_ns, reps, &res[n++]);
+    for (size_t s = 0; s < sizeof(suites) / sizeof(suites[0]); s++) {
+        for (const bench_t *b = suites[s]; b->name; b++) {
+            if (filter && !strstr(b->name, filter)) {
+                continue;
+            }
+            bench_measure(b, min_time_ns, reps, &res[n++]);
+        }
+    }
+
+    if (json) {
+        bench_write_json(stdout, res, n, reps);
+    } else {
+        printf("%-40s %14s %14s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+        for (int i = 0; i < n; i++) {
+            printf("%-40s %11.1f ns %11.1f ns %12lu\n", res[i].name, res[i].real_ns,
+                   res[i].cpu_ns, (unsigned long)res[i].iters);
+        }
+    }
+    if (out) {
+        FILE *f = fopen(out, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", out);
+            free(res);
+            return 1;
+        }
+        bench_write_json(f, res, n, reps);
+        fclose(f);
+    }
+    free(res);
+    return 0;
+}
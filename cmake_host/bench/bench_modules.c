@@ -0,0 +1,337 @@
+/**
+ * @file bench_modules.c
+ * @brief Microbenchmarks of the platform independent modules
+ *
+ * One benchmark per call made on a hot path of the firmware: per report,
+ * per delivery, per sample or per round. Inputs are deterministic so the
+ * runs are repeatable.
+ */
+
+#include "bench.h"
+
+#include "chgdet.h"
+#include "gen_plan.h"
+#include "linkfit.h"
+#include "rjournal.h"
+#include "rptq.h"
+#include "rstore.h"
+#include "topk.h"
+#include "tput_stats.h"
+#include "wallclock.h"
+
+#include <string.h>
+
+#define BENCH_FLASH_SECTORS     16
+#define BENCH_ADDRS             256     /* Advertisers in the top-k stream */
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* tput_stats: one delivery */
+
+static tput_stats_t tput;
+static uint32_t tput_now;
+
+static void tput_feed_setup(void)
+{
+    tput_stats_init(&tput, 1000, 100);
+    tput_now = 0;
+}
+
+static void tput_feed_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        tput_now += 7 + (i & 3);
+        tput_stats_feed(&tput, tput_now, 244);
+    }
+    bench_sink += tput.win_cnt;
+}
+
+/* gen_plan: one plan */
+
+static void gen_plan_run(uint32_t iters)
+{
+    gen_plan_t plan;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        gen_plan_build((uint16_t)(50 + (i & 127)), 100, 5, 32, &plan);
+        bench_sink += plan.planned_mpps;
+    }
+}
+
+/* chgdet: one sample */
+
+static chgdet_cusum_t cusum;
+static chgdet_ph_t ph;
+
+static void chgdet_setup(void)
+{
+    chgdet_cusum_init(&cusum, 0.5f, 8.0f, 0.5f, 20);
+    chgdet_ph_init(&ph, 0.5f, 50.0f, 20);
+    rnd_state = 1;
+}
+
+static void chgdet_cusum_run(uint32_t iters)
+{
+    int alarms = 0;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        alarms += chgdet_cusum_update(&cusum, 10.0f + (float)(rnd() & 7));
+    }
+    bench_sink += (uint32_t)alarms;
+}
+
+static void chgdet_ph_run(uint32_t iters)
+{
+    int alarms = 0;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        alarms += chgdet_ph_update(&ph, 10.0f + (float)(rnd() & 7));
+    }
+    bench_sink += (uint32_t)alarms;
+}
+
+/* linkfit: one solve of a 15 level sweep */
+
+static linkfit_t fit;
+
+static void linkfit_setup(void)
+{
+    static const int8_t tx[] = { -40, -20, -16, -12, -8, -4, 0, 2, 3, 4, 5, 6, 7, 8, 10 };
+
+    linkfit_reset(&fit);
+    for (unsigned i = 0; i < sizeof(tx); i++) {
+        int rssi = tx[i] - 90;
+        /* Loss falls from all to none over -100..-90 dBm */
+        int lost = (rssi <= -100) ? 250 : (rssi >= -90) ? 2 : (-90 - rssi) * 25;
+        linkfit_add(&fit, tx[i], (int8_t)rssi, (uint16_t)(250 - lost), 250);
+    }
+}
+
+static void linkfit_solve_run(uint32_t iters)
+{
+    linkfit_result_t res;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        linkfit_solve(&fit, &res);
+        bench_sink += (uint32_t)res.sens_dbm[0];
+    }
+}
+
+/* rptq: one report */
+
+static rptq_mon_t rptq;
+static uint32_t rptq_now;
+
+static void rptq_setup(void)
+{
+    rptq_mon_init(&rptq, 10, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&rptq, 0, 25000);
+    rptq_mon_period(&rptq, 1, 30000);
+    rptq_now = 0;
+}
+
+static void rptq_report_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        /* Every 64th report closes a stall and a short drain follows */
+        rptq_now += ((i & 63) == 0) ? 400000 : ((i & 63) < 6) ? 300 : 12500;
+        rptq_mon_report(&rptq, (int8_t)(i & 1), rptq_now);
+    }
+    bench_sink += rptq.reports;
+}
+
+/* rstore: append and range query on a RAM flash */
+
+static uint8_t flash_mem[BENCH_FLASH_SECTORS * RSTORE_SECTOR_SIZE];
+
+static int flash_read(void *ctx, uint32_t addr, void *buf, uint32_t len)
+{
+    (void)ctx;
+    memcpy(buf, &flash_mem[addr], len);
+    return 0;
+}
+
+static int flash_program(void *ctx, uint32_t addr, const void *buf, uint32_t len)
+{
+    const uint8_t *p = buf;
+
+    (void)ctx;
+    for (uint32_t i = 0; i < len; i++) {
+        flash_mem[addr + i] &= p[i];
+    }
+    return 0;
+}
+
+static int flash_erase(void *ctx, uint32_t addr)
+{
+    (void)ctx;
+    memset(&flash_mem[addr], 0xFF, RSTORE_SECTOR_SIZE);
+    return 0;
+}
+
+static const rstore_flash_t flash = {
+    flash_read, flash_program, flash_erase, NULL, 0, BENCH_FLASH_SECTORS
+};
+static rstore_sector_t store_index[BENCH_FLASH_SECTORS];
+static rstore_t store;
+static uint32_t store_round;
+static uint8_t store_buf[256];
+
+static void rstore_setup(void)
+{
+    memset(flash_mem, 0xFF, sizeof(flash_mem));
+    rstore_mount(&store, &flash, store_index);
+    for (unsigned i = 0; i < sizeof(store_buf); i++) {
+        store_buf[i] = (uint8_t)(i * 7);
+    }
+    /* Fill the ring once, so appends also erase */
+    for (store_round = 1; store_round <= 400; store_round++) {
+        rstore_append(&store, RSTORE_TYPE_RESULT, store_round, store_buf, 160);
+    }
+}
+
+static void rstore_append_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        rstore_append(&store, RSTORE_TYPE_RESULT, store_round++, store_buf, 160);
+    }
+    bench_sink += store.records;
+}
+
+static bool rstore_count_cb(void *ctx, const rstore_rec_t *rec, const void *data)
+{
+    (void)rec;
+    (void)data;
+    (*(uint32_t *)ctx)++;
+    return true;
+}
+
+static void rstore_query_run(uint32_t iters)
+{
+    uint8_t buf[RSTORE_MAX_DATA];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t hi = store.last_round - (i & 15) * 8;
+        rstore_query(&store, hi - 10, hi, buf, sizeof(buf), rstore_count_cb, &n);
+    }
+    bench_sink += n;
+}
+
+/* topk: one report */
+
+static topk_t tk;
+
+static void topk_setup(void)
+{
+    topk_reset(&tk);
+    rnd_state = 7;
+}
+
+static void topk_add_run(uint32_t iters)
+{
+    for (uint32_t i = 0; i < iters; i++) {
+        /* Skewed stream: the low ids take most reports */
+        uint32_t r = rnd();
+        uint32_t id = (r & 0xFF) % (1u + ((r >> 8) & (BENCH_ADDRS - 1)));
+        uint8_t addr[6] = { (uint8_t)id, (uint8_t)(id >> 3), 0x5A, 0x11, 0x22, 0xC0 };
+        topk_add(&tk, addr, 1, (uint8_t)(id & 3), 31, (int8_t)(-40 - (int)(id & 31)));
+    }
+    bench_sink += tk.total;
+}
+
+/* wallclock: stamp and calendar conversion */
+
+static wallclock_t wc;
+
+static void wallclock_setup(void)
+{
+    wallclock_stamp_t now = { 1760000000u, 250 };
+
+    wallclock_init(&wc);
+    wallclock_set(&wc, 5000, &now, WALLCLOCK_SRC_GATT);
+}
+
+static void wallclock_now_run(uint32_t iters)
+{
+    wallclock_stamp_t st;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        wallclock_now(&wc, 5000 + (int64_t)i * 37, &st);
+        bench_sink += st.ms;
+    }
+}
+
+static void wallclock_date_run(uint32_t iters)
+{
+    wallclock_date_t date;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        wallclock_to_date(1700000000u + i * 86399u, &date);
+        bench_sink += date.day;
+    }
+}
+
+/* rjournal: one checkpoint */
+
+static rjournal_t journal;
+
+static void rjournal_setup(void)
+{
+    rjournal_clear(&journal);
+}
+
+static void rjournal_write_run(uint32_t iters)
+{
+    uint8_t data[96];
+
+    memset(data, 0x3C, sizeof(data));
+    for (uint32_t i = 0; i < iters; i++) {
+        data[0] = (uint8_t)i;
+        rjournal_write(&journal, data, sizeof(data));
+    }
+    bench_sink += journal.slot[0].seq;
+}
+
+static void rjournal_read_setup(void)
+{
+    uint8_t data[96];
+
+    memset(data, 0x3C, sizeof(data));
+    rjournal_clear(&journal);
+    rjournal_write(&journal, data, sizeof(data));
+}
+
+static void rjournal_read_run(uint32_t iters)
+{
+    uint8_t data[96];
+
+    for (uint32_t i = 0; i < iters; i++) {
+        bench_sink += (uint32_t)rjournal_read(&journal, data, sizeof(data));
+    }
+}
+
+const bench_t bench_modules[] = {
+    { "tput_stats/feed",     tput_feed_setup,     tput_feed_run },
+    { "gen_plan/build",      NULL,                gen_plan_run },
+    { "chgdet/cusum_update", chgdet_setup,        chgdet_cusum_run },
+    { "chgdet/ph_update",    chgdet_setup,        chgdet_ph_run },
+    { "linkfit/solve",       linkfit_setup,       linkfit_solve_run },
+    { "rptq/report",         rptq_setup,          rptq_report_run },
+    { "rstore/append_160",   rstore_setup,        rstore_append_run },
+    { "rstore/query_10",     rstore_setup,        rstore_query_run },
+    { "topk/add",            topk_setup,          topk_add_run },
+    { "wallclock/now",       wallclock_setup,     wallclock_now_run },
+    { "wallclock/to_date",   NULL,                wallclock_date_run },
+    { "rjournal/write_96",   rjournal_setup,      rjournal_write_run },
+    { "rjournal/read_96",    rjournal_read_setup, rjournal_read_run },
+    { NULL, NULL, NULL },
+};
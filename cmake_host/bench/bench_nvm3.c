@@ -0,0 +1,102 @@
+/**
+ * @file bench_nvm3.c
+ * @brief Microbenchmarks of NVM3 and the PSA ITS lookup on it
+ *
+ * The real NVM3 on the RAM HAL (mock/nvm3_hal_ram.c). The ITS lookups run
+ * on a full range of files, once through the UID index and once through
+ * the scan of the range that it replaced.
+ */
+
+#include "bench.h"
+
+#include "nvm3_default.h"
+#include "nvm3_hal_ram.h"
+#include "psa/internal_trusted_storage.h"
+#include "psa/sli_internal_trusted_storage.h"
+
+#define BENCH_NVM3_KEYS     64
+#define BENCH_ITS_UID       0x2000u
+
+/* Statics of sl_psa_its_nvm3.c, exposed by SLI_STATIC_TESTABLE */
+extern bool nvm3_uid_set_cache_initialized;
+extern bool nvm3_uid_index_complete;
+
+/* NVM3: small objects as the application settings */
+
+static void nvm3_setup(void)
+{
+    uint32_t v = 0;
+
+    nvm3_ram_format();
+    nvm3_uid_set_cache_initialized = false;
+    nvm3_initDefault();
+    for (uint32_t k = 0; k < BENCH_NVM3_KEYS; k++) {
+        nvm3_writeData(nvm3_defaultHandle, k, &v, sizeof(v));
+    }
+}
+
+static void nvm3_write_run(uint32_t iters)
+{
+    uint32_t data[4] = { 0 };
+
+    for (uint32_t i = 0; i < iters; i++) {
+        data[0] = i;
+        nvm3_writeData(nvm3_defaultHandle, i % BENCH_NVM3_KEYS, data, sizeof(data));
+        if (nvm3_repackNeeded(nvm3_defaultHandle)) {
+            nvm3_repack(nvm3_defaultHandle);
+        }
+    }
+    bench_sink += nvm3_ram_erases;
+}
+
+static void nvm3_read_run(uint32_t iters)
+{
+    uint32_t v = 0;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        nvm3_readData(nvm3_defaultHandle, (i * 7) % BENCH_NVM3_KEYS, &v, sizeof(v));
+        bench_sink += v;
+    }
+}
+
+/* PSA ITS: get_info of a file in a full range */
+
+static void its_full_setup(void)
+{
+    nvm3_setup();
+    for (uint32_t i = 0; i < SL_PSA_ITS_MAX_FILES; i++) {
+        psa_its_set(BENCH_ITS_UID + i, sizeof(i), &i, PSA_STORAGE_FLAG_NONE);
+    }
+}
+
+/* Consecutive lookups of different files, past the last lookup shortcut */
+static void its_get_info(uint32_t iters)
+{
+    struct psa_storage_info_t info;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        psa_its_get_info(BENCH_ITS_UID + (i * 389u) % SL_PSA_ITS_MAX_FILES, &info);
+        bench_sink += info.size;
+    }
+}
+
+static void its_index_run(uint32_t iters)
+{
+    nvm3_uid_index_complete = true;
+    its_get_info(iters);
+}
+
+static void its_scan_run(uint32_t iters)
+{
+    nvm3_uid_index_complete = false;
+    its_get_info(iters);
+    nvm3_uid_index_complete = true;
+}
+
+const bench_t bench_nvm3[] = {
+    { "nvm3/write_16b",         nvm3_setup,     nvm3_write_run },
+    { "nvm3/read_4b",           nvm3_setup,     nvm3_read_run },
+    { "its/get_info_index",     its_full_setup, its_index_run },
+    { "its/get_info_scan",      its_full_setup, its_scan_run },
+    { NULL, NULL, NULL },
+};
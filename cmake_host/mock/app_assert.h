@@ -0,0 +1,31 @@
+/**
+ * @file app_assert.h
+ * @brief Host stand-in for the application assert
+ *
+ * Same macros as the SDK app_assert.h without the component catalog and
+ * app_log: a failed assert prints its message and ends the test.
+ */
+
+#ifndef APP_ASSERT_H
+#define APP_ASSERT_H
+
+#include "sl_status.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define app_assert(expr, ...)                                               \
+    do {                                                                    \
+        if (!(expr)) {                                                      \
+            fprintf(stderr, "%s:%d: assertion '%s' failed: ", __FILE__,     \
+                    __LINE__, #expr);                                       \
+            fprintf(stderr, __VA_ARGS__);                                   \
+            fputc('\n', stderr);                                            \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+#define app_assert_status(sc) \
+    app_assert(SL_STATUS_OK == (sc), "status 0x%04x", (unsigned)(sc))
+
+#endif /* APP_ASSERT_H */
@@ -0,0 +1,81 @@
+/**
+ * @file app_host.c
+ * @brief Host stand-ins for the platform calls of app.c
+ *
+ * The application task always has work, the LCD menu does nothing and the
+ * event flags are a single word for the one group app.c creates. The
+ * service calls are in losstst_host.c.
+ */
+
+#include "app.h"
+#include "lcd_ui.h"
+#include "cmsis_os2.h"
+#include "sl_simple_button_instances.h"
+
+static uint32_t event_flags;
+
+sl_button_t sl_button_btn0;
+sl_button_t sl_button_btn1;
+
+bool app_is_process_required(void)
+{
+    return true;
+}
+
+sl_button_state_t sl_button_get_state(const sl_button_t *handle)
+{
+    return handle->state;
+}
+
+int lcd_ui_init(void)
+{
+    return 0;
+}
+
+void lcd_ui_show_startup(void *param)
+{
+    (void)param;
+}
+
+void lcd_ui_show_channel_per(void)
+{
+}
+
+bool lcd_ui_show_link_fit(void)
+{
+    return false;
+}
+
+void lcd_ui_next_selection(void)
+{
+}
+
+void lcd_ui_expand_selection(void)
+{
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+    (void)attr;
+    event_flags = 0;
+    return (osEventFlagsId_t)&event_flags;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    *(uint32_t *)ef_id |= flags;
+    return *(uint32_t *)ef_id;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    uint32_t was = *(uint32_t *)ef_id;
+
+    *(uint32_t *)ef_id &= ~flags;
+    return was;
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+    return *(uint32_t *)ef_id;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file em_device.h
+ * @brief Host stand-in for the device header
+ *
+ * GLIB only takes __INLINE from it, NVM3 the flash page size and PSA ITS
+ * the SRAM range it checks output buffers against.
+ */
+
+#ifndef EM_DEVICE_H
+#define EM_DEVICE_H
+
+#ifndef __INLINE
+#define __INLINE inline
+#endif
+
+/* EFR32MG27 flash page */
+#define FLASH_PAGE_SIZE         (0x00002000UL)
+
+/*
+ * Host buffers can be anywhere, and PSA ITS compares the low 32 bits of
+ * the pointer only: accept all of them.
+ */
+#define SRAM_BASE               (0x00000000UL)
+#define SRAM_SIZE               (0xFFFFFFFFUL)
+
+#endif /* EM_DEVICE_H */
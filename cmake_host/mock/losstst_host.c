@@ -0,0 +1,97 @@
+/**
+ * @file losstst_host.c
+ * @brief Host stand-ins for the application calls of the loss test service
+ *
+ * app_proceed() and the LCD screens do nothing. The MX25 flash is a RAM
+ * array that programs like NOR flash: bits only clear, erase sets a 4 KB
+ * sector to 0xFF.
+ */
+
+#include "app.h"
+#include "lcd_ui.h"
+#include "mx25.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define MX25_HOST_SIZE          (64 * MX25_SECTOR_SIZE)
+
+static uint8_t flash[MX25_HOST_SIZE];
+static bool flash_ready;
+
+void app_proceed(void)
+{
+}
+
+void lcd_ui_update(const void *param, const char *test_mode, const char *status)
+{
+    (void)param;
+    (void)test_mode;
+    (void)status;
+}
+
+void lcd_ui_show_progress(uint32_t current, uint32_t total, int8_t rssi)
+{
+    (void)current;
+    (void)total;
+    (void)rssi;
+}
+
+bool lcd_ui_show_env_top(void)
+{
+    return false;
+}
+
+int mx25_init(void)
+{
+    if (!flash_ready) {
+        memset(flash, 0xFF, sizeof(flash));
+        flash_ready = true;
+    }
+    return 0;
+}
+
+uint32_t mx25_size(void)
+{
+    return flash_ready ? MX25_HOST_SIZE : 0;
+}
+
+void mx25_acquire(void)
+{
+}
+
+void mx25_release(void)
+{
+}
+
+int mx25_read(uint32_t addr, void *buf, uint32_t len)
+{
+    if (buf == NULL || addr > MX25_HOST_SIZE || len > MX25_HOST_SIZE - addr) {
+        return -EINVAL;
+    }
+    memcpy(buf, &flash[addr], len);
+    return 0;
+}
+
+int mx25_program(uint32_t addr, const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+
+    if (data == NULL || addr >= MX25_HOST_SIZE || len > MX25_PAGE_SIZE
+        || (addr % MX25_PAGE_SIZE) + len > MX25_PAGE_SIZE) {
+        return -EINVAL;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        flash[addr + i] &= p[i];
+    }
+    return 0;
+}
+
+int mx25_erase(uint32_t addr)
+{
+    if (addr >= MX25_HOST_SIZE) {
+        return -EINVAL;
+    }
+    memset(&flash[addr - addr % MX25_SECTOR_SIZE], 0xFF, MX25_SECTOR_SIZE);
+    return 0;
+}
@@ -0,0 +1,16 @@
+/**
+ * @file build_info.h
+ * @brief Host stand-in for the Mbed TLS configuration
+ *
+ * Just enough for the PSA ITS on NVM3 and the PSA types it uses: key
+ * storage on, no threading, and random numbers from outside Mbed TLS as
+ * on the Silicon Labs parts (the IV of an encrypted file).
+ */
+
+#ifndef MBEDTLS_BUILD_INFO_H
+#define MBEDTLS_BUILD_INFO_H
+
+#define MBEDTLS_PSA_CRYPTO_STORAGE_C
+#define MBEDTLS_PSA_CRYPTO_EXTERNAL_RNG
+
+#endif /* MBEDTLS_BUILD_INFO_H */
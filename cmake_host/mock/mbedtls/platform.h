@@ -0,0 +1,14 @@
+/**
+ * @file platform.h
+ * @brief Host stand-in for the Mbed TLS platform layer
+ */
+
+#ifndef MBEDTLS_PLATFORM_H
+#define MBEDTLS_PLATFORM_H
+
+#include <stdlib.h>
+
+#define mbedtls_calloc  calloc
+#define mbedtls_free    free
+
+#endif /* MBEDTLS_PLATFORM_H */
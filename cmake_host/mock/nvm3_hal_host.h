@@ -0,0 +1,26 @@
+/**
+ * @file nvm3_hal_host.h
+ * @brief Host build replacement for the target includes of nvm3_hal.h
+ *
+ * NVM3 includes this instead of sl_assert.h and sl_common.h when built with
+ * NVM3_HOST_BUILD, and defines EFM_ASSERT and SL_WEAK itself. The rest of
+ * sl_common.h that NVM3 uses is repeated here, word for word so the two can
+ * meet in one file.
+ */
+
+#ifndef NVM3_HAL_HOST_H
+#define NVM3_HAL_HOST_H
+
+#include "em_device.h"
+
+#include <assert.h>
+
+#if !defined(__STATIC_INLINE)
+#define __STATIC_INLINE static inline
+#endif
+
+#define SL_MIN(a, b) __extension__({ __typeof__(a)_a = (a); __typeof__(b)_b = (b); _a < _b ? _a : _b; })
+
+#define SL_MAX(a, b) __extension__({ __typeof__(a)_a = (a); __typeof__(b)_b = (b); _a > _b ? _a : _b; })
+
+#endif /* NVM3_HAL_HOST_H */
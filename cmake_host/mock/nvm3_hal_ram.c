@@ -0,0 +1,182 @@
+/**
+ * @file nvm3_hal_ram.c
+ * @brief Host NVM3 HAL on a RAM array, and the default instance on it
+ */
+
+#include "nvm3_hal_ram.h"
+#include "nvm3_default.h"
+#include "nvm3_default_config.h"
+
+#include <string.h>
+
+static uint32_t ram_mem[NVM3_RAM_SIZE / sizeof(uint32_t)]
+__attribute__((aligned(FLASH_PAGE_SIZE)));
+
+uint32_t nvm3_ram_reads;
+uint32_t nvm3_ram_writes;
+uint32_t nvm3_ram_erases;
+
+/* Power cut: armed, operations left before it, and whether it happened */
+static bool cut_armed;
+static uint32_t cut_ops_left;
+static bool power_lost;
+
+/* Whether a word write or page erase still reaches the array */
+static bool powered_op(void)
+{
+    if (power_lost) {
+        return false;
+    }
+    if (cut_armed && cut_ops_left-- == 0) {
+        power_lost = true;
+        return false;
+    }
+    return true;
+}
+
+static sl_status_t ram_open(nvm3_HalPtr_t nvmAdr, size_t nvmSize)
+{
+    (void)nvmAdr;
+    (void)nvmSize;
+    return SL_STATUS_OK;
+}
+
+static void ram_close(void)
+{
+}
+
+static sl_status_t ram_get_info(nvm3_HalInfo_t *info)
+{
+    info->deviceFamilyPartNumber = 0;
+    info->memoryMapped = 1;
+    info->writeSize = NVM3_HAL_WRITE_SIZE_32;
+    info->pageSize = FLASH_PAGE_SIZE;
+    info->systemUnique = 0;
+    return SL_STATUS_OK;
+}
+
+static void ram_access(nvm3_HalNvmAccessCode_t access)
+{
+    (void)access;
+}
+
+static bool in_ram(const void *adr, size_t len)
+{
+    const uint8_t *p = adr;
+
+    return p >= (const uint8_t *)ram_mem && p + len <= (const uint8_t *)ram_mem + sizeof(ram_mem);
+}
+
+static sl_status_t ram_read_words(nvm3_HalPtr_t nvmAdr, void *dst, size_t wordCnt)
+{
+    if (!in_ram(nvmAdr, wordCnt * sizeof(uint32_t))) {
+        return SL_STATUS_NVM3_INVALID_ADDR;
+    }
+    nvm3_ram_reads += (uint32_t)wordCnt;
+    memcpy(dst, nvmAdr, wordCnt * sizeof(uint32_t));
+    return SL_STATUS_OK;
+}
+
+static sl_status_t ram_write_words(nvm3_HalPtr_t nvmAdr, void const *src, size_t wordCnt)
+{
+    uint32_t *dst = nvmAdr;
+    const uint32_t *s = src;
+
+    if (!in_ram(nvmAdr, wordCnt * sizeof(uint32_t)) || ((size_t)nvmAdr % sizeof(uint32_t))) {
+        return SL_STATUS_NVM3_INVALID_ADDR;
+    }
+    for (size_t i = 0; i < wordCnt; i++) {
+        uint32_t w;
+
+        if (!powered_op()) {
+            return SL_STATUS_FLASH_PROGRAM_FAILED;
+        }
+        memcpy(&w, &s[i], sizeof(w));
+        dst[i] &= w;
+        if (dst[i] != w) {
+            return SL_STATUS_FLASH_PROGRAM_FAILED;
+        }
+    }
+    nvm3_ram_writes += (uint32_t)wordCnt;
+    return SL_STATUS_OK;
+}
+
+static sl_status_t ram_page_erase(nvm3_HalPtr_t nvmAdr)
+{
+    if (!in_ram(nvmAdr, FLASH_PAGE_SIZE) || ((size_t)nvmAdr % FLASH_PAGE_SIZE)) {
+        return SL_STATUS_NVM3_INVALID_ADDR;
+    }
+    if (!powered_op()) {
+        return SL_STATUS_FLASH_ERASE_FAILED;
+    }
+    memset(nvmAdr, 0xFF, FLASH_PAGE_SIZE);
+    nvm3_ram_erases++;
+    return SL_STATUS_OK;
+}
+
+const nvm3_HalHandle_t nvm3_halRamHandle = {
+    .open = ram_open,
+    .close = ram_close,
+    .getInfo = ram_get_info,
+    .access = ram_access,
+    .pageErase = ram_page_erase,
+    .readWords = ram_read_words,
+    .writeWords = ram_write_words,
+};
+
+/* Default instance, as nvm3_default_common_linker.c sets it up on flash */
+static nvm3_Handle_t default_handle;
+static nvm3_CacheEntry_t default_cache[NVM3_RAM_CACHE_SIZE];
+
+static nvm3_Init_t default_init = {
+    .nvmAdr = ram_mem,
+    .nvmSize = NVM3_RAM_SIZE,
+    .cachePtr = default_cache,
+    .cacheEntryCount = NVM3_RAM_CACHE_SIZE,
+    .maxObjectSize = NVM3_DEFAULT_MAX_OBJECT_SIZE,
+    .repackHeadroom = NVM3_DEFAULT_REPACK_HEADROOM,
+    .halHandle = &nvm3_halRamHandle,
+};
+
+nvm3_Handle_t *nvm3_defaultHandle = &default_handle;
+nvm3_Init_t *nvm3_defaultInit = &default_init;
+
+sl_status_t nvm3_initDefault(void)
+{
+    return nvm3_open(nvm3_defaultHandle, nvm3_defaultInit);
+}
+
+sl_status_t nvm3_deinitDefault(void)
+{
+    return nvm3_close(nvm3_defaultHandle);
+}
+
+void nvm3_ram_format(void)
+{
+    if (default_handle.hasBeenOpened) {
+        nvm3_deinitDefault();
+    }
+    memset(ram_mem, 0xFF, sizeof(ram_mem));
+    nvm3_ram_reads = 0;
+    nvm3_ram_writes = 0;
+    nvm3_ram_erases = 0;
+    nvm3_ram_power_on();
+}
+
+void nvm3_ram_cut_power_after(uint32_t ops)
+{
+    cut_armed = true;
+    cut_ops_left = ops;
+    power_lost = false;
+}
+
+bool nvm3_ram_power_lost(void)
+{
+    return power_lost;
+}
+
+void nvm3_ram_power_on(void)
+{
+    cut_armed = false;
+    power_lost = false;
+}
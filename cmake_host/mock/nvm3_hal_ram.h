@@ -0,0 +1,52 @@
+/**
+ * @file nvm3_hal_ram.h
+ * @brief Host NVM3 HAL on a RAM array, and the default instance on it
+ *
+ * The array behaves as the flash of the part: 8 kB pages, one 32-bit
+ * write per word that can only clear bits, and page erase to 0xFF. A power
+ * cut can be armed to stop all writes and erases from a given one on.
+ */
+
+#ifndef NVM3_HAL_RAM_H
+#define NVM3_HAL_RAM_H
+
+#include "nvm3.h"
+
+/*
+ * Large enough for a full PSA ITS range of small files. An application
+ * storing that many objects sizes the NVM3 cache for them.
+ */
+#define NVM3_RAM_SIZE           (16 * FLASH_PAGE_SIZE)
+#define NVM3_RAM_CACHE_SIZE     1280
+
+extern const nvm3_HalHandle_t nvm3_halRamHandle;
+
+/** Word reads, word writes and page erases since the last format */
+extern uint32_t nvm3_ram_reads;
+extern uint32_t nvm3_ram_writes;
+extern uint32_t nvm3_ram_erases;
+
+/**
+ * @brief Erase the whole array
+ *
+ * Closes the default instance first; the next nvm3_initDefault() opens it
+ * on empty flash.
+ */
+void nvm3_ram_format(void);
+
+/**
+ * @brief Lose power after a number of word writes and page erases
+ *
+ * The cut operation and every later one leave the array as it is and
+ * fail, as if the part had stopped there; a page erase is all or nothing.
+ * Until nvm3_ram_power_on() the array only reads.
+ */
+void nvm3_ram_cut_power_after(uint32_t ops);
+
+/** Whether the armed power cut has happened */
+bool nvm3_ram_power_lost(void);
+
+/** Disarm the power cut and let writes through again */
+void nvm3_ram_power_on(void);
+
+#endif /* NVM3_HAL_RAM_H */
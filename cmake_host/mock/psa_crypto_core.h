@@ -0,0 +1,14 @@
+/**
+ * @file psa_crypto_core.h
+ * @brief Host stand-in for the PSA core header of Mbed TLS
+ *
+ * The encrypted PSA ITS only takes the PSA types from it, and the external
+ * RNG that psa_crypto_host.c provides.
+ */
+
+#ifndef PSA_CRYPTO_CORE_H
+#define PSA_CRYPTO_CORE_H
+
+#include "psa/crypto.h"
+
+#endif /* PSA_CRYPTO_CORE_H */
@@ -0,0 +1,38 @@
+/**
+ * @file psa_crypto_driver_wrappers.h
+ * @brief Host stand-in for the PSA driver wrappers, on psa_crypto_host.c
+ *
+ * Only the entry points the encrypted PSA ITS calls: CMAC as its session
+ * key derivation, and GCM.
+ */
+
+#ifndef PSA_CRYPTO_DRIVER_WRAPPERS_H
+#define PSA_CRYPTO_DRIVER_WRAPPERS_H
+
+#include "psa_crypto_core.h"
+
+psa_status_t psa_driver_wrapper_mac_compute(const psa_key_attributes_t *attributes,
+                                            const uint8_t *key_buffer, size_t key_buffer_size,
+                                            psa_algorithm_t alg,
+                                            const uint8_t *input, size_t input_length,
+                                            uint8_t *mac, size_t mac_size, size_t *mac_length);
+
+psa_status_t psa_driver_wrapper_aead_encrypt(const psa_key_attributes_t *attributes,
+                                             const uint8_t *key_buffer, size_t key_buffer_size,
+                                             psa_algorithm_t alg,
+                                             const uint8_t *nonce, size_t nonce_length,
+                                             const uint8_t *additional_data, size_t additional_data_length,
+                                             const uint8_t *plaintext, size_t plaintext_length,
+                                             uint8_t *ciphertext, size_t ciphertext_size,
+                                             size_t *ciphertext_length);
+
+psa_status_t psa_driver_wrapper_aead_decrypt(const psa_key_attributes_t *attributes,
+                                             const uint8_t *key_buffer, size_t key_buffer_size,
+                                             psa_algorithm_t alg,
+                                             const uint8_t *nonce, size_t nonce_length,
+                                             const uint8_t *additional_data, size_t additional_data_length,
+                                             const uint8_t *ciphertext, size_t ciphertext_length,
+                                             uint8_t *plaintext, size_t plaintext_size,
+                                             size_t *plaintext_length);
+
+#endif /* PSA_CRYPTO_DRIVER_WRAPPERS_H */
@@ -0,0 +1,20 @@
+/**
+ * @file psa_crypto_host.h
+ * @brief Host stand-in for the PSA crypto drivers of the encrypted ITS
+ *
+ * Not AES: a keyed 64-bit mix replaces CMAC and the GCM keystream and tag.
+ * It keeps what the ITS relies on, a session key that depends on every byte
+ * of the root key and IV, and decryption that fails unless key, IV,
+ * metadata and data all match the encryption.
+ */
+
+#ifndef PSA_CRYPTO_HOST_H
+#define PSA_CRYPTO_HOST_H
+
+#include "psa_crypto_driver_wrappers.h"
+
+/** MAC computations (ITS session key derivations) and AEAD operations */
+extern uint32_t psa_crypto_host_mac_calls;
+extern uint32_t psa_crypto_host_aead_calls;
+
+#endif /* PSA_CRYPTO_HOST_H */
@@ -0,0 +1,719 @@
+/**
+ * @file sl_bt_host.c
+ * @brief Host stand-in for the Bluetooth stack, sleeptimer and RTOS calls
+ *        of the loss test service
+ */
+
+#include "sl_bt_host.h"
+#include "sl_bt_api.h"
+#include "sl_sleeptimer.h"
+#include "cmsis_os2.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define TIMER_FREQUENCY         32768u
+#define ADV_DELAY_US            10000u
+#define MAX_TIMERS              8
+
+typedef struct {
+    bool created;
+    bool running;
+    bool legacy;
+    uint8_t primary_phy;
+    uint8_t secondary_phy;
+    uint8_t channel_map;
+    uint32_t interval_min;      /* Programmed, taken at the next start */
+    uint16_t duration;
+    uint8_t maxevents;
+    sl_bt_host_adv_t on_air;    /* Timing of the running start */
+    uint64_t start_us;
+    uint64_t next_us;
+    uint8_t data[256];
+} host_set_t;
+
+typedef struct {
+    sl_sleeptimer_timer_handle_t *handle;   /* NULL = free */
+    uint64_t due_us;
+    uint64_t period_us;                     /* 0 = one-shot */
+    sl_sleeptimer_timer_callback_t callback;
+    void *data;
+} host_timer_t;
+
+static host_set_t sets[SL_BT_HOST_MAX_SETS];
+static host_timer_t timers[MAX_TIMERS];
+static sl_bt_host_conn_t conns[SL_BT_HOST_MAX_CONNS];
+static union {
+    sl_bt_msg_t msg;
+    uint8_t buf[sizeof(sl_bt_msg_t) + 256];
+} event;
+static sl_bt_host_hooks_t hooks;
+static uint64_t now_us;
+static uint32_t rnd_state = 1;
+static bd_addr identity = { { 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 } };
+static uint8_t scanning_phy;
+static uint32_t scan_starts;
+static sl_bt_host_ll_config_t ll_log[SL_BT_HOST_MAX_LL_CONFIGS];
+static uint32_t ll_configs;
+static uint32_t ll_refused[256];    /* Status per key */
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static host_set_t *set_of(uint8_t handle)
+{
+    return (handle < SL_BT_HOST_MAX_SETS && sets[handle].created) ? &sets[handle] : NULL;
+}
+
+static void set_end(uint8_t handle)
+{
+    sets[handle].running = false;
+    if (hooks.adv_timeout != NULL) {
+        hooks.adv_timeout(handle);
+    }
+}
+
+/* Events due up to now, in time order over all sets */
+static void adv_events(void)
+{
+    while (true) {
+        host_set_t *s = NULL;
+        uint8_t handle = 0;
+
+        for (uint8_t i = 0; i < SL_BT_HOST_MAX_SETS; i++) {
+            if (sets[i].running && sets[i].next_us <= now_us
+                && (s == NULL || sets[i].next_us < s->next_us)) {
+                s = &sets[i];
+                handle = i;
+            }
+        }
+        if (s == NULL) {
+            return;
+        }
+        if (s->on_air.duration && s->next_us >= s->start_us + s->on_air.duration * 10000ull) {
+            set_end(handle);
+            continue;
+        }
+        s->on_air.t_us = s->next_us;
+        s->on_air.channel_map = s->channel_map;
+        s->next_us += s->on_air.interval * 625ull + rnd() % (ADV_DELAY_US + 1);
+        if (hooks.adv_preempt != NULL && hooks.adv_preempt(&s->on_air)) {
+            continue;
+        }
+        s->on_air.event++;
+        if (hooks.adv_event != NULL) {
+            hooks.adv_event(&s->on_air);
+        }
+        if (s->on_air.max_events && s->on_air.event >= s->on_air.max_events) {
+            set_end(handle);
+        }
+    }
+}
+
+/* Timers due up to now, earliest first */
+static void timer_events(void)
+{
+    while (true) {
+        host_timer_t *t = NULL;
+
+        for (uint8_t i = 0; i < MAX_TIMERS; i++) {
+            if (timers[i].handle != NULL && timers[i].due_us <= now_us
+                && (t == NULL || timers[i].due_us < t->due_us)) {
+                t = &timers[i];
+            }
+        }
+        if (t == NULL) {
+            return;
+        }
+
+        sl_sleeptimer_timer_handle_t *handle = t->handle;
+
+        if (t->period_us) {
+            t->due_us += t->period_us;
+        } else {
+            t->handle = NULL;
+        }
+        t->callback(handle, t->data);
+    }
+}
+
+static host_timer_t *timer_of(const sl_sleeptimer_timer_handle_t *handle)
+{
+    for (uint8_t i = 0; i < MAX_TIMERS; i++) {
+        if (timers[i].handle == handle) {
+            return &timers[i];
+        }
+    }
+    return NULL;
+}
+
+static sl_bt_host_conn_t *conn_of(uint8_t connection)
+{
+    return (connection >= 1 && connection <= SL_BT_HOST_MAX_CONNS && conns[connection - 1].open)
+           ? &conns[connection - 1] : NULL;
+}
+
+void sl_bt_host_hooks(const sl_bt_host_hooks_t *h)
+{
+    memset(&hooks, 0, sizeof(hooks));
+    if (h != NULL) {
+        hooks = *h;
+    }
+}
+
+void sl_bt_host_seed(uint32_t seed)
+{
+    rnd_state = seed;
+}
+
+void sl_bt_host_address(const uint8_t addr[6])
+{
+    memcpy(identity.addr, addr, sizeof(identity.addr));
+}
+
+uint64_t sl_bt_host_now_us(void)
+{
+    return now_us;
+}
+
+void sl_bt_host_run(uint32_t ms)
+{
+    while (ms--) {
+        now_us += 1000;
+        adv_events();
+        timer_events();
+        if (hooks.step != NULL) {
+            hooks.step(now_us);
+        }
+    }
+}
+
+uint8_t sl_bt_host_scanning(void)
+{
+    return scanning_phy;
+}
+
+uint32_t sl_bt_host_scan_starts(void)
+{
+    return scan_starts;
+}
+
+void sl_bt_host_accept(uint8_t connection)
+{
+    if (connection >= 1 && connection <= SL_BT_HOST_MAX_CONNS) {
+        memset(&conns[connection - 1], 0, sizeof(conns[0]));
+        conns[connection - 1].open = true;
+    }
+}
+
+void sl_bt_host_drop(uint8_t connection)
+{
+    if (connection >= 1 && connection <= SL_BT_HOST_MAX_CONNS) {
+        conns[connection - 1].open = false;
+    }
+}
+
+const sl_bt_host_conn_t *sl_bt_host_conn(uint8_t connection)
+{
+    return (connection >= 1 && connection <= SL_BT_HOST_MAX_CONNS) ? &conns[connection - 1] : NULL;
+}
+
+uint32_t sl_bt_host_ll_configs(void)
+{
+    return ll_configs;
+}
+
+const sl_bt_host_ll_config_t *sl_bt_host_ll_config(uint32_t n)
+{
+    return (n < ll_configs && n < SL_BT_HOST_MAX_LL_CONFIGS) ? &ll_log[n] : NULL;
+}
+
+void sl_bt_host_ll_refuse(uint8_t key, uint32_t status)
+{
+    ll_refused[key] = status;
+}
+
+sl_bt_msg_t *sl_bt_host_event(uint32_t id)
+{
+    memset(&event, 0, sizeof(event));
+    event.msg.header = id;
+    return &event.msg;
+}
+
+/* ==================== Advertiser ==================== */
+
+sl_status_t sl_bt_advertiser_create_set(uint8_t *handle)
+{
+    for (uint8_t i = 0; i < SL_BT_HOST_MAX_SETS; i++) {
+        if (!sets[i].created) {
+            memset(&sets[i], 0, sizeof(sets[i]));
+            sets[i].created = true;
+            sets[i].primary_phy = sl_bt_gap_phy_1m;
+            sets[i].secondary_phy = sl_bt_gap_phy_1m;
+            sets[i].channel_map = 0x07;
+            sets[i].interval_min = 160;
+            sets[i].on_air.handle = i;
+            sets[i].on_air.data = sets[i].data;
+            *handle = i;
+            return SL_STATUS_OK;
+        }
+    }
+    return SL_STATUS_NO_MORE_RESOURCE;
+}
+
+sl_status_t sl_bt_advertiser_delete_set(uint8_t advertising_set)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    s->created = s->running = false;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_timing(uint8_t advertising_set, uint32_t interval_min,
+                                        uint32_t interval_max, uint16_t duration,
+                                        uint8_t maxevents)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    if (interval_min < 32 || interval_max < interval_min) {
+        return SL_STATUS_INVALID_PARAMETER;
+    }
+    s->interval_min = interval_min;
+    s->duration = duration;
+    s->maxevents = maxevents;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_channel_map(uint8_t advertising_set, uint8_t channel_map)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    s->channel_map = channel_map & 0x07;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_tx_power(uint8_t advertising_set, int16_t power,
+                                          int16_t *set_power)
+{
+    /* The service sets the power of its four handles before the first
+     * start creates them, so any handle in range takes it */
+    if (advertising_set >= SL_BT_HOST_MAX_SETS) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    *set_power = power;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_random_address(uint8_t advertising_set, uint8_t addr_type,
+                                                bd_addr address, bd_addr *address_out)
+{
+    (void)addr_type;
+    if (set_of(advertising_set) == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    *address_out = address;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_clear_random_address(uint8_t advertising_set)
+{
+    return (set_of(advertising_set) != NULL) ? SL_STATUS_OK : SL_STATUS_INVALID_HANDLE;
+}
+
+sl_status_t sl_bt_advertiser_stop(uint8_t advertising_set)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    s->running = false;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_extended_advertiser_set_phy(uint8_t advertising_set, uint8_t primary_phy,
+                                              uint8_t secondary_phy)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    s->primary_phy = primary_phy;
+    s->secondary_phy = secondary_phy;
+    return SL_STATUS_OK;
+}
+
+static sl_status_t set_data(uint8_t advertising_set, size_t data_len, const uint8_t *data)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    if (data_len > sizeof(s->data)) {
+        return SL_STATUS_INVALID_PARAMETER;
+    }
+    memcpy(s->data, data, data_len);
+    s->on_air.len = data_len;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_extended_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t *data)
+{
+    return set_data(advertising_set, data_len, data);
+}
+
+sl_status_t sl_bt_legacy_advertiser_set_data(uint8_t advertising_set, uint8_t type,
+                                             size_t data_len, const uint8_t *data)
+{
+    (void)type;
+    return set_data(advertising_set, data_len, data);
+}
+
+sl_status_t sl_bt_legacy_advertiser_generate_data(uint8_t advertising_set, uint8_t discover)
+{
+    static const uint8_t flags[] = { 2, 0x01, 0x06 };
+
+    (void)discover;
+    return set_data(advertising_set, sizeof(flags), flags);
+}
+
+static sl_status_t adv_start(uint8_t advertising_set, bool legacy)
+{
+    host_set_t *s = set_of(advertising_set);
+
+    if (s == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    s->legacy = legacy;
+    s->on_air.primary_phy = legacy ? sl_bt_gap_phy_1m : s->primary_phy;
+    s->on_air.secondary_phy = legacy ? 0 : s->secondary_phy;
+    s->on_air.interval = s->interval_min;
+    s->on_air.duration = s->duration;
+    s->on_air.max_events = s->maxevents;
+    s->on_air.event = 0;
+    s->on_air.start++;
+    s->running = true;
+    s->start_us = now_us;
+    s->next_us = now_us + rnd() % (ADV_DELAY_US + 1);
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_extended_advertiser_start(uint8_t advertising_set, uint8_t connect,
+                                            uint32_t flags)
+{
+    (void)connect;
+    (void)flags;
+    return adv_start(advertising_set, false);
+}
+
+sl_status_t sl_bt_legacy_advertiser_start(uint8_t advertising_set, uint8_t connect)
+{
+    (void)connect;
+    return adv_start(advertising_set, true);
+}
+
+/* ==================== Scanner ==================== */
+
+sl_status_t sl_bt_scanner_set_parameters(uint8_t mode, uint16_t interval, uint16_t window)
+{
+    (void)mode;
+    return (window <= interval) ? SL_STATUS_OK : SL_STATUS_INVALID_PARAMETER;
+}
+
+sl_status_t sl_bt_scanner_start(uint8_t scanning_phy_in, uint8_t discover_mode)
+{
+    (void)discover_mode;
+    scanning_phy = scanning_phy_in;
+    scan_starts++;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_scanner_stop(void)
+{
+    scanning_phy = 0;
+    return SL_STATUS_OK;
+}
+
+/* ==================== System ==================== */
+
+sl_status_t sl_bt_system_get_identity_address(bd_addr *address, uint8_t *type)
+{
+    *address = identity;
+    *type = 0;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_system_get_random_data(uint8_t length, size_t max_data_size,
+                                         size_t *data_len, uint8_t *data)
+{
+    *data_len = (length < max_data_size) ? length : max_data_size;
+    for (size_t i = 0; i < *data_len; i++) {
+        data[i] = (uint8_t)rnd();
+    }
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_system_get_counters(uint8_t reset, uint16_t *tx_packets,
+                                      uint16_t *rx_packets, uint16_t *crc_errors,
+                                      uint16_t *failures)
+{
+    (void)reset;
+    *tx_packets = *rx_packets = *crc_errors = *failures = 0;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_system_linklayer_configure(uint8_t key, size_t data_len, const uint8_t *data)
+{
+    if (ll_configs < SL_BT_HOST_MAX_LL_CONFIGS) {
+        sl_bt_host_ll_config_t *rec = &ll_log[ll_configs];
+
+        rec->key = key;
+        rec->len = (uint8_t)data_len;
+        memcpy(rec->data, data, (data_len < sizeof(rec->data)) ? data_len : sizeof(rec->data));
+        rec->status = ll_refused[key];
+    }
+    ll_configs++;
+    return ll_refused[key];
+}
+
+/* ==================== Connections and GATT ==================== */
+
+sl_status_t sl_bt_connection_open(bd_addr address, uint8_t address_type,
+                                  uint8_t initiating_phy, uint8_t *connection)
+{
+    (void)initiating_phy;
+    for (uint8_t i = 0; i < SL_BT_HOST_MAX_CONNS; i++) {
+        if (!conns[i].open) {
+            sl_bt_host_accept(i + 1);
+            memcpy(conns[i].peer, address.addr, sizeof(conns[i].peer));
+            conns[i].peer_type = address_type;
+            *connection = i + 1;
+            return SL_STATUS_OK;
+        }
+    }
+    return SL_STATUS_NO_MORE_RESOURCE;
+}
+
+sl_status_t sl_bt_connection_close(uint8_t connection)
+{
+    sl_bt_host_conn_t *c = conn_of(connection);
+
+    if (c == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    c->close_req = true;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us)
+{
+    sl_bt_host_conn_t *c = conn_of(connection);
+
+    (void)tx_time_us;
+    if (c == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    c->tx_data_len = tx_data_len;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_default_parameters(uint16_t min_interval, uint16_t max_interval,
+                                                    uint16_t latency, uint16_t timeout,
+                                                    uint16_t min_ce_length,
+                                                    uint16_t max_ce_length)
+{
+    (void)min_interval;
+    (void)max_interval;
+    (void)latency;
+    (void)timeout;
+    (void)min_ce_length;
+    (void)max_ce_length;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+    sl_bt_host_conn_t *c = conn_of(connection);
+
+    (void)accepted_phy;
+    if (c == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    c->preferred_phy = preferred_phy;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_set_max_mtu(uint16_t max_mtu, uint16_t *max_mtu_out)
+{
+    *max_mtu_out = max_mtu;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_set_characteristic_notification(uint8_t connection,
+                                                       uint16_t characteristic, uint8_t flags)
+{
+    sl_bt_host_conn_t *c = conn_of(connection);
+
+    if (c == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    c->notify_char = characteristic;
+    c->notify_flags = flags;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t *value)
+{
+    sl_bt_host_conn_t *c = conn_of(connection);
+
+    (void)value;
+    if (c == NULL) {
+        return SL_STATUS_INVALID_HANDLE;
+    }
+    c->sent_char = characteristic;
+    c->sent++;
+    c->sent_bytes += (uint32_t)value_len;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_read_attribute_value(uint16_t attribute, uint16_t offset,
+                                                   size_t max_value_size, size_t *value_len,
+                                                   uint8_t *value)
+{
+    (void)attribute;
+    (void)offset;
+    (void)max_value_size;
+    (void)value;
+    *value_len = 0;
+    return SL_STATUS_BT_ATT_INVALID_HANDLE;
+}
+
+/* ==================== Sleeptimer ==================== */
+
+uint64_t sl_sleeptimer_get_tick_count64(void)
+{
+    return now_us * TIMER_FREQUENCY / 1000000u;
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+    return TIMER_FREQUENCY;
+}
+
+sl_status_t sl_sleeptimer_tick64_to_ms(uint64_t tick, uint64_t *ms)
+{
+    *ms = tick * 1000u / TIMER_FREQUENCY;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_ms32_to_tick(uint32_t time_ms, uint32_t *tick)
+{
+    *tick = (uint32_t)((uint64_t)time_ms * TIMER_FREQUENCY / 1000u);
+    return SL_STATUS_OK;
+}
+
+static sl_status_t timer_start(sl_sleeptimer_timer_handle_t *handle, uint64_t timeout_us,
+                               uint64_t period_us, sl_sleeptimer_timer_callback_t callback,
+                               void *callback_data)
+{
+    host_timer_t *t = timer_of(handle);
+
+    if (handle == NULL || callback == NULL) {
+        return SL_STATUS_NULL_POINTER;
+    }
+    if (t == NULL && (t = timer_of(NULL)) == NULL) {
+        return SL_STATUS_NO_MORE_RESOURCE;
+    }
+    t->handle = handle;
+    t->due_us = now_us + timeout_us;
+    t->period_us = period_us;
+    t->callback = callback;
+    t->data = callback_data;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_restart_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                        sl_sleeptimer_timer_callback_t callback,
+                                        void *callback_data, uint8_t priority,
+                                        uint16_t option_flags)
+{
+    (void)priority;
+    (void)option_flags;
+    return timer_start(handle, (uint64_t)timeout * 1000000u / TIMER_FREQUENCY, 0, callback,
+                       callback_data);
+}
+
+sl_status_t sl_sleeptimer_restart_periodic_timer_ms(sl_sleeptimer_timer_handle_t *handle,
+                                                    uint32_t timeout_ms,
+                                                    sl_sleeptimer_timer_callback_t callback,
+                                                    void *callback_data, uint8_t priority,
+                                                    uint16_t option_flags)
+{
+    (void)priority;
+    (void)option_flags;
+    if (0 == timeout_ms) {
+        return SL_STATUS_INVALID_PARAMETER;
+    }
+    return timer_start(handle, timeout_ms * 1000ull, timeout_ms * 1000ull, callback,
+                       callback_data);
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+    host_timer_t *t = timer_of(handle);
+
+    if (handle == NULL) {
+        return SL_STATUS_NULL_POINTER;
+    }
+    if (t == NULL) {
+        return SL_STATUS_INVALID_STATE;
+    }
+    t->handle = NULL;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(const sl_sleeptimer_timer_handle_t *handle,
+                                           bool *running)
+{
+    if (handle == NULL || running == NULL) {
+        return SL_STATUS_NULL_POINTER;
+    }
+    *running = (timer_of(handle) != NULL);
+    return SL_STATUS_OK;
+}
+
+/* ==================== RTOS: one task, a yield is a clock step ==================== */
+
+osKernelState_t osKernelGetState(void)
+{
+    return osKernelRunning;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+    return (osThreadId_t)&identity;
+}
+
+osStatus_t osThreadYield(void)
+{
+    sl_bt_host_run(1);
+    return osOK;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file sl_bt_host.h
+ * @brief Host stand-in for the Bluetooth stack, sleeptimer and RTOS calls
+ *        of the loss test service
+ *
+ * A virtual clock runs in 1 ms steps: every osThreadYield() of the service
+ * is one step, and a test moves it on with sl_bt_host_run(). Advertising
+ * sets send an event every interval_min plus an advDelay of 0-10 ms from
+ * their start, and a start with a duration or event limit ends with the
+ * advertiser timeout. A pre-empted event is skipped without using up the
+ * event limit, as the controller does for a higher priority radio task. Timing set while advertising applies from the next
+ * start; starting a running set restarts its limits, as HCI does.
+ * Sleeptimers expire on the same clock, after the advertising events of
+ * the step.
+ *
+ * Connections are bookkeeping only: sl_bt_connection_open() takes the
+ * lowest free handle, a peer connecting takes one with
+ * sl_bt_host_accept(), and the handle stays taken until
+ * sl_bt_host_drop(). GATT calls on a taken handle succeed and are noted.
+ *
+ * Link layer configurations are logged in call order; a key can be set
+ * to be refused with a status, as a controller built without the feature
+ * does.
+ *
+ * Nothing reaches the service on its own. The test sees every advertising
+ * event, advertiser timeout and clock step through the hooks and delivers
+ * what it wants, the way app.c passes on the stack events.
+ */
+
+#ifndef SL_BT_HOST_H
+#define SL_BT_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SL_BT_HOST_MAX_SETS     8
+#define SL_BT_HOST_MAX_CONNS    4       /**< SL_BT_CONFIG_MAX_CONNECTIONS, handles from 1 */
+#define SL_BT_HOST_MAX_LL_CONFIGS 32    /**< Link layer configurations logged */
+
+struct sl_bt_msg;
+
+/** One advertising event on air */
+typedef struct {
+    uint64_t t_us;              /**< Virtual time of the event */
+    uint8_t handle;             /**< Advertising set */
+    uint8_t primary_phy;        /**< sl_bt_gap_phy_t, 1M for legacy */
+    uint8_t secondary_phy;      /**< sl_bt_gap_phy_t, 0 for legacy */
+    uint8_t channel_map;        /**< Bit 0 = 37, 1 = 38, 2 = 39 */
+    uint32_t interval;          /**< interval_min of the start (0.625 ms) */
+    uint16_t duration;          /**< Duration limit of the start (10 ms), 0 = none */
+    uint8_t max_events;         /**< Event limit of the start, 0 = none */
+    uint16_t event;             /**< Event of the start, from 1 */
+    uint32_t start;             /**< Starts of the set so far, from 1 */
+    const uint8_t *data;        /**< Advertising data */
+    size_t len;
+} sl_bt_host_adv_t;
+
+typedef struct {
+    /** Before every advertising event: true pre-empts it, so it is not sent
+     *  and does not count against the event limit */
+    bool (*adv_preempt)(const sl_bt_host_adv_t *adv);
+    void (*adv_event)(const sl_bt_host_adv_t *adv);     /**< Every advertising event */
+    void (*adv_timeout)(uint8_t handle);                /**< sl_bt_evt_advertiser_timeout */
+    void (*step)(uint64_t now_us);                      /**< After every 1 ms step */
+} sl_bt_host_hooks_t;
+
+/** One connection handle */
+typedef struct {
+    bool open;
+    bool close_req;             /**< sl_bt_connection_close() called */
+    uint8_t peer[6];            /**< sl_bt_connection_open() only */
+    uint8_t peer_type;
+    uint16_t tx_data_len;       /**< Last sl_bt_connection_set_data_length() */
+    uint8_t preferred_phy;      /**< Last sl_bt_connection_set_preferred_phy() */
+    uint16_t notify_char;       /**< Last sl_bt_gatt_set_characteristic_notification() */
+    uint8_t notify_flags;
+    uint16_t sent_char;         /**< Last sl_bt_gatt_server_send_notification() */
+    uint32_t sent;              /**< Notifications sent */
+    uint32_t sent_bytes;
+} sl_bt_host_conn_t;
+
+/** One sl_bt_system_linklayer_configure() call */
+typedef struct {
+    uint8_t key;                /**< sl_bt_system_linklayer_config_key_t */
+    uint8_t len;                /**< data_len of the call */
+    uint8_t data[64];           /**< The first 64 octets of data */
+    uint32_t status;            /**< sl_status_t returned */
+} sl_bt_host_ll_config_t;
+
+/** Install the hooks (NULL members are skipped) */
+void sl_bt_host_hooks(const sl_bt_host_hooks_t *hooks);
+
+/** Seed of the advDelay and sl_bt_system_get_random_data() */
+void sl_bt_host_seed(uint32_t seed);
+
+/** Identity address returned by sl_bt_system_get_identity_address() */
+void sl_bt_host_address(const uint8_t addr[6]);
+
+/** Virtual time */
+uint64_t sl_bt_host_now_us(void);
+
+/** Move the clock on by whole milliseconds */
+void sl_bt_host_run(uint32_t ms);
+
+/** scanning_phy of the running scanner (sl_bt_scanner_scan_phy_t), 0 = stopped */
+uint8_t sl_bt_host_scanning(void);
+
+/** Scanner starts so far */
+uint32_t sl_bt_host_scan_starts(void);
+
+/** A peer connects on the handle */
+void sl_bt_host_accept(uint8_t connection);
+
+/** The link on the handle is gone, the handle free again */
+void sl_bt_host_drop(uint8_t connection);
+
+/** State of a handle, NULL if out of range */
+const sl_bt_host_conn_t *sl_bt_host_conn(uint8_t connection);
+
+/** Link layer configurations so far, refused ones included */
+uint32_t sl_bt_host_ll_configs(void);
+
+/** Link layer configuration n, from 0; NULL past the log */
+const sl_bt_host_ll_config_t *sl_bt_host_ll_config(uint32_t n);
+
+/** Refuse configurations of the key with the status, SL_STATUS_OK (0)
+ *  accepts them again */
+void sl_bt_host_ll_refuse(uint8_t key, uint32_t status);
+
+/** An event for the test to fill in and deliver: zeroed, with the header
+ *  set and room for 255 octets of array data */
+struct sl_bt_msg *sl_bt_host_event(uint32_t id);
+
+#endif /* SL_BT_HOST_H */
@@ -0,0 +1,53 @@
+/**
+ * @file sl_memlcd.h
+ * @brief Host stand-in for the memory LCD driver
+ *
+ * Same types and functions as the SDK sl_memlcd.h without the SPI and
+ * CMSIS dependencies, so dmd_memlcd.c builds unchanged on the host. The
+ * display keeps no state: the DMD frame buffer is the picture.
+ */
+
+#ifndef SL_MEMLCD_H
+#define SL_MEMLCD_H
+
+#include "sl_status.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SL_MEMLCD_COLOR_MODE_MONOCHROME          1
+#define SL_MEMLCD_COLOR_MODE_RGB_3BIT            2
+
+typedef struct sl_memlcd_t {
+    unsigned short width;       /**< Display pixel width */
+    unsigned short height;      /**< Display pixel height */
+    uint8_t bpp;                /**< Bits per pixel */
+    uint8_t color_mode;         /**< Color mode */
+    int spi_freq;
+    uint8_t extcomin_freq;
+    uint8_t setup_us;
+    uint8_t hold_us;
+    void *custom_data;
+} sl_memlcd_t;
+
+sl_status_t sl_memlcd_init(void);
+const struct sl_memlcd_t *sl_memlcd_get(void);
+sl_status_t sl_memlcd_power_on(const struct sl_memlcd_t *device, bool on);
+sl_status_t sl_memlcd_clear(const struct sl_memlcd_t *device);
+sl_status_t sl_memlcd_draw(const struct sl_memlcd_t *device, const void *data,
+                           unsigned int row_start, unsigned int row_count);
+
+/**
+ * @brief Rows passed to sl_memlcd_draw() since sl_memlcd_init()
+ */
+uint32_t sl_memlcd_host_rows_drawn(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SL_MEMLCD_H */
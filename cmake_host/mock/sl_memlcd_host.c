@@ -0,0 +1,58 @@
+/**
+ * @file sl_memlcd_host.c
+ * @brief Host stand-in for the memory LCD driver
+ *
+ * The LS013B7DH03 of the board: 128 x 128 pixels, 1 bit per pixel.
+ */
+
+#include "sl_memlcd.h"
+#include "sl_memlcd_display.h"
+
+static const sl_memlcd_t host_lcd = {
+    .width = SL_MEMLCD_DISPLAY_WIDTH,
+    .height = SL_MEMLCD_DISPLAY_HEIGHT,
+    .bpp = SL_MEMLCD_DISPLAY_BPP,
+    .color_mode = SL_MEMLCD_COLOR_MODE_MONOCHROME,
+};
+
+static uint32_t rows_drawn;
+
+sl_status_t sl_memlcd_init(void)
+{
+    rows_drawn = 0;
+    return SL_STATUS_OK;
+}
+
+const struct sl_memlcd_t *sl_memlcd_get(void)
+{
+    return &host_lcd;
+}
+
+sl_status_t sl_memlcd_power_on(const struct sl_memlcd_t *device, bool on)
+{
+    (void)device;
+    (void)on;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_memlcd_clear(const struct sl_memlcd_t *device)
+{
+    (void)device;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_memlcd_draw(const struct sl_memlcd_t *device, const void *data,
+                           unsigned int row_start, unsigned int row_count)
+{
+    (void)data;
+    if (row_start + row_count > device->height) {
+        return SL_STATUS_INVALID_PARAMETER;
+    }
+    rows_drawn += row_count;
+    return SL_STATUS_OK;
+}
+
+uint32_t sl_memlcd_host_rows_drawn(void)
+{
+    return rows_drawn;
+}
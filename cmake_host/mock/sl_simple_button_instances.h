@@ -0,0 +1,30 @@
+/**
+ * @file sl_simple_button_instances.h
+ * @brief Host stand-in for the generated button instances
+ *
+ * The two buttons app.c knows, with a state a test can set; nothing calls
+ * sl_button_on_change() but the test.
+ */
+
+#ifndef SL_SIMPLE_BUTTON_INSTANCES_H
+#define SL_SIMPLE_BUTTON_INSTANCES_H
+
+#include <stdint.h>
+
+#define SL_SIMPLE_BUTTON_RELEASED   0U
+#define SL_SIMPLE_BUTTON_PRESSED    1U
+
+typedef uint8_t sl_button_state_t;
+
+typedef struct sl_button {
+    sl_button_state_t state;
+} sl_button_t;
+
+extern sl_button_t sl_button_btn0;
+extern sl_button_t sl_button_btn1;
+
+sl_button_state_t sl_button_get_state(const sl_button_t *handle);
+
+void sl_button_on_change(const sl_button_t *handle);
+
+#endif /* SL_SIMPLE_BUTTON_INSTANCES_H */
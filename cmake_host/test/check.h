@@ -0,0 +1,37 @@
+/**
+ * @file check.h
+ * @brief Minimal test assertions for the host tests
+ *
+ * CHECK() reports a failed condition with its location and counts it;
+ * the test's main() returns CHECK_RESULT(), which is non-zero after any
+ * failure, so ctest marks the test failed.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int check_failed;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            check_failed++;                                                   \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+        }                                                                     \
+    } while (0)
+
+#define CHECK_MSG(cond, ...)                                                  \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            check_failed++;                                                   \
+            printf("%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond);   \
+            printf(__VA_ARGS__);                                              \
+            printf("\n");                                                     \
+        }                                                                     \
+    } while (0)
+
+#define CHECK_RESULT()  (check_failed ? (printf("%d check(s) failed\n", check_failed), 1) : 0)
+
+#endif /* CHECK_H */
@@ -0,0 +1,196 @@
+/**
+ * @file test_chgdet.c
+ * @brief Detection delay and false alarm rate of the change detectors
+ *
+ * Synthetic soak runs: 400 rounds of Gaussian PER or RSSI with a step of
+ * the mean at round 200, detectors tuned as the soak mode in losstst_svc.c.
+ */
+
+#include "check.h"
+#include "chgdet.h"
+
+#include <math.h>
+
+#define TRIALS          500
+#define ROUNDS          400
+#define STEP_ROUND      200
+
+/* Soak mode tuning (SOAK_* in losstst_svc.c) */
+#define WARMUP          30
+#define CUSUM_K         0.5f
+#define CUSUM_H         6.0f
+
+typedef struct {
+    const char *name;
+    double base;
+    double sd;
+    double step;
+    float sd_floor;             /**< CUSUM standard deviation floor */
+    float ph_delta;
+    float ph_lambda;
+    bool non_negative;          /**< PER can not go below 0 */
+} metric_t;
+
+typedef struct {
+    uint32_t detected;          /**< Trials with an alarm after the step */
+    uint32_t delay_sum;         /**< Rounds from the step to the first alarm */
+    uint32_t false_alarms;      /**< Alarms before the step */
+    uint32_t wrong_dir;         /**< First alarm after the step against it */
+} det_result_t;
+
+static uint64_t rnd_state;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 6364136223846793005ull + 1442695040888963407ull;
+    return ((double)(rnd_state >> 11) + 1.0) / 9007199254740994.0;
+}
+
+static double gauss(void)
+{
+    double u = uniform();
+    double v = uniform();
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+static void account(det_result_t *res, int alarm, int round, int expect, bool *seen)
+{
+    if (CHGDET_NONE == alarm) {
+        return;
+    }
+    if (round < STEP_ROUND) {
+        res->false_alarms++;
+    } else if (!*seen) {
+        *seen = true;
+        res->detected++;
+        res->delay_sum += (uint32_t)(round - STEP_ROUND);
+        if (alarm != expect) {
+            res->wrong_dir++;
+        }
+    }
+}
+
+static void run(const metric_t *m, det_result_t *cusum, det_result_t *ph)
+{
+    int expect = (m->step > 0) ? CHGDET_UP : CHGDET_DOWN;
+
+    rnd_state = 1;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        chgdet_cusum_t c;
+        chgdet_ph_t p;
+        bool seen_c = false;
+        bool seen_p = false;
+
+        chgdet_cusum_init(&c, CUSUM_K, CUSUM_H, m->sd_floor, WARMUP);
+        chgdet_ph_init(&p, m->ph_delta, m->ph_lambda, WARMUP);
+        for (int r = 0; r < ROUNDS; r++) {
+            double x = m->base + m->sd * gauss() + ((r >= STEP_ROUND) ? m->step : 0.0);
+            if (m->non_negative && x < 0.0) {
+                x = 0.0;
+            }
+            account(cusum, chgdet_cusum_update(&c, (float)x), r, expect, &seen_c);
+            account(ph, chgdet_ph_update(&p, (float)x), r, expect, &seen_p);
+        }
+    }
+}
+
+static void check_result(const char *metric, const char *det, const det_result_t *res,
+                         double max_delay, double max_fa)
+{
+    double delay = res->detected ? (double)res->delay_sum / res->detected : 0.0;
+    double fa = (double)res->false_alarms / ((double)TRIALS * STEP_ROUND);
+
+    printf("%s %s: detected %u/%u, delay %.2f rounds, %.5f false alarms per round\n",
+           metric, det, res->detected, TRIALS, delay, fa);
+    /* A false alarm shortly before the step re-learns the baseline across it */
+    CHECK_MSG(res->detected >= TRIALS * 98 / 100, "%s %s missed %u", metric, det,
+              TRIALS - res->detected);
+    CHECK_MSG(0 == res->wrong_dir, "%s %s wrong direction %u", metric, det, res->wrong_dir);
+    CHECK_MSG(delay <= max_delay, "%s %s delay %.2f", metric, det, delay);
+    CHECK_MSG(fa <= max_fa, "%s %s false alarms %.5f", metric, det, fa);
+}
+
+/* Steps the soak mode is meant to flag within a few rounds */
+static void test_steps(void)
+{
+    static const metric_t metrics[] = {
+        { "PER",  2.0,  0.8,  4.0, 0.5f, 0.5f,  8.0f, true  },
+        { "RSSI", -60.0, 1.5, -6.0, 1.0f, 1.0f, 15.0f, false },
+    };
+
+    for (unsigned i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+        det_result_t cusum = { 0 };
+        det_result_t ph = { 0 };
+
+        run(&metrics[i], &cusum, &ph);
+        check_result(metrics[i].name, "CUSUM", &cusum, 3.0, 0.005);
+        check_result(metrics[i].name, "Page-Hinkley", &ph, 3.5, 0.001);
+    }
+}
+
+/* A flat baseline does not alarm on a small wobble thanks to the floor */
+static void test_flat_baseline(void)
+{
+    chgdet_cusum_t c;
+    int alarms = 0;
+
+    chgdet_cusum_init(&c, CUSUM_K, CUSUM_H, 0.5f, WARMUP);
+    for (int r = 0; r < WARMUP; r++) {
+        alarms += (CHGDET_NONE != chgdet_cusum_update(&c, 0.0f));
+    }
+    for (int r = 0; r < 100; r++) {
+        alarms += (CHGDET_NONE != chgdet_cusum_update(&c, (r % 10) ? 0.0f : 1.0f));
+    }
+    CHECK(0 == alarms);
+    CHECK(c.sd >= 0.5f);
+}
+
+/* After an alarm the baseline is re-learned at the new level */
+static void test_relearn(void)
+{
+    chgdet_cusum_t c;
+    chgdet_ph_t p;
+    int up = 0;
+    int c_after = 0;
+    int p_after = 0;
+
+    chgdet_cusum_init(&c, CUSUM_K, CUSUM_H, 0.5f, 10);
+    chgdet_ph_init(&p, 0.5f, 8.0f, 10);
+    for (int r = 0; r < 20; r++) {
+        chgdet_cusum_update(&c, (r & 1) ? 2.5f : 1.5f);
+        chgdet_ph_update(&p, (r & 1) ? 2.5f : 1.5f);
+    }
+    for (int r = 0; r < 200; r++) {
+        float x = (r & 1) ? 10.5f : 9.5f;
+        int a = chgdet_cusum_update(&c, x);
+        int b = chgdet_ph_update(&p, x);
+
+        if (0 == up) {
+            up = a;
+        } else if (CHGDET_NONE != a) {
+            c_after++;
+        }
+        if (r > 20 && CHGDET_NONE != b) {
+            p_after++;
+        }
+    }
+    CHECK(CHGDET_UP == up);
+    CHECK(0 == c_after);
+    CHECK(0 == p_after);
+    CHECK(fabsf(c.mean - 10.0f) < 0.1f);
+
+    /* And a drop back is flagged down */
+    int down = CHGDET_NONE;
+    for (int r = 0; r < 20 && CHGDET_NONE == down; r++) {
+        down = chgdet_cusum_update(&c, 2.0f);
+    }
+    CHECK(CHGDET_DOWN == down);
+}
+
+int main(void)
+{
+    test_steps();
+    test_flat_baseline();
+    test_relearn();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file test_gen_plan.c
+ * @brief Traffic generator plans: device split, advDelay, clamping
+ */
+
+#include "check.h"
+#include "gen_plan.h"
+
+#include <errno.h>
+#include <stddef.h>
+
+#define MIN_INTERVAL    32      /* 20 ms, non-connectable advertising */
+
+static void test_arguments(void)
+{
+    gen_plan_t plan;
+
+    CHECK(-EINVAL == gen_plan_build(10, 1000, 4, MIN_INTERVAL, NULL));
+    CHECK(-EINVAL == gen_plan_build(0, 1000, 4, MIN_INTERVAL, &plan));
+    CHECK(-EINVAL == gen_plan_build(10, 0, 4, MIN_INTERVAL, &plan));
+    CHECK(-EINVAL == gen_plan_build(10, 1000, 0, MIN_INTERVAL, &plan));
+    CHECK(-EINVAL == gen_plan_build(10, 1000, GEN_PLAN_MAX_SETS + 1, MIN_INTERVAL, &plan));
+}
+
+/* 20 devices every second on 4 sets: 5 per set, one event every 200 ms */
+static void test_exact(void)
+{
+    gen_plan_t plan;
+
+    CHECK(0 == gen_plan_build(20, 1000, 4, MIN_INTERVAL, &plan));
+    CHECK(4 == plan.sets);
+    for (int i = 0; i < 4; i++) {
+        CHECK(5 == plan.set[i].devices);
+        /* 195 ms configured, the controller adds 5 ms on average */
+        CHECK(312 == plan.set[i].interval);
+        CHECK(200000 == plan.set[i].period_us);
+    }
+    CHECK(20000 == plan.target_mpps);
+    CHECK(20000 == plan.planned_mpps);
+    CHECK(0 == plan.error_permille);
+    CHECK(!plan.clamped);
+}
+
+/* Fewer devices than sets: one set per device */
+static void test_few_devices(void)
+{
+    gen_plan_t plan;
+
+    CHECK(0 == gen_plan_build(3, 100, 8, MIN_INTERVAL, &plan));
+    CHECK(3 == plan.sets);
+    for (int i = 0; i < 3; i++) {
+        CHECK(1 == plan.set[i].devices);
+        CHECK(152 == plan.set[i].interval);    /* 95 ms */
+    }
+    CHECK(0 == plan.set[3].devices && 0 == plan.set[3].interval);
+}
+
+/* Rate above what the sets reach: the closest plan and -ERANGE */
+static void test_clamped(void)
+{
+    gen_plan_t plan;
+
+    CHECK(-ERANGE == gen_plan_build(1000, 1000, 4, MIN_INTERVAL, &plan));
+    CHECK(plan.clamped);
+    for (int i = 0; i < 4; i++) {
+        CHECK(250 == plan.set[i].devices);
+        CHECK(MIN_INTERVAL == plan.set[i].interval);
+        CHECK(25000 == plan.set[i].period_us);
+    }
+    CHECK(1000000 == plan.target_mpps);
+    CHECK(160000 == plan.planned_mpps);
+    CHECK(840 == plan.error_permille);
+}
+
+/* Any request: all devices planned, the split even, each set within half
+ * an interval unit of its spacing unless clamped */
+static void test_sweep(void)
+{
+    int plans = 0, clamped = 0, max_error = 0;
+
+    for (uint16_t devices = 1; devices <= 300; devices += 7) {
+        for (uint16_t interval_ms = 20; interval_ms <= 10000; interval_ms = interval_ms * 3 / 2) {
+            for (uint8_t max_sets = 1; max_sets <= GEN_PLAN_MAX_SETS; max_sets++) {
+                gen_plan_t plan;
+                uint32_t total = 0, planned = 0;
+                int rc = gen_plan_build(devices, interval_ms, max_sets, MIN_INTERVAL, &plan);
+
+                plans++;
+                CHECK(plan.sets == ((devices < max_sets) ? devices : max_sets));
+                CHECK((rc == -ERANGE) == plan.clamped && (rc == 0 || rc == -ERANGE));
+                clamped += plan.clamped;
+                for (uint8_t i = 0; i < plan.sets; i++) {
+                    const gen_plan_set_t *set = &plan.set[i];
+                    uint32_t spacing_us = (interval_ms * 1000u + set->devices / 2) / set->devices;
+                    int32_t off = (int32_t)set->period_us - (int32_t)spacing_us;
+
+                    total += set->devices;
+                    CHECK(set->devices == plan.set[0].devices || set->devices + 1 == plan.set[0].devices);
+                    CHECK(set->interval >= MIN_INTERVAL);
+                    CHECK(set->period_us == set->interval * GEN_INTERVAL_UNIT_US + GEN_ADV_DELAY_MEAN_US);
+                    if (set->interval > MIN_INTERVAL) {
+                        CHECK_MSG(off >= -GEN_INTERVAL_UNIT_US / 2 && off <= GEN_INTERVAL_UNIT_US / 2,
+                                  "%u devices every %u ms: period %u for spacing %u", set->devices,
+                                  interval_ms, set->period_us, spacing_us);
+                    } else {
+                        CHECK(off >= -GEN_INTERVAL_UNIT_US / 2);
+                    }
+                    planned += (uint32_t)((1000000000ull + set->period_us / 2) / set->period_us);
+                }
+                CHECK(total == devices);
+                CHECK(planned == plan.planned_mpps);
+                if (!plan.clamped && plan.error_permille > max_error) {
+                    max_error = plan.error_permille;
+                }
+            }
+        }
+    }
+    printf("%d plans, %d clamped, largest error of the others %d permille\n", plans, clamped,
+           max_error);
+}
+
+static void test_events(void)
+{
+    gen_plan_set_t set = { .devices = 5, .interval = 312, .period_us = 200000 };
+    gen_plan_set_t idle = { 0 };
+
+    CHECK(5 == gen_plan_events(&set, 1000));
+    CHECK(5 == gen_plan_events(&set, 1199));
+    CHECK(1 == gen_plan_events(&set, 0));
+    CHECK(1 == gen_plan_events(&idle, 1000));
+    CHECK(1 == gen_plan_events(NULL, 1000));
+    set.period_us = 25000;
+    CHECK(UINT16_MAX == gen_plan_events(&set, 2000000));
+}
+
+int main(void)
+{
+    test_arguments();
+    test_exact();
+    test_few_devices();
+    test_clamped();
+    test_sweep();
+    test_events();
+    return CHECK_RESULT();
+}
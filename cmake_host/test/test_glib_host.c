@@ -0,0 +1,72 @@
+/**
+ * @file test_glib_host.c
+ * @brief GLIB on the host display stub
+ *
+ * Checks that the host build draws into the real DMD frame buffer, which
+ * the GLIB tests and benchmarks read back.
+ */
+
+#include "check.h"
+#include "glib.h"
+#include "sl_memlcd.h"
+
+#include <string.h>
+
+#define ROW_BYTES   (128 / 8)
+
+/* Memory LCD frame buffer: 1 bit per pixel, LSB first, 0 = black */
+static int pixel_black(const uint8_t *fb, int x, int y)
+{
+    return !(fb[y * ROW_BYTES + x / 8] & (1u << (x % 8)));
+}
+
+int main(void)
+{
+    GLIB_Context_t ctx;
+    DMD_DisplayGeometry *geo;
+    uint8_t *fb;
+
+    CHECK(DMD_OK == DMD_init(0));
+    CHECK(DMD_OK == DMD_getDisplayGeometry(&geo));
+    CHECK(128 == geo->xSize && 128 == geo->ySize);
+    CHECK(DMD_OK == DMD_getFrameBuffer((void **)&fb));
+
+    CHECK(GLIB_OK == GLIB_contextInit(&ctx));
+    ctx.backgroundColor = White;
+    ctx.foregroundColor = Black;
+    CHECK(GLIB_OK == GLIB_clear(&ctx));
+    for (int i = 0; i < 128 * ROW_BYTES; i++) {
+        CHECK_MSG(0xFF == fb[i], "byte %d", i);
+    }
+
+    CHECK(GLIB_OK == GLIB_drawPixel(&ctx, 3, 5));
+    CHECK(pixel_black(fb, 3, 5));
+    CHECK(!pixel_black(fb, 4, 5));
+
+    /* A character sets pixels in its cell only */
+    CHECK(GLIB_OK == GLIB_clear(&ctx));
+    GLIB_setFont(&ctx, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+    CHECK(GLIB_OK == GLIB_drawChar(&ctx, 'A', 10, 20, false));
+    int inside = 0;
+    int outside = 0;
+    for (int y = 0; y < 128; y++) {
+        for (int x = 0; x < 128; x++) {
+            if (pixel_black(fb, x, y)) {
+                if (x >= 10 && x < 16 && y >= 20 && y < 28) {
+                    inside++;
+                } else {
+                    outside++;
+                }
+            }
+        }
+    }
+    CHECK(inside > 0);
+    CHECK(0 == outside);
+
+    /* An update sends the dirty rows */
+    sl_memlcd_init();
+    CHECK(DMD_OK == DMD_updateDisplay());
+    CHECK(sl_memlcd_host_rows_drawn() > 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,277 @@
+/**
+ * @file test_glib_line.c
+ * @brief GLIB lines against the per-pixel Bresenham they replaced
+ *
+ * GLIB_drawLine() draws a general line as runs along its major axis. Every
+ * line, random and as rays from a centre in all octants, is checked pixel
+ * by pixel against the Cohen-Sutherland clip and per-pixel Bresenham of the
+ * original routine, in clipping regions at and away from the origin. A
+ * pixel drawn after each line checks the driver clipping area is back to
+ * the clipping region.
+ */
+
+#include "check.h"
+#include "glib.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define SIZE        128
+#define ROW_BYTES   (SIZE / 8)
+#define LINES       20000
+
+static uint8_t *fb;
+static bool model[SIZE][SIZE];
+static uint32_t rnd_state = 12345;
+
+static uint32_t rnd(uint32_t n)
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return (rnd_state >> 8) % n;
+}
+
+static int32_t rnd_range(int32_t lo, int32_t hi)
+{
+    return lo + (int32_t)rnd((uint32_t)(hi - lo + 1));
+}
+
+/* Memory LCD frame buffer: 1 bit per pixel, LSB first, 0 = black */
+static int pixel_black(int x, int y)
+{
+    return !(fb[y * ROW_BYTES + x / 8] & (1u << (x % 8)));
+}
+
+static bool inside(const GLIB_Rectangle_t *r, int32_t x, int32_t y)
+{
+    return x >= r->xMin && x <= r->xMax && y >= r->yMin && y <= r->yMax;
+}
+
+/* Reference: the clip and line of the original routine, one pixel at a time */
+
+static int clip_code(const GLIB_Rectangle_t *r, int32_t x, int32_t y)
+{
+    return (x < r->xMin) | (x > r->xMax) << 1 | (y > r->yMax) << 2 | (y < r->yMin) << 3;
+}
+
+static bool ref_clip(const GLIB_Rectangle_t *r, int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2)
+{
+    int code1 = clip_code(r, *x1, *y1);
+    int code2 = clip_code(r, *x2, *y2);
+
+    while (true) {
+        int32_t x, y;
+        int code;
+
+        if ((code1 | code2) == 0) {
+            return true;
+        }
+        if (code1 & code2) {
+            return false;
+        }
+        code = code1 ? code1 : code2;
+        if (code & 1) {
+            x = r->xMin;
+            y = *y1 + ((*y2 - *y1) * (r->xMin - *x1)) / (*x2 - *x1);
+        } else if (code & 2) {
+            x = r->xMax;
+            y = *y1 + ((*y2 - *y1) * (r->xMax - *x1)) / (*x2 - *x1);
+        } else if (code & 4) {
+            y = r->yMax;
+            x = *x1 + ((*x2 - *x1) * (r->yMax - *y1)) / (*y2 - *y1);
+        } else {
+            y = r->yMin;
+            x = *x1 + ((*x2 - *x1) * (r->yMin - *y1)) / (*y2 - *y1);
+        }
+        if (code1) {
+            *x1 = x;
+            *y1 = y;
+            code1 = clip_code(r, x, y);
+        } else {
+            *x2 = x;
+            *y2 = y;
+            code2 = clip_code(r, x, y);
+        }
+    }
+}
+
+static void model_set(const GLIB_Rectangle_t *r, int32_t x, int32_t y)
+{
+    if (inside(r, x, y)) {
+        model[y][x] = true;
+    }
+}
+
+static EMSTATUS ref_line(const GLIB_Rectangle_t *r, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t t, dx, dy, error, step;
+    bool steep;
+
+    /* Vertical and horizontal lines: the coordinate in the region, the
+     * ends clamped to it */
+    if (x1 == x2 || y1 == y2) {
+        bool vertical = (x1 == x2);
+        int32_t at = vertical ? x1 : y1;
+        int32_t a = vertical ? y1 : x1, b = vertical ? y2 : x2;
+        int32_t lo = vertical ? r->yMin : r->xMin, hi = vertical ? r->yMax : r->xMax;
+
+        if (at < (vertical ? r->xMin : r->yMin) || at > (vertical ? r->xMax : r->yMax)) {
+            return GLIB_ERROR_NOTHING_TO_DRAW;
+        }
+        if (a > b) {
+            t = a; a = b; b = t;
+        }
+        if (a > hi || b < lo) {
+            return GLIB_ERROR_NOTHING_TO_DRAW;
+        }
+        for (int32_t i = (a < lo ? lo : a); i <= (b > hi ? hi : b); i++) {
+            model_set(r, vertical ? at : i, vertical ? i : at);
+        }
+        return GLIB_OK;
+    }
+
+    if (!ref_clip(r, &x1, &y1, &x2, &y2)) {
+        return GLIB_ERROR_NOTHING_TO_DRAW;
+    }
+    steep = (y2 > y1 ? y2 - y1 : y1 - y2) > (x2 > x1 ? x2 - x1 : x1 - x2);
+    if (steep) {
+        t = x1; x1 = y1; y1 = t;
+        t = x2; x2 = y2; y2 = t;
+    }
+    if (x2 < x1) {
+        t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+    }
+    dx = x2 - x1;
+    dy = y2 > y1 ? y2 - y1 : y1 - y2;
+    error = -dx / 2;
+    step = (y2 < y1) ? -1 : 1;
+    for (; x1 <= x2; x1++) {
+        if (steep) {
+            model_set(r, y1, x1);
+        } else {
+            model_set(r, x1, y1);
+        }
+        error += dy;
+        if (error > 0) {
+            y1 += step;
+            error -= dx;
+        }
+    }
+    return GLIB_OK;
+}
+
+/* Number of pixels where the frame buffer and the model differ */
+static int diff_model(void)
+{
+    int diff = 0;
+
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            diff += (pixel_black(x, y) != model[y][x]);
+        }
+    }
+    return diff;
+}
+
+static const GLIB_Rectangle_t regions[] = {
+    { 0, 0, 127, 127 },
+    { 0, 0, 59, 89 },
+    { 10, 20, 109, 110 },
+    { 37, 5, 41, 122 },     /* Narrow: long clipped runs of steep lines */
+    { 3, 60, 126, 64 },
+};
+
+static int lines, pixels, mismatched;
+
+static void check_line(GLIB_Context_t *ctx, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const GLIB_Rectangle_t *r = &ctx->clippingRegion;
+    EMSTATUS expected, got;
+    int32_t px, py;
+
+    memset(model, 0, sizeof(model));
+    memset(fb, 0xFF, SIZE * ROW_BYTES);
+    expected = ref_line(r, x1, y1, x2, y2);
+    got = GLIB_drawLine(ctx, x1, y1, x2, y2);
+
+    /* A pixel after the line lands where it should */
+    px = rnd_range(r->xMin, r->xMax);
+    py = rnd_range(r->yMin, r->yMax);
+    model[py][px] = true;
+    CHECK(GLIB_OK == GLIB_drawPixel(ctx, px, py));
+
+    lines++;
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            pixels += model[y][x];
+        }
+    }
+    if (expected != got || diff_model() != 0) {
+        if (mismatched++ < 5) {
+            printf("line (%d,%d)-(%d,%d) in (%d,%d)-(%d,%d): status %x, expected %x, %d pixels differ\n",
+                   (int)x1, (int)y1, (int)x2, (int)y2, (int)r->xMin, (int)r->yMin,
+                   (int)r->xMax, (int)r->yMax, (unsigned)got, (unsigned)expected, diff_model());
+        }
+    }
+}
+
+static void test_lines(GLIB_Context_t *ctx)
+{
+    for (size_t g = 0; g < sizeof(regions) / sizeof(regions[0]); g++) {
+        const GLIB_Rectangle_t *r = &regions[g];
+        int32_t cx = (r->xMin + r->xMax) / 2, cy = (r->yMin + r->yMax) / 2;
+
+        CHECK(GLIB_OK == GLIB_setClippingRegion(ctx, r));
+
+        /* Rays from the centre of the region, every octant and both ends first */
+        for (int32_t i = -150; i <= 150; i += 3) {
+            check_line(ctx, cx, cy, cx + i, cy - 150);
+            check_line(ctx, cx, cy, cx + i, cy + 150);
+            check_line(ctx, cx - 150, cy + i, cx, cy);
+            check_line(ctx, cx + 150, cy + i, cx, cy);
+            check_line(ctx, cx, cy, cx + i / 10, cy + i / 3);
+        }
+
+        /* Random lines, on and off the display */
+        for (int i = 0; i < LINES; i++) {
+            int32_t x1 = rnd_range(-60, 190), y1 = rnd_range(-60, 190);
+            int32_t x2 = rnd_range(-60, 190), y2 = rnd_range(-60, 190);
+
+            switch (i % 4) {
+                case 0:             /* Nearly vertical */
+                    x2 = x1 + rnd_range(-3, 3);
+                    break;
+                case 1:             /* Nearly horizontal */
+                    y2 = y1 + rnd_range(-3, 3);
+                    break;
+                case 2:             /* Short, near the region */
+                    x1 = rnd_range(r->xMin - 8, r->xMax + 8);
+                    y1 = rnd_range(r->yMin - 8, r->yMax + 8);
+                    x2 = x1 + rnd_range(-12, 12);
+                    y2 = y1 + rnd_range(-12, 12);
+                    break;
+                default:
+                    break;
+            }
+            check_line(ctx, x1, y1, x2, y2);
+        }
+    }
+    printf("%d lines in %d clipping regions, %d pixels, %d mismatched\n", lines,
+           (int)(sizeof(regions) / sizeof(regions[0])), pixels, mismatched);
+    CHECK(0 == mismatched);
+}
+
+int main(void)
+{
+    GLIB_Context_t ctx;
+
+    CHECK(DMD_OK == DMD_init(0));
+    CHECK(DMD_OK == DMD_getFrameBuffer((void **)&fb));
+    CHECK(GLIB_OK == GLIB_contextInit(&ctx));
+    ctx.backgroundColor = White;
+    ctx.foregroundColor = Black;
+
+    CHECK(GLIB_ERROR_INVALID_ARGUMENT == GLIB_drawLine(NULL, 0, 0, 5, 7));
+    test_lines(&ctx);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,213 @@
+/**
+ * @file test_glib_polygon.c
+ * @brief GLIB filled polygons against an exact scan line reference
+ *
+ * GLIB_drawPolygonFilled() steps the crossings of a sorted edge table in
+ * fixed point. Random convex, star shaped and self-intersecting polygons,
+ * partly off the display, are checked pixel by pixel against the rows and
+ * crossing rule of the original routine, with every crossing computed
+ * exactly in integers, rounded towards zero and sorted, in clipping
+ * regions at and away from the origin.
+ */
+
+#include "check.h"
+#include "glib.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define SIZE        128
+#define ROW_BYTES   (SIZE / 8)
+#define MAX_POINTS  64
+#define POLYGONS    6000
+
+static uint8_t *fb;
+static bool model[SIZE][SIZE];
+static uint32_t rnd_state = 12345;
+
+static int32_t rnd_range(int32_t lo, int32_t hi)
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return lo + (int32_t)((rnd_state >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+/* Memory LCD frame buffer: 1 bit per pixel, LSB first, 0 = black */
+static int pixel_black(int x, int y)
+{
+    return !(fb[y * ROW_BYTES + x / 8] & (1u << (x % 8)));
+}
+
+/*
+ * Reference: rows from the top point to the row above the bottom one, in
+ * the region. An edge crosses row y if one end is above it and the other
+ * on or below it; the pairs of sorted crossings are filled as
+ * GLIB_drawLineH() does.
+ */
+static void ref_fill(const GLIB_Rectangle_t *r, uint32_t n, const int32_t *p)
+{
+    int32_t min_y = p[1], max_y = p[1];
+    int32_t cx[MAX_POINTS];
+
+    for (uint32_t i = 1; i < n; i++) {
+        min_y = (p[2 * i + 1] < min_y) ? p[2 * i + 1] : min_y;
+        max_y = (p[2 * i + 1] > max_y) ? p[2 * i + 1] : max_y;
+    }
+    min_y = (min_y < r->yMin) ? r->yMin : min_y;
+    max_y = (max_y > r->yMax) ? r->yMax : max_y;
+
+    for (int32_t y = min_y; y < max_y; y++) {
+        int k = 0;
+
+        for (uint32_t i = 0, j = n - 1; i < n; j = i++) {
+            int64_t xa = p[2 * i], ya = p[2 * i + 1], xb = p[2 * j], yb = p[2 * j + 1];
+
+            if ((ya < y && yb >= y) || (yb < y && ya >= y)) {
+                int64_t num = xa * (yb - ya) + (y - ya) * (xb - xa), den = yb - ya;
+
+                if (den < 0) {
+                    num = -num;
+                    den = -den;
+                }
+                cx[k++] = (int32_t)(num / den);
+            }
+        }
+        for (int a = 1; a < k; a++) {
+            for (int b = a; b > 0 && cx[b - 1] > cx[b]; b--) {
+                int32_t t = cx[b];
+                cx[b] = cx[b - 1];
+                cx[b - 1] = t;
+            }
+        }
+        for (int a = 0; a + 1 < k; a += 2) {
+            int32_t x1 = (cx[a] < r->xMin) ? r->xMin : cx[a];
+            int32_t x2 = (cx[a + 1] > r->xMax) ? r->xMax : cx[a + 1];
+
+            for (int32_t x = x1; x <= x2; x++) {
+                model[y][x] = true;
+            }
+        }
+    }
+}
+
+/* Convex: points on an ellipse in angle order. Star: alternating radii.
+ * Random: any order, so mostly self-intersecting. */
+static uint32_t make_polygon(int kind, int32_t *p)
+{
+    uint32_t n;
+
+    if (kind == 0) {
+        int32_t cx = rnd_range(-20, 148), cy = rnd_range(-20, 148);
+        int32_t rx = rnd_range(1, 90), ry = rnd_range(1, 90);
+        double a0 = rnd_range(0, 628) / 100.0;
+
+        n = (uint32_t)rnd_range(3, 24);
+        for (uint32_t i = 0; i < n; i++) {
+            double a = a0 + 6.2831853 * i / n;
+            p[2 * i] = cx + (int32_t)(rx * cos(a));
+            p[2 * i + 1] = cy + (int32_t)(ry * sin(a));
+        }
+    } else if (kind == 1) {
+        int32_t cx = rnd_range(0, 128), cy = rnd_range(0, 128), ro = rnd_range(10, 90);
+
+        n = 2 * (uint32_t)rnd_range(3, 16);
+        for (uint32_t i = 0; i < n; i++) {
+            double a = 6.2831853 * i / n;
+            int32_t rr = (i & 1) ? rnd_range(1, ro) : ro;
+
+            p[2 * i] = cx + (int32_t)(rr * cos(a));
+            p[2 * i + 1] = cy + (int32_t)(rr * sin(a));
+        }
+    } else {
+        n = (uint32_t)rnd_range(3, MAX_POINTS);
+        for (uint32_t i = 0; i < n; i++) {
+            p[2 * i] = rnd_range(-60, 188);
+            p[2 * i + 1] = rnd_range(-60, 188);
+        }
+    }
+    return n;
+}
+
+static const GLIB_Rectangle_t regions[] = {
+    { 0, 0, 127, 127 },
+    { 0, 0, 59, 89 },
+    { 10, 20, 109, 110 },
+    { 50, 50, 51, 80 },
+};
+
+static void test_polygons(GLIB_Context_t *ctx)
+{
+    static const char *const kinds[] = { "convex", "star", "random" };
+    int32_t p[2 * MAX_POINTS];
+    int mismatched[3] = { 0 }, count[3] = { 0 };
+    long pixels = 0;
+
+    for (size_t g = 0; g < sizeof(regions) / sizeof(regions[0]); g++) {
+        const GLIB_Rectangle_t *r = &regions[g];
+
+        CHECK(GLIB_OK == GLIB_setClippingRegion(ctx, r));
+        for (int i = 0; i < POLYGONS; i++) {
+            int kind = i % 3;
+            uint32_t n = make_polygon(kind, p);
+            int32_t px = rnd_range(r->xMin, r->xMax), py = rnd_range(r->yMin, r->yMax);
+            int diff = 0;
+
+            memset(model, 0, sizeof(model));
+            memset(fb, 0xFF, SIZE * ROW_BYTES);
+            ref_fill(r, n, p);
+            CHECK(GLIB_OK == GLIB_drawPolygonFilled(ctx, n, p));
+
+            /* A pixel after the fill lands where it should */
+            model[py][px] = true;
+            CHECK(GLIB_OK == GLIB_drawPixel(ctx, px, py));
+
+            for (int y = 0; y < SIZE; y++) {
+                for (int x = 0; x < SIZE; x++) {
+                    diff += (pixel_black(x, y) != model[y][x]);
+                    pixels += model[y][x];
+                }
+            }
+            count[kind]++;
+            if (diff != 0 && mismatched[kind]++ < 3) {
+                printf("%s polygon of %u points in (%d,%d)-(%d,%d): %d pixels differ\n ",
+                       kinds[kind], (unsigned)n, (int)r->xMin, (int)r->yMin,
+                       (int)r->xMax, (int)r->yMax, diff);
+                for (uint32_t q = 0; q < n; q++) {
+                    printf(" (%d,%d)", (int)p[2 * q], (int)p[2 * q + 1]);
+                }
+                printf("\n");
+            }
+        }
+    }
+    for (int k = 0; k < 3; k++) {
+        printf("%s: %d polygons, %d mismatched\n", kinds[k], count[k], mismatched[k]);
+        CHECK(0 == mismatched[k]);
+    }
+    printf("%ld pixels filled\n", pixels);
+}
+
+static void test_arguments(GLIB_Context_t *ctx)
+{
+    int32_t p[2 * (MAX_POINTS + 1)] = { 0 };
+
+    CHECK(GLIB_ERROR_INVALID_ARGUMENT == GLIB_drawPolygonFilled(NULL, 3, p));
+    CHECK(GLIB_ERROR_INVALID_ARGUMENT == GLIB_drawPolygonFilled(ctx, 3, NULL));
+    CHECK(GLIB_ERROR_INVALID_ARGUMENT == GLIB_drawPolygonFilled(ctx, 1, p));
+    CHECK(GLIB_ERROR_INVALID_ARGUMENT == GLIB_drawPolygonFilled(ctx, MAX_POINTS + 1, p));
+    CHECK(GLIB_OK == GLIB_drawPolygonFilled(ctx, MAX_POINTS, p));
+}
+
+int main(void)
+{
+    GLIB_Context_t ctx;
+
+    CHECK(DMD_OK == DMD_init(0));
+    CHECK(DMD_OK == DMD_getFrameBuffer((void **)&fb));
+    CHECK(GLIB_OK == GLIB_contextInit(&ctx));
+    ctx.backgroundColor = White;
+    ctx.foregroundColor = Black;
+
+    test_arguments(&ctx);
+    test_polygons(&ctx);
+    return CHECK_RESULT();
+}
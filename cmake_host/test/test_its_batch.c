@@ -0,0 +1,308 @@
+/**
+ * @file test_its_batch.c
+ * @brief PSA ITS batch writes under power cuts, on NVM3 in RAM
+ *
+ * The ITS V3 driver on the real NVM3. A batch overwrites some files and
+ * creates others, with power cut at every word write and page erase of it,
+ * also in the repack done ahead of a batch on nearly full flash. After the
+ * reboot every file of the batch must read back whole, old or new, the new
+ * ones a prefix of the batch, and the batch must then go through again.
+ */
+
+#include "check.h"
+#include "nvm3_default.h"
+#include "nvm3_hal_ram.h"
+#include "psa/internal_trusted_storage.h"
+#include "psa/sli_internal_trusted_storage.h"
+
+#include <string.h>
+
+#define BATCH           6
+#define BYSTANDERS      3
+#define MAX_DATA        200
+#define UID_BASE        0xBA7C0000ULL
+#define FILLER_KEY      0x1000u     /* Application objects outside the ITS range */
+#define FILLER_KEYS     40
+#define FILLER_SIZE     240
+
+/* Statics of sl_psa_its_nvm3.c, exposed by SLI_STATIC_TESTABLE */
+extern bool nvm3_uid_set_cache_initialized;
+extern uint32_t nvm3_uid_set_cache[];
+extern uint32_t nvm3_uid_tomb_cache[];
+
+/* Page erases done when the batch writes its first file, if it has */
+static bool batch_writing;
+static uint32_t erases_at_first_write;
+
+sl_status_t __real_nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value,
+                                  size_t len);
+
+sl_status_t __wrap_nvm3_writeData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, const void *value,
+                                  size_t len)
+{
+    if (batch_writing) {
+        batch_writing = false;
+        erases_at_first_write = nvm3_ram_erases;
+    }
+    return __real_nvm3_writeData(h, key, value, len);
+}
+
+static uint8_t old_data[BATCH][MAX_DATA];
+static uint8_t new_data[BATCH][MAX_DATA];
+static uint32_t old_len[BATCH];
+static sli_psa_its_batch_entry_t batch[BATCH];
+
+/*
+ * RAM comes up zero on a real boot, so the next ITS call opens NVM3 and
+ * rebuilds the caches from it.
+ */
+static void reboot(void)
+{
+    nvm3_ram_power_on();
+    if (nvm3_defaultHandle->hasBeenOpened) {
+        nvm3_deinitDefault();
+    }
+    nvm3_uid_set_cache_initialized = false;
+    memset(nvm3_uid_set_cache, 0, (SL_PSA_ITS_MAX_FILES + 31) / 32 * sizeof(uint32_t));
+    memset(nvm3_uid_tomb_cache, 0, (SL_PSA_ITS_MAX_FILES + 31) / 32 * sizeof(uint32_t));
+}
+
+/* The even entries overwrite files, the odd ones create them */
+static void build_batch(void)
+{
+    for (int i = 0; i < BATCH; i++) {
+        uint32_t len = 8 + (uint32_t)i * 37;
+
+        old_len[i] = (i % 2 == 0) ? len / 2 + 3 : 0;
+        for (uint32_t b = 0; b < MAX_DATA; b++) {
+            old_data[i][b] = (uint8_t)(0x40 + i * 7 + b);
+            new_data[i][b] = (uint8_t)(0x90 + i * 11 + b * 3);
+        }
+        batch[i].uid = UID_BASE + (uint64_t)i * 0x10001u;
+        batch[i].data_length = len;
+        batch[i].p_data = new_data[i];
+        batch[i].create_flags = PSA_STORAGE_FLAG_NONE;
+    }
+}
+
+/* NVM3 space of the batch: ITS metadata, data and NVM3 object header */
+static size_t batch_size(void)
+{
+    size_t size = 0;
+
+    for (int i = 0; i < BATCH; i++) {
+        size += ((16 + batch[i].data_length + 3) & ~3u) + 8;
+    }
+    return size;
+}
+
+static psa_storage_uid_t bystander_uid(int i)
+{
+    return UID_BASE + 0x100 + (psa_storage_uid_t)i;
+}
+
+/*
+ * Empty flash with the old files and a few others. With low_space, NVM3 is
+ * then filled with stale copies of application objects until it asks for a
+ * repack, and the batch does not fit without one.
+ */
+static void setup(bool low_space)
+{
+    uint8_t filler[FILLER_SIZE];
+
+    nvm3_ram_format();
+    reboot();
+    for (int i = 0; i < BATCH; i++) {
+        if (old_len[i] != 0) {
+            CHECK(PSA_SUCCESS == psa_its_set(batch[i].uid, old_len[i], old_data[i],
+                                             PSA_STORAGE_FLAG_NONE));
+        }
+    }
+    for (int i = 0; i < BYSTANDERS; i++) {
+        CHECK(PSA_SUCCESS == psa_its_set(bystander_uid(i), 4, "byst", PSA_STORAGE_FLAG_NONE));
+    }
+    if (low_space) {
+        nvm3_MemInfo_t info;
+        uint32_t n = 0;
+
+        memset(filler, 0x5A, sizeof(filler));
+        do {
+            filler[0] = (uint8_t)n;
+            CHECK(SL_STATUS_OK == nvm3_writeData(nvm3_defaultHandle, FILLER_KEY + n % FILLER_KEYS,
+                                                 filler, sizeof(filler)));
+            CHECK(SL_STATUS_OK == nvm3_getMemInfo(nvm3_defaultHandle, &info));
+            n++;
+        } while (!nvm3_repackNeeded(nvm3_defaultHandle));
+        CHECK(info.availableMemory < batch_size());
+    }
+}
+
+/* Whether a file reads back as exactly the given content, or is absent */
+static bool file_is(psa_storage_uid_t uid, const uint8_t *data, uint32_t len)
+{
+    uint8_t buf[MAX_DATA];
+    size_t got = 0;
+    psa_status_t st = psa_its_get(uid, 0, MAX_DATA, buf, &got);
+
+    if (len == 0) {
+        return st == PSA_ERROR_DOES_NOT_EXIST;
+    }
+    return st == PSA_SUCCESS && got == len && 0 == memcmp(buf, data, len);
+}
+
+/* Word writes and page erases of the whole batch */
+static uint32_t batch_ops(bool low_space)
+{
+    uint32_t before;
+
+    setup(low_space);
+    before = nvm3_ram_writes + nvm3_ram_erases;
+    CHECK(PSA_SUCCESS == sli_psa_its_set_batch(batch, BATCH));
+    return nvm3_ram_writes + nvm3_ram_erases - before;
+}
+
+static void test_power_cuts(bool low_space)
+{
+    uint32_t ops = batch_ops(low_space);
+    uint32_t torn = 0, out_of_order = 0, lost = 0, failed_retry = 0;
+    uint32_t prefix_count[BATCH + 1] = { 0 };
+
+    for (uint32_t cut = 0; cut <= ops; cut++) {
+        psa_status_t st;
+        int prefix = 0;
+        bool ended = false;
+
+        setup(low_space);
+        nvm3_ram_cut_power_after(cut);
+        st = sli_psa_its_set_batch(batch, BATCH);
+        CHECK(nvm3_ram_power_lost() == (cut < ops));
+        CHECK((cut < ops) || PSA_SUCCESS == st);
+        reboot();
+
+        for (int i = 0; i < BATCH; i++) {
+            bool is_new = file_is(batch[i].uid, new_data[i], batch[i].data_length);
+            bool is_old = file_is(batch[i].uid, old_data[i], old_len[i]);
+
+            if (!is_new && !is_old) {
+                torn++;
+            }
+            if (is_new && !ended) {
+                prefix++;
+            } else if (is_new) {
+                out_of_order++;
+            } else {
+                ended = true;
+            }
+        }
+        prefix_count[prefix]++;
+        for (int i = 0; i < BYSTANDERS; i++) {
+            lost += !file_is(bystander_uid(i), (const uint8_t *)"byst", 4);
+        }
+
+        /* Recovery: the whole batch again */
+        if (PSA_SUCCESS != sli_psa_its_set_batch(batch, BATCH)) {
+            failed_retry++;
+            continue;
+        }
+        reboot();
+        for (int i = 0; i < BATCH; i++) {
+            failed_retry += !file_is(batch[i].uid, new_data[i], batch[i].data_length);
+        }
+    }
+
+    printf("%s: %u power cuts, %u torn, %u out of order, %u bystanders lost, %u failed retries\n",
+           low_space ? "low space" : "free space", ops + 1, torn, out_of_order, lost, failed_retry);
+    printf("  files of the batch written:");
+    for (int k = 0; k <= BATCH; k++) {
+        printf(" %u", prefix_count[k]);
+    }
+    printf("\n");
+    CHECK(0 == torn);
+    CHECK(0 == out_of_order);
+    CHECK(0 == lost);
+    CHECK(0 == failed_retry);
+    /* Every cut left the batch somewhere, the last one none */
+    CHECK(prefix_count[BATCH] >= 1);
+}
+
+/* On nearly full flash, the repack is done before the first write */
+static void test_repack_ahead(void)
+{
+    uint32_t erases;
+
+    setup(true);
+    erases = nvm3_ram_erases;
+    batch_writing = true;
+    CHECK(PSA_SUCCESS == sli_psa_its_set_batch(batch, BATCH));
+    batch_writing = false;
+    printf("repack ahead: %u page erases before the first write, %u during the writes\n",
+           erases_at_first_write - erases, nvm3_ram_erases - erases_at_first_write);
+    CHECK(erases_at_first_write > erases);
+    CHECK(nvm3_ram_erases == erases_at_first_write);
+}
+
+/* A batch that fails its checks writes nothing */
+static void test_rejected(void)
+{
+    sli_psa_its_batch_entry_t bad[BATCH];
+    uint32_t writes;
+
+    setup(false);
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE + 0x200, 4, "once", PSA_STORAGE_FLAG_WRITE_ONCE));
+    writes = nvm3_ram_writes;
+
+    /* Write-once file last */
+    memcpy(bad, batch, sizeof(bad));
+    bad[BATCH - 1].uid = UID_BASE + 0x200;
+    CHECK(PSA_ERROR_NOT_PERMITTED == sli_psa_its_set_batch(bad, BATCH));
+
+    /* Same UID twice */
+    memcpy(bad, batch, sizeof(bad));
+    bad[BATCH - 1].uid = bad[0].uid;
+    CHECK(PSA_ERROR_INVALID_ARGUMENT == sli_psa_its_set_batch(bad, BATCH));
+
+    /* Data missing, unknown flag */
+    memcpy(bad, batch, sizeof(bad));
+    bad[2].p_data = NULL;
+    CHECK(PSA_ERROR_INVALID_ARGUMENT == sli_psa_its_set_batch(bad, BATCH));
+    memcpy(bad, batch, sizeof(bad));
+    bad[3].create_flags = 0x80;
+    CHECK(PSA_ERROR_NOT_SUPPORTED == sli_psa_its_set_batch(bad, BATCH));
+
+    CHECK(writes == nvm3_ram_writes);
+    for (int i = 0; i < BATCH; i++) {
+        CHECK(file_is(batch[i].uid, old_data[i], old_len[i]));
+    }
+    CHECK(PSA_SUCCESS == sli_psa_its_set_batch(batch, 0));
+    CHECK(PSA_ERROR_INVALID_ARGUMENT == sli_psa_its_set_batch(NULL, 1));
+}
+
+/* More new files than free ITS files: nothing written */
+static void test_full(void)
+{
+    uint32_t files = 1 + BATCH / 2 + BYSTANDERS;    /* 0x200 and the old files */
+    uint32_t writes;
+
+    setup(false);
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE + 0x200, 4, "once", PSA_STORAGE_FLAG_WRITE_ONCE));
+    for (uint32_t n = 0; files < SL_PSA_ITS_MAX_FILES - 1; n++, files++) {
+        CHECK(PSA_SUCCESS == psa_its_set(0xF0000000ULL + n, 0, NULL, PSA_STORAGE_FLAG_NONE));
+    }
+    writes = nvm3_ram_writes;
+    CHECK(PSA_ERROR_INSUFFICIENT_STORAGE == sli_psa_its_set_batch(batch, BATCH));
+    CHECK(writes == nvm3_ram_writes);
+    for (int i = 0; i < BATCH; i++) {
+        CHECK(file_is(batch[i].uid, old_data[i], old_len[i]));
+    }
+}
+
+int main(void)
+{
+    build_batch();
+    test_rejected();
+    test_full();
+    test_repack_ahead();
+    test_power_cuts(false);
+    test_power_cuts(true);
+    return CHECK_RESULT();
+}
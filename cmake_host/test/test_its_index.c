@@ -0,0 +1,330 @@
+/**
+ * @file test_its_index.c
+ * @brief PSA ITS UID index against the range scan, on NVM3 in RAM
+ *
+ * The ITS V2 driver on the real NVM3. Random set, remove and get of UIDs
+ * from a pool with bucket and tag collisions and write-once files. Every
+ * lookup through the index must give the same result as the original scan
+ * of the range, and both the same as a model of the files, also after a
+ * reboot rebuilt the index from what NVM3 holds.
+ */
+
+#include "check.h"
+#include "nvm3_default.h"
+#include "nvm3_hal_ram.h"
+#include "psa/internal_trusted_storage.h"
+#include "psa/sli_internal_trusted_storage.h"
+
+#include <string.h>
+
+#define RANGE_START     SLI_PSA_ITS_NVM3_RANGE_BASE
+#define POOL            1200
+#define COLLIDING       12
+#define STEPS           20000
+#define REBOOT_EVERY    2500
+#define ANCHOR_UID      0xA5C4011DULL   /* Never removed: resets the last lookup */
+#define MAX_DATA        32
+
+/* Statics of sl_psa_its_nvm3.c, exposed by SLI_STATIC_TESTABLE */
+extern bool nvm3_uid_set_cache_initialized;
+extern bool nvm3_uid_index_complete;
+extern uint16_t nvm3_uid_index_head[SL_PSA_ITS_MAX_FILES];
+extern uint16_t nvm3_uid_index_next[SL_PSA_ITS_MAX_FILES];
+
+/* Metadata and data reads of ITS files */
+static uint32_t partial_reads;
+
+sl_status_t __real_nvm3_readPartialData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value,
+                                        size_t ofs, size_t len);
+
+sl_status_t __wrap_nvm3_readPartialData(nvm3_Handle_t *h, nvm3_ObjectKey_t key, void *value,
+                                        size_t ofs, size_t len)
+{
+    partial_reads++;
+    return __real_nvm3_readPartialData(h, key, value, ofs, len);
+}
+
+typedef struct {
+    psa_storage_uid_t uid;
+    bool stored;
+    bool write_once;
+    uint8_t len;
+    uint8_t version;
+} file_t;
+
+static file_t pool[POOL];
+static uint32_t stored;
+
+static uint64_t rnd_state = 7;
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32_t)(rnd_state >> 33);
+}
+
+/* The index hash of sl_psa_its_nvm3.c */
+static uint32_t uid_hash(psa_storage_uid_t uid)
+{
+    uint64_t h = uid;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+static void file_data(const file_t *f, uint8_t *buf)
+{
+    for (uint8_t i = 0; i < f->len && i < MAX_DATA; i++) {
+        buf[i] = (uint8_t)(f->uid * 31u + f->version * 7u + i);
+    }
+}
+
+/* The next ITS call opens NVM3 and builds the index again */
+static void reboot(void)
+{
+    if (nvm3_defaultHandle->hasBeenOpened) {
+        CHECK(SL_STATUS_OK == nvm3_deinitDefault());
+    }
+    nvm3_uid_set_cache_initialized = false;
+}
+
+/* Empty flash and a fresh boot, with only the anchor file */
+static void its_format(void)
+{
+    struct psa_storage_info_t info;
+
+    nvm3_ram_format();
+    reboot();
+    stored = 0;
+    CHECK(PSA_SUCCESS == psa_its_set(ANCHOR_UID, 4, "anch", PSA_STORAGE_FLAG_NONE));
+    CHECK(PSA_SUCCESS == psa_its_get_info(ANCHOR_UID, &info));
+}
+
+/* Every indexed file is in the chain of its UID's bucket, once */
+static bool index_consistent(void)
+{
+    uint32_t linked = 0;
+
+    for (uint32_t b = 0; b < SL_PSA_ITS_MAX_FILES; b++) {
+        for (uint16_t i = nvm3_uid_index_head[b]; i != 0xFFFFu; i = nvm3_uid_index_next[i]) {
+            if (++linked > SL_PSA_ITS_MAX_FILES) {
+                return false;           /* Loop */
+            }
+        }
+    }
+    return linked == stored + 1;        /* And the anchor */
+}
+
+/* get_info of one UID by the index or by the scan; reads counted */
+static psa_status_t lookup(psa_storage_uid_t uid, bool scan, struct psa_storage_info_t *info,
+                           uint32_t *reads)
+{
+    struct psa_storage_info_t anchor;
+    psa_status_t st;
+
+    CHECK(PSA_SUCCESS == psa_its_get_info(ANCHOR_UID, &anchor));
+    nvm3_uid_index_complete = !scan;
+    partial_reads = 0;
+    st = psa_its_get_info(uid, info);
+    *reads = partial_reads;
+    nvm3_uid_index_complete = true;
+    return st;
+}
+
+static void build_pool(void)
+{
+    uint32_t tag_bucket = uid_hash(0x1000) % SL_PSA_ITS_MAX_FILES | (uid_hash(0x1000) >> 24) << 16;
+    uint32_t n = 0;
+
+    memset(pool, 0, sizeof(pool));
+    /* Persistent key IDs are small and sequential */
+    for (; n < POOL / 2; n++) {
+        pool[n].uid = 0x1000 + n;
+    }
+    /* Same bucket and tag as key 0x1000: every lookup reads all of them */
+    for (uint64_t u = 1ULL << 40; n < POOL / 2 + COLLIDING; u++) {
+        uint32_t h = uid_hash(u);
+        if ((h % SL_PSA_ITS_MAX_FILES | (h >> 24) << 16) == tag_bucket) {
+            pool[n++].uid = u;
+        }
+    }
+    for (; n < POOL; n++) {
+        pool[n].uid = ((uint64_t)rnd() << 32 | rnd()) | 1ULL << 63;
+    }
+}
+
+static void test_random_workload(void)
+{
+    uint32_t mismatches = 0, gets = 0;
+    uint64_t index_reads = 0, scan_reads = 0;
+    uint8_t buf[MAX_DATA], out[MAX_DATA];
+
+    build_pool();
+    its_format();
+
+    for (uint32_t step = 1; step <= STEPS; step++) {
+        uint32_t r = rnd();
+        file_t *f = &pool[(r & 7) ? rnd() % POOL : POOL / 2 + rnd() % COLLIDING];
+        uint32_t op = (r >> 8) % 10;
+
+        if (op < 5) {
+            file_t next = *f;
+            psa_storage_create_flags_t flags = (0 == rnd() % 20) ? PSA_STORAGE_FLAG_WRITE_ONCE
+                                               : PSA_STORAGE_FLAG_NONE;
+            psa_status_t expect = PSA_SUCCESS;
+
+            next.len = (uint8_t)(1 + rnd() % MAX_DATA);
+            next.version++;
+            file_data(&next, buf);
+            if (f->stored && f->write_once) {
+                expect = PSA_ERROR_NOT_PERMITTED;
+            } else if (!f->stored && stored + 1 == SL_PSA_ITS_MAX_FILES) {
+                expect = PSA_ERROR_INSUFFICIENT_STORAGE;
+            }
+            CHECK(expect == psa_its_set(f->uid, next.len, buf, flags));
+            if (PSA_SUCCESS == expect) {
+                stored += !f->stored;
+                *f = next;
+                f->stored = true;
+                f->write_once = (PSA_STORAGE_FLAG_WRITE_ONCE == flags);
+            }
+        } else if (op < 7) {
+            psa_status_t expect = !f->stored ? PSA_ERROR_DOES_NOT_EXIST
+                                  : f->write_once ? PSA_ERROR_NOT_PERMITTED : PSA_SUCCESS;
+
+            CHECK(expect == psa_its_remove(f->uid));
+            if (PSA_SUCCESS == expect) {
+                f->stored = false;
+                stored--;
+            }
+        } else if (f->uid != ANCHOR_UID) {
+            struct psa_storage_info_t by_index = { 0 }, by_scan = { 0 };
+            uint32_t ir, sr;
+            psa_status_t si = lookup(f->uid, false, &by_index, &ir);
+            psa_status_t ss = lookup(f->uid, true, &by_scan, &sr);
+            size_t n = 0;
+            bool ok = (si == ss && by_index.size == by_scan.size && by_index.flags == by_scan.flags);
+
+            if (f->stored) {
+                file_data(f, buf);
+                ok = ok && PSA_SUCCESS == si && f->len == by_index.size
+                     && (f->write_once ? PSA_STORAGE_FLAG_WRITE_ONCE : PSA_STORAGE_FLAG_NONE)
+                     == by_index.flags;
+                ok = ok && PSA_SUCCESS == psa_its_get(f->uid, 0, f->len, out, &n)
+                     && n == f->len && 0 == memcmp(out, buf, n);
+            } else {
+                ok = ok && PSA_ERROR_DOES_NOT_EXIST == si;
+            }
+            if (!ok && mismatches++ < 5) {
+                printf("step %u uid 0x%llx: index %d, scan %d\n",
+                       step, (unsigned long long)f->uid, (int)si, (int)ss);
+            }
+            gets++;
+            index_reads += ir;
+            scan_reads += sr;
+        }
+
+        if (0 == step % REBOOT_EVERY) {
+            CHECK(index_consistent());
+            reboot();
+        }
+    }
+    CHECK(index_consistent());
+
+    printf("%u lookups, %u mismatches; reads per get_info: index %.2f, scan %.2f\n",
+           gets, mismatches, (double)index_reads / gets, (double)scan_reads / gets);
+    CHECK(0 == mismatches);
+    CHECK(gets > STEPS / 4);
+    CHECK(nvm3_uid_index_complete);
+}
+
+/* A full range: one metadata read to find a file, none for a missing one */
+static void test_full_range(void)
+{
+    uint32_t reads, index_reads = 0, scan_reads = 0, miss_reads = 0;
+    struct psa_storage_info_t info;
+
+    its_format();
+    for (uint32_t i = 1; i < SL_PSA_ITS_MAX_FILES; i++) {
+        uint32_t v = i;
+        CHECK(PSA_SUCCESS == psa_its_set(0x2000 + i, sizeof(v), &v, PSA_STORAGE_FLAG_NONE));
+    }
+    CHECK(PSA_ERROR_INSUFFICIENT_STORAGE
+          == psa_its_set(0x1FFF, 4, "full", PSA_STORAGE_FLAG_NONE));
+    reboot();
+
+    for (uint32_t i = 1; i < SL_PSA_ITS_MAX_FILES; i++) {
+        CHECK(PSA_SUCCESS == lookup(0x2000 + i, false, &info, &reads));
+        index_reads += reads;
+        CHECK(PSA_SUCCESS == lookup(0x2000 + i, true, &info, &reads));
+        scan_reads += reads;
+        CHECK(PSA_ERROR_DOES_NOT_EXIST == lookup(0x10000 + i, false, &info, &reads));
+        miss_reads += reads;
+    }
+    /* Less get_info's own read of the file */
+    double per_index = (double)index_reads / (SL_PSA_ITS_MAX_FILES - 1) - 1.0;
+    double per_scan = (double)scan_reads / (SL_PSA_ITS_MAX_FILES - 1) - 1.0;
+    double per_miss = (double)miss_reads / (SL_PSA_ITS_MAX_FILES - 1);
+
+    printf("full range: metadata reads per lookup, index %.3f, scan %.1f, missing UID %.3f\n",
+           per_index, per_scan, per_miss);
+    CHECK(per_index < 1.05);
+    CHECK(per_miss < 0.05);
+    CHECK(per_scan > 100.0);
+}
+
+/* Foreign objects in the range: deleted at boot, or the index falls back to the scan */
+static void test_foreign_objects(void)
+{
+    /* Header of the v1 format, padded to 24 bytes */
+    struct {
+        struct {
+            uint32_t magic;
+            psa_storage_uid_t uid;
+            psa_storage_create_flags_t flags;
+        } meta;
+        uint8_t data[4];
+    } v1 = { { SLI_PSA_ITS_META_MAGIC_V1, 0x3001, PSA_STORAGE_FLAG_NONE }, { 1, 2, 3, 4 } };
+    struct psa_storage_info_t info;
+    uint32_t junk = 0x12345678, reads;
+
+    its_format();
+    CHECK(PSA_SUCCESS == psa_its_set(0x3000, 4, "data", PSA_STORAGE_FLAG_NONE));
+    /* A file of the v1 format, an object without an ITS header, a counter */
+    CHECK(SL_STATUS_OK == nvm3_writeData(nvm3_defaultHandle, RANGE_START + 10, &v1,
+                                        sizeof(v1.meta) + sizeof(v1.data)));
+    CHECK(SL_STATUS_OK == nvm3_writeData(nvm3_defaultHandle, RANGE_START + 11, &junk, sizeof(junk)));
+    reboot();
+
+    CHECK(PSA_SUCCESS == lookup(0x3001, false, &info, &reads));
+    CHECK(4 == info.size);
+    CHECK(nvm3_uid_index_complete);
+    CHECK(ECODE_NVM3_ERR_KEY_NOT_FOUND
+          == nvm3_readData(nvm3_defaultHandle, RANGE_START + 11, &junk, sizeof(junk)));
+
+    CHECK(SL_STATUS_OK == nvm3_writeCounter(nvm3_defaultHandle, RANGE_START + 12, 5));
+    reboot();
+    CHECK(PSA_SUCCESS == psa_its_get_info(0x3000, &info));
+    CHECK(!nvm3_uid_index_complete);
+    CHECK(PSA_SUCCESS == psa_its_get_info(0x3001, &info));
+    CHECK(PSA_ERROR_DOES_NOT_EXIST == psa_its_get_info(0x3002, &info));
+    /* Still indexed on the way, so a fixed range can use it again */
+    CHECK(PSA_SUCCESS == psa_its_set(0x3003, 4, "more", PSA_STORAGE_FLAG_NONE));
+    CHECK(PSA_SUCCESS == psa_its_remove(0x3000));
+    CHECK(PSA_ERROR_DOES_NOT_EXIST == psa_its_get_info(0x3000, &info));
+    CHECK(SL_STATUS_OK == nvm3_deleteObject(nvm3_defaultHandle, RANGE_START + 12));
+    reboot();
+    CHECK(PSA_SUCCESS == psa_its_get_info(0x3003, &info));
+    CHECK(nvm3_uid_index_complete);
+    CHECK(PSA_SUCCESS == lookup(0x3001, false, &info, &reads));
+}
+
+int main(void)
+{
+    test_random_workload();
+    test_full_range();
+    test_foreign_objects();
+    return CHECK_RESULT();
+}
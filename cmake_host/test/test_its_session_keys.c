@@ -0,0 +1,398 @@
+/**
+ * @file test_its_session_keys.c
+ * @brief LRU cache of the session keys of encrypted PSA ITS files
+ *
+ * The ITS V2 driver with SLI_PSA_ITS_ENCRYPTED on the real NVM3, and the
+ * host stand-in for the crypto drivers (mock/psa_crypto_host.c). Random
+ * set, get and remove of a few files must read back what was written, with
+ * the hits, misses and key derivations of a model LRU. Keys leaving the
+ * cache must be gone from it, not only marked inactive.
+ */
+
+#include "check.h"
+#include "nvm3_default.h"
+#include "nvm3_hal_ram.h"
+#include "psa_crypto_host.h"
+#include "psa/internal_trusted_storage.h"
+#include "psa/sli_internal_trusted_storage.h"
+
+#include <string.h>
+
+#define CACHE_SIZE      4       /* SL_PSA_ITS_SESSION_KEY_CACHE_SIZE default */
+#define IV_SIZE         12
+#define KEY_SIZE        16
+#define FILES           7
+#define UID_BASE        0x5E550000ULL
+#define STEPS           20000
+#define REBOOT_EVERY    3000
+#define MAX_DATA        40
+#define META_SIZE       16      /* sli_its_file_meta_v2_t */
+
+/* session_key_t of sl_psa_its_nvm3.c */
+typedef struct {
+    bool active;
+    psa_storage_uid_t uid;
+    uint32_t last_use;
+    uint8_t iv[IV_SIZE];
+    uint8_t data[KEY_SIZE];
+} session_key_t;
+
+/* Statics of sl_psa_its_nvm3.c, exposed by SLI_STATIC_TESTABLE */
+extern bool nvm3_uid_set_cache_initialized;
+extern session_key_t g_cached_session_keys[CACHE_SIZE];
+extern uint32_t session_key_cache_hits;
+extern uint32_t session_key_cache_misses;
+
+static uint8_t root_key[32];
+
+/* Model of the files and of the cache */
+typedef struct {
+    bool stored;
+    uint8_t len;
+    uint8_t version;
+} file_t;
+
+typedef struct {
+    bool active;
+    psa_storage_uid_t uid;
+    uint32_t last_use;
+} lru_entry_t;
+
+static file_t files[FILES];
+static lru_entry_t lru[CACHE_SIZE];
+static uint32_t lru_clock;
+
+static uint64_t rnd_state = 11;
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32_t)(rnd_state >> 33);
+}
+
+static void file_data(psa_storage_uid_t uid, const file_t *f, uint8_t *buf)
+{
+    for (uint8_t i = 0; i < f->len && i < MAX_DATA; i++) {
+        buf[i] = (uint8_t)(uid * 13u + f->version * 5u + i);
+    }
+}
+
+/* The next ITS call opens NVM3 again; the cache is RAM and survives */
+static void reboot(void)
+{
+    if (nvm3_defaultHandle->hasBeenOpened) {
+        CHECK(SL_STATUS_OK == nvm3_deinitDefault());
+    }
+    nvm3_uid_set_cache_initialized = false;
+}
+
+static void its_format(void)
+{
+    nvm3_ram_format();
+    reboot();
+    sli_psa_its_flush_session_keys();
+    memset(files, 0, sizeof(files));
+    memset(lru, 0, sizeof(lru));
+}
+
+static bool all_zero(const void *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (((const uint8_t *)p)[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The cache entry of a UID */
+static session_key_t *entry_of(psa_storage_uid_t uid)
+{
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (g_cached_session_keys[i].active && g_cached_session_keys[i].uid == uid) {
+            return &g_cached_session_keys[i];
+        }
+    }
+    return NULL;
+}
+
+/* Whether a key is anywhere in the cache memory */
+static bool key_in_cache(const uint8_t *key)
+{
+    const uint8_t *mem = (const uint8_t *)g_cached_session_keys;
+
+    for (size_t i = 0; i + KEY_SIZE <= sizeof(g_cached_session_keys); i++) {
+        if (0 == memcmp(&mem[i], key, KEY_SIZE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Model: the entry of a UID is taken over, else a free one, else the LRU */
+static void lru_insert(psa_storage_uid_t uid)
+{
+    lru_entry_t *e = NULL;
+
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (lru[i].active && lru[i].uid == uid) {
+            e = &lru[i];
+            break;
+        }
+        if (e == NULL || (e->active && (!lru[i].active || lru[i].last_use < e->last_use))) {
+            e = &lru[i];
+        }
+    }
+    e->active = true;
+    e->uid = uid;
+    e->last_use = ++lru_clock;
+}
+
+static bool lru_get(psa_storage_uid_t uid)
+{
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (lru[i].active && lru[i].uid == uid) {
+            lru[i].last_use = ++lru_clock;
+            return true;
+        }
+    }
+    lru_insert(uid);
+    return false;
+}
+
+static void lru_drop(psa_storage_uid_t uid)
+{
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (lru[i].active && lru[i].uid == uid) {
+            lru[i].active = false;
+        }
+    }
+}
+
+static void model_lookup(psa_storage_uid_t uid, uint32_t *hits, uint32_t *misses)
+{
+    if (lru_get(uid)) {
+        (*hits)++;
+    } else {
+        (*misses)++;
+    }
+}
+
+/* Every cached key is the derivation of its IV, for a UID the model has */
+static uint32_t cache_mismatches(void)
+{
+    uint32_t bad = 0;
+    uint32_t mac_calls = psa_crypto_host_mac_calls;
+
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        const session_key_t *k = &g_cached_session_keys[i];
+        bool modelled = false;
+        uint8_t key[KEY_SIZE];
+        size_t len;
+
+        for (int j = 0; j < CACHE_SIZE; j++) {
+            modelled |= lru[j].active && lru[j].uid == k->uid;
+        }
+        if (!k->active) {
+            bad += !all_zero(k, sizeof(*k));
+            continue;
+        }
+        psa_driver_wrapper_mac_compute(NULL, root_key, sizeof(root_key), PSA_ALG_CMAC,
+                                       k->iv, IV_SIZE, key, sizeof(key), &len);
+        bad += !modelled || 0 != memcmp(key, k->data, KEY_SIZE);
+    }
+    psa_crypto_host_mac_calls = mac_calls;
+    return bad;
+}
+
+/* Random workload against the model */
+static void test_random_workload(void)
+{
+    uint32_t mismatches = 0, gets = 0, sets = 0;
+    uint32_t model_hits = 0, model_misses = 0;
+    uint32_t mac_start, hit_start, miss_start;
+
+    its_format();
+    mac_start = psa_crypto_host_mac_calls;
+    hit_start = session_key_cache_hits;
+    miss_start = session_key_cache_misses;
+
+    for (uint32_t step = 1; step <= STEPS; step++) {
+        /* Skewed towards the first files, as keys in use are */
+        uint32_t n = rnd() % FILES;
+        uint32_t idx = (rnd() & 1) ? n % 3 : n;
+        psa_storage_uid_t uid = UID_BASE + idx;
+        file_t *f = &files[idx];
+        uint32_t op = rnd() % 100;
+
+        if (op < 20) {
+            uint8_t buf[MAX_DATA];
+
+            /* An existing file is authenticated before it is overwritten */
+            if (f->stored) {
+                model_lookup(uid, &model_hits, &model_misses);
+            }
+            f->len = (uint8_t)(rnd() % (MAX_DATA + 1));
+            f->version++;
+            file_data(uid, f, buf);
+            CHECK(PSA_SUCCESS == psa_its_set(uid, f->len, buf, PSA_STORAGE_FLAG_NONE));
+            f->stored = true;
+            lru_insert(uid);
+            sets++;
+        } else if (op < 27) {
+            /* And before it is removed */
+            if (f->stored) {
+                model_lookup(uid, &model_hits, &model_misses);
+            }
+            CHECK((f->stored ? PSA_SUCCESS : PSA_ERROR_DOES_NOT_EXIST) == psa_its_remove(uid));
+            f->stored = false;
+            lru_drop(uid);
+        } else {
+            uint8_t buf[MAX_DATA], want[MAX_DATA];
+            size_t len = 0;
+            psa_status_t st = psa_its_get(uid, 0, MAX_DATA, buf, &len);
+
+            if (!f->stored) {
+                mismatches += (st != PSA_ERROR_DOES_NOT_EXIST);
+                continue;
+            }
+            file_data(uid, f, want);
+            mismatches += (st != PSA_SUCCESS || len != f->len || 0 != memcmp(buf, want, len));
+            model_lookup(uid, &model_hits, &model_misses);
+            gets++;
+        }
+
+        if (step % REBOOT_EVERY == 0) {
+            reboot();
+        }
+        if (step % 97 == 0) {
+            mismatches += cache_mismatches();
+        }
+    }
+
+    printf("%u gets, %u sets, %u mismatches; hits %u (model %u), misses %u (model %u), "
+           "key derivations %u\n",
+           gets, sets, mismatches,
+           session_key_cache_hits - hit_start, model_hits,
+           session_key_cache_misses - miss_start, model_misses,
+           psa_crypto_host_mac_calls - mac_start);
+    CHECK(0 == mismatches);
+    CHECK(session_key_cache_hits - hit_start == model_hits);
+    CHECK(session_key_cache_misses - miss_start == model_misses);
+    CHECK(psa_crypto_host_mac_calls - mac_start == sets + model_misses);
+}
+
+/* Derivations of reading files in turn from a cold cache */
+static uint32_t derivations_in_turn(uint32_t n_files, uint32_t reads)
+{
+    uint8_t buf[4] = { 1, 2, 3, 4 };
+    uint32_t mac_start;
+    size_t len;
+
+    its_format();
+    for (uint32_t i = 0; i < n_files; i++) {
+        CHECK(PSA_SUCCESS == psa_its_set(UID_BASE + i, sizeof(buf), buf, PSA_STORAGE_FLAG_NONE));
+    }
+    sli_psa_its_flush_session_keys();
+    mac_start = psa_crypto_host_mac_calls;
+    for (uint32_t r = 0; r < reads; r++) {
+        CHECK(PSA_SUCCESS == psa_its_get(UID_BASE + r % n_files, 0, sizeof(buf), buf, &len));
+    }
+    return psa_crypto_host_mac_calls - mac_start;
+}
+
+static void test_access_patterns(void)
+{
+    uint32_t two = derivations_in_turn(2, 2000);
+    uint32_t four = derivations_in_turn(CACHE_SIZE, 2000);
+    uint32_t five = derivations_in_turn(CACHE_SIZE + 1, 2000);
+
+    printf("key derivations over 2000 reads: 2 files %u, %u files %u, %u files %u\n",
+           two, CACHE_SIZE, four, CACHE_SIZE + 1, five);
+    CHECK(2 == two);
+    CHECK(CACHE_SIZE == four);
+    CHECK(2000 == five);                /* Cycling one more file than the LRU holds */
+}
+
+/* Raw NVM3 object of a file */
+static nvm3_ObjectKey_t object_of(psa_storage_uid_t uid)
+{
+    for (nvm3_ObjectKey_t key = SLI_PSA_ITS_NVM3_RANGE_BASE;
+         key < SLI_PSA_ITS_NVM3_RANGE_BASE + SL_PSA_ITS_MAX_FILES; key++) {
+        uint8_t meta[META_SIZE];
+        psa_storage_uid_t stored_uid;
+
+        if (SL_STATUS_OK == nvm3_readPartialData(nvm3_defaultHandle, key, meta, 0, sizeof(meta))) {
+            memcpy(&stored_uid, &meta[8], sizeof(stored_uid));
+            if (stored_uid == uid) {
+                return key;
+            }
+        }
+    }
+    return 0;
+}
+
+static void test_zeroization(void)
+{
+    uint8_t old_obj[META_SIZE + IV_SIZE + 4 + KEY_SIZE];
+    uint8_t buf[4], key[KEY_SIZE];
+    session_key_t *e;
+    nvm3_ObjectKey_t obj;
+    size_t len;
+
+    /* A removed file's key is gone */
+    its_format();
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE, 4, "abcd", PSA_STORAGE_FLAG_NONE));
+    e = entry_of(UID_BASE);
+    CHECK(NULL != e);
+    memcpy(key, e->data, KEY_SIZE);
+    CHECK(PSA_SUCCESS == psa_its_remove(UID_BASE));
+    CHECK(!key_in_cache(key));
+    CHECK(all_zero(g_cached_session_keys, sizeof(g_cached_session_keys)));
+
+    /* An evicted key is overwritten */
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE, 4, "abcd", PSA_STORAGE_FLAG_NONE));
+    memcpy(key, entry_of(UID_BASE)->data, KEY_SIZE);
+    for (uint32_t i = 1; i <= CACHE_SIZE; i++) {
+        CHECK(PSA_SUCCESS == psa_its_set(UID_BASE + i, 4, "efgh", PSA_STORAGE_FLAG_NONE));
+    }
+    CHECK(NULL == entry_of(UID_BASE) && !key_in_cache(key));
+    CHECK(PSA_SUCCESS == psa_its_get(UID_BASE, 0, 4, buf, &len) && 0 == memcmp(buf, "abcd", 4));
+
+    /* A rewritten file's old key is overwritten in place */
+    e = entry_of(UID_BASE);
+    CHECK(NULL != e);
+    memcpy(key, e->data, KEY_SIZE);
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE, 4, "ijkl", PSA_STORAGE_FLAG_NONE));
+    CHECK(e == entry_of(UID_BASE) && !key_in_cache(key));
+
+    /* Flushing clears everything */
+    sli_psa_its_flush_session_keys();
+    CHECK(all_zero(g_cached_session_keys, sizeof(g_cached_session_keys)));
+    CHECK(PSA_SUCCESS == psa_its_get(UID_BASE, 0, 4, buf, &len) && 0 == memcmp(buf, "ijkl", 4));
+
+    /*
+     * An older copy of a file comes back (a restored backup): the cached key
+     * of the newer IV must not be used for it.
+     */
+    obj = object_of(UID_BASE);
+    CHECK(0 != obj);
+    CHECK(SL_STATUS_OK == nvm3_readData(nvm3_defaultHandle, obj, old_obj, sizeof(old_obj)));
+    CHECK(PSA_SUCCESS == psa_its_set(UID_BASE, 4, "mnop", PSA_STORAGE_FLAG_NONE));
+    CHECK(PSA_SUCCESS == psa_its_get(UID_BASE, 0, 4, buf, &len) && 0 == memcmp(buf, "mnop", 4));
+    CHECK(SL_STATUS_OK == nvm3_writeData(nvm3_defaultHandle, obj, old_obj, sizeof(old_obj)));
+    CHECK(PSA_SUCCESS == psa_its_get(UID_BASE, 0, 4, buf, &len) && 0 == memcmp(buf, "ijkl", 4));
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(root_key); i++) {
+        root_key[i] = (uint8_t)(0xC3 ^ i * 17);
+    }
+    CHECK(PSA_SUCCESS == sli_psa_its_set_root_key(root_key, sizeof(root_key)));
+
+    test_zeroization();
+    test_access_patterns();
+    test_random_workload();
+    return CHECK_RESULT();
+}
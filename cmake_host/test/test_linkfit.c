@@ -0,0 +1,244 @@
+/**
+ * @file test_linkfit.c
+ * @brief Single precision link fit against a double precision reference
+ *
+ * Synthetic tx power sweeps over random path loss, sensitivity and PER
+ * slope, three rounds of 250 packets per level with 1.5 dB RSSI noise.
+ * The reference maximises the same penalised likelihood in double
+ * precision until the step vanishes; the fitter has a fixed iteration
+ * count and single precision, and must land on the same curve.
+ */
+
+#include "check.h"
+#include "linkfit.h"
+
+#include <errno.h>
+#include <math.h>
+
+#define SWEEPS          2000
+#define ROUNDS          3
+#define PACKETS         250
+
+/* Objective of linkfit.c */
+#define RIDGE           0.5
+#define RIDGE_B0        1e-3
+
+static const int8_t tx_levels[] = { -40, -20, -16, -12, -8, -4, 0, 2, 3, 4, 5, 6, 7, 8, 10 };
+
+static uint64_t rnd_state;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 6364136223846793005ull + 1442695040888963407ull;
+    return ((double)(rnd_state >> 11) + 1.0) / 9007199254740994.0;
+}
+
+static double gauss(void)
+{
+    double u = uniform();
+    double v = uniform();
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+static double logit(double p)
+{
+    return log(p / (1.0 - p));
+}
+
+static double loglik(const linkfit_t *fit, double x_off, double b0, double b1)
+{
+    double ll = -0.5 * (RIDGE_B0 * b0 * b0 + RIDGE * b1 * b1);
+
+    for (int i = 0; i < fit->n; i++) {
+        double eta = b0 + b1 * (fit->pt[i].tx_dbm - x_off);
+        double sp = (eta > 0.0) ? eta + log1p(exp(-eta)) : log1p(exp(eta));
+        ll += (double)(fit->pt[i].exp - fit->pt[i].rcv) * eta - (double)fit->pt[i].exp * sp;
+    }
+    return ll;
+}
+
+typedef struct {
+    double path_loss;
+    double rssi_ref;
+    double b0;
+    double b1;
+} ref_fit_t;
+
+/* Damped Newton in double precision until converged */
+static void reference(const linkfit_t *fit, ref_fit_t *ref)
+{
+    double pl = 0.0, n = 0.0, xs = 0.0, lost = 0.0, total = 0.0;
+
+    for (int i = 0; i < fit->n; i++) {
+        pl += (double)fit->pt[i].tx_dbm * fit->pt[i].rssi_n - fit->pt[i].rssi_sum;
+        n += fit->pt[i].rssi_n;
+        lost += fit->pt[i].exp - fit->pt[i].rcv;
+        total += fit->pt[i].exp;
+    }
+    ref->path_loss = pl / n;
+    for (int i = 0; i < fit->n; i++) {
+        xs += fit->pt[i].tx_dbm - ref->path_loss;
+    }
+    ref->rssi_ref = xs / fit->n;
+
+    double x_off = ref->path_loss + ref->rssi_ref;
+    double b0 = logit(fmin(fmax(lost / total, 0.01), 0.99));
+    double b1 = 0.0;
+    double ll = loglik(fit, x_off, b0, b1);
+
+    for (int it = 0; it < 500; it++) {
+        double h00 = RIDGE_B0, h01 = 0.0, h11 = RIDGE;
+        double g0 = -RIDGE_B0 * b0, g1 = -RIDGE * b1;
+
+        for (int i = 0; i < fit->n; i++) {
+            double x = fit->pt[i].tx_dbm - x_off;
+            double p = 1.0 / (1.0 + exp(-(b0 + b1 * x)));
+            double w = fit->pt[i].exp * p * (1.0 - p);
+            double r = (double)(fit->pt[i].exp - fit->pt[i].rcv) - fit->pt[i].exp * p;
+            g0 += r;
+            g1 += r * x;
+            h00 += w;
+            h01 += w * x;
+            h11 += w * x * x;
+        }
+        double det = h00 * h11 - h01 * h01;
+        double d0 = (h11 * g0 - h01 * g1) / det;
+        double d1 = (h00 * g1 - h01 * g0) / det;
+        double ll_new;
+
+        while ((ll_new = loglik(fit, x_off, b0 + d0, b1 + d1)) < ll) {
+            d0 *= 0.5;
+            d1 *= 0.5;
+        }
+        b0 += d0;
+        b1 += d1;
+        ll = ll_new;
+        if (fabs(d0) < 1e-12 && fabs(d1) < 1e-12) {
+            break;
+        }
+    }
+    ref->b0 = b0;
+    ref->b1 = b1;
+}
+
+static double ref_rssi_at(const ref_fit_t *ref, double per)
+{
+    return ref->rssi_ref + (logit(per) - ref->b0) / ref->b1;
+}
+
+/* Random sweeps: the float fit matches the converged double fit */
+static void test_against_reference(void)
+{
+    double worst_pl = 0.0, worst_sens = 0.0, worst_sens1 = 0.0, worst_true = 0.0;
+    uint32_t failed = 0;
+
+    rnd_state = 1;
+    for (int s = 0; s < SWEEPS; s++) {
+        linkfit_t fit;
+        linkfit_result_t res;
+        ref_fit_t ref;
+        double pl = 60.0 + 40.0 * uniform();
+        double sens = -100.0 + 8.0 * uniform();
+        double slope = -(0.3 + 1.5 * uniform());
+        int lossy = 0;
+
+        linkfit_reset(&fit);
+        for (int r = 0; r < ROUNDS; r++) {
+            for (unsigned i = 0; i < sizeof(tx_levels); i++) {
+                double rssi = tx_levels[i] - pl;
+                double p = 1.0 / (1.0 + exp(-(logit(0.308) + slope * (rssi - sens))));
+                uint16_t lost = 0;
+
+                for (int k = 0; k < PACKETS; k++) {
+                    lost += (uniform() < p);
+                }
+                CHECK(0 == linkfit_add(&fit, tx_levels[i], (int8_t)lrint(rssi + 1.5 * gauss()),
+                                       (uint16_t)(PACKETS - lost), PACKETS));
+            }
+        }
+        for (int i = 0; i < fit.n; i++) {
+            lossy += (fit.pt[i].rcv < fit.pt[i].exp);
+        }
+
+        int err = linkfit_solve(&fit, &res);
+        if (0 != err) {
+            failed++;
+            continue;
+        }
+        reference(&fit, &ref);
+
+        worst_pl = fmax(worst_pl, fabs(res.path_loss_db - ref.path_loss));
+        worst_sens = fmax(worst_sens, fabs(res.sens_dbm[0] - ref_rssi_at(&ref, 0.308)));
+        worst_sens1 = fmax(worst_sens1, fabs(res.sens_dbm[2] - ref_rssi_at(&ref, 0.01)));
+        /* With the loss spread over a few levels the curve itself is pinned down */
+        if (lossy >= 3) {
+            worst_true = fmax(worst_true, fabs(res.sens_dbm[0] - sens));
+        }
+    }
+
+    printf("%u/%u sweeps not fitted; worst |float - double|: path loss %.4f dB, "
+           "30.8%% %.4f dB, 1%% %.4f dB; worst |fit - true| 30.8%% %.2f dB\n",
+           failed, SWEEPS, worst_pl, worst_sens, worst_sens1, worst_true);
+    CHECK(0 == failed);
+    CHECK(worst_pl < 0.01);
+    /* Sensitivities are shown in 0.1 dB */
+    CHECK(worst_sens < 0.1);
+    CHECK(worst_sens1 < 0.1);
+    CHECK(worst_true < 3.0);
+}
+
+/* A single lossy level far below the rest: the fit still converges */
+static void test_single_lossy_level(void)
+{
+    linkfit_t fit;
+    linkfit_result_t res;
+    ref_fit_t ref;
+
+    linkfit_reset(&fit);
+    CHECK(0 == linkfit_add(&fit, -40, -102, 230, 750));
+    for (int8_t tx = -20; tx <= 10; tx += 4) {
+        CHECK(0 == linkfit_add(&fit, tx, (int8_t)(tx - 62), 750, 750));
+    }
+    CHECK(0 == linkfit_solve(&fit, &res));
+    reference(&fit, &ref);
+    CHECK(res.b1 < 0.0f);
+    CHECK(fabs(res.b1 - ref.b1) < 1e-3);
+    CHECK(fabs(res.sens_dbm[0] - ref_rssi_at(&ref, 0.308)) < 0.05);
+}
+
+/* Argument and degenerate input handling */
+static void test_errors(void)
+{
+    linkfit_t fit;
+    linkfit_result_t res;
+
+    linkfit_reset(&fit);
+    CHECK(-EINVAL == linkfit_add(&fit, 0, -60, 10, 0));
+    CHECK(-EINVAL == linkfit_add(&fit, 0, -60, 11, 10));
+    CHECK(-EINVAL == linkfit_solve(NULL, &res));
+
+    CHECK(0 == linkfit_add(&fit, 0, -60, 10, 10));
+    CHECK(0 == linkfit_add(&fit, 4, -56, 10, 10));
+    CHECK(-EAGAIN == linkfit_solve(&fit, &res));
+    CHECK(0 == linkfit_add(&fit, 8, -52, 10, 10));
+    /* No loss at all: no curve to fit */
+    CHECK(-EDOM == linkfit_solve(&fit, &res));
+
+    /* Rounds at the same tx power merge */
+    CHECK(0 == linkfit_add(&fit, 8, -54, 5, 10));
+    CHECK(3 == fit.n && 15 == fit.pt[2].rcv && 20 == fit.pt[2].exp && 2 == fit.pt[2].rssi_n);
+
+    linkfit_reset(&fit);
+    for (int i = 0; i < LINKFIT_MAX_POINTS; i++) {
+        CHECK(0 == linkfit_add(&fit, (int8_t)i, -60, 10, 10));
+    }
+    CHECK(-ENOSPC == linkfit_add(&fit, 100, -60, 10, 10));
+}
+
+int main(void)
+{
+    test_against_reference();
+    test_single_lossy_level();
+    test_errors();
+    return CHECK_RESULT();
+}
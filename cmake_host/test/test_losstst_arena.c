@@ -0,0 +1,196 @@
+/**
+ * @file test_losstst_arena.c
+ * @brief Mode arena hand-over of the loss test service
+ *
+ * Scanner, envmon, numcast and sender share one arena, poisoned with 0xA5
+ * on every claim in this build. The modes are run in turn and each leaves
+ * state behind: a packet trace, a top list of advertisers. After every
+ * hand-over the readers of that state must report nothing of the previous
+ * owner, neither its data nor the poison: the top list, the skip estimate
+ * and the trace of the stored round.
+ */
+
+#include "check.h"
+#include "losstst_svc.h"
+#include "sl_bt_host.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define BURST_RX    10      /* Burst packets heard per PHY */
+#define POISON16    0xA5A5
+
+typedef struct {
+    uint32_t round;
+    uint32_t results;
+    uint32_t traces;        /* Trace entries */
+    losstst_store_result_t rec;
+} round_log_t;
+
+static const bd_addr sender = { { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 } };
+
+/* A burst packet of the given PHY index (0 = 2M, 1 = 1M) */
+static void report_burst(uint8_t idx, int16_t pre_cnt)
+{
+    uint8_t ad[3 + 2 + 16] = { 2, 0x01, 0x06, 17, 0xFF, 0xFF, 0xFF, 0xAB, 0xBA };
+
+    ad[9] = (uint8_t)pre_cnt;
+    ad[10] = (uint8_t)((uint16_t)pre_cnt >> 8);
+    ad[11] = 1;             /* Flow 1 */
+    ad[12] = 0;
+    memcpy(&ad[13], "\xF8\xF9\xFA\xF5\xFC\xFD\xFE\x01", 8);
+    sl_bt_scanner_process_extended_report(&sender, 0, -50, 0, sl_bt_gap_phy_1m,
+                                          (0 == idx) ? sl_bt_gap_phy_2m : sl_bt_gap_phy_1m,
+                                          ad, sizeof(ad));
+}
+
+/* Some other advertiser on 2M */
+static void report_other(uint8_t id)
+{
+    const bd_addr addr = { { id, 0xA0, 0xB0, 0xC0, 0xD0, 0xE0 } };
+    static const uint8_t ad[] = { 2, 0x01, 0x06, 3, 0x03, 0x0F, 0x18 };
+
+    sl_bt_scanner_process_extended_report(&addr, 0, -60, 0, sl_bt_gap_phy_1m, sl_bt_gap_phy_2m,
+                                          ad, sizeof(ad));
+}
+
+static bool on_record(void *ctx, uint8_t type, uint32_t round, const void *data, uint16_t len)
+{
+    round_log_t *log = ctx;
+
+    if (round != log->round) {
+        return true;
+    }
+    if (1 == type && sizeof(log->rec) == len) {
+        memcpy(&log->rec, data, len);
+        log->results++;
+    } else if (2 == type) {
+        log->traces += len / sizeof(losstst_trace_entry_t);
+    }
+    return true;
+}
+
+/* Store the round and read it back */
+static round_log_t store_round(void)
+{
+    round_log_t log = { 0 };
+    int32_t round = losstst_store_round();
+
+    CHECK_MSG(0 < round, "round not stored: %d", (int)round);
+    log.round = (uint32_t)round;
+    CHECK(0 < losstst_store_query(log.round, log.round, on_record, &log));
+    CHECK(1 == log.results);
+    return log;
+}
+
+/* What no mode but the owner may show, on the round stored now */
+static round_log_t check_not_owner(const char *mode, bool scanner, bool envmon)
+{
+    losstst_prio_stats_t prio;
+    topk_item_t top[4];
+    uint32_t total = 1;
+    uint8_t n = losstst_get_env_top(top, 4, &total);
+    round_log_t log = store_round();
+
+    if (!envmon) {
+        CHECK_MSG(0 == n && 0 == total, "%s: top list of %u, %u reports", mode, n, total);
+    }
+    if (!scanner) {
+        CHECK_MSG(0 == log.traces && 0 == log.rec.trace_lost, "%s: round %u with %u traced, %u lost",
+                  mode, log.round, log.traces, log.rec.trace_lost);
+    }
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        CHECK_MSG(POISON16 != log.rec.result[idx].rcv && POISON16 != log.rec.result[idx].exp,
+                  "%s: PHY %u result %u/%u", mode, idx, log.rec.result[idx].rcv,
+                  log.rec.result[idx].exp);
+    }
+    CHECK(0 == losstst_get_prio_stats(&prio));
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        CHECK_MSG(0 == prio.adv_skipped[idx], "%s: set %u skipped %u", mode, idx,
+                  prio.adv_skipped[idx]);
+    }
+    return log;
+}
+
+static void run_scanner(const test_param_t *param, bool bursts)
+{
+    round_log_t log;
+
+    scanner_task_tgr(1);
+    CHECK(0 == scanner_setup(param));
+    CHECK(0 < losstst_scanner());
+    sl_bt_host_run(10);
+    for (int16_t pre_cnt = 250; bursts && pre_cnt > 250 - BURST_RX; pre_cnt--) {
+        report_burst(0, pre_cnt);
+        report_burst(1, pre_cnt);
+        sl_bt_host_run(2);
+    }
+    log = check_not_owner("scanner", true, false);
+    CHECK_MSG((bursts ? 2 * BURST_RX : 0) == log.traces, "scanner: %u traced", log.traces);
+    CHECK((bursts ? BURST_RX : 0) == log.rec.result[1].rcv);
+    scanner_task_tgr(-scanner_task_tgr(0));
+}
+
+static void run_envmon(const test_param_t *param)
+{
+    topk_item_t top[4];
+    uint32_t total;
+
+    envmon_task_tgr(1);
+    CHECK(0 == envmon_setup(param));
+    CHECK(0 == losstst_get_env_top(top, 4, &total) && 0 == total);
+    /* Three advertisers with 6, 4 and 2 reports */
+    for (uint8_t i = 0; i < 6; i++) {
+        for (uint8_t id = 1; id <= 3; id++) {
+            if (i < 8 - 2 * id) {
+                report_other(id);
+            }
+        }
+        sl_bt_host_run(10);
+        CHECK(0 < losstst_envmon());
+    }
+    CHECK(3 == losstst_get_env_top(top, 4, &total) && 12 == total);
+    CHECK(1 == top[0].addr[0] && 6 == top[0].count);
+    CHECK(3 == top[2].addr[0] && 2 == top[2].count);
+    check_not_owner("envmon", false, true);
+    envmon_task_tgr(-envmon_task_tgr(0));
+}
+
+int main(void)
+{
+    test_param_t param = {
+        .interval_idx = 0,
+        .count_idx = 0,
+        .phy_2m = true,
+        .phy_1m = true,
+        .prio_profile = LOSSTST_PRIO_AUTO,
+    };
+
+    CHECK(0 == losstst_init());
+    CHECK(0 == losstst_store_init());
+    /* The timeout handler takes the handle for the set index: create the
+     * four test sets in index order, stopped as the test mode leaves them */
+    for (uint8_t idx = 0; idx <= 3; idx++) {
+        CHECK(0 == update_adv(idx, NULL, NULL, NULL));
+        blocking_adv(idx);
+    }
+
+    run_scanner(&param, true);
+    run_envmon(&param);
+
+    numcst_task_tgr(1);
+    CHECK(0 == numcast_setup(&param));
+    check_not_owner("numcast", false, false);
+    numcst_task_tgr(-numcst_task_tgr(0));
+
+    sender_task_tgr(1);
+    CHECK(0 == sender_setup(&param));
+    check_not_owner("sender", false, false);
+    sender_finit();
+    sender_task_tgr(-sender_task_tgr(0));
+
+    /* Back to the scanner and envmon: nothing of their last run is left */
+    run_scanner(&param, false);
+    run_envmon(&param);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,220 @@
+/**
+ * @file test_losstst_burst.c
+ * @brief Concurrent burst cycles of the loss test sender
+ *
+ * The sender runs on the stand-in stack with all four PHYs bursting in the
+ * same cycle. Every set must send exactly one limited burst of 250 events
+ * per cycle on an interval of its own, the bursts must overlap, and no
+ * other start may carry a limit. A scanner echo of the report shortens the
+ * next countdown, and events lost to pre-emption show in the skip estimate.
+ */
+
+#include "check.h"
+#include "losstst_svc.h"
+#include "sl_bt_host.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SETS        4
+#define CYCLES      2       /* 500 packets per PHY */
+#define BURST       250
+#define PREEMPT_SET 1       /* Loses PREEMPTED events of the last burst */
+#define PREEMPTED   25
+#define SKIP_NOISE  4       /* advDelay spread in the skip estimate (events) */
+
+typedef struct {
+    uint16_t events;            /* Burst events (pre_cnt > 0) */
+    uint64_t first_us;
+    uint64_t last_us;
+    uint32_t interval;
+    int16_t first_pre_cnt;      /* First countdown value on air */
+    bool echoed;
+} flow_log_t;
+
+static flow_log_t flows[CYCLES + 1][SETS];
+static uint32_t bad_limits;     /* Events of a start with the wrong limit */
+static uint32_t wrong_phy;
+static uint32_t bad_flow;
+static uint32_t attempts;
+static uint32_t preempted;
+
+/* Manufacturer data of the test form: man_id, form_id, pre_cnt, flw_cnt */
+static bool read_form(const sl_bt_host_adv_t *adv, int16_t *pre_cnt, uint16_t *flw_cnt)
+{
+    for (size_t i = 0; i + 1 < adv->len; i += adv->data[i] + 1u) {
+        const uint8_t *ad = &adv->data[i];
+
+        if (0xFF == ad[1] && ad[0] >= 9 && 0xFFFF == (ad[2] | ad[3] << 8)
+            && 0xBAAB == (ad[4] | ad[5] << 8)) {
+            *pre_cnt = (int16_t)(ad[6] | ad[7] << 8);
+            *flw_cnt = (uint16_t)(ad[8] | ad[9] << 8);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The scanner answers the report with the same form; device_found() takes
+ * Coded as 3/3 and legacy through the legacy report */
+static void echo(const sl_bt_host_adv_t *adv)
+{
+    static const bd_addr scanner = { { 1, 2, 3, 4, 5, 6 } };
+
+    if (0 == adv->secondary_phy) {
+        sl_bt_scanner_process_legacy_report(&scanner, 0, -40, adv->data, (uint16_t)adv->len);
+    } else {
+        uint8_t prim = (sl_bt_gap_phy_coded == adv->primary_phy) ? 3 : adv->primary_phy;
+        uint8_t sec = (sl_bt_gap_phy_coded == adv->secondary_phy) ? 3 : adv->secondary_phy;
+
+        sl_bt_scanner_process_extended_report(&scanner, 0, -40, 0, prim, sec,
+                                              adv->data, (uint16_t)adv->len);
+    }
+}
+
+/* Every tenth burst event of one set in the last cycle goes to a higher
+ * priority task */
+static bool on_preempt(const sl_bt_host_adv_t *adv)
+{
+    int16_t pre_cnt;
+    uint16_t flw_cnt;
+
+    if (PREEMPT_SET != adv->handle || !read_form(adv, &pre_cnt, &flw_cnt)
+        || CYCLES != flw_cnt || pre_cnt <= 0 || INT16_MAX == pre_cnt) {
+        return false;
+    }
+    if (0 != ++attempts % 10 || PREEMPTED == preempted) {
+        return false;
+    }
+    preempted++;
+    return true;
+}
+
+static void on_adv(const sl_bt_host_adv_t *adv)
+{
+    static const uint8_t primary[SETS] = {
+        sl_bt_gap_phy_1m, sl_bt_gap_phy_1m, sl_bt_gap_phy_coded, sl_bt_gap_phy_1m
+    };
+    static const uint8_t secondary[SETS] = {
+        sl_bt_gap_phy_2m, sl_bt_gap_phy_1m, sl_bt_gap_phy_coded, 0
+    };
+    int16_t pre_cnt;
+    uint16_t flw_cnt;
+    flow_log_t *f;
+
+    if (adv->handle >= SETS || !read_form(adv, &pre_cnt, &flw_cnt)) {
+        return;
+    }
+    if (primary[adv->handle] != adv->primary_phy || secondary[adv->handle] != adv->secondary_phy) {
+        wrong_phy++;
+    }
+    if (INT16_MIN == pre_cnt || INT16_MAX == pre_cnt) {
+        /* Setup and completion forms */
+        bad_limits += (0 != adv->max_events || 0 != adv->duration);
+        return;
+    }
+    if (0 == flw_cnt || flw_cnt > CYCLES) {
+        bad_flow++;
+        return;
+    }
+    f = &flows[flw_cnt][adv->handle];
+    if (pre_cnt > 0) {
+        bad_limits += (BURST != adv->max_events || 0 != adv->duration);
+        if (0 == f->events++) {
+            f->first_us = adv->t_us;
+            f->interval = adv->interval;
+        }
+        f->last_us = adv->t_us;
+        return;
+    }
+    bad_limits += (0 != adv->max_events || 0 != adv->duration);
+    if (pre_cnt < 0 && 0 == f->first_pre_cnt) {
+        f->first_pre_cnt = pre_cnt;
+    }
+    if (0 == pre_cnt && !f->echoed) {
+        f->echoed = true;
+        echo(adv);
+    }
+}
+
+static void on_timeout(uint8_t handle)
+{
+    losstst_adv_sent_handler(handle);
+}
+
+static void test_concurrent_burst(void)
+{
+    static const sl_bt_host_hooks_t hooks = {
+        .adv_preempt = on_preempt, .adv_event = on_adv, .adv_timeout = on_timeout
+    };
+    test_param_t param = {
+        .interval_idx = 0,
+        .count_idx = 0,
+        .phy_2m = true,
+        .phy_1m = true,
+        .phy_s8 = true,
+        .phy_ble4 = true,
+        .concurrent_burst = true,
+        .short_countdown = true,
+        .prio_profile = LOSSTST_PRIO_AUTO,
+    };
+    losstst_prio_stats_t prio;
+    int cycles = 0;
+    int ret;
+
+    sl_bt_host_hooks(&hooks);
+    CHECK(0 == losstst_init());
+    sender_task_tgr(1);
+    CHECK(0 == sender_setup(&param));
+    while ((ret = losstst_sender()) > 0 && cycles < 2 * CYCLES) {
+        cycles++;
+    }
+    CHECK_MSG(0 == ret && CYCLES == cycles, "sender returned %d after %d cycles", ret, cycles);
+    CHECK(0 == wrong_phy);
+    CHECK(0 == bad_flow);
+    CHECK_MSG(0 == bad_limits, "%u events of a start with the wrong limit", bad_limits);
+
+    for (int c = 1; c <= CYCLES; c++) {
+        uint64_t first_end = UINT64_MAX;
+        uint64_t last_start = 0;
+
+        for (int s = 0; s < SETS; s++) {
+            flow_log_t *f = &flows[c][s];
+
+            CHECK_MSG(BURST == f->events, "cycle %d set %d: %u burst events", c, s, f->events);
+            CHECK_MSG(f->echoed, "cycle %d set %d: no report", c, s);
+            /* The first cycle counts down from -3, the next starts at -1
+             * because every set was acked */
+            CHECK_MSG(((1 == c) ? -3 : -1) == f->first_pre_cnt,
+                      "cycle %d set %d: countdown from %d", c, s, f->first_pre_cnt);
+            for (int o = 0; o < s; o++) {
+                CHECK_MSG(flows[c][o].interval != f->interval,
+                          "cycle %d: sets %d and %d on interval %u", c, o, s, f->interval);
+            }
+            first_end = (f->last_us < first_end) ? f->last_us : first_end;
+            last_start = (f->first_us > last_start) ? f->first_us : last_start;
+        }
+        CHECK_MSG(last_start < first_end, "cycle %d: bursts do not overlap", c);
+    }
+
+    /* The pre-empted events still leave a full burst on air, and the
+     * stretched burst shows them in the skip estimate */
+    CHECK(PREEMPTED == preempted);
+    CHECK(0 == losstst_get_prio_stats(&prio));
+    for (int s = 0; s < SETS; s++) {
+        int expect = (PREEMPT_SET == s) ? PREEMPTED : 0;
+
+        CHECK_MSG(abs(prio.adv_skipped[s] - expect) <= SKIP_NOISE,
+                  "set %d: %u events skipped, %d pre-empted", s, prio.adv_skipped[s], expect);
+    }
+    sender_task_tgr(-1);
+    sl_bt_host_hooks(NULL);
+    printf("%d cycles, %.1f s virtual\n", cycles, sl_bt_host_now_us() / 1e6);
+}
+
+int main(void)
+{
+    test_concurrent_burst();
+    return CHECK_RESULT();
+}
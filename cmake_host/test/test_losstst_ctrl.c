@@ -0,0 +1,130 @@
+/**
+ * @file test_losstst_ctrl.c
+ * @brief Controller behaviour switches of the loss test service
+ *
+ * losstst_ctrl_apply() on the stand-in stack, which logs every link layer
+ * configuration. Only switches that changed may be sent: early abort as
+ * the set or clear flags key with the controller flag, adaptivity as the
+ * channel map flags key. A refused switch keeps its old state in
+ * losstst_ctrl_active() and in the round record, the others still apply.
+ */
+
+#include "check.h"
+#include "losstst_svc.h"
+#include "sl_bt_api.h"
+#include "sl_btctrl_linklayer_defs.h"
+#include "sl_bt_host.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BOTH    (LOSSTST_CTRL_EARLY_ABORT | LOSSTST_CTRL_ADAPTIVITY)
+
+/* Configuration n after the mark is key with the 32-bit value */
+static void check_config(uint32_t mark, uint32_t n, uint8_t key, uint32_t value)
+{
+    const sl_bt_host_ll_config_t *rec = sl_bt_host_ll_config(mark + n);
+    uint32_t sent = 0;
+
+    CHECK_MSG(rec != NULL, "configuration %u not sent", n);
+    if (NULL == rec) {
+        return;
+    }
+    memcpy(&sent, rec->data, sizeof(sent));
+    CHECK_MSG(key == rec->key && sizeof(value) == rec->len && value == sent,
+              "configuration %u: key 0x%x len %u value 0x%x", n, rec->key, rec->len, sent);
+}
+
+static bool on_record(void *ctx, uint8_t type, uint32_t round, const void *data, uint16_t len)
+{
+    losstst_store_result_t *rec = ctx;
+
+    (void)round;
+    if (1 == type && sizeof(*rec) == len) {
+        memcpy(rec, data, len);
+    }
+    return true;
+}
+
+/* ctrl_switches of a round stored now */
+static uint8_t stored_switches(void)
+{
+    losstst_store_result_t rec;
+    int32_t round = losstst_store_round();
+
+    memset(&rec, 0xFF, sizeof(rec));
+    CHECK_MSG(0 < round, "round not stored: %d", (int)round);
+    CHECK(0 < losstst_store_query((uint32_t)round, (uint32_t)round, on_record, &rec));
+    return rec.ctrl_switches;
+}
+
+int main(void)
+{
+    uint32_t mark;
+
+    CHECK(0 == losstst_init());
+    CHECK(0 == losstst_store_init());
+
+    /* The build configuration: no early abort, no AFH component */
+    CHECK(0 == losstst_ctrl_default());
+    CHECK(losstst_ctrl_default() == losstst_ctrl_active());
+    CHECK(0 == stored_switches());
+
+    /* Nothing changed, nothing sent */
+    mark = sl_bt_host_ll_configs();
+    CHECK(0 == losstst_ctrl_apply(0));
+    CHECK(mark == sl_bt_host_ll_configs());
+
+    mark = sl_bt_host_ll_configs();
+    CHECK(0 == losstst_ctrl_apply(LOSSTST_CTRL_EARLY_ABORT));
+    CHECK(mark + 1 == sl_bt_host_ll_configs());
+    check_config(mark, 0, sl_bt_system_linklayer_config_key_set_flags,
+                 SL_BTCTRL_CONFIG_FLAG_SCANNER_RECEPTION_EARLY_ABORT);
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == losstst_ctrl_active());
+
+    mark = sl_bt_host_ll_configs();
+    CHECK(0 == losstst_ctrl_apply(BOTH));
+    CHECK(mark + 1 == sl_bt_host_ll_configs());
+    check_config(mark, 0, sl_bt_system_linklayer_config_key_set_channelmap_flags,
+                 SL_BTCTRL_CHANNELMAP_FLAG_ACTIVE_ADAPTIVITY);
+    CHECK(BOTH == losstst_ctrl_active());
+    CHECK(BOTH == stored_switches());
+
+    mark = sl_bt_host_ll_configs();
+    CHECK(0 == losstst_ctrl_apply(LOSSTST_CTRL_ADAPTIVITY));
+    CHECK(mark + 1 == sl_bt_host_ll_configs());
+    check_config(mark, 0, sl_bt_system_linklayer_config_key_clr_flags,
+                 SL_BTCTRL_CONFIG_FLAG_SCANNER_RECEPTION_EARLY_ABORT);
+    CHECK(LOSSTST_CTRL_ADAPTIVITY == losstst_ctrl_active());
+
+    /* A controller without AFH: the refused switch stays, the other applies */
+    sl_bt_host_ll_refuse(sl_bt_system_linklayer_config_key_set_channelmap_flags,
+                         SL_STATUS_NOT_SUPPORTED);
+    mark = sl_bt_host_ll_configs();
+    CHECK(-ENOTSUP == losstst_ctrl_apply(LOSSTST_CTRL_EARLY_ABORT));
+    CHECK(mark + 2 == sl_bt_host_ll_configs());
+    check_config(mark, 0, sl_bt_system_linklayer_config_key_set_flags,
+                 SL_BTCTRL_CONFIG_FLAG_SCANNER_RECEPTION_EARLY_ABORT);
+    check_config(mark, 1, sl_bt_system_linklayer_config_key_set_channelmap_flags, 0);
+    CHECK_MSG(BOTH == losstst_ctrl_active(), "0x%x active", losstst_ctrl_active());
+    CHECK(BOTH == stored_switches());
+
+    /* Accepted again: only the switch still pending is sent */
+    sl_bt_host_ll_refuse(sl_bt_system_linklayer_config_key_set_channelmap_flags, SL_STATUS_OK);
+    mark = sl_bt_host_ll_configs();
+    CHECK(0 == losstst_ctrl_apply(LOSSTST_CTRL_EARLY_ABORT));
+    CHECK(mark + 1 == sl_bt_host_ll_configs());
+    check_config(mark, 0, sl_bt_system_linklayer_config_key_set_channelmap_flags, 0);
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == losstst_ctrl_active());
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == stored_switches());
+
+    /* Early abort refused on the way back */
+    sl_bt_host_ll_refuse(sl_bt_system_linklayer_config_key_clr_flags, SL_STATUS_NOT_SUPPORTED);
+    CHECK(-ENOTSUP == losstst_ctrl_apply(0));
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == losstst_ctrl_active());
+    sl_bt_host_ll_refuse(sl_bt_system_linklayer_config_key_clr_flags, SL_STATUS_OK);
+    CHECK(0 == losstst_ctrl_apply(0));
+    CHECK(0 == losstst_ctrl_active());
+    return CHECK_RESULT();
+}
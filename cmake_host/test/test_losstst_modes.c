@@ -0,0 +1,303 @@
+/**
+ * @file test_losstst_modes.c
+ * @brief Test mode scheduling of the application on the stand-in stack
+ *
+ * app.c, test_mode.c and ble_log.c run on the loss test service as they do
+ * on the board. The test only sets task triggers, as the LCD menu does,
+ * and delivers stack events through sl_bt_on_event(); the application
+ * task makes a pass after every millisecond. The scanner has to wait out
+ * both settle periods before its first step, count the reports delivered
+ * while it runs and stop on a cleared trigger. The sender has to end its
+ * burst on the advertiser timeout, although the scanner created set 3
+ * first and the stack handles no longer match the set indexes, and stop
+ * mid-burst on a cleared trigger.
+ *
+ * Tput runs beside the phone's log link. Its own link refuses a new run
+ * only while it is open: after an abort until its close event, which must
+ * not reach the log link.
+ */
+
+#include "check.h"
+#include "app.h"
+#include "ble_log.h"
+#include "losstst_svc.h"
+#include "sl_bt_api.h"
+#include "sl_bt_host.h"
+#include "sl_main_init.h"
+#include "test_mode.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define BURST_RX    10
+
+/* app.c */
+extern test_param_t round_test_parm;
+void sl_bt_on_event(sl_bt_msg_t *evt);
+
+static const bd_addr sender = { { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 } };
+static const bd_addr source = { { 0x21, 0x32, 0x43, 0x54, 0x65, 0x76 } };
+
+/* The application task: a pass after every millisecond */
+static void run(uint32_t ms)
+{
+    while (ms--) {
+        sl_bt_host_run(1);
+        app_process_action();
+    }
+}
+
+static const char *active_name(void)
+{
+    const test_mode_t *mode = test_mode_active();
+
+    return (mode != NULL) ? mode->name : "idle";
+}
+
+static uint8_t prio_profile(void)
+{
+    losstst_prio_stats_t prio;
+
+    CHECK(0 == losstst_get_prio_stats(&prio));
+    return prio.profile;
+}
+
+/* A 2M burst packet of flow 1 */
+static void report_burst(int16_t pre_cnt)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_scanner_extended_advertisement_report_id);
+    sl_bt_evt_scanner_extended_advertisement_report_t *rep =
+        &evt->data.evt_scanner_extended_advertisement_report;
+    uint8_t ad[3 + 2 + 16] = { 2, 0x01, 0x06, 17, 0xFF, 0xFF, 0xFF, 0xAB, 0xBA };
+
+    ad[9] = (uint8_t)pre_cnt;
+    ad[10] = (uint8_t)((uint16_t)pre_cnt >> 8);
+    ad[11] = 1;
+    memcpy(&ad[13], "\xF8\xF9\xFA\xF5\xFC\xFD\xFE\x01", 8);
+    rep->address = sender;
+    rep->rssi = -50;
+    rep->primary_phy = sl_bt_gap_phy_1m;
+    rep->secondary_phy = sl_bt_gap_phy_2m;
+    rep->data.len = sizeof(ad);
+    memcpy(rep->data.data, ad, sizeof(ad));
+    sl_bt_on_event(evt);
+}
+
+/* Trigger, settle, run on reports, abort */
+static void test_scanner(void)
+{
+    uint32_t starts;
+    losstst_result_t result;
+
+    scanner_task_tgr(1);
+    run(1);
+    CHECK_MSG(0 == strcmp("Scanner", active_name()), "%s active", active_name());
+    CHECK(LOSSTST_PRIO_SCAN_EXCLUSIVE == prio_profile());
+    CHECK(sl_bt_scanner_scan_phy_1m_and_coded == sl_bt_host_scanning());
+    starts = sl_bt_host_scan_starts();
+
+    /* The first step picks the scan of the round: not before 1 + 1 s */
+    run(1990);
+    CHECK_MSG(starts == sl_bt_host_scan_starts(), "scan restarted while settling");
+    run(20);
+    CHECK(sl_bt_scanner_scan_phy_1m == sl_bt_host_scanning());
+
+    for (int16_t pre_cnt = 250; pre_cnt > 250 - BURST_RX; pre_cnt--) {
+        report_burst(pre_cnt);
+        run(2);
+    }
+    CHECK(0 == strcmp("Scanner", active_name()));
+    CHECK(0 == losstst_get_result(0, &result));
+    CHECK_MSG(BURST_RX == result.rcv, "%u of %u reports counted", result.rcv, BURST_RX);
+
+    /* Stop Task in the menu */
+    scanner_task_tgr(-scanner_task_tgr(0));
+    run(1);
+    CHECK_MSG(0 == strcmp("idle", active_name()), "%s still active", active_name());
+    CHECK(0 == sl_bt_host_scanning());
+    CHECK(LOSSTST_PRIO_DEFAULT == prio_profile());
+}
+
+/* Sender: timeouts through the event handler, a trigger cleared on air */
+
+static uint32_t burst_events;
+static uint32_t stop_at;
+static uint8_t burst_handle;
+static uint64_t burst_end_us;       /* Last burst event of the first cycle */
+static uint64_t report_us;          /* First report after it */
+
+static int16_t burst_pre_cnt(const sl_bt_host_adv_t *adv)
+{
+    for (size_t i = 0; i + 1 < adv->len; i += adv->data[i] + 1u) {
+        const uint8_t *ad = &adv->data[i];
+
+        if (0xFF == ad[1] && ad[0] >= 9 && 0xBAAB == (ad[4] | ad[5] << 8)) {
+            return (int16_t)(ad[6] | ad[7] << 8);
+        }
+    }
+    return INT16_MIN;
+}
+
+/* Burst events are the limited starts */
+static void on_adv(const sl_bt_host_adv_t *adv)
+{
+    int16_t pre_cnt = burst_pre_cnt(adv);
+
+    if (pre_cnt > 0 && 0 != adv->max_events) {
+        if (0 == report_us) {
+            burst_handle = adv->handle;
+            burst_end_us = adv->t_us;
+        }
+        if (++burst_events == stop_at) {
+            sender_task_tgr(-sender_task_tgr(0));
+        }
+    } else if (0 == pre_cnt && 0 != burst_events && burst_handle == adv->handle && 0 == report_us) {
+        report_us = adv->t_us;
+    }
+}
+
+static void on_timeout(uint8_t handle)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_advertiser_timeout_id);
+
+    evt->data.evt_advertiser_timeout.handle = handle;
+    sl_bt_on_event(evt);
+}
+
+static void test_sender(void)
+{
+    static const sl_bt_host_hooks_t hooks = { .adv_event = on_adv, .adv_timeout = on_timeout };
+    uint32_t events;
+
+    sl_bt_host_hooks(&hooks);
+    burst_events = 0;
+    stop_at = 300;
+    sender_task_tgr(1);
+    run(1);
+    CHECK_MSG(0 == strcmp("Sender", active_name()), "%s active", active_name());
+    CHECK(LOSSTST_PRIO_ADV_EXCLUSIVE == prio_profile());
+
+    /* No burst before 1 + 3 s of settling */
+    run(3990);
+    CHECK_MSG(0 == burst_events, "%u burst events while settling", burst_events);
+
+    /* The step runs the cycle until the trigger is cleared on air */
+    run(20000);
+    CHECK_MSG(stop_at == burst_events, "%u burst events", burst_events);
+    /* The timeout of the burst ends the wait, not the burst period */
+    CHECK_MSG(0 != report_us && report_us - burst_end_us < 1000000,
+              "report %lu ms after the burst", (unsigned long)((report_us - burst_end_us) / 1000));
+    CHECK_MSG(0 == strcmp("idle", active_name()), "%s still active", active_name());
+    CHECK(LOSSTST_PRIO_DEFAULT == prio_profile());
+    events = burst_events;
+    run(1000);
+    CHECK_MSG(events == burst_events, "%u burst events after the stop", burst_events - events);
+    sl_bt_host_hooks(NULL);
+}
+
+static void connection_opened(uint8_t connection)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_connection_opened_id);
+
+    evt->data.evt_connection_opened.connection = connection;
+    evt->data.evt_connection_opened.advertiser = 0xFF;
+    sl_bt_on_event(evt);
+}
+
+static void connection_closed(uint8_t connection)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_connection_closed_id);
+
+    sl_bt_host_drop(connection);
+    evt->data.evt_connection_closed.connection = connection;
+    evt->data.evt_connection_closed.reason = SL_STATUS_BT_CTRL_REMOTE_USER_TERMINATED;
+    sl_bt_on_event(evt);
+}
+
+/* The throughput source on 1M */
+static void report_tput_source(void)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_scanner_extended_advertisement_report_id);
+    sl_bt_evt_scanner_extended_advertisement_report_t *rep =
+        &evt->data.evt_scanner_extended_advertisement_report;
+    static const uint8_t ad[] = {
+        2, 0x01, 0x06, 13, 0xFF, 0xFF, 0xFF, 0xAD, 0xBA, 1, 2, 3, 4, 5, 6, 7, 8
+    };
+
+    rep->address = source;
+    rep->rssi = -50;
+    rep->primary_phy = sl_bt_gap_phy_1m;
+    rep->secondary_phy = sl_bt_gap_phy_1m;
+    rep->data.len = sizeof(ad);
+    memcpy(rep->data.data, ad, sizeof(ad));
+    sl_bt_on_event(evt);
+}
+
+static void test_tput_beside_log_link(void)
+{
+    const uint8_t log_link = 1;
+    uint8_t tput_link = 0;
+
+    sl_bt_host_accept(log_link);
+    connection_opened(log_link);
+    CHECK(ble_log_is_connected());
+
+    tput_task_tgr(1);
+    run(1);
+    CHECK_MSG(0 == strcmp("Tput", active_name()), "%s active with the log link up", active_name());
+    CHECK(LOSSTST_PRIO_LOG_FRIENDLY == prio_profile());
+    CHECK(sl_bt_scanner_scan_phy_1m == sl_bt_host_scanning());
+
+    /* The sink connects to the source it found, on a handle of its own */
+    report_tput_source();
+    run(1);
+    for (uint8_t c = 1; c <= SL_BT_HOST_MAX_CONNS; c++) {
+        if (c != log_link && sl_bt_host_conn(c)->open) {
+            tput_link = c;
+        }
+    }
+    CHECK_MSG(0 != tput_link, "no throughput connection");
+    if (0 == tput_link) {
+        return;
+    }
+    CHECK(0 == memcmp(source.addr, sl_bt_host_conn(tput_link)->peer, 6));
+    connection_opened(tput_link);
+    CHECK(251 == sl_bt_host_conn(tput_link)->tx_data_len);
+    CHECK(0 == sl_bt_host_conn(log_link)->tx_data_len);
+
+    /* Stop Task: the link is closed, but stays until its close event */
+    tput_task_tgr(-tput_task_tgr(0));
+    run(1);
+    CHECK(0 == strcmp("idle", active_name()));
+    CHECK(sl_bt_host_conn(tput_link)->close_req);
+    CHECK(!sl_bt_host_conn(log_link)->close_req);
+    tput_task_tgr(1);
+    run(1);
+    CHECK_MSG(0 == strcmp("idle", active_name()) && 0 == tput_task_tgr(0),
+              "Tput started on an open throughput link");
+
+    /* Its close event is the test's, the log link stays */
+    connection_closed(tput_link);
+    CHECK(ble_log_is_connected());
+    tput_task_tgr(1);
+    run(1);
+    CHECK_MSG(0 == strcmp("Tput", active_name()), "%s active after the close", active_name());
+    tput_task_tgr(-tput_task_tgr(0));
+    run(1);
+    CHECK(0 == strcmp("idle", active_name()));
+    CHECK(ble_log_is_connected());
+}
+
+int main(void)
+{
+    app_init();
+    /* 2M only, as the default configuration */
+    CHECK(round_test_parm.phy_2m && !round_test_parm.phy_1m && !round_test_parm.phy_s8);
+    run(10);
+    CHECK(0 == strcmp("idle", active_name()));
+
+    test_scanner();
+    test_sender();
+    test_tput_beside_log_link();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,308 @@
+/**
+ * @file test_losstst_ping.c
+ * @brief Ping round trips of the loss test, both ends
+ *
+ * As initiator the service pings on 2M and 1M against a scripted responder
+ * that echoes after a known hop and responder delay, drops some requests
+ * and sends the delay of others without the echo. The RTT statistics must
+ * come out as the hops alone. As responder (scanner) the service must echo
+ * each request once, on its PHY and on the echo set, as a single event
+ * followed by the delay from the request report to that event.
+ */
+
+#include "check.h"
+#include "losstst_svc.h"
+#include "sl_bt_host.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PINGS           100     /* PING_SAMPLES */
+#define PING_REQUEST    0xFFFF
+#define PING_ECHO_SYNC  0xFFFE
+#define FORM_LEN        20      /* ping_info_t */
+
+typedef struct {
+    uint16_t seq;
+    uint32_t tx_tm;
+    uint16_t resp_dly;
+    uint8_t eui[8];
+} ping_t;
+
+/* Scripted responder, per PHY: the echo of the request sent at sent_ms */
+typedef struct {
+    ping_t req;
+    uint64_t sync_ms;       /* 0 = no echo */
+    uint64_t follow_ms;
+    uint16_t dly;
+    bool pending;
+} script_t;
+
+static script_t script[4];
+static uint16_t hops[4][PINGS];
+static uint16_t hops_n[4];
+static uint16_t requests[4];
+static uint16_t dropped[4];
+
+static bool read_ping(const uint8_t *data, size_t len, ping_t *p)
+{
+    for (size_t i = 0; i + 1 < len; i += data[i] + 1u) {
+        const uint8_t *ad = &data[i];
+
+        if (0xFF == ad[1] && FORM_LEN + 1 == ad[0] && 0xFFFF == (ad[2] | ad[3] << 8)
+            && 0xBAAC == (ad[4] | ad[5] << 8)) {
+            p->seq = (uint16_t)(ad[6] | ad[7] << 8);
+            p->tx_tm = (uint32_t)ad[8] | (uint32_t)ad[9] << 8 | (uint32_t)ad[10] << 16
+                       | (uint32_t)ad[11] << 24;
+            p->resp_dly = (uint16_t)(ad[12] | ad[13] << 8);
+            memcpy(p->eui, &ad[14], sizeof(p->eui));
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Flags and the ping form, as the service builds them */
+static void report_ping(uint8_t idx, const ping_t *p)
+{
+    static const bd_addr peer = { { 9, 8, 7, 6, 5, 4 } };
+    uint8_t ad[3 + 2 + FORM_LEN] = { 2, 0x01, 0x06, FORM_LEN + 1, 0xFF, 0xFF, 0xFF, 0xAC, 0xBA };
+
+    ad[9] = (uint8_t)p->seq;
+    ad[10] = (uint8_t)(p->seq >> 8);
+    for (int i = 0; i < 4; i++) {
+        ad[11 + i] = (uint8_t)(p->tx_tm >> (8 * i));
+    }
+    ad[15] = (uint8_t)p->resp_dly;
+    ad[16] = (uint8_t)(p->resp_dly >> 8);
+    memcpy(&ad[17], p->eui, sizeof(p->eui));
+    sl_bt_scanner_process_extended_report(&peer, 0, -50, 0, sl_bt_gap_phy_1m,
+                                          (0 == idx) ? sl_bt_gap_phy_2m : sl_bt_gap_phy_1m,
+                                          ad, sizeof(ad));
+}
+
+static uint64_t now_ms(void)
+{
+    return sl_bt_host_now_us() / 1000;
+}
+
+/* ==================== Initiator ==================== */
+
+static void on_request(const sl_bt_host_adv_t *adv)
+{
+    script_t *s;
+    ping_t p;
+    uint16_t hop;
+
+    if (adv->handle > 1 || !read_ping(adv->data, adv->len, &p) || PING_REQUEST != p.resp_dly) {
+        return;
+    }
+    s = &script[adv->handle];
+    requests[adv->handle]++;
+    /* Every tenth request is lost, every tenth echo from the fifth on is
+     * missed with only its delay getting through */
+    if (0 == p.seq % 10) {
+        dropped[adv->handle]++;
+        return;
+    }
+    hop = (uint16_t)(2 + (p.seq * 7 + adv->handle) % 11);
+    s->req = p;
+    s->dly = (uint16_t)(5 + p.seq % 17);
+    s->sync_ms = (5 == p.seq % 10) ? 0 : now_ms() + s->dly + hop;
+    s->follow_ms = now_ms() + s->dly + hop + 30;
+    s->pending = true;
+    if (0 != s->sync_ms) {
+        hops[adv->handle][hops_n[adv->handle]++] = hop;
+    } else {
+        dropped[adv->handle]++;
+    }
+}
+
+static void on_initiator_step(uint64_t now_us)
+{
+    for (uint8_t idx = 0; idx <= 1; idx++) {
+        script_t *s = &script[idx];
+        ping_t echo = s->req;
+
+        if (!s->pending) {
+            continue;
+        }
+        if (0 != s->sync_ms && now_us / 1000 == s->sync_ms) {
+            echo.resp_dly = PING_ECHO_SYNC;
+            report_ping(idx, &echo);
+        }
+        if (now_us / 1000 == s->follow_ms) {
+            echo.resp_dly = s->dly;
+            report_ping(idx, &echo);
+            s->pending = false;
+        }
+    }
+}
+
+static void on_timeout(uint8_t handle)
+{
+    losstst_adv_sent_handler(handle);
+}
+
+static int cmp_u16(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static void test_initiator(void)
+{
+    static const sl_bt_host_hooks_t hooks = {
+        .adv_event = on_request, .adv_timeout = on_timeout, .step = on_initiator_step
+    };
+    test_param_t param = { .phy_2m = true, .phy_1m = true, .prio_profile = LOSSTST_PRIO_AUTO };
+    uint32_t calls = 0;
+    int ret;
+
+    sl_bt_host_hooks(&hooks);
+    ping_task_tgr(1);
+    CHECK(0 == ping_setup(&param));
+    while ((ret = losstst_ping()) > 0 && calls++ < 200000) {
+    }
+    sl_bt_host_hooks(NULL);
+    ping_task_tgr(-ping_task_tgr(0));
+    CHECK_MSG(0 == ret, "ping returned %d", ret);
+
+    for (uint8_t idx = 0; idx <= 1; idx++) {
+        losstst_ping_stats_t st;
+        uint16_t *h = hops[idx];
+        uint16_t n = hops_n[idx];
+
+        CHECK(0 == losstst_get_ping_stats(idx, &st));
+        qsort(h, n, sizeof(h[0]), cmp_u16);
+        CHECK_MSG(PINGS == st.sent && PINGS == requests[idx], "PHY %u: %u sent, %u on air",
+                  idx, st.sent, requests[idx]);
+        CHECK_MSG(PINGS - dropped[idx] == st.echoed, "PHY %u: %u echoed, %u dropped",
+                  idx, st.echoed, dropped[idx]);
+        /* RTT without the responder delay is the hop, to the ms tick */
+        CHECK_MSG(abs(st.rtt_min - h[0]) <= 1, "PHY %u: min %u, hop %u", idx, st.rtt_min, h[0]);
+        CHECK_MSG(abs(st.rtt_median - (h[n / 2 - 1] + h[n / 2]) / 2) <= 1,
+                  "PHY %u: median %u", idx, st.rtt_median);
+        CHECK_MSG(abs(st.rtt_p99 - h[(99 * n + 99) / 100 - 1]) <= 1,
+                  "PHY %u: p99 %u, hop %u", idx, st.rtt_p99, h[(99 * n + 99) / 100 - 1]);
+        printf("PHY %u: %u/%u echoed, RTT min %u med %u p99 %u ms\n", idx, st.echoed, st.sent,
+               st.rtt_min, st.rtt_median, st.rtt_p99);
+    }
+}
+
+/* ==================== Responder ==================== */
+
+typedef struct {
+    uint8_t handle;
+    uint8_t secondary_phy;
+    uint8_t max_events;
+    uint64_t t_ms;
+    ping_t form;
+} echo_t;
+
+static echo_t echoes[16];
+static uint32_t echoes_n;
+
+static void on_echo(const sl_bt_host_adv_t *adv)
+{
+    ping_t p;
+
+    if (!read_ping(adv->data, adv->len, &p) || PING_REQUEST == p.resp_dly
+        || echoes_n == sizeof(echoes) / sizeof(echoes[0])) {
+        return;
+    }
+    echoes[echoes_n++] = (echo_t){
+        .handle = adv->handle,
+        .secondary_phy = adv->secondary_phy,
+        .max_events = adv->max_events,
+        .t_ms = now_ms(),
+        .form = p,
+    };
+}
+
+static void test_responder(void)
+{
+    static const sl_bt_host_hooks_t hooks = { .adv_event = on_echo, .adv_timeout = on_timeout };
+    test_param_t param = { .phy_2m = true, .phy_1m = true, .prio_profile = LOSSTST_PRIO_AUTO };
+    ping_t req[2] = {
+        { .seq = 7, .tx_tm = 123456, .resp_dly = PING_REQUEST,
+          .eui = { 0xF8, 0xF9, 0xFA, 0xF5, 0xFC, 0xFD, 0xFE, 0x01 } },
+        { .seq = 9, .tx_tm = 654321, .resp_dly = PING_REQUEST,
+          .eui = { 0xF8, 0xF9, 0xFA, 0xF5, 0xFC, 0xFD, 0xFE, 0x02 } },
+    };
+    uint64_t rx_ms[2] = { 0, 0 };
+    uint32_t ticks;
+
+    sl_bt_host_hooks(&hooks);
+    scanner_task_tgr(1);
+    CHECK(0 == scanner_setup(&param));
+    CHECK(0 < losstst_scanner());
+    sl_bt_host_run(10);
+
+    /* The 1M request twice (it repeats every event) and a 2M one while the
+     * echo set is busy with it */
+    rx_ms[1] = now_ms();
+    report_ping(1, &req[1]);
+    report_ping(1, &req[1]);
+    rx_ms[0] = now_ms();
+    report_ping(0, &req[0]);
+    for (ticks = 0; ticks < 20 && 0 < losstst_scanner(); ticks++) {
+        sl_bt_host_run(10);
+    }
+    /* The next event of the same request, after its echo went out */
+    report_ping(1, &req[1]);
+    for (ticks = 0; ticks < 20 && 0 < losstst_scanner(); ticks++) {
+        sl_bt_host_run(10);
+    }
+    sl_bt_host_hooks(NULL);
+    scanner_task_tgr(-scanner_task_tgr(0));
+
+    /* Per PHY: one sync event, then the delay on the same set */
+    for (uint8_t idx = 0; idx <= 1; idx++) {
+        const echo_t *sync = NULL;
+        uint32_t syncs = 0;
+        uint32_t follows = 0;
+
+        for (uint32_t i = 0; i < echoes_n; i++) {
+            const echo_t *e = &echoes[i];
+
+            if (e->form.seq != req[idx].seq) {
+                continue;
+            }
+            CHECK(e->form.tx_tm == req[idx].tx_tm);
+            CHECK(0 == memcmp(e->form.eui, req[idx].eui, sizeof(e->form.eui)));
+            CHECK_MSG(e->handle > 3, "PHY %u: echo on test set %u", idx, e->handle);
+            CHECK_MSG(((0 == idx) ? sl_bt_gap_phy_2m : sl_bt_gap_phy_1m) == e->secondary_phy,
+                      "PHY %u: echo on secondary PHY %u", idx, e->secondary_phy);
+            if (PING_ECHO_SYNC == e->form.resp_dly) {
+                CHECK(1 == e->max_events);
+                sync = e;
+                syncs++;
+            } else {
+                /* Request report to the sent sync event, to the ms tick */
+                CHECK(sync != NULL && sync->handle == e->handle);
+                CHECK_MSG(sync != NULL
+                          && abs((int)e->form.resp_dly - (int)(sync->t_ms - rx_ms[idx])) <= 1,
+                          "PHY %u: delay %u", idx, e->form.resp_dly);
+                follows++;
+            }
+        }
+        CHECK_MSG(1 == syncs, "PHY %u: %u echoes", idx, syncs);
+        CHECK_MSG(3 == follows, "PHY %u: %u follow-up events", idx, follows);
+    }
+    printf("%u echo events\n", echoes_n);
+}
+
+int main(void)
+{
+    CHECK(0 == losstst_init());
+    /* The timeout handler takes the handle for the set index: create the
+     * four test sets in index order, stopped as the test mode leaves them */
+    for (uint8_t idx = 0; idx <= 3; idx++) {
+        CHECK(0 == update_adv(idx, NULL, NULL, NULL));
+        blocking_adv(idx);
+    }
+    test_initiator();
+    test_responder();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,222 @@
+/**
+ * @file test_losstst_sweep.c
+ * @brief Channel sweep of the loss test, sender to scanner
+ *
+ * The sender runs four 1M cycles with the channel sweep on, so the bursts
+ * rotate 37, 38, 39, 37 while the countdowns and reports stay on the
+ * configured map. Its air log is then played to the same service as a
+ * scanner, delivered only while the scan covers 1M and thinned out per
+ * channel; the per-channel result must count exactly what was delivered
+ * against 250 packets for every burst sent on that channel.
+ */
+
+#include "check.h"
+#include "losstst_svc.h"
+#include "sl_bt_host.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CYCLES      4       /* 1000 packets */
+#define BURST       250
+#define LOG_LEN     2048
+#define CH_ALL      0x07
+#define LEAD_MS     200     /* Scanner start to the first logged event */
+
+typedef struct {
+    uint64_t t_us;
+    int16_t pre_cnt;
+    uint8_t channel_map;
+    uint8_t len;
+    uint8_t data[64];
+} air_t;
+
+static air_t air[LOG_LEN];
+static uint32_t air_n;
+static uint32_t air_lost;
+static uint32_t bad_map;            /* Bursts off their sweep channel */
+static uint32_t bad_report_map;     /* Other forms off the configured map */
+static uint16_t burst_ch[3];        /* Bursts sent per channel */
+
+/* Every n-th burst packet on a channel is lost, 0 = none */
+static const uint8_t drop_every[3] = { 0, 5, 3 };
+static uint32_t seen[3];
+static uint16_t delivered[3];
+static uint32_t replay_next;
+static uint64_t replay_offset_us;
+
+static bool read_form(const uint8_t *data, size_t len, int16_t *pre_cnt, uint16_t *flw_cnt)
+{
+    for (size_t i = 0; i + 1 < len; i += data[i] + 1u) {
+        const uint8_t *ad = &data[i];
+
+        if (0xFF == ad[1] && ad[0] >= 9 && 0xFFFF == (ad[2] | ad[3] << 8)
+            && 0xBAAB == (ad[4] | ad[5] << 8)) {
+            *pre_cnt = (int16_t)(ad[6] | ad[7] << 8);
+            *flw_cnt = (uint16_t)(ad[8] | ad[9] << 8);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int channel_of(uint8_t map)
+{
+    return (0x1 == map) ? 0 : (0x2 == map) ? 1 : (0x4 == map) ? 2 : -1;
+}
+
+static void on_sender_adv(const sl_bt_host_adv_t *adv)
+{
+    static const bd_addr scanner = { { 1, 2, 3, 4, 5, 6 } };
+    static uint16_t echoed;
+    int16_t pre_cnt;
+    uint16_t flw_cnt;
+
+    if (1 != adv->handle || !read_form(adv->data, adv->len, &pre_cnt, &flw_cnt)) {
+        return;
+    }
+    /* The scanner answers each report, so the next countdown follows */
+    if (0 == pre_cnt && echoed != flw_cnt) {
+        echoed = flw_cnt;
+        sl_bt_scanner_process_extended_report(&scanner, 0, -40, 0, sl_bt_gap_phy_1m,
+                                              sl_bt_gap_phy_1m, adv->data, (uint16_t)adv->len);
+    }
+    if (0 < pre_cnt && INT16_MAX != pre_cnt) {
+        /* Flow 1 on 37, then 38, 39 and round again */
+        if (1 << ((flw_cnt + 2) % 3) != adv->channel_map) {
+            bad_map++;
+        } else if (1 == adv->event) {
+            burst_ch[channel_of(adv->channel_map)]++;
+        }
+    } else if (CH_ALL != adv->channel_map) {
+        bad_report_map++;
+    }
+    if (air_n == LOG_LEN || adv->len > sizeof(air[0].data)) {
+        air_lost++;
+        return;
+    }
+    air[air_n] = (air_t){
+        .t_us = adv->t_us,
+        .pre_cnt = pre_cnt,
+        .channel_map = adv->channel_map,
+        .len = (uint8_t)adv->len,
+    };
+    memcpy(air[air_n].data, adv->data, adv->len);
+    air_n++;
+}
+
+static void on_sender_timeout(uint8_t handle)
+{
+    losstst_adv_sent_handler(handle);
+}
+
+/* Air log events due by now, heard while the scanner is on 1M */
+static void on_scanner_step(uint64_t now_us)
+{
+    static const bd_addr sender = { { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 } };
+
+    while (replay_next < air_n && air[replay_next].t_us + replay_offset_us <= now_us) {
+        const air_t *a = &air[replay_next++];
+        int ch = channel_of(a->channel_map);
+
+        if (!(sl_bt_host_scanning() & sl_bt_scanner_scan_phy_1m)) {
+            continue;
+        }
+        if (0 < a->pre_cnt && INT16_MAX != a->pre_cnt && ch >= 0) {
+            if (drop_every[ch] && 0 == ++seen[ch] % drop_every[ch]) {
+                continue;
+            }
+            delivered[ch]++;
+        }
+        sl_bt_scanner_process_extended_report(&sender, 0, -60, 0, sl_bt_gap_phy_1m,
+                                              sl_bt_gap_phy_1m, a->data, a->len);
+    }
+}
+
+static void run_sender(const test_param_t *param)
+{
+    static const sl_bt_host_hooks_t hooks = {
+        .adv_event = on_sender_adv, .adv_timeout = on_sender_timeout
+    };
+    int cycles = 0;
+    int ret;
+
+    sl_bt_host_hooks(&hooks);
+    sender_task_tgr(1);
+    CHECK(0 == sender_setup(param));
+    while ((ret = losstst_sender()) > 0 && cycles < 2 * CYCLES) {
+        cycles++;
+    }
+    CHECK_MSG(0 == ret && CYCLES == cycles, "sender returned %d after %d cycles", ret, cycles);
+    /* A few completion forms at the 1 s interval */
+    sl_bt_host_run(3000);
+    sl_bt_host_hooks(NULL);
+    sender_finit();
+    sender_task_tgr(-1);
+
+    CHECK_MSG(0 == bad_map, "%u burst events off their sweep channel", bad_map);
+    CHECK_MSG(0 == bad_report_map, "%u other events off the configured map", bad_report_map);
+    CHECK(2 == burst_ch[0] && 1 == burst_ch[1] && 1 == burst_ch[2]);
+    CHECK(0 == air_lost);
+}
+
+static void run_scanner(const test_param_t *param)
+{
+    static const sl_bt_host_hooks_t hooks = { .step = on_scanner_step };
+    losstst_result_t res;
+    uint32_t ticks = 0;
+    int ret;
+
+    scanner_task_tgr(1);
+    CHECK(0 == scanner_setup(param));
+    replay_offset_us = sl_bt_host_now_us() + LEAD_MS * 1000ull - air[0].t_us;
+    sl_bt_host_hooks(&hooks);
+    /* The test mode scheduler's tick */
+    while ((ret = losstst_scanner()) > 0 && ticks++ < 20000) {
+        sl_bt_host_run(10);
+    }
+    sl_bt_host_hooks(NULL);
+    CHECK_MSG(0 == ret, "scanner returned %d", ret);
+    /* The round ends on the completion form */
+    CHECK_MSG(0 < replay_next && INT16_MAX == air[replay_next - 1].pre_cnt,
+              "scanner stopped at event %u of %u", replay_next, air_n);
+
+    CHECK(0 == losstst_get_result(1, &res));
+    CHECK_MSG(delivered[0] + delivered[1] + delivered[2] == res.rcv,
+              "%u received, %u delivered", res.rcv, delivered[0] + delivered[1] + delivered[2]);
+    CHECK(CYCLES * BURST == res.exp);
+    for (int ch = 0; ch < 3; ch++) {
+        CHECK_MSG(delivered[ch] == res.ch[ch].rcv, "channel %d: %u received, %u delivered",
+                  37 + ch, res.ch[ch].rcv, delivered[ch]);
+        CHECK_MSG(BURST * burst_ch[ch] == res.ch[ch].exp, "channel %d: %u expected",
+                  37 + ch, res.ch[ch].exp);
+    }
+    /* The drops leave the channels apart */
+    CHECK(2 * BURST == delivered[0]);
+    CHECK(delivered[2] < delivered[1] && delivered[1] < BURST);
+    scanner_task_tgr(-scanner_task_tgr(0));
+    printf("channel 37 %u/%u, 38 %u/%u, 39 %u/%u\n", res.ch[0].rcv, res.ch[0].exp,
+           res.ch[1].rcv, res.ch[1].exp, res.ch[2].rcv, res.ch[2].exp);
+}
+
+int main(void)
+{
+    test_param_t param = {
+        .interval_idx = 0,
+        .count_idx = 1,
+        .phy_1m = true,
+        .channel_sweep = true,
+        .prio_profile = LOSSTST_PRIO_AUTO,
+    };
+
+    CHECK(0 == losstst_init());
+    /* The timeout handler takes the handle for the set index: create the
+     * four test sets in index order, stopped as the test mode leaves them */
+    for (uint8_t idx = 0; idx <= 3; idx++) {
+        CHECK(0 == update_adv(idx, NULL, NULL, NULL));
+        blocking_adv(idx);
+    }
+    run_sender(&param);
+    run_scanner(&param);
+    return CHECK_RESULT();
+}
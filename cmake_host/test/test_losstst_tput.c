@@ -0,0 +1,209 @@
+/**
+ * @file test_losstst_tput.c
+ * @brief Connection throughput sink of the loss test service
+ *
+ * losstst_tput() as the sink on the stand-in stack; every call is one
+ * millisecond. The test plays the source and its stack: it answers the
+ * connection with the opened, parameters, PHY, data length and MTU
+ * events, and once the sink subscribes to the Log Output characteristic
+ * it notifies MTU-3 octets every 5 ms for 8 s, one sequence number
+ * skipped. The sink must measure for its 10 s phase and report the
+ * goodput of what arrived, the lost payload, the stall of the silent end
+ * and the link it negotiated, then close the link.
+ */
+
+#include "check.h"
+#include "gatt_db.h"
+#include "losstst_svc.h"
+#include "sl_bt_api.h"
+#include "sl_bt_host.h"
+#include "sl_sleeptimer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define MTU             247
+#define PAYLOAD         (MTU - 3)
+#define INTERVAL        24          /* 30 ms */
+#define NOTIFY_MS       5
+#define STREAM_MS       8000
+#define SKIP_AT         1000        /* Notification whose sequence number is skipped */
+
+static const bd_addr source = { { 0x21, 0x32, 0x43, 0x54, 0x65, 0x76 } };
+static uint8_t link;
+
+/* The source's notifications */
+static bool streaming;
+static uint64_t stream_end_us;
+static uint32_t seq;
+static uint32_t notified;
+static uint32_t first_ms;
+static uint32_t last_ms;
+
+/* The clock of the service */
+static uint32_t uptime_ms(void)
+{
+    uint64_t ms;
+
+    sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64(), &ms);
+    return (uint32_t)ms;
+}
+
+static void deliver(sl_bt_msg_t *evt)
+{
+    CHECK_MSG(losstst_tput_event(evt), "event 0x%08x not taken", (unsigned)evt->header);
+}
+
+static void notify(uint64_t now_us)
+{
+    sl_bt_msg_t *evt;
+    sl_bt_evt_gatt_characteristic_value_t *e;
+
+    if (!streaming || now_us > stream_end_us || 0 != (now_us / 1000) % NOTIFY_MS) {
+        return;
+    }
+    if (SKIP_AT == notified) {
+        seq++;
+    }
+    evt = sl_bt_host_event(sl_bt_evt_gatt_characteristic_value_id);
+    e = &evt->data.evt_gatt_characteristic_value;
+    e->connection = link;
+    e->characteristic = gattdb_log_output;
+    e->att_opcode = sl_bt_gatt_handle_value_notification;
+    e->value.len = PAYLOAD;
+    memset(e->value.data, 0x5A, PAYLOAD);
+    memcpy(e->value.data, &seq, sizeof(seq));
+    deliver(evt);
+    seq++;
+    if (0 == notified++) {
+        first_ms = uptime_ms();
+    }
+    last_ms = uptime_ms();
+}
+
+static void report_source(void)
+{
+    static const uint8_t ad[] = {
+        2, 0x01, 0x06, 13, 0xFF, 0xFF, 0xFF, 0xAD, 0xBA, 1, 2, 3, 4, 5, 6, 7, 8
+    };
+
+    sl_bt_scanner_process_extended_report(&source, 0, -50, 0, sl_bt_gap_phy_1m, sl_bt_gap_phy_1m,
+                                          ad, sizeof(ad));
+}
+
+/* The link comes up on 2M with the long data length and MTU */
+static void link_up(void)
+{
+    sl_bt_msg_t *evt;
+
+    evt = sl_bt_host_event(sl_bt_evt_connection_opened_id);
+    evt->data.evt_connection_opened.connection = link;
+    evt->data.evt_connection_opened.advertiser = 0xFF;
+    deliver(evt);
+    evt = sl_bt_host_event(sl_bt_evt_connection_parameters_id);
+    evt->data.evt_connection_parameters.connection = link;
+    evt->data.evt_connection_parameters.interval = INTERVAL;
+    deliver(evt);
+    evt = sl_bt_host_event(sl_bt_evt_connection_phy_status_id);
+    evt->data.evt_connection_phy_status.connection = link;
+    evt->data.evt_connection_phy_status.phy = sl_bt_gap_phy_2m;
+    deliver(evt);
+    evt = sl_bt_host_event(sl_bt_evt_connection_data_length_id);
+    evt->data.evt_connection_data_length.connection = link;
+    evt->data.evt_connection_data_length.tx_data_len = 27;
+    evt->data.evt_connection_data_length.rx_data_len = 251;
+    deliver(evt);
+    evt = sl_bt_host_event(sl_bt_evt_gatt_mtu_exchanged_id);
+    evt->data.evt_gatt_mtu_exchanged.connection = link;
+    evt->data.evt_gatt_mtu_exchanged.mtu = MTU;
+    deliver(evt);
+}
+
+static void link_closed(void)
+{
+    sl_bt_msg_t *evt = sl_bt_host_event(sl_bt_evt_connection_closed_id);
+
+    sl_bt_host_drop(link);
+    evt->data.evt_connection_closed.connection = link;
+    evt->data.evt_connection_closed.reason = SL_STATUS_BT_CTRL_CONNECTION_TERMINATED_BY_LOCAL_HOST;
+    deliver(evt);
+}
+
+int main(void)
+{
+    static const sl_bt_host_hooks_t hooks = { .step = notify };
+    test_param_t param = { .phy_2m = true, .tput_source = false };
+    const sl_bt_host_conn_t *conn = NULL;
+    losstst_tput_result_t res;
+    uint32_t expected_bps;
+    int ret;
+
+    CHECK(0 == losstst_init());
+    tput_task_tgr(1);
+    CHECK(0 == tput_setup(&param));
+    CHECK(sl_bt_scanner_scan_phy_1m == sl_bt_host_scanning());
+
+    /* The sink connects to the first source it hears */
+    report_source();
+    CHECK(1 == losstst_tput());
+    CHECK(0 == sl_bt_host_scanning());
+    for (uint8_t c = 1; c <= SL_BT_HOST_MAX_CONNS; c++) {
+        if (sl_bt_host_conn(c)->open) {
+            link = c;
+            conn = sl_bt_host_conn(c);
+        }
+    }
+    CHECK_MSG(conn != NULL, "no connection opened");
+    if (NULL == conn) {
+        return CHECK_RESULT();
+    }
+    CHECK(0 == memcmp(source.addr, conn->peer, 6));
+    CHECK(losstst_tput_connected());
+
+    link_up();
+    CHECK(251 == conn->tx_data_len);
+    CHECK(sl_bt_gap_phy_2m == conn->preferred_phy);
+
+    /* Subscribed after the MTU exchange, on the log characteristic */
+    CHECK(1 == losstst_tput());
+    CHECK_MSG(gattdb_log_output == conn->notify_char && sl_bt_gatt_notification == conn->notify_flags,
+              "subscribed to %u with 0x%x", conn->notify_char, conn->notify_flags);
+
+    streaming = true;
+    stream_end_us = sl_bt_host_now_us() + STREAM_MS * 1000ull;
+    sl_bt_host_hooks(&hooks);
+    for (uint32_t ms = 0; ms < 15000 && (ret = losstst_tput()) > 0; ms++) {
+        if (conn->close_req && conn->open) {
+            link_closed();
+        }
+    }
+    sl_bt_host_hooks(NULL);
+    CHECK_MSG(0 == ret, "losstst_tput() returned %d", ret);
+    CHECK(conn->close_req && !losstst_tput_connected());
+    CHECK(STREAM_MS / NOTIFY_MS == notified);
+
+    /* The first delivery opens the span, its bytes do not count */
+    CHECK(0 == losstst_get_tput_result(0, &res));
+    expected_bps = (uint32_t)((uint64_t)(notified - 1) * PAYLOAD * 8000u / (last_ms - first_ms));
+    CHECK_MSG(notified * PAYLOAD == res.bytes, "%u bytes", res.bytes);
+    CHECK_MSG(expected_bps == res.goodput_bps, "goodput %u bps, expected %u", res.goodput_bps,
+              expected_bps);
+    /* 244 octets every 5 ms */
+    CHECK(res.goodput_bps > 390400 * 99 / 100 && res.goodput_bps < 390400 * 101 / 100);
+    CHECK_MSG(1 == res.seq_lost, "%u lost", res.seq_lost);
+    /* The source fell silent 2 s before the end of the phase: empty windows, one stall */
+    CHECK_MSG(0 == res.win_min_bps && res.win_max_bps > 390400 * 99 / 100
+              && res.win_max_bps < 390400 * 101 / 100, "windows %u-%u bps",
+              res.win_min_bps, res.win_max_bps);
+    CHECK_MSG(1 == res.stalls && res.max_gap_ms >= 1990 && res.max_gap_ms <= 2010,
+              "%u stalls, max gap %u ms", res.stalls, res.max_gap_ms);
+    CHECK(MTU == res.mtu && 251 == res.data_len && INTERVAL == res.conn_interval);
+    CHECK(sl_bt_gap_phy_2m == res.phy);
+    /* 251 octet PDUs on 2M: (251 + 11) * 4 + 150 + 11 * 4 + 150 us per 244 octets */
+    CHECK_MSG(1402298 == res.capacity_bps, "capacity %u bps", res.capacity_bps);
+    CHECK(res.goodput_bps * 100ull / 1402298 == res.util_pct);
+    CHECK(0 == res.backpressure);
+
+    tput_task_tgr(-tput_task_tgr(0));
+    return CHECK_RESULT();
+}
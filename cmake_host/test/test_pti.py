@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""PTI decoder against hand-assembled frames and its own encoder.
+
+The fixtures are PTI frames written out byte by byte with their fields
+worked out by hand, not produced by pti.py: they pin the frame layout,
+and the encoder has to reproduce them exactly. The BLE protocol id and
+the baud rate are read from the SDK and the PTI configuration of the app.
+No recorded capture is in the tree; one should be added here as soon as
+a board is at hand.
+
+Synthetic captures with known loss causes, on every PHY and with an EUI-64
+full of PTI marker bytes, must decode to exactly the frames, errors and
+loss test packets that were encoded, both timed and as a plain binary
+stream.
+
+  test_pti.py <tools dir> [<SDK dir>]
+"""
+
+import argparse
+import os
+import re
+import sys
+import tempfile
+from collections import Counter
+
+TOOLS_DIR = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "..", "..", "tools")
+APP_DIR = os.path.join(TOOLS_DIR, "..")
+SDK_DIR = sys.argv[2] if len(sys.argv) > 2 else os.path.join(APP_DIR, "simplicity_sdk_2025.12.1")
+sys.path.insert(0, TOOLS_DIR)
+import pti  # noqa: E402
+
+failures = 0
+
+
+def check(cond, msg):
+    global failures
+    if not cond:
+        failures += 1
+        print(f"FAIL: {msg}")
+
+
+# Hand-assembled frames: hex by field, then the fields they must decode to
+FIXTURES = (
+    ("RX OK, ADV_NONCONN_IND of the loss test on 37",
+     "f8"                                   # RX start
+     " 42 1b 010203040506"                  # ADV_NONCONN_IND TxAdd, 27 octets, AdvA
+     " 020106"                              # AD flags
+     " 11 ff ffff abba 0500 0100"           # Manufacturer data: man_id, form_id, pre_cnt 5, flow 1
+     " 0011223344556677"                    # EUI-64
+     " 00"                                  # Radio cfg: 1M
+     " c4"                                  # RSSI -60 dBm
+     " 25"                                  # Radio info: channel 37
+     " 03"                                  # Status: OK, protocol BLE
+     " 4c"                                  # Info cfg: RX, version 1, 4 appended bytes
+     " f9",                                 # RX end
+     dict(rx=True, err=0, channel=37, rssi=-60, phy="1M", version=1, pdu_len=29,
+          eui=0x0011223344556677)),
+    ("RX CRC error, AUX_ADV_IND of the loss test on 2M, markers in the EUI-64",
+     "f8"
+     " 07 1d 07 01 010203040506"            # AUX_ADV_IND, 29 octets, ext header 7: AdvA
+     " 020106"
+     " 11 ff ffff abba 0400 0100"           # pre_cnt 4, flow 1
+     " f5d8 1122334455 f5de 77"             # EUI-64 f8..fe77, 0xf8 and 0xfe escaped
+     " 01"                                  # Radio cfg: 2M
+     " a8"                                  # RSSI -88 dBm
+     " 0c"                                  # Radio info: channel 12
+     " 13"                                  # Status: CRC error, protocol BLE
+     " 4c"
+     " f9",
+     dict(rx=True, err=1, channel=12, rssi=-88, phy="2M", version=1, pdu_len=31,
+          eui=0xF81122334455FE77)),
+    ("RX abort, AUX_ADV_IND of someone else on coded",
+     "f8"
+     " 07 08 07 01 a1a2a3a4a5a6"            # AUX_ADV_IND, 8 octets, AdvA only
+     " 02"                                  # Radio cfg: coded
+     " 9c"                                  # RSSI -100 dBm
+     " 05"                                  # Radio info: channel 5
+     " 23"                                  # Status: abort, protocol BLE
+     " 4c"
+     " fa",                                 # RX abort
+     dict(rx=True, err=2, channel=5, rssi=-100, phy="S8", version=1, pdu_len=10, eui=None)),
+    ("TX OK, ADV_NONCONN_IND on 39",
+     "fc"                                   # TX start
+     " 42 06 010203040506"
+     " 00"                                  # Radio cfg: 1M
+     " 27"                                  # Radio info: channel 39, no RSSI on TX
+     " 03"
+     " 0b"                                  # Info cfg: TX, version 1, 3 appended bytes
+     " fd",                                 # TX end
+     dict(rx=False, err=0, channel=39, rssi=None, phy="1M", version=1, pdu_len=8, eui=None)),
+    ("RX OK, version 0 without radio cfg, escaped RSSI",
+     "f8"
+     " 42 06 010203040506"
+     " f5da"                                # RSSI -6 dBm, 0xfa escaped
+     " 26"                                  # Radio info: channel 38
+     " 03"
+     " 43"                                  # Info cfg: RX, version 0, 3 appended bytes
+     " f9",
+     dict(rx=True, err=0, channel=38, rssi=-6, phy=None, version=0, pdu_len=8, eui=None)),
+)
+
+
+def sdk_define(path, name):
+    """Value of a C define or enumerator in a header."""
+    with open(path) as f:
+        m = re.search(rf"\b{name}\s*=?\s*\(?(0x[0-9a-fA-F]+|\d+)", f.read())
+    return int(m.group(1), 0) if m else None
+
+
+def test_fixtures():
+    """Hand-assembled frames: decoded one by one and as a stream, and re-encoded."""
+    stream = b""
+    for what, hexes, exp in FIXTURES:
+        frame = bytes.fromhex(hexes)
+        events = list(pti.decode([(0.0, frame)]))
+        check(len(events) == 1, f"{what}: {len(events)} events")
+        if not events:
+            continue
+        ev = events[0]
+        got = dict(rx=ev.rx, err=ev.err, channel=ev.channel, rssi=ev.rssi, phy=ev.phy,
+                   pdu_len=len(ev.pdu))
+        want = {k: exp[k] for k in got}
+        check(got == want, f"{what}: decoded {got}")
+        check(ev.ok == (exp["err"] == pti.ERR_OK), f"{what}: ok {ev.ok}")
+        check(pti.loss_packet(ev, exp["eui"]) == (exp["eui"] is not None),
+              f"{what}: loss test packet")
+        enc = pti.encode_frame(ev.pdu, rx=exp["rx"], err=exp["err"], channel=exp["channel"],
+                               rssi=exp["rssi"] or 0, phy=exp["phy"] or "1M",
+                               version=exp["version"])
+        check(enc == frame, f"{what}: encoded as {enc.hex()}")
+        # Idle bytes and a stray end marker between frames
+        stream += b"\x00\xf9" + frame
+
+    events = list(pti.decode([(0.0, stream)]))
+    check([(e.rx, e.err, e.channel) for e in events]
+          == [(x["rx"], x["err"], x["channel"]) for _, _, x in FIXTURES],
+          f"fixture stream: {len(events)} events")
+
+    rail_types = os.path.join(SDK_DIR, "rail_library", "common", "rail_types.h")
+    check(sdk_define(rail_types, "RAIL_PTI_PROTOCOL_BLE") == pti.PROTOCOL_BLE,
+          "protocol id differs from RAIL_PTI_PROTOCOL_BLE")
+    pti_config = os.path.join(APP_DIR, "config", "sl_rail_util_pti_config.h")
+    check(sdk_define(pti_config, "SL_RAIL_UTIL_PTI_BAUD_RATE_HZ") == pti.BAUD,
+          "baud rate differs from SL_RAIL_UTIL_PTI_BAUD_RATE_HZ")
+
+
+def synth_args(phy, seed, eui):
+    return argparse.Namespace(packets=400, interval_ms=20.0, phy=phy, eui=eui,
+                              sync_miss=0.05, crc=0.05, abort=0.02, host_drop=0.02,
+                              noise=0.1, seed=seed)
+
+
+def roundtrip(phy, seed, eui, tmp):
+    args = synth_args(phy, seed, eui)
+    chunks, counts = pti.synth(args)
+    path = os.path.join(tmp, f"{phy}_{seed}.txt")
+    with open(path, "w") as f:
+        for t, data in chunks:
+            f.write(f"{t:.0f} {data.hex()}\n")
+
+    events = list(pti.decode(pti.read_capture(path, True)))
+    what = f"{phy} seed {seed}"
+    check(len(events) == len(chunks), f"{what}: {len(events)} events of {len(chunks)} frames")
+    check([round(e.t_us) for e in events] == [round(t) for t, _ in chunks],
+          f"{what}: event times differ from the capture")
+
+    stats, foreign_crc = pti.classify(events, eui)
+    got = stats.get(phy, Counter())
+    check(set(stats) <= {phy}, f"{what}: test frames on {sorted(stats)}")
+    for kind in ("ok", "crc", "abort"):
+        check(got[kind] == counts[kind], f"{what}: {got[kind]} {kind}, encoded {counts[kind]}")
+    noise = len(chunks) - counts["ok"] - counts["crc"] - counts["abort"]
+    check(foreign_crc == noise, f"{what}: {foreign_crc} foreign CRC errors, encoded {noise}")
+    check(counts["ok"] + counts["crc"] + counts["abort"] + counts["sync"] == args.packets,
+          f"{what}: encoder lost packets")
+
+    # Another sender's EUI: nothing is a test frame, the CRC errors are foreign
+    stats, foreign_crc = pti.classify(events, eui ^ 1)
+    check(not stats, f"{what}: frames of another EUI counted")
+    check(foreign_crc == noise + counts["crc"], f"{what}: foreign CRC errors with another EUI")
+
+    # The same frames as one untimed binary stream
+    with open(path + ".bin", "wb") as f:
+        f.write(b"".join(data for _, data in chunks))
+    events = list(pti.decode(pti.read_capture(path + ".bin", False)))
+    check(len(events) == len(chunks), f"{what}: {len(events)} events in the binary stream")
+    check(all(b.t_us > a.t_us for a, b in zip(events, events[1:])),
+          f"{what}: binary stream times not increasing")
+
+    # The app log line of the encoder reads back as the app counts
+    with open(path + ".log", "w") as f:
+        f.write(f"noise\n[SCAN] {phy}: {counts['rcv']}/{args.packets}, sync miss 0\n")
+        f.write(f"[SCAN] {phy}: 1/2\n")
+    check(pti.read_log(path + ".log") == {phy: (counts["rcv"] + 1, args.packets + 2)},
+          f"{what}: log totals")
+    return len(chunks)
+
+
+def test_frames():
+    """Single frames: fields, marker escaping, TX without RSSI, old layout."""
+    pdu = bytes(range(0xF0, 0x100)) + bytes((0x00, 0x42))
+    for rx in (True, False):
+        for err in (pti.ERR_OK, pti.ERR_CRC, pti.ERR_ABORT):
+            for version in (0, 1):
+                frame = pti.encode_frame(pdu, rx=rx, err=err, channel=38, rssi=-77,
+                                         phy="S8", version=version)
+                check(not (pti.MARKERS - {pti.ESCAPE}) & set(frame[1:-1]), "marker inside a frame")
+                events = list(pti.decode([(100.0, b"\x00\xf9" + frame + b"\xf5")]))
+                what = f"rx {rx} err {err} version {version}"
+                check(len(events) == 1, f"{what}: {len(events)} events")
+                if not events:
+                    continue
+                ev = events[0]
+                check(ev.rx == rx and ev.err == err and ev.ok == (err == pti.ERR_OK),
+                      f"{what}: status")
+                check(ev.pdu == pdu and ev.channel == 38, f"{what}: pdu or channel")
+                check(ev.rssi == (-77 if rx else None), f"{what}: rssi {ev.rssi}")
+                check(ev.phy == ("S8" if version else None), f"{what}: phy {ev.phy}")
+
+    # A frame cut by a new start is dropped, the next one decodes
+    frame = pti.encode_frame(b"\x02\x00")
+    events = list(pti.decode([(0.0, frame[:3] + frame)]))
+    check(len(events) == 1, f"cut frame: {len(events)} events")
+
+
+def main():
+    frames = 0
+    test_fixtures()
+    test_frames()
+    with tempfile.TemporaryDirectory() as tmp:
+        for phy in ("2M", "1M", "S8", "BLE4"):
+            for seed in range(1, 6):
+                frames += roundtrip(phy, seed, 0xF8F9FAF5FCFDFE00 | seed, tmp)
+    print(f"{frames} frames encoded and decoded, {failures} failures")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
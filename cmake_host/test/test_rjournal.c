@@ -0,0 +1,116 @@
+/**
+ * @file test_rjournal.c
+ * @brief Retained RAM journal under resets at every byte of a write
+ *
+ * A reset in the middle of rjournal_write() leaves any part of the changed
+ * bytes written. Every prefix, forwards and backwards through the journal,
+ * must read back as either the new record or the previous one.
+ */
+
+#include "check.h"
+#include "rjournal.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define WRITES          500
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1664525u + 1013904223u;
+    return rnd_state >> 8;
+}
+
+static void test_torn_writes(void)
+{
+    static rjournal_t j, old, upd, torn;
+    uint8_t rec[RJOURNAL_MAX_DATA];
+    uint8_t prev[RJOURNAL_MAX_DATA];
+    uint8_t out[RJOURNAL_MAX_DATA];
+    uint32_t resets = 0, bad = 0;
+
+    /* Power-on contents */
+    for (size_t b = 0; b < sizeof(j); b++) {
+        ((uint8_t *)&j)[b] = (uint8_t)rnd();
+    }
+    CHECK(-ENOENT == rjournal_read(&j, out, sizeof(out)));
+
+    for (int it = 0; it < WRITES; it++) {
+        uint16_t len = (uint16_t)(8 + rnd() % 100);
+        int prev_len;
+
+        for (uint16_t i = 0; i < len; i++) {
+            rec[i] = (uint8_t)rnd();
+        }
+        old = j;
+        prev_len = rjournal_read(&old, prev, sizeof(prev));
+        CHECK(0 == rjournal_write(&j, rec, len));
+        upd = j;
+
+        for (size_t k = 0; k <= sizeof(j); k++) {
+            for (int backwards = 0; backwards < 2; backwards++) {
+                int n;
+
+                torn = old;
+                for (size_t b = 0; b < k; b++) {
+                    size_t x = backwards ? sizeof(j) - 1 - b : b;
+                    ((uint8_t *)&torn)[x] = ((const uint8_t *)&upd)[x];
+                }
+                n = rjournal_read(&torn, out, sizeof(out));
+                resets++;
+                if (n == len && 0 == memcmp(out, rec, len)) {
+                    continue;
+                }
+                if (prev_len >= 0 && n == prev_len && 0 == memcmp(out, prev, (size_t)prev_len)) {
+                    continue;
+                }
+                if (prev_len < 0 && -ENOENT == n) {
+                    continue;
+                }
+                bad++;
+            }
+        }
+        CHECK(len == rjournal_read(&j, out, sizeof(out)));
+        CHECK(0 == memcmp(out, rec, len));
+    }
+    printf("%u resets, %u read neither copy\n", resets, bad);
+    CHECK(0 == bad);
+}
+
+static void test_api(void)
+{
+    static rjournal_t j;
+    uint8_t rec[RJOURNAL_MAX_DATA] = { 1, 2, 3, 4 };
+    uint8_t out[RJOURNAL_MAX_DATA];
+
+    rjournal_clear(&j);
+    CHECK(-ENOENT == rjournal_read(&j, out, sizeof(out)));
+    CHECK(-EINVAL == rjournal_write(&j, rec, RJOURNAL_MAX_DATA + 1));
+    CHECK(0 == rjournal_write(&j, rec, 4));
+    CHECK(-ENOSPC == rjournal_read(&j, out, 3));
+    CHECK(4 == rjournal_read(&j, out, 4));
+
+    /* Newest of the two slots wins */
+    rec[0] = 9;
+    CHECK(0 == rjournal_write(&j, rec, 4));
+    CHECK(4 == rjournal_read(&j, out, sizeof(out)) && 9 == out[0]);
+    CHECK(0 == rjournal_write(&j, rec, 0));
+    CHECK(0 == rjournal_read(&j, out, sizeof(out)));
+
+    /* A flipped bit in the newest slot falls back to the older one */
+    rjournal_slot_t *newest = (j.slot[0].seq > j.slot[1].seq) ? &j.slot[0] : &j.slot[1];
+    newest->seq ^= 0x100;
+    CHECK(4 == rjournal_read(&j, out, sizeof(out)) && 9 == out[0]);
+
+    rjournal_clear(&j);
+    CHECK(-ENOENT == rjournal_read(&j, out, sizeof(out)));
+}
+
+int main(void)
+{
+    test_api();
+    test_torn_writes();
+    return CHECK_RESULT();
+}
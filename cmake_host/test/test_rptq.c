@@ -0,0 +1,151 @@
+/**
+ * @file test_rptq.c
+ * @brief Report queue drains: host loss apart from RF loss
+ */
+
+#include "check.h"
+#include "rptq.h"
+
+#include <stddef.h>
+
+#define DEPTH       4
+#define PERIOD_US   10000
+#define BURST_US    500     /* Spacing of queued reports in a drain */
+
+/* Reports of one stream at its event period, from t; returns the time after */
+static uint32_t steady(rptq_mon_t *m, int8_t stream, uint32_t t, int count)
+{
+    for (int i = 0; i < count; i++) {
+        rptq_mon_report(m, stream, t);
+        t += PERIOD_US;
+    }
+    return t;
+}
+
+/* No stall: every report its own run, nothing lost */
+static void test_steady(void)
+{
+    rptq_mon_t m;
+
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&m, 0, PERIOD_US);
+    steady(&m, 0, 1000, 100);
+    CHECK(100 == m.reports);
+    CHECK(0 == m.drains);
+    CHECK(0 == rptq_mon_host_lost(&m, 0));
+}
+
+/* A 100 ms stall and a full drain: 10 events, 4 reports, 6 dropped */
+static void test_saturated(void)
+{
+    rptq_mon_t m;
+    uint32_t t;
+
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&m, 0, PERIOD_US);
+    rptq_mon_period(&m, 1, 2 * PERIOD_US);
+    t = steady(&m, 0, 1000, 5) - PERIOD_US + 100000;
+    for (int i = 0; i < DEPTH; i++) {
+        rptq_mon_report(&m, 0, t);
+        t += BURST_US;
+    }
+    /* Readable with the drain still open */
+    CHECK(6 == rptq_mon_host_lost(&m, 0));
+    /* Stream 1 is in the drain with none of its 5 events */
+    CHECK(5 == rptq_mon_host_lost(&m, 1));
+    CHECK(0 == m.drains);
+
+    steady(&m, 0, t + PERIOD_US, 3);
+    CHECK(1 == m.drains && 1 == m.sat_drains);
+    CHECK(DEPTH == m.max_run);
+    CHECK(6 == m.host_lost[0] && 6 == rptq_mon_host_lost(&m, 0));
+    CHECK(5 == rptq_mon_host_lost(&m, 1));
+    CHECK(0 == rptq_mon_host_lost(&m, 2));
+}
+
+/* A drain shorter than the queue depth dropped nothing */
+static void test_short_drain(void)
+{
+    rptq_mon_t m;
+    uint32_t t = 1000;
+
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&m, 0, PERIOD_US);
+    rptq_mon_report(&m, 0, t);
+    t += 100000;
+    for (int i = 0; i < DEPTH - 1; i++, t += BURST_US) {
+        rptq_mon_report(&m, 0, t);
+    }
+    steady(&m, 0, t + PERIOD_US, 2);
+    CHECK(1 == m.drains && 0 == m.sat_drains);
+    CHECK(DEPTH - 1 == m.max_run);
+    CHECK(0 == rptq_mon_host_lost(&m, 0));
+}
+
+/* Reports of other advertisers fill the queue too */
+static void test_foreign(void)
+{
+    rptq_mon_t m;
+    uint32_t t = 1000;
+
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&m, 0, PERIOD_US);
+    rptq_mon_report(&m, 0, t);
+    t += 100000;
+    rptq_mon_report(&m, -1, t);
+    rptq_mon_report(&m, 0, t + BURST_US);
+    rptq_mon_report(&m, -1, t + 2 * BURST_US);
+    rptq_mon_report(&m, 0, t + 3 * BURST_US);
+    CHECK(8 == rptq_mon_host_lost(&m, 0));
+    CHECK(5 == m.reports);
+
+    /* Out of range streams count as foreign */
+    rptq_mon_period(&m, RPTQ_MAX_STREAMS, PERIOD_US);
+    rptq_mon_report(&m, RPTQ_MAX_STREAMS, t + 4 * BURST_US);
+    CHECK(5 == m.run);
+    CHECK(0 == rptq_mon_host_lost(&m, RPTQ_MAX_STREAMS));
+    CHECK(8 == rptq_mon_host_lost(&m, 0));
+}
+
+/* The microsecond clock wraps during a drain */
+static void test_wrap(void)
+{
+    rptq_mon_t m;
+    uint32_t t = 0xFFFFFFFFu - 100000u;
+
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(&m, 0, PERIOD_US);
+    rptq_mon_report(&m, 0, t);
+    t += 100000;
+    for (int i = 0; i < DEPTH; i++, t += BURST_US) {
+        rptq_mon_report(&m, 0, t);
+    }
+    steady(&m, 0, t + PERIOD_US, 2);
+    CHECK(1 == m.sat_drains);
+    CHECK(6 == rptq_mon_host_lost(&m, 0));
+}
+
+static void test_arguments(void)
+{
+    rptq_mon_t m;
+
+    rptq_mon_init(&m, 0, RPTQ_DRAIN_GAP_US);
+    CHECK(1 == m.depth);
+    rptq_mon_init(NULL, DEPTH, RPTQ_DRAIN_GAP_US);
+    rptq_mon_period(NULL, 0, PERIOD_US);
+    rptq_mon_report(NULL, 0, 0);
+    CHECK(0 == rptq_mon_host_lost(NULL, 0));
+    rptq_mon_init(&m, DEPTH, RPTQ_DRAIN_GAP_US);
+    CHECK(0 == rptq_mon_host_lost(&m, 0));
+}
+
+int main(void)
+{
+    test_steady();
+    test_saturated();
+    test_short_drain();
+    test_foreign();
+    test_wrap();
+    test_arguments();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,363 @@
+/**
+ * @file test_rstore.c
+ * @brief Result store on a RAM NOR flash model with power cuts and faults
+ *
+ * The model programs by clearing bits only and checks the page boundary.
+ * A power cut at flash operation N tears that operation (part of a
+ * program lands, the last byte with random bits; an erase leaves random
+ * bytes erased) and fails everything after it until the next mount.
+ */
+
+#include "check.h"
+#include "rstore.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define SECTORS         8
+#define REC_TYPE        RSTORE_TYPE_RESULT
+
+static uint8_t flash_mem[SECTORS * RSTORE_SECTOR_SIZE];
+static uint32_t ops;            /* Program and erase operations */
+static uint32_t cut_at;         /* Power cut at this operation (0: never) */
+static bool powered_off;
+static uint32_t fail_prog_at;   /* Single program failure, power stays on (0: never) */
+static uint32_t fail_erase_addr = UINT32_MAX;   /* Sector whose erase fails */
+static uint32_t reads;
+static bool page_error;
+
+static uint32_t rnd_state = 12345;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static int model_read(void *ctx, uint32_t addr, void *buf, uint32_t len)
+{
+    (void)ctx;
+    if (powered_off) {
+        return -EIO;
+    }
+    reads++;
+    memcpy(buf, &flash_mem[addr], len);
+    return 0;
+}
+
+static int model_program(void *ctx, uint32_t addr, const void *buf, uint32_t len)
+{
+    const uint8_t *p = buf;
+
+    (void)ctx;
+    if (powered_off) {
+        return -EIO;
+    }
+    if (len && addr / RSTORE_PAGE_SIZE != (addr + len - 1) / RSTORE_PAGE_SIZE) {
+        page_error = true;
+    }
+    ops++;
+    if (ops == fail_prog_at) {
+        return -EIO;
+    }
+    if (ops == cut_at) {
+        uint32_t n = rnd() % (len + 1);
+
+        for (uint32_t i = 0; i < n; i++) {
+            flash_mem[addr + i] &= p[i];
+        }
+        if (n < len) {
+            flash_mem[addr + n] &= (uint8_t)(p[n] | rnd());
+        }
+        powered_off = true;
+        return -EIO;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        flash_mem[addr + i] &= p[i];
+    }
+    return 0;
+}
+
+static int model_erase(void *ctx, uint32_t addr)
+{
+    (void)ctx;
+    if (powered_off) {
+        return -EIO;
+    }
+    ops++;
+    if (addr == fail_erase_addr) {
+        return -EIO;
+    }
+    if (ops == cut_at) {
+        for (uint32_t i = 0; i < RSTORE_SECTOR_SIZE; i++) {
+            if (0 == rnd() % 3) {
+                flash_mem[addr + i] = 0xFF;
+            }
+        }
+        powered_off = true;
+        return -EIO;
+    }
+    memset(&flash_mem[addr], 0xFF, RSTORE_SECTOR_SIZE);
+    return 0;
+}
+
+static const rstore_flash_t model = {
+    .read = model_read,
+    .program = model_program,
+    .erase = model_erase,
+    .ctx = NULL,
+    .base = 0,
+    .sectors = SECTORS,
+};
+
+static rstore_sector_t index_mem[SECTORS];
+
+static void model_reset(void)
+{
+    memset(flash_mem, 0xFF, sizeof(flash_mem));
+    ops = 0;
+    cut_at = 0;
+    powered_off = false;
+    fail_prog_at = 0;
+    fail_erase_addr = UINT32_MAX;
+}
+
+/* Record contents follow from the round id */
+static uint16_t rec_len(uint32_t round)
+{
+    return (uint16_t)((round * 37u) % 300u + 1u);
+}
+
+static void rec_fill(uint32_t round, uint8_t *buf)
+{
+    for (uint16_t i = 0; i < rec_len(round); i++) {
+        buf[i] = (uint8_t)(round * 7u + i);
+    }
+}
+
+static int append_round(rstore_t *st, uint32_t round)
+{
+    uint8_t buf[300];
+
+    rec_fill(round, buf);
+    return rstore_append(st, REC_TYPE, round, buf, rec_len(round));
+}
+
+typedef struct {
+    uint8_t seen[2048];
+    uint32_t visited;
+    uint32_t bad;               /**< Records with wrong length or contents */
+    uint32_t no_data;           /**< Callbacks without data */
+    uint32_t last;              /**< Round of the last record */
+    bool ordered;               /**< Rounds came oldest first */
+    uint32_t stop_after;        /**< Stop the query after this many (0: never) */
+} visit_t;
+
+static bool visit_cb(void *ctx, const rstore_rec_t *rec, const void *data)
+{
+    visit_t *v = ctx;
+    uint8_t expect[300];
+
+    v->visited++;
+    if (rec->round <= v->last && v->visited > 1) {
+        v->ordered = false;
+    }
+    v->last = rec->round;
+    if (NULL == data) {
+        v->no_data++;
+    } else {
+        rec_fill(rec->round, expect);
+        if (REC_TYPE != rec->type || rec->len != rec_len(rec->round)
+            || memcmp(data, expect, rec->len)) {
+            v->bad++;
+        }
+    }
+    if (rec->round < sizeof(v->seen)) {
+        v->seen[rec->round] = 1;
+    }
+    return 0 == v->stop_after || v->visited < v->stop_after;
+}
+
+static int query_all(rstore_t *st, uint32_t lo, uint32_t hi, visit_t *v)
+{
+    static uint8_t buf[400];
+
+    memset(v, 0, sizeof(*v));
+    v->ordered = true;
+    return rstore_query(st, lo, hi, buf, sizeof(buf), visit_cb, v);
+}
+
+/* Power cut at every operation of a run: acked records survive intact */
+static void test_power_cut(void)
+{
+    uint32_t cuts = 0;
+    uint32_t failures = 0;
+
+    for (uint32_t at = 1; at < 3000; at++) {
+        rstore_t st;
+        visit_t v;
+        uint32_t acked = 0;
+
+        model_reset();
+        CHECK(0 == rstore_mount(&st, &model, index_mem));
+        cut_at = at;
+        for (uint32_t r = 1; r < 200 && !powered_off; r++) {
+            if (0 == append_round(&st, r)) {
+                acked = r;
+            }
+        }
+        if (!powered_off) {
+            break;                      /* Run finished before the cut */
+        }
+        cuts++;
+
+        powered_off = false;
+        cut_at = 0;
+        CHECK(0 == rstore_mount(&st, &model, index_mem));
+        CHECK(query_all(&st, 0, UINT32_MAX, &v) >= 0);
+        /* The ring holds far more than the last 20 records */
+        bool ok = (0 == v.bad && v.ordered);
+        for (uint32_t r = (acked > 20) ? acked - 20 : 1; r <= acked; r++) {
+            ok = ok && v.seen[r];
+        }
+        /* Nothing beyond the record the cut hit */
+        ok = ok && v.last <= acked + 1;
+
+        /* The store keeps working after the cut */
+        for (uint32_t r = 1000; r < 1300; r++) {
+            ok = ok && (0 == append_round(&st, r));
+        }
+        CHECK(0 == rstore_mount(&st, &model, index_mem));
+        query_all(&st, 1000, 1299, &v);
+        for (uint32_t r = 1250; r < 1300; r++) {
+            ok = ok && v.seen[r];
+        }
+        ok = ok && 0 == v.bad && 1299 == st.last_round;
+        if (!ok) {
+            failures++;
+            printf("power cut at operation %u: acked %u, last read %u\n", at, acked, v.last);
+        }
+    }
+    printf("%u power cuts, %u failed\n", cuts, failures);
+    CHECK(cuts > 500);
+    CHECK(0 == failures);
+    CHECK(!page_error);
+}
+
+/* A failed program gives up the sector, the next append carries on */
+static void test_program_fault(void)
+{
+    rstore_t st;
+    visit_t v;
+
+    model_reset();
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    for (uint32_t r = 1; r <= 10; r++) {
+        CHECK(0 == append_round(&st, r));
+    }
+    uint16_t head = st.head;
+    fail_prog_at = ops + 2;             /* Data of round 11 */
+    CHECK(-EIO == append_round(&st, 11));
+    CHECK(0 == append_round(&st, 12));
+    CHECK(st.head != head);
+
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    CHECK(11 == query_all(&st, 0, UINT32_MAX, &v));
+    CHECK(!v.seen[11] && v.seen[10] && v.seen[12]);
+    CHECK(0 == v.bad);
+}
+
+/* A sector that fails to erase is left out of the ring */
+static void test_erase_fault(void)
+{
+    rstore_t st;
+    visit_t v;
+
+    model_reset();
+    fail_erase_addr = 2 * RSTORE_SECTOR_SIZE;
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    for (uint32_t r = 1; r <= 150; r++) {
+        CHECK(0 == append_round(&st, r));
+        CHECK(2 != st.head);
+    }
+    CHECK(0 == index_mem[2].seq);
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    CHECK(query_all(&st, 0, UINT32_MAX, &v) > 0);
+    CHECK(0 == v.bad && v.ordered && 150 == v.last);
+}
+
+/* A flipped data bit fails the CRC: that record alone is skipped */
+static void test_corrupt_data(void)
+{
+    rstore_t st;
+    visit_t v;
+
+    model_reset();
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    for (uint32_t r = 1; r <= 5; r++) {
+        CHECK(0 == append_round(&st, r));
+    }
+    /* Data of round 2 follows record 1 */
+    uint32_t addr = (uint32_t)st.head * RSTORE_SECTOR_SIZE + RSTORE_HDR_SIZE
+                    + RSTORE_REC_HDR_SIZE + ((rec_len(1) + 3u) & ~3u) + RSTORE_REC_HDR_SIZE + 3;
+    flash_mem[addr] ^= 0x10;
+    CHECK(4 == query_all(&st, 0, UINT32_MAX, &v));
+    CHECK(!v.seen[2] && v.seen[1] && v.seen[3]);
+}
+
+/* The ring drops the oldest sector; range queries read only overlapping sectors */
+static void test_ring_and_range(void)
+{
+    rstore_t st;
+    visit_t v;
+    uint8_t small[16];
+
+    model_reset();
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    for (uint32_t r = 1; r <= 2000; r++) {
+        CHECK(0 == append_round(&st, r));
+    }
+    CHECK(0 == rstore_mount(&st, &model, index_mem));
+    CHECK(2000 == st.last_round);
+    /* Erases spread over the ring: every sector is within one lap */
+    CHECK(st.erase_max >= 2000 / (SECTORS * 20));
+    CHECK(query_all(&st, 0, UINT32_MAX, &v) > 0);
+    CHECK(0 == v.bad && v.ordered && 2000 == v.last);
+    CHECK(!v.seen[1]);
+
+    reads = 0;
+    CHECK(3 == query_all(&st, 1990, 1992, &v));
+    uint32_t range_reads = reads;
+    reads = 0;
+    query_all(&st, 0, UINT32_MAX, &v);
+    CHECK(range_reads * 3 < reads);
+
+    /* Short buffer: records still visited, without data */
+    memset(&v, 0, sizeof(v));
+    CHECK(3 == rstore_query(&st, 1990, 1992, small, sizeof(small), visit_cb, &v));
+    CHECK(3 == v.no_data);
+
+    /* The callback stops the query */
+    memset(&v, 0, sizeof(v));
+    v.ordered = true;
+    v.stop_after = 2;
+    CHECK(2 == rstore_query(&st, 0, UINT32_MAX, small, sizeof(small), visit_cb, &v));
+
+    /* Format empties the store */
+    CHECK(0 == rstore_format(&st));
+    CHECK(0 == query_all(&st, 0, UINT32_MAX, &v));
+    CHECK(-EINVAL == rstore_append(&st, 0, 1, small, 1));
+    CHECK(-EINVAL == rstore_append(&st, REC_TYPE, 1, small, RSTORE_MAX_DATA + 1));
+}
+
+int main(void)
+{
+    test_power_cut();
+    test_program_fault();
+    test_erase_fault();
+    test_corrupt_data();
+    test_ring_and_range();
+    return CHECK_RESULT();
+}
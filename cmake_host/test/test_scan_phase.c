@@ -0,0 +1,369 @@
+/**
+ * @file test_scan_phase.c
+ * @brief Scan PHY schedule against a simulated sender and channel
+ *
+ * The sender runs burst cycles as losstst_sender(): a 3 step countdown,
+ * the guard, a burst of LOSS_TEST_BURST_COUNT events with the remaining
+ * seconds in pre_cnt, then pre_cnt 0 for a pause of at least 1 s. The
+ * channel delivers a packet of the scanned group with a fixed loss; dual
+ * PHY scanning splits the time between the groups, so it gets half. The
+ * scanner side follows losstst_scanner(): a countdown seen at a poll opens
+ * a reception window on its group, scanned on both PHYs until shortly
+ * before the predicted burst start; pre_cnt 0 on every PHY of the group or
+ * the predicted burst end closes it and holds the group predicted next.
+ */
+
+#include "check.h"
+#include "scan_phase.h"
+
+#include <string.h>
+
+#define STEP_MS         5
+#define POLL_MS         100     /* losstst_scanner() call period */
+#define INTERVAL_MS     20      /* Advertising interval of the sender */
+#define BURST_MS        (250 * INTERVAL_MS)
+#define CYCLES          40
+#define LOSS_PERMILLE   50      /* Channel loss of a scanned packet */
+#define PHY_SEL         0x7     /* 2M, 1M and Coded */
+
+enum {
+    ORDER_ALTERNATE,            /* Sender picks as scan_phase_next_method() predicts */
+    ORDER_SURPRISE,             /* Every third cycle repeats the last group */
+    ORDER_CONCURRENT,           /* Both groups burst in every cycle */
+    ORDER_DUAL_ONLY,            /* Alternate, scanner never leaves 1M+Coded */
+};
+
+typedef struct {
+    uint32_t burst_tx[3];       /**< Burst packets sent per group (0 unused) */
+    uint32_t burst_rx[3];       /**< Burst packets received per group */
+    uint32_t countdowns;        /**< Countdowns sent */
+    uint32_t caught;            /**< Countdowns that opened a window before the burst */
+    uint32_t wrong;             /**< Holds on the group the sender did not pick next */
+} sim_result_t;
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1664525u + 1013904223u;
+    return rnd_state >> 8;
+}
+
+static int group_of(int idx)
+{
+    return (SCAN_PHASE_CODED == idx) ? 2 : 1;
+}
+
+static bool received(int8_t method, int idx)
+{
+    uint32_t r = rnd() % 2000;
+
+    if (0 == method) {
+        /* Half the scan time on each primary PHY */
+        return r < 1000 - LOSS_PERMILLE / 2;
+    }
+    if (method != group_of(idx)) {
+        return false;
+    }
+    return r < 2000 - 2 * LOSS_PERMILLE;
+}
+
+/* All PHYs of the group (0: both groups) received their pre_cnt 0 */
+static bool group_ended(const scan_phase_t *sp, int8_t method)
+{
+    for (int idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        if ((PHY_SEL & (1u << idx)) && (0 == method || method == group_of(idx))
+            && 0 != sp->pre_cnt[idx]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void simulate(int order, uint32_t seed, sim_result_t *res)
+{
+    scan_phase_t sp;
+    uint16_t flow[SCAN_PHASE_PHYS] = { 0 };
+    int16_t last_rx[SCAN_PHASE_PHYS];
+    uint16_t sent_flow[3] = { 0 };
+    int64_t t = 1000;
+    int last_group = 2;
+
+    bool in_window = false;
+    bool dual = false;
+    int8_t win_method = 0;
+    int8_t held = 0;
+    int64_t win_barrier = 0;
+    uint32_t win_cycle = UINT32_MAX;
+
+    memset(res, 0, sizeof(*res));
+    memset(&sp, 0, sizeof(sp));
+    rnd_state = seed;
+    scan_phase_round(&sp, PHY_SEL, BURST_MS);
+    for (int idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        sp.pre_cnt[idx] = SCAN_PHASE_PRE_CNT_IDLE;
+        last_rx[idx] = SCAN_PHASE_PRE_CNT_IDLE;
+    }
+
+    for (uint32_t cycle = 0; cycle < CYCLES; cycle++) {
+        /* Sender group selection */
+        bool groups[3] = { false, false, false };
+        if (ORDER_CONCURRENT == order) {
+            groups[1] = groups[2] = true;
+        } else if (ORDER_SURPRISE == order && 2 == cycle % 3) {
+            groups[last_group] = true;
+        } else {
+            groups[(sent_flow[1] <= sent_flow[2]) ? 1 : 2] = true;
+        }
+        last_group = groups[1] ? 1 : 2;
+        if (0 != held && !groups[held]) {
+            res->wrong++;
+        }
+        held = 0;
+
+        int64_t cd_start = t;
+        int64_t burst_start = cd_start + 3 * SCAN_PHASE_PRE_CNT_MS + SCAN_PHASE_GUARD_MS;
+        int64_t burst_end = burst_start + BURST_MS;
+        int64_t cycle_end = burst_end + 1000 + (int64_t)(rnd() % 500);
+        res->countdowns++;
+
+        for (; t < cycle_end; t += STEP_MS) {
+            /* Scan method of this moment */
+            int8_t method;
+            if (ORDER_DUAL_ONLY == order) {
+                method = 0;
+            } else if (in_window) {
+                if (!dual) {
+                    dual = scan_phase_concurrent(&sp, t);
+                }
+                method = dual ? 0 : scan_phase_window_method(&sp, win_method, t);
+            } else {
+                method = scan_phase_method(&sp, 0, t);
+            }
+
+            for (int idx = 0; idx < 3; idx++) {
+                int g = group_of(idx);
+                int16_t pre_cnt;
+
+                if (!groups[g] || 0 != (t - cd_start) % INTERVAL_MS) {
+                    continue;
+                }
+                if (t < cd_start + 3 * SCAN_PHASE_PRE_CNT_MS) {
+                    pre_cnt = (int16_t)(-3 + (t - cd_start) / SCAN_PHASE_PRE_CNT_MS);
+                } else if (t < burst_start) {
+                    pre_cnt = -1;
+                } else if (t < burst_end) {
+                    pre_cnt = (int16_t)((burst_end - t + SCAN_PHASE_PRE_CNT_MS - 1) / SCAN_PHASE_PRE_CNT_MS);
+                    res->burst_tx[g]++;
+                } else {
+                    pre_cnt = 0;
+                }
+                if (!received(method, idx)) {
+                    continue;
+                }
+                if (pre_cnt > 0) {
+                    res->burst_rx[g]++;
+                }
+                scan_phase_precnt(&sp, (uint8_t)idx, pre_cnt, t);
+
+                if (0 == pre_cnt && 0 != last_rx[idx]) {
+                    flow[idx]++;
+                }
+                last_rx[idx] = pre_cnt;
+
+                if (in_window && 0 == pre_cnt && (dual || g == win_method)
+                    && group_ended(&sp, dual ? 0 : win_method)) {
+                    /* Burst end of every PHY of the active group */
+                    in_window = false;
+                    if (dual) {
+                        sp.method = 0;
+                    } else {
+                        held = scan_phase_next_method(&sp, 0, flow);
+                        scan_phase_hold(&sp, held, sp.pre_cnt_tm[idx], t);
+                    }
+                }
+            }
+
+            if (!in_window && 0 == t % POLL_MS) {
+                /* Scanner poll: a countdown opens the window on its group */
+                for (int idx = 0; idx < 3; idx++) {
+                    if (sp.pre_cnt[idx] < 0 && SCAN_PHASE_PRE_CNT_IDLE != sp.pre_cnt[idx]) {
+                        in_window = true;
+                        win_method = (int8_t)group_of(idx);
+                        win_barrier = t + 3 * SCAN_PHASE_PRE_CNT_MS + 2 * BURST_MS;
+                        dual = scan_phase_concurrent(&sp, t);
+                        if (win_cycle != cycle && t < burst_start) {
+                            res->caught++;
+                        }
+                        win_cycle = cycle;
+                        break;
+                    }
+                }
+            }
+
+            if (in_window && scan_phase_barrier(&sp, dual ? 0 : win_method, win_barrier, t) <= t) {
+                /* Window ended on the prediction, without a pre_cnt 0 */
+                in_window = false;
+                if (dual) {
+                    sp.method = 0;
+                } else {
+                    held = scan_phase_next_method(&sp, 0, flow);
+                    scan_phase_hold(&sp, held, sp.end_tm, t);
+                }
+            }
+        }
+        for (int g = 1; g <= 2; g++) {
+            sent_flow[g] += groups[g] ? 1 : 0;
+        }
+    }
+}
+
+static uint32_t permille(uint32_t n, uint32_t d)
+{
+    return d ? (uint32_t)((uint64_t)n * 1000 / d) : 0;
+}
+
+/* Predictions from single countdown values */
+static void test_predictions(void)
+{
+    scan_phase_t sp;
+
+    memset(&sp, 0, sizeof(sp));
+    scan_phase_round(&sp, PHY_SEL, BURST_MS);
+
+    scan_phase_precnt(&sp, 1, -3, 10000);
+    CHECK(10000 + 3000 + SCAN_PHASE_GUARD_MS == scan_phase_burst_start(&sp, 1));
+    CHECK(10000 + 3000 + SCAN_PHASE_GUARD_MS + BURST_MS
+          == scan_phase_burst_end(&sp, 1, scan_phase_burst_start(&sp, 1)));
+
+    /* The stamp only moves on a change of value */
+    scan_phase_precnt(&sp, 1, -3, 10400);
+    CHECK(10000 == sp.pre_cnt_tm[1]);
+    scan_phase_precnt(&sp, 1, -2, 11010);
+    CHECK(11010 + 2000 + SCAN_PHASE_GUARD_MS == scan_phase_burst_start(&sp, 1));
+
+    /* Remaining burst seconds take over from the countdown */
+    scan_phase_precnt(&sp, 1, 4, 14000);
+    CHECK(0 == scan_phase_burst_start(&sp, 1));
+    CHECK(18000 == scan_phase_burst_end(&sp, 1, 0));
+    CHECK(18000 + SCAN_PHASE_TAIL_MS == scan_phase_barrier(&sp, 1, 30000, 14000));
+    CHECK(16000 == scan_phase_barrier(&sp, 1, 16000, 14000));
+    /* The Coded group has no countdown */
+    CHECK(30000 == scan_phase_barrier(&sp, 2, 30000, 14000));
+    /* Stale stamps are ignored */
+    CHECK(30000 == scan_phase_barrier(&sp, 1, 30000, 14000 + SCAN_PHASE_STALE_MS + 1));
+
+    /* Idle and done values carry no timing */
+    scan_phase_precnt(&sp, 2, SCAN_PHASE_PRE_CNT_IDLE, 14000);
+    CHECK(0 == scan_phase_burst_start(&sp, 2));
+    scan_phase_precnt(&sp, 2, SCAN_PHASE_PRE_CNT_DONE, 15000);
+    CHECK(0 == scan_phase_burst_end(&sp, 2, 0));
+}
+
+/* Next group: the uncoded group until its slowest PHY overtakes Coded */
+static void test_next_method(void)
+{
+    scan_phase_t sp;
+    uint16_t flow[SCAN_PHASE_PHYS] = { 3, 2, 2, 0 };
+
+    memset(&sp, 0, sizeof(sp));
+    scan_phase_round(&sp, PHY_SEL, BURST_MS);
+    CHECK(1 == scan_phase_next_method(&sp, 0, flow));
+    flow[1] = 3;
+    CHECK(2 == scan_phase_next_method(&sp, 0, flow));
+    /* Completed PHYs drop out */
+    CHECK(1 == scan_phase_next_method(&sp, 1u << 2, flow));
+    CHECK(2 == scan_phase_next_method(&sp, 0x3, flow));
+    CHECK(0 == scan_phase_next_method(&sp, 0x7, flow));
+    sp.pre_cnt[2] = SCAN_PHASE_PRE_CNT_DONE;
+    CHECK(1 == scan_phase_next_method(&sp, 0, flow));
+}
+
+/* A hold ends within the pause before the next countdown */
+static void test_hold(void)
+{
+    scan_phase_t sp;
+
+    memset(&sp, 0, sizeof(sp));
+    scan_phase_hold(&sp, 2, 50000, 50020);
+    CHECK(2 == scan_phase_method(&sp, 0, 50000 + SCAN_PHASE_HOLD_MS - 1));
+    CHECK(0 == scan_phase_method(&sp, 0, 50000 + SCAN_PHASE_HOLD_MS));
+    CHECK(0 == sp.method);
+    CHECK(SCAN_PHASE_HOLD_MS < 1000);
+
+    /* An end in the future holds from now */
+    scan_phase_hold(&sp, 1, 60000, 59000);
+    CHECK(59000 + SCAN_PHASE_HOLD_MS == sp.expire_tm);
+
+    scan_phase_reset(&sp);
+    CHECK(0 == scan_phase_method(&sp, 0, 59001));
+}
+
+/* Both PHYs while counting down, the window's group from shortly before the burst */
+static void test_window_method(void)
+{
+    scan_phase_t sp;
+
+    memset(&sp, 0, sizeof(sp));
+    scan_phase_round(&sp, PHY_SEL, BURST_MS);
+    scan_phase_precnt(&sp, 1, -3, 20000);
+    scan_phase_barrier(&sp, 1, 40000, 20000);
+    CHECK(23000 + SCAN_PHASE_GUARD_MS == sp.start_tm);
+    CHECK(0 == scan_phase_window_method(&sp, 1, 20000));
+    CHECK(0 == scan_phase_window_method(&sp, 1, sp.start_tm - SCAN_PHASE_SETTLE_MS - 1));
+    CHECK(1 == scan_phase_window_method(&sp, 1, sp.start_tm - SCAN_PHASE_SETTLE_MS));
+
+    /* The other group counting down as well keeps both PHYs */
+    scan_phase_precnt(&sp, 2, -1, 22500);
+    CHECK(0 == scan_phase_window_method(&sp, 1, 22800));
+}
+
+static void test_channel_sim(void)
+{
+    sim_result_t sched;
+    sim_result_t dual;
+    sim_result_t surprise;
+    sim_result_t conc;
+
+    simulate(ORDER_ALTERNATE, 1, &sched);
+    simulate(ORDER_DUAL_ONLY, 1, &dual);
+    simulate(ORDER_SURPRISE, 2, &surprise);
+    simulate(ORDER_CONCURRENT, 3, &conc);
+
+    for (int g = 1; g <= 2; g++) {
+        uint32_t s = permille(sched.burst_rx[g], sched.burst_tx[g]);
+        uint32_t d = permille(dual.burst_rx[g], dual.burst_tx[g]);
+        printf("group %d: scheduled %u, dual only %u permille received\n", g, s, d);
+        /* Single PHY scanning gets close to the channel, dual about half */
+        CHECK_MSG(s >= 900, "group %d scheduled %u", g, s);
+        CHECK_MSG(d <= 520, "group %d dual %u", g, d);
+    }
+    CHECK(sched.caught == sched.countdowns);
+    CHECK_MSG(0 == sched.wrong, "%u wrong", sched.wrong);
+
+    /* Wrong predictions cost no countdown: the hold ends before it */
+    printf("surprise: %u wrong holds, %u/%u countdowns caught\n",
+           surprise.wrong, surprise.caught, surprise.countdowns);
+    CHECK(surprise.wrong > 0);
+    CHECK(surprise.caught == surprise.countdowns);
+    for (int g = 1; g <= 2; g++) {
+        CHECK(permille(surprise.burst_rx[g], surprise.burst_tx[g]) >= 900);
+    }
+
+    /* A concurrent sender keeps the scanner on both PHYs, no group starves */
+    for (int g = 1; g <= 2; g++) {
+        uint32_t c = permille(conc.burst_rx[g], conc.burst_tx[g]);
+        printf("concurrent group %d: %u permille received\n", g, c);
+        CHECK_MSG(c >= 420 && c <= 520, "group %d concurrent %u", g, c);
+    }
+}
+
+int main(void)
+{
+    test_predictions();
+    test_next_method();
+    test_hold();
+    test_window_method();
+    test_channel_sim();
+    return CHECK_RESULT();
+}
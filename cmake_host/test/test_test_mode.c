@@ -0,0 +1,494 @@
+/**
+ * @file test_test_mode.c
+ * @brief Test mode registry and scheduler
+ *
+ * test_mode.c on stubs of the sleeptimer and of the application calls it
+ * makes. The timer only fires when a test says so.
+ */
+
+#include "check.h"
+#include "app.h"
+#include "sl_sleeptimer.h"
+#include "test_mode.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Stubs: sleeptimer */
+
+static sl_sleeptimer_timer_callback_t timer_cb;
+static bool timer_running;
+static uint32_t timer_ms;
+
+sl_status_t sl_sleeptimer_ms32_to_tick(uint32_t time_ms, uint32_t *tick)
+{
+    *tick = time_ms;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_restart_timer(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout,
+                                        sl_sleeptimer_timer_callback_t callback, void *callback_data,
+                                        uint8_t priority, uint16_t option_flags)
+{
+    (void)handle;
+    (void)callback_data;
+    (void)priority;
+    (void)option_flags;
+    timer_cb = callback;
+    timer_ms = timeout;
+    timer_running = true;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+    (void)handle;
+    timer_running = false;
+    return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(const sl_sleeptimer_timer_handle_t *handle, bool *running)
+{
+    (void)handle;
+    *running = timer_running;
+    return SL_STATUS_OK;
+}
+
+static void timer_fire(void)
+{
+    CHECK(timer_running);
+    timer_running = false;
+    timer_cb(NULL, NULL);
+}
+
+/* Stubs: application */
+
+static int proceeds;
+static uint8_t adv_blocked;
+
+void app_proceed(void)
+{
+    proceeds++;
+}
+
+void blocking_adv(uint8_t index)
+{
+    adv_blocked |= 1u << index;
+}
+
+/* Controller scheduler profile in effect, and at the last setup */
+static uint8_t prio_now;
+static uint8_t prio_at_setup;
+static int prio_applies;
+
+int losstst_prio_apply(uint8_t profile)
+{
+    prio_now = profile;
+    prio_applies++;
+    return 0;
+}
+
+/* Controller switches in effect, and at the last setup, on a build with
+ * adaptivity on and early abort off */
+#define CTRL_BUILD      LOSSTST_CTRL_ADAPTIVITY
+
+static uint8_t ctrl_now = CTRL_BUILD;
+static uint8_t ctrl_at_setup;
+
+int losstst_ctrl_apply(uint8_t switches)
+{
+    ctrl_now = switches;
+    return 0;
+}
+
+uint8_t losstst_ctrl_default(void)
+{
+    return CTRL_BUILD;
+}
+
+/* Modes: a trigger each, hooks that log what ran */
+
+static char log_buf[64];
+static int8_t tgr_val[3];
+static int step_results[8];
+static int step_count;
+static int setup_result;
+static bool abort_now;
+static int teardown_result;
+static uint8_t app_res;
+
+static void log_event(char c)
+{
+    size_t n = strlen(log_buf);
+
+    if (n + 1 < sizeof(log_buf)) {
+        log_buf[n] = c;
+        log_buf[n + 1] = '\0';
+    }
+}
+
+/* Read with 0, set with a positive value, clear with its negative */
+static int8_t tgr(int n, int8_t set)
+{
+    if (set > 0) {
+        tgr_val[n] = set;
+    } else if (set < 0 && -set == tgr_val[n]) {
+        tgr_val[n] = 0;
+    }
+    return tgr_val[n];
+}
+
+static int8_t tgr_a(int8_t set) { return tgr(0, set); }
+static int8_t tgr_b(int8_t set) { return tgr(1, set); }
+static int8_t tgr_c(int8_t set) { return tgr(2, set); }
+
+static int setup_hook(const test_param_t *param)
+{
+    (void)param;
+    log_event('S');
+    prio_at_setup = prio_now;
+    ctrl_at_setup = ctrl_now;
+    return setup_result;
+}
+
+static int step_hook(void)
+{
+    log_event('s');
+    return step_results[step_count++];
+}
+
+static bool abort_hook(void)
+{
+    return abort_now;
+}
+
+static void settle_hook(void)
+{
+    log_event('x');
+}
+
+static void teardown_hook(int result)
+{
+    log_event('T');
+    teardown_result = result;
+}
+
+static uint8_t in_use(void)
+{
+    return app_res;
+}
+
+static const test_mode_t modes[] = {
+    { "A", tgr_a, setup_hook, step_hook, abort_hook, settle_hook, teardown_hook,
+      TEST_MODE_RES_ADV_SETS, LOSSTST_PRIO_ADV_EXCLUSIVE, { 50, 20 } },
+    { "B", tgr_b, setup_hook, step_hook, NULL, NULL, NULL,
+      TEST_MODE_RES_SCANNER, LOSSTST_PRIO_SCAN_EXCLUSIVE, { 0, 0 } },
+    { "C", tgr_c, setup_hook, step_hook, NULL, NULL, teardown_hook,
+      TEST_MODE_RES_CONNECTION, LOSSTST_PRIO_LOG_FRIENDLY, { 30, 0 } },
+};
+
+static test_param_t param;
+
+/* Steps return the given results, the last one ends the mode */
+static void start(int n, const int *results, int count)
+{
+    memcpy(step_results, results, (size_t)count * sizeof(int));
+    step_count = 0;
+    setup_result = 0;
+    abort_now = false;
+    adv_blocked = 0;
+    log_buf[0] = '\0';
+    tgr(n, (int8_t)(n + 1));
+}
+
+static void test_register(void)
+{
+    test_mode_t bad[2] = { modes[0], modes[1] };
+
+    /* Nothing registered: nothing runs */
+    tgr_a(1);
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    tgr_a(-1);
+
+    CHECK(-EINVAL == test_mode_register(NULL, 1, NULL));
+    CHECK(-EINVAL == test_mode_register(modes, 0, NULL));
+    bad[1].step = NULL;
+    CHECK(-EINVAL == test_mode_register(bad, 2, NULL));
+    bad[1] = modes[1];
+    bad[1].setup = NULL;
+    CHECK(-EINVAL == test_mode_register(bad, 2, NULL));
+    bad[1] = modes[1];
+    bad[1].trigger = tgr_a;
+    CHECK(-EINVAL == test_mode_register(bad, 2, NULL));
+    CHECK(0 == test_mode_register(modes, 3, in_use));
+}
+
+/* Setup, both settle periods timed, steps until the mode finishes */
+static void test_lifecycle(void)
+{
+    const int results[] = { 1, 1, 0 };
+
+    start(0, results, 3);
+    test_mode_run(&param);
+    CHECK(&modes[0] == test_mode_active());
+    CHECK(TEST_MODE_RES_ADV_SETS == test_mode_resources());
+    CHECK(0x0F == adv_blocked);
+    CHECK(timer_running && 50 == timer_ms);
+
+    /* Nothing happens before the timer fires */
+    test_mode_run(&param);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("S", log_buf));
+
+    proceeds = 0;
+    timer_fire();
+    CHECK(1 == proceeds);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("Sx", log_buf));
+    CHECK(timer_running && 20 == timer_ms);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("Sx", log_buf));
+
+    /* Run state: steps keep a tick timer going */
+    timer_fire();
+    test_mode_run(&param);
+    CHECK(timer_running && TEST_MODE_TICK_MS == timer_ms);
+    CHECK(0 == strcmp("Sx", log_buf));
+    test_mode_run(&param);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("Sxss", log_buf));
+    CHECK(&modes[0] == test_mode_active());
+    test_mode_run(&param);
+    CHECK(0 == strcmp("SxsssT", log_buf));
+    CHECK(0 == teardown_result);
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == test_mode_resources());
+    CHECK(0 == test_mode_trigger());
+    CHECK(!timer_running);
+
+    /* Idle again: nothing to run */
+    test_mode_run(&param);
+    CHECK(0 == strcmp("SxsssT", log_buf));
+}
+
+/* Without settle periods the first pass after setup steps */
+static void test_no_settle(void)
+{
+    const int results[] = { 1, -EIO };
+
+    start(1, results, 2);
+    test_mode_run(&param);
+    CHECK(&modes[1] == test_mode_active());
+    CHECK(0 == adv_blocked);
+    CHECK(timer_running && TEST_MODE_TICK_MS == timer_ms);
+    test_mode_run(&param);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("Sss", log_buf));
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == tgr_b(0));
+
+    /* One settle period without a settle hook, an error ends the mode */
+    start(2, results + 1, 1);
+    test_mode_run(&param);
+    CHECK(timer_running && 30 == timer_ms);
+    timer_fire();
+    test_mode_run(&param);
+    CHECK(timer_running && TEST_MODE_TICK_MS == timer_ms);
+    test_mode_run(&param);
+    CHECK(0 == strcmp("SsT", log_buf));
+    CHECK(-EIO == teardown_result);
+}
+
+/* Table order decides between triggered modes */
+static void test_order(void)
+{
+    const int results[] = { 0 };
+
+    start(2, results, 1);
+    tgr_b(2);
+    test_mode_run(&param);
+    CHECK(&modes[1] == test_mode_active());
+    CHECK(3 == test_mode_trigger());
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == tgr_b(0) && 3 == tgr_c(0));
+
+    step_count = 0;
+    test_mode_run(&param);
+    CHECK(&modes[2] == test_mode_active());
+    timer_fire();
+    test_mode_run(&param);
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == test_mode_trigger());
+}
+
+/* A mode needing what the application holds is refused, its trigger cleared */
+static void test_resources(void)
+{
+    const int results[] = { 0 };
+
+    app_res = TEST_MODE_RES_SCANNER | TEST_MODE_RES_ADV_STATUS;
+    start(1, results, 1);
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == tgr_b(0));
+    CHECK(0 == strcmp("", log_buf));
+
+    /* No overlap: runs */
+    start(0, results, 1);
+    test_mode_run(&param);
+    CHECK(&modes[0] == test_mode_active());
+    app_res = 0;
+    abort_now = true;
+    test_mode_run(&param);
+    tgr_a(-1);
+    CHECK(NULL == test_mode_active());
+}
+
+/* A failed setup and an abort while settling release the mode */
+static void test_failures(void)
+{
+    const int results[] = { 0 };
+
+    start(0, results, 1);
+    setup_result = -EIO;
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(0 == test_mode_resources());
+    CHECK(0 == tgr_a(0));
+    CHECK(!timer_running);
+    CHECK(0 == strcmp("S", log_buf));
+
+    /* Aborted in either settle period: no settle hook, step or teardown */
+    for (int phase = 0; phase < 2; phase++) {
+        start(0, results, 1);
+        test_mode_run(&param);
+        if (phase == 1) {
+            timer_fire();
+            test_mode_run(&param);
+        }
+        tgr_a(-1);
+        abort_now = true;
+        test_mode_run(&param);
+        CHECK(NULL == test_mode_active());
+        CHECK(!timer_running);
+        CHECK(0 == strcmp(phase ? "Sx" : "S", log_buf));
+        test_mode_run(&param);
+        CHECK(NULL == test_mode_active());
+    }
+}
+
+/* The profile of the mode, or of the parameters, from setup to the end */
+static void test_priority(void)
+{
+    const int results[] = { 1, 0 };
+    int applies;
+
+    start(1, results, 2);
+    test_mode_run(&param);
+    CHECK(LOSSTST_PRIO_SCAN_EXCLUSIVE == prio_at_setup);
+    test_mode_run(&param);
+    CHECK(LOSSTST_PRIO_SCAN_EXCLUSIVE == prio_now);
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(LOSSTST_PRIO_DEFAULT == prio_now);
+
+    param.prio_profile = LOSSTST_PRIO_SHARED;
+    start(1, results, 2);
+    test_mode_run(&param);
+    CHECK(LOSSTST_PRIO_SHARED == prio_at_setup);
+    test_mode_run(&param);
+    test_mode_run(&param);
+    CHECK(LOSSTST_PRIO_DEFAULT == prio_now);
+    param.prio_profile = LOSSTST_PRIO_AUTO;
+
+    /* Back to the default after a failed setup */
+    start(2, results, 2);
+    setup_result = -EIO;
+    test_mode_run(&param);
+    CHECK(LOSSTST_PRIO_LOG_FRIENDLY == prio_at_setup);
+    CHECK(LOSSTST_PRIO_DEFAULT == prio_now);
+
+    /* A refused mode leaves the profile alone */
+    applies = prio_applies;
+    app_res = TEST_MODE_RES_CONNECTION;
+    start(2, results, 2);
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(applies == prio_applies);
+    app_res = 0;
+}
+
+/* The switches of the parameters from setup to the end, then the build's */
+static void test_ctrl_switches(void)
+{
+    const int results[] = { 1, 0 };
+    const uint8_t runs[] = {
+        LOSSTST_CTRL_EARLY_ABORT,
+        LOSSTST_CTRL_EARLY_ABORT | LOSSTST_CTRL_ADAPTIVITY,
+        0,
+    };
+
+    for (size_t i = 0; i < sizeof(runs); i++) {
+        param.ctrl_switches = runs[i];
+        start(1, results, 2);
+        test_mode_run(&param);
+        CHECK(runs[i] == ctrl_at_setup);
+        test_mode_run(&param);
+        CHECK(runs[i] == ctrl_now);
+        test_mode_run(&param);
+        CHECK(NULL == test_mode_active());
+        CHECK(CTRL_BUILD == ctrl_now);
+    }
+
+    /* Also after a failed setup or an abort */
+    param.ctrl_switches = LOSSTST_CTRL_EARLY_ABORT;
+    start(1, results, 2);
+    setup_result = -EIO;
+    test_mode_run(&param);
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == ctrl_at_setup);
+    CHECK(CTRL_BUILD == ctrl_now);
+    start(0, results, 2);
+    test_mode_run(&param);
+    CHECK(LOSSTST_CTRL_EARLY_ABORT == ctrl_now);
+    tgr_a(-1);
+    abort_now = true;
+    test_mode_run(&param);
+    CHECK(NULL == test_mode_active());
+    CHECK(CTRL_BUILD == ctrl_now);
+    param.ctrl_switches = CTRL_BUILD;
+}
+
+/* Trigger changes seen since the last update */
+static void test_resched(void)
+{
+    CHECK(0 == test_mode_trigger());
+    test_mode_resched(true);
+    CHECK(0 == test_mode_resched(false));
+    tgr_b(2);
+    CHECK(2 == test_mode_resched(false));
+    CHECK(2 == test_mode_resched(true));
+    CHECK(0 == test_mode_resched(false));
+    tgr_b(-2);
+    CHECK(-2 == test_mode_resched(false));
+    CHECK(-2 == test_mode_resched(true));
+    CHECK(0 == test_mode_resched(false));
+}
+
+int main(void)
+{
+    param.prio_profile = LOSSTST_PRIO_AUTO;
+    param.ctrl_switches = CTRL_BUILD;
+    test_register();
+    test_lifecycle();
+    test_no_settle();
+    test_order();
+    test_resources();
+    test_failures();
+    test_priority();
+    test_ctrl_switches();
+    test_resched();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,186 @@
+/**
+ * @file test_topk.c
+ * @brief Space-Saving bounds against exact counts of Zipf traces
+ *
+ * Traces of 200000 reports from 50 to 100000 advertisers with Zipf
+ * exponents 0.8 to 1.5. Every returned entry must bracket the exact
+ * count, and every advertiser above N / TOPK_SIZE must be in the table.
+ */
+
+#include "check.h"
+#include "topk.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORTS         200000u
+#define MAX_ADV         100000
+#define ADDR_MUL        2654435761u     /* Odd, so the address maps back */
+
+static uint32_t exact[MAX_ADV];
+static double cdf[MAX_ADV];
+static topk_t tk;
+
+static uint64_t rnd_state;
+
+static double uniform(void)
+{
+    rnd_state = rnd_state * 6364136223846793005ull + 1442695040888963407ull;
+    return (double)(rnd_state >> 11) / 9007199254740992.0;
+}
+
+/* Advertiser j: scrambled 32-bit id, two fixed bytes, type from the id */
+static void adv_addr(uint32_t j, uint8_t *addr)
+{
+    uint32_t id = j * ADDR_MUL;
+
+    addr[0] = (uint8_t)id;
+    addr[1] = (uint8_t)(id >> 8);
+    addr[2] = (uint8_t)(id >> 16);
+    addr[3] = (uint8_t)(id >> 24);
+    addr[4] = 0x5A;
+    addr[5] = 0xC7;
+}
+
+static uint32_t adv_index(const topk_item_t *it)
+{
+    uint32_t id = it->addr[0] | (uint32_t)it->addr[1] << 8 | (uint32_t)it->addr[2] << 16
+                  | (uint32_t)it->addr[3] << 24;
+    uint32_t inv = ADDR_MUL;
+
+    /* Inverse modulo 2^32 by Newton iteration */
+    for (int i = 0; i < 5; i++) {
+        inv *= 2u - ADDR_MUL * inv;
+    }
+    return id * inv;
+}
+
+static void run_trace(double s, uint32_t m)
+{
+    topk_item_t items[TOPK_SIZE];
+    double acc = 0.0;
+    uint32_t bad_bound = 0, bad_err = 0, bad_order = 0, bad_rssi = 0, unknown = 0;
+    uint32_t heavy = 0, heavy_found = 0, top10 = 0;
+    uint64_t sum = 0;
+    uint8_t n;
+
+    for (uint32_t j = 0; j < m; j++) {
+        acc += 1.0 / pow(j + 1, s);
+        cdf[j] = acc;
+    }
+    memset(exact, 0, sizeof(exact));
+    topk_reset(&tk);
+    rnd_state = (uint64_t)(s * 10) * 131 + m;
+
+    for (uint32_t k = 0; k < REPORTS; k++) {
+        double u = uniform() * acc;
+        uint32_t lo = 0, hi = m - 1;
+        uint8_t addr[6];
+
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (cdf[mid] < u) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        exact[lo]++;
+        adv_addr(lo, addr);
+        topk_add(&tk, addr, lo & 1, lo % 4, (uint16_t)(20 + lo % 10), (int8_t)(-40 - (int)(lo % 50)));
+    }
+
+    n = topk_get(&tk, items, TOPK_SIZE);
+    for (uint8_t i = 0; i < n; i++) {
+        uint32_t j = adv_index(&items[i]);
+
+        if (j >= m || items[i].addr_type != (j & 1)) {
+            unknown++;
+            continue;
+        }
+        sum += items[i].count;
+        if (!(items[i].count - items[i].err <= exact[j] && exact[j] <= items[i].count)) {
+            bad_bound++;
+        }
+        if (items[i].err > REPORTS / TOPK_SIZE) {
+            bad_err++;
+        }
+        if (i && items[i].count > items[i - 1].count) {
+            bad_order++;
+        }
+        /* Mean of the counted reports; one RSSI per advertiser */
+        if (items[i].rssi != -40 - (int)(j % 50) || !(items[i].phy_mask & (1u << (j % 4)))) {
+            bad_rssi++;
+        }
+        if (j < 10 && i < 10) {
+            top10++;
+        }
+    }
+    for (uint32_t j = 0; j < m; j++) {
+        if (exact[j] <= REPORTS / TOPK_SIZE) {
+            continue;
+        }
+        heavy++;
+        for (uint8_t i = 0; i < n; i++) {
+            if (adv_index(&items[i]) == j) {
+                heavy_found++;
+                break;
+            }
+        }
+    }
+
+    printf("s=%.1f advertisers %6u: heavy %u/%u, top 10 recall %u, max err %u (N/K %u)\n",
+           s, m, heavy_found, heavy, top10, n ? items[n - 1].err : 0, REPORTS / TOPK_SIZE);
+    CHECK(0 == unknown);
+    CHECK(0 == bad_bound);
+    CHECK(0 == bad_err);
+    CHECK(0 == bad_order);
+    CHECK(0 == bad_rssi);
+    CHECK(heavy == heavy_found);
+    CHECK(REPORTS == tk.total);
+    /* A full table accounts for every report */
+    CHECK(m < TOPK_SIZE || REPORTS == sum);
+}
+
+static void test_zipf(void)
+{
+    static const double exps[] = { 0.8, 1.0, 1.2, 1.5 };
+    static const uint32_t advs[] = { 50, 1000, 20000, MAX_ADV };
+
+    for (unsigned si = 0; si < sizeof(exps) / sizeof(exps[0]); si++) {
+        for (unsigned ni = 0; ni < sizeof(advs) / sizeof(advs[0]); ni++) {
+            run_trace(exps[si], advs[ni]);
+        }
+    }
+}
+
+/* Fewer advertisers than entries: exact counts; the type is part of the key */
+static void test_exact(void)
+{
+    topk_item_t items[TOPK_SIZE];
+    uint8_t addr[6] = { 1, 2, 3, 4, 5, 6 };
+
+    topk_reset(&tk);
+    CHECK(0 == topk_get(&tk, items, TOPK_SIZE));
+    for (int k = 0; k < 10; k++) {
+        topk_add(&tk, addr, 0, 0, 31, -50);
+    }
+    for (int k = 0; k < 4; k++) {
+        topk_add(&tk, addr, 1, 2, 10, (k & 1) ? -70 : -80);
+    }
+    CHECK(2 == topk_get(&tk, items, TOPK_SIZE));
+    CHECK(10 == items[0].count && 0 == items[0].err && 0 == items[0].addr_type);
+    CHECK(310 == items[0].bytes && -50 == items[0].rssi && 0x1 == items[0].phy_mask);
+    CHECK(4 == items[1].count && 1 == items[1].addr_type);
+    CHECK(-75 == items[1].rssi && 0x4 == items[1].phy_mask);
+    CHECK(1 == topk_get(&tk, items, 1));
+    CHECK(10 == items[0].count);
+}
+
+int main(void)
+{
+    test_exact();
+    test_zipf();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_tput_stats.c
+ * @brief Throughput windows, stalls and link capacity
+ */
+
+#include "check.h"
+#include "tput_stats.h"
+
+/* Steady stream with a single gap: windows, goodput and the stall */
+static void test_stream(void)
+{
+    tput_stats_t st;
+    uint32_t t = 1000;
+
+    tput_stats_init(&st, 500, 30);
+    for (int i = 0; i < 2000; i++) {
+        tput_stats_feed(&st, t, 244);
+        t += (1000 == i) ? 200 : 2;
+    }
+    tput_stats_finish(&st, t);
+
+    CHECK(2000 == st.packets);
+    CHECK(2000u * 244u == st.total_bytes);
+    /* 244 bytes every 2 ms */
+    CHECK(976000 == st.win_max_bps);
+    CHECK(1 == st.stalls);
+    CHECK(200 == st.stall_total_ms);
+    CHECK(200 == st.max_gap_ms);
+    /* 1999 deliveries after the first over 1998 * 2 + 200 ms */
+    CHECK((uint32_t)(1999ull * 244 * 8 * 1000 / (1998 * 2 + 200)) == tput_stats_goodput_bps(&st));
+    /* The window holding the gap carries less */
+    CHECK(st.win_min_bps < st.win_max_bps && st.win_min_bps > 0);
+    CHECK((t - 1000) / 500 == st.win_cnt);
+}
+
+/* Idle windows count as zero, a trailing gap is a stall */
+static void test_idle(void)
+{
+    tput_stats_t st;
+
+    tput_stats_init(&st, 100, 60);
+    tput_stats_feed(&st, 0, 100);
+    tput_stats_feed(&st, 50, 100);
+    tput_stats_tick(&st, 99);
+    CHECK(0 == st.win_cnt);
+    tput_stats_tick(&st, 450);
+    /* One window with 200 bytes, three idle ones */
+    CHECK(4 == st.win_cnt);
+    CHECK(16000 == st.win_max_bps);
+    CHECK(0 == st.win_min_bps);
+    CHECK(0 == st.win_last_bps);
+    CHECK(0 == st.stalls);
+
+    tput_stats_finish(&st, 450);
+    CHECK(1 == st.stalls);
+    CHECK(400 == st.stall_total_ms);
+
+    /* Nothing delivered, nothing to close */
+    tput_stats_init(&st, 100, 50);
+    tput_stats_finish(&st, 1000);
+    CHECK(0 == st.win_cnt && 0 == st.stalls);
+    CHECK(0 == tput_stats_goodput_bps(&st));
+}
+
+/* The millisecond clock wraps during a measurement */
+static void test_wrap(void)
+{
+    tput_stats_t st;
+    uint32_t t = UINT32_MAX - 999;
+
+    tput_stats_init(&st, 500, 30);
+    for (int i = 0; i < 1000; i++) {
+        tput_stats_feed(&st, t, 100);
+        t += 2;
+    }
+    tput_stats_finish(&st, t);
+    CHECK(0 == st.stalls);
+    CHECK(2 == st.max_gap_ms);
+    CHECK(400000 == tput_stats_goodput_bps(&st));
+    CHECK(400000 == st.win_min_bps && 400000 == st.win_max_bps);
+    CHECK(4 == st.win_cnt);
+}
+
+/* Capacity from the PDU air times, worked by hand */
+static void test_capacity(void)
+{
+    /* 1M: 261 * 8 us PDU, 80 us ack, 2 * 150 us T_IFS */
+    CHECK(244u * 8u * 1000000u / 2468u == tput_stats_capacity_bps(TPUT_PHY_1M, 251, 244));
+    /* 2M: 262 * 4 us PDU, 44 us ack */
+    CHECK(244u * 8u * 1000000u / 1392u == tput_stats_capacity_bps(TPUT_PHY_2M, 251, 244));
+    /* Coded S=8: 400 + 256 * 64 us PDU, 400 + 5 * 64 us ack */
+    CHECK(244u * 8u * 1000000u / 17804u == tput_stats_capacity_bps(TPUT_PHY_CODED, 251, 244));
+    /* Default data length on 1M: 37 * 8 us PDU */
+    CHECK(20u * 8u * 1000000u / 676u == tput_stats_capacity_bps(TPUT_PHY_1M, 27, 20));
+    CHECK(0 == tput_stats_capacity_bps(0x3, 251, 244));
+
+    tput_stats_t st;
+    tput_stats_init(&st, 1000, 100);
+    tput_stats_feed(&st, 0, 244);
+    tput_stats_feed(&st, 1000, 244);
+    /* 1952 bit/s of 790923 */
+    CHECK(0 == tput_stats_utilisation(&st, tput_stats_capacity_bps(TPUT_PHY_1M, 251, 244)));
+    CHECK(50 == tput_stats_utilisation(&st, 3904));
+    CHECK(100 == tput_stats_utilisation(&st, 1000));
+    CHECK(0 == tput_stats_utilisation(&st, 0));
+}
+
+int main(void)
+{
+    test_stream();
+    test_idle();
+    test_wrap();
+    test_capacity();
+    return CHECK_RESULT();
+}
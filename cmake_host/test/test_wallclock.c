@@ -0,0 +1,181 @@
+/**
+ * @file test_wallclock.c
+ * @brief Calendar against the C library, leap years and clock sources
+ */
+
+#include "check.h"
+#include "wallclock.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+static bool same_as_gmtime(uint32_t sec, const wallclock_date_t *d)
+{
+    time_t t = (time_t)sec;
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    return d->year == tm.tm_year + 1900 && d->month == tm.tm_mon + 1 && d->day == tm.tm_mday
+           && d->hour == tm.tm_hour && d->min == tm.tm_min && d->sec == tm.tm_sec
+           && d->wday == tm.tm_wday;
+}
+
+/* Both sides of every midnight of the 32-bit range, both directions */
+static void test_day_boundaries(void)
+{
+    uint32_t bad = 0;
+    uint32_t n = 0;
+
+    for (int64_t day = 0; day * 86400 <= UINT32_MAX; day++) {
+        for (int64_t s = day * 86400 - 1; s <= day * 86400; s++) {
+            wallclock_date_t d;
+            uint32_t back;
+
+            if (s < 0 || s > UINT32_MAX) {
+                continue;
+            }
+            wallclock_to_date((uint32_t)s, &d);
+            n++;
+            if (!same_as_gmtime((uint32_t)s, &d)
+                || wallclock_from_date(&d, &back) || back != (uint32_t)s) {
+                if (bad++ < 5) {
+                    printf("mismatch at %lld\n", (long long)s);
+                }
+            }
+        }
+    }
+    printf("%u day boundaries checked\n", n);
+    CHECK(0 == bad);
+}
+
+static int from_ymd(uint16_t year, uint8_t month, uint8_t day, uint32_t *sec)
+{
+    wallclock_date_t d = { .year = year, .month = month, .day = day };
+
+    return wallclock_from_date(&d, sec);
+}
+
+/* Gregorian leap rules at the century years of the range */
+static void test_leap_years(void)
+{
+    uint32_t s, s2;
+    wallclock_date_t d;
+
+    /* 2000 is divisible by 400: leap year */
+    CHECK(0 == from_ymd(2000, 2, 29, &s));
+    CHECK(951782400u == s);
+    CHECK(0 == from_ymd(2000, 3, 1, &s2));
+    CHECK(s2 - s == 86400);
+    wallclock_to_date(s + 86399, &d);
+    CHECK(2000 == d.year && 2 == d.month && 29 == d.day && 23 == d.hour && 2 == d.wday);
+
+    /* 2100 is divisible by 100 only: no leap year */
+    CHECK(-EINVAL == from_ymd(2100, 2, 29, &s));
+    CHECK(0 == from_ymd(2100, 2, 28, &s));
+    CHECK(0 == from_ymd(2100, 3, 1, &s2));
+    CHECK(s2 - s == 86400);
+    wallclock_to_date(s2 - 1, &d);
+    CHECK(2100 == d.year && 2 == d.month && 28 == d.day);
+
+    /* Ordinary leap years either side */
+    CHECK(0 == from_ymd(2096, 2, 29, &s));
+    CHECK(0 == from_ymd(2104, 2, 29, &s));
+    CHECK(-EINVAL == from_ymd(2023, 2, 29, &s));
+    CHECK(0 == from_ymd(1972, 2, 29, &s));
+    CHECK(68169600u == s);
+
+    /* Day 366 of a leap year, 365 of a common one */
+    CHECK(0 == from_ymd(2024, 12, 31, &s));
+    wallclock_to_date(s, &d);
+    CHECK(2024 == d.year && 12 == d.month && 31 == d.day && 2 == d.wday);
+    CHECK(0 == from_ymd(2025, 1, 1, &s2));
+    CHECK(s2 - s == 86400);
+
+    /* Other month ends */
+    CHECK(-EINVAL == from_ymd(2024, 4, 31, &s));
+    CHECK(-EINVAL == from_ymd(2024, 13, 1, &s));
+    CHECK(-EINVAL == from_ymd(2024, 1, 0, &s));
+}
+
+/* Ends of the 32-bit stamp */
+static void test_range(void)
+{
+    wallclock_date_t d = { 2106, 2, 7, 6, 28, 15, 0 };
+    uint32_t s;
+
+    CHECK(0 == wallclock_from_date(&d, &s));
+    CHECK(UINT32_MAX == s);
+    d.sec = 16;
+    CHECK(-EINVAL == wallclock_from_date(&d, &s));
+    d = (wallclock_date_t){ 1969, 12, 31, 23, 59, 59, 0 };
+    CHECK(-EINVAL == wallclock_from_date(&d, &s));
+    d = (wallclock_date_t){ 1970, 1, 1, 0, 0, 0, 0 };
+    CHECK(0 == wallclock_from_date(&d, &s) && 0 == s);
+    d.hour = 24;
+    CHECK(-EINVAL == wallclock_from_date(&d, &s));
+
+    wallclock_to_date(UINT32_MAX, &d);
+    CHECK(2106 == d.year && 2 == d.month && 7 == d.day && 15 == d.sec);
+}
+
+/* Current Time characteristic */
+static void test_cts(void)
+{
+    uint8_t cts[WALLCLOCK_CTS_LEN] = { 0xEA, 0x07, 10, 19, 12, 34, 56, 1, 128, 0 };
+    wallclock_stamp_t st;
+    uint32_t s;
+
+    CHECK(0 == from_ymd(2026, 10, 19, &s));
+    CHECK(0 == wallclock_from_cts(cts, sizeof(cts), &st));
+    CHECK(s + 12 * 3600 + 34 * 60 + 56 == st.sec);
+    CHECK(500 == st.ms);
+    /* The adjust reason may be left out */
+    CHECK(0 == wallclock_from_cts(cts, WALLCLOCK_CTS_LEN - 1, &st));
+    CHECK(-EINVAL == wallclock_from_cts(cts, WALLCLOCK_CTS_LEN - 2, &st));
+    cts[2] = 0;
+    CHECK(-EINVAL == wallclock_from_cts(cts, sizeof(cts), &st));
+    cts[2] = 2;
+    cts[3] = 29;
+    CHECK(-EINVAL == wallclock_from_cts(cts, sizeof(cts), &st));
+}
+
+/* Source ranks and the hold time */
+static void test_sources(void)
+{
+    wallclock_t wc;
+    wallclock_stamp_t gatt = { 1000000, 500 };
+    wallclock_stamp_t beacon = { 2000000, 0 };
+    wallclock_stamp_t st;
+
+    wallclock_init(&wc);
+    CHECK(-EAGAIN == wallclock_now(&wc, 0, &st));
+    CHECK(WALLCLOCK_SRC_NONE == wallclock_source(&wc));
+
+    CHECK(0 == wallclock_set(&wc, 1000, &gatt, WALLCLOCK_SRC_GATT));
+    CHECK(0 == wallclock_now(&wc, 3700, &st));
+    CHECK(1000003 == st.sec && 200 == st.ms);
+
+    /* A lower rank waits for the hold time */
+    CHECK(-EPERM == wallclock_set(&wc, 2000, &beacon, WALLCLOCK_SRC_BEACON));
+    CHECK(0 == wallclock_set(&wc, 1000 + WALLCLOCK_HOLD_MS, &beacon, WALLCLOCK_SRC_BEACON));
+    CHECK(WALLCLOCK_SRC_BEACON == wallclock_source(&wc));
+    CHECK(0 == wallclock_set(&wc, 2000 + WALLCLOCK_HOLD_MS, &gatt, WALLCLOCK_SRC_GATT));
+    CHECK(-EINVAL == wallclock_set(&wc, 0, &gatt, WALLCLOCK_SRC_NONE));
+    CHECK(0 == strcmp("?", wallclock_source_name(0xFF)));
+
+    /* Past the end of the stamp */
+    wallclock_stamp_t last = { UINT32_MAX, 999 };
+    CHECK(0 == wallclock_set(&wc, 0, &last, WALLCLOCK_SRC_GATT));
+    CHECK(-ERANGE == wallclock_now(&wc, 1, &st));
+}
+
+int main(void)
+{
+    test_day_boundaries();
+    test_leap_years();
+    test_range();
+    test_cts();
+    test_sources();
+    return CHECK_RESULT();
+}
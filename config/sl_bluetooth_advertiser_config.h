@@ -39,8 +39,8 @@
 // <i> Specifically, if the component "bluetooth_feature_periodic_advertiser" is used, its configuration SL_BT_CONFIG_MAX_PERIODIC_ADVERTISERS specifies how many of the SL_BT_CONFIG_USER_ADVERTISERS advertising sets are capable of periodic advertising. Similarly, if the component bluetooth_feature_pawr_advertiser is used, its configuration SL_BT_CONFIG_MAX_PAWR_ADVERTISERS specifies how many of the periodic advertising sets are capable of Periodic Advertising with Responses.
 // <i>
 // <i> The configuration values must satisfy the condition SL_BT_CONFIG_USER_ADVERTISERS >= SL_BT_CONFIG_MAX_PERIODIC_ADVERTISERS >= SL_BT_CONFIG_MAX_PAWR_ADVERTISERS.
-// losstst_svc uses 5 sets (0-4), app.c uses 1 for phone connection = 6 total
-#define SL_BT_CONFIG_USER_ADVERTISERS     6
+// losstst_svc uses 5 sets (0-4) and 1 for the time beacon, app.c uses 1 for phone connection = 7 total
+#define SL_BT_CONFIG_USER_ADVERTISERS     7
 // <<< end of configuration section >>>
 
 #endif
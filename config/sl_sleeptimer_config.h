@@ -62,7 +62,7 @@
 // <q SL_SLEEPTIMER_WALLCLOCK_CONFIG> Enable wallclock functionality
 // <i> Enable or disable wallclock functionalities (get_time, get_date, etc).
 // <i> Default: 0
-#define SL_SLEEPTIMER_WALLCLOCK_CONFIG  0
+#define SL_SLEEPTIMER_WALLCLOCK_CONFIG  1
 
 // <o SL_SLEEPTIMER_FREQ_DIVIDER> Timer frequency divider (not applicable for WTIMER/TIMER)
 // <i> WTIMER/TIMER peripherals are always prescaled to 1024.
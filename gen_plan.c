@@ -0,0 +1,83 @@
+/**
+ * @file gen_plan.c
+ * @brief Traffic Generator Planning
+ *
+ * Implementation of gen_plan.h. The controller adds a random advDelay of
+ * 0-10 ms to every advertising event, so a set configured for interval T
+ * sends on average every T + 5 ms. The plan subtracts that mean from the
+ * spacing each set has to reach.
+ */
+
+#include "gen_plan.h"
+#include <string.h>
+#include <errno.h>
+
+/**
+ * @brief Rate of one event spacing in 1/1000 packets/s
+ */
+static uint32_t gen_plan_mpps(uint32_t period_us)
+{
+    return (uint32_t)((1000000000ull + period_us / 2) / period_us);
+}
+
+int gen_plan_build(uint16_t devices, uint16_t interval_ms, uint8_t max_sets,
+                   uint32_t min_interval, gen_plan_t *plan)
+{
+    uint32_t planned = 0;
+    uint32_t diff;
+
+    if (plan == NULL || 0 == devices || 0 == interval_ms
+        || 0 == max_sets || max_sets > GEN_PLAN_MAX_SETS) {
+        return -EINVAL;
+    }
+
+    memset(plan, 0, sizeof(*plan));
+    plan->sets = (devices < max_sets) ? (uint8_t)devices : max_sets;
+    plan->target_mpps = (uint32_t)(((uint64_t)devices * 1000000u + interval_ms / 2) / interval_ms);
+
+    for (uint8_t i = 0; i < plan->sets; i++) {
+        gen_plan_set_t *set = &plan->set[i];
+        uint32_t spacing_us;
+        uint32_t interval;
+
+        /* Spread the remainder over the first sets */
+        set->devices = devices / plan->sets + ((i < devices % plan->sets) ? 1 : 0);
+
+        /* Event spacing that serves all devices of this set */
+        spacing_us = (uint32_t)(((uint64_t)interval_ms * 1000u + set->devices / 2) / set->devices);
+        if (spacing_us > GEN_ADV_DELAY_MEAN_US) {
+            interval = (spacing_us - GEN_ADV_DELAY_MEAN_US + GEN_INTERVAL_UNIT_US / 2) / GEN_INTERVAL_UNIT_US;
+        } else {
+            interval = 0;
+        }
+        if (interval < min_interval) {
+            interval = min_interval;
+            plan->clamped = true;
+        }
+
+        set->interval = interval;
+        set->period_us = interval * GEN_INTERVAL_UNIT_US + GEN_ADV_DELAY_MEAN_US;
+        planned += gen_plan_mpps(set->period_us);
+    }
+
+    plan->planned_mpps = planned;
+    diff = (planned > plan->target_mpps) ? planned - plan->target_mpps : plan->target_mpps - planned;
+    plan->error_permille = (uint16_t)(((uint64_t)diff * 1000u) / plan->target_mpps);
+
+    return plan->clamped ? -ERANGE : 0;
+}
+
+uint16_t gen_plan_events(const gen_plan_set_t *set, uint32_t on_ms)
+{
+    uint32_t events;
+
+    if (set == NULL || 0 == set->period_us) {
+        return 1;
+    }
+
+    events = (uint32_t)(((uint64_t)on_ms * 1000u) / set->period_us);
+    if (0 == events) {
+        events = 1;
+    }
+    return (events > UINT16_MAX) ? UINT16_MAX : (uint16_t)events;
+}
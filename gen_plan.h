@@ -0,0 +1,80 @@
+/**
+ * @file gen_plan.h
+ * @brief Traffic Generator Planning
+ *
+ * Maps "emulate N devices advertising every X ms" onto the advertising
+ * sets of one board. Each set stands in for a share of the devices and
+ * advertises at the combined rate of that share.
+ *
+ * Features:
+ * - Even split of devices over the available sets
+ * - Compensation of the mean advDelay (0-10 ms random per event)
+ * - Clamping to the minimum advertising interval with rate error report
+ *
+ * @note No Bluetooth stack dependency, so the plan can be checked on a
+ *       host build as well
+ */
+
+#ifndef GEN_PLAN_H
+#define GEN_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GEN_PLAN_MAX_SETS       8
+#define GEN_ADV_DELAY_MEAN_US   5000    /* Mean of the 0-10 ms advDelay */
+#define GEN_INTERVAL_UNIT_US    625     /* Advertising interval unit */
+
+/**
+ * @brief Plan of one advertising set
+ */
+typedef struct {
+    uint16_t devices;          /**< Devices emulated by this set */
+    uint32_t interval;         /**< Advertising interval (0.625 ms units) */
+    uint32_t period_us;        /**< Expected event spacing incl. advDelay */
+} gen_plan_set_t;
+
+/**
+ * @brief Generator plan
+ */
+typedef struct {
+    uint8_t sets;                          /**< Sets in use */
+    gen_plan_set_t set[GEN_PLAN_MAX_SETS]; /**< Per-set plan */
+    uint32_t target_mpps;                  /**< Requested rate (1/1000 packets/s) */
+    uint32_t planned_mpps;                 /**< Expected rate of the plan (1/1000 packets/s) */
+    uint16_t error_permille;               /**< |planned - target| / target */
+    bool clamped;                          /**< A set hit the minimum interval */
+} gen_plan_t;
+
+/**
+ * @brief Build a generator plan
+ *
+ * @param devices Devices to emulate (>0)
+ * @param interval_ms Advertising interval of each emulated device (>0)
+ * @param max_sets Advertising sets available (1..GEN_PLAN_MAX_SETS)
+ * @param min_interval Minimum advertising interval (0.625 ms units)
+ * @param plan Output plan
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -ERANGE if the rate is not reachable (plan holds the closest one)
+ */
+int gen_plan_build(uint16_t devices, uint16_t interval_ms, uint8_t max_sets,
+                   uint32_t min_interval, gen_plan_t *plan);
+
+/**
+ * @brief Advertising events a set sends in an on-window
+ *
+ * @param set Set plan
+ * @param on_ms Length of the on-window (ms)
+ * @return Event count (at least 1)
+ */
+uint16_t gen_plan_events(const gen_plan_set_t *set, uint32_t on_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GEN_PLAN_H
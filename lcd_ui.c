@@ -42,7 +42,7 @@ static bool lcd_initialized = false;
 
 /* Selection cursor state */
 static uint8_t current_selection = 0;  // Current selected item (0-based)
-static uint8_t max_selection_items = 9;  // Total number of selectable items
+static uint8_t max_selection_items = 10;  // Total number of selectable items
 static test_param_t *cached_param = NULL;  // Cache for redraw (non-const for editing)
 static uint8_t scroll_offset = 0;  // Menu scroll offset (items scrolled up)
 
@@ -66,8 +66,9 @@ static const char* item_names[] = {
     "Channel",    // 4
     "NonAnon",    // 5
     "IgnResp",    // 6
-    "StartTask",  // 7
-    "StopTask"    // 8
+    "Burst",      // 7
+    "StartTask",  // 8
+    "StopTask"    // 9
 };
 
 /* ==================== Helper Functions ==================== */
@@ -430,7 +431,9 @@ void lcd_ui_show_startup(void *param_ptr)
                     break;
                     
                 case 4: // Channel Status
-                    if (param->inhibit_ch37 || param->inhibit_ch38 || param->inhibit_ch39) {
+                    if (param->channel_sweep) {
+                        snprintf(buf, sizeof(buf), "CH:Sweep 37/38/39");
+                    } else if (param->inhibit_ch37 || param->inhibit_ch38 || param->inhibit_ch39) {
                         snprintf(buf, sizeof(buf), "CH:%s%s%s",
                                  param->inhibit_ch37 ? "X37 " : "O37 ",
                                  param->inhibit_ch38 ? "X38 " : "O38 ",
@@ -451,11 +454,18 @@ void lcd_ui_show_startup(void *param_ptr)
                     draw_text(text_x, y, buf);
                     break;
                     
-                case 7: // Start Task
+                case 7: // Burst scheduling
+                    snprintf(buf, sizeof(buf), "Burst:%s",
+                             !param->concurrent_burst ? "Alternate" :
+                             (param->short_countdown ? "Concur+CD" : "Concur"));
+                    draw_text(text_x, y, buf);
+                    break;
+                    
+                case 8: // Start Task
                     draw_text(text_x, y, "StartTask:Select");
                     break;
                     
-                case 8: // Stop Task
+                case 9: // Stop Task
                     draw_text(text_x, y, "StopTask:Stop All");
                     break;
             }
@@ -533,6 +543,10 @@ void lcd_ui_update(const void *param_ptr, const char *test_mode, const char *sta
     }
     if (param->ignore_rcv_resp) {
         draw_text(2, y, "IgnResp");
+        y += 10;
+    }
+    if (param->concurrent_burst) {
+        draw_text(2, y, param->short_countdown ? "Concur+CD" : "Concur");
     }
     
     DMD_updateDisplay();
@@ -664,6 +678,157 @@ void lcd_ui_show_connection(bool connected)
     (void)connected;
 }
 
+void lcd_ui_show_channel_per(void)
+{
+    if (!lcd_initialized) {
+        return;
+    }
+    
+    static const char* phy_names[] = {"2M", "1M", "S8", "BLE4"};
+    char buf[32];
+    char per[3][6];
+    uint8_t y = 28;
+    
+    GLIB_clear(&glibContext);
+    GLIB_setFont(&glibContext, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+    
+    draw_text(2, 2, "Channel PER %");
+    GLIB_drawLineH(&glibContext, 0, 127, 12);
+    draw_text(2, 16, "PHY   37   38   39");
+    
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        losstst_result_t result;
+        
+        if (losstst_get_result(idx, &result) != 0 || result.exp == 0) {
+            continue;  // PHY not received
+        }
+        
+        for (uint8_t ch = 0; ch < 3; ch++) {
+            const losstst_count_t *cnt = &result.ch[ch];
+            if (cnt->exp == 0) {
+                snprintf(per[ch], sizeof(per[ch]), "--");
+            } else {
+                // Duplicates can exceed the expected count; clamp to 0%
+                uint32_t lost = (cnt->rcv < cnt->exp) ? (cnt->exp - cnt->rcv) : 0;
+                snprintf(per[ch], sizeof(per[ch]), "%lu", (unsigned long)((lost * 100 + cnt->exp / 2) / cnt->exp));
+            }
+        }
+        
+        snprintf(buf, sizeof(buf), "%-4s %4s %4s %4s", phy_names[idx], per[0], per[1], per[2]);
+        draw_text(2, y, buf);
+        y += 10;
+    }
+    
+    DMD_updateDisplay();
+}
+
+/**
+ * @brief Round a 0.1 dB level to whole dB
+ */
+static int db10_round(int16_t db10)
+{
+    return (db10 < 0) ? (db10 - 5) / 10 : (db10 + 5) / 10;
+}
+
+bool lcd_ui_show_link_fit(void)
+{
+    if (!lcd_initialized) {
+        return false;
+    }
+    
+    static const char* phy_names[] = {"2M", "1M", "S8", "BLE4"};
+    losstst_link_fit_t fit[4];
+    bool valid[4];
+    bool any = false;
+    char buf[32];
+    uint8_t y;
+    
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        valid[idx] = (losstst_get_link_fit(idx, &fit[idx]) == 0);
+        any |= valid[idx];
+    }
+    if (!any) {
+        return false;
+    }
+    
+    GLIB_clear(&glibContext);
+    GLIB_setFont(&glibContext, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+    
+    draw_text(2, 2, "Link Fit (dBm)");
+    GLIB_drawLineH(&glibContext, 0, 127, 12);
+    draw_text(2, 16, "PHY  S31 S10  S1 Mrg");
+    
+    y = 28;
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        if (!valid[idx]) {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "%-4s%4d%4d%4d%+4d", phy_names[idx],
+                 db10_round(fit[idx].sens[0]), db10_round(fit[idx].sens[1]),
+                 db10_round(fit[idx].sens[2]), db10_round(fit[idx].margin));
+        draw_text(2, y, buf);
+        y += 10;
+    }
+    
+    y += 4;
+    GLIB_drawLineH(&glibContext, 0, 127, y);
+    y += 4;
+    draw_text(2, y, "PHY  PL@Tx     Lvls");
+    y += 12;
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        if (!valid[idx]) {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "%-4s%3d@%+3d %6u", phy_names[idx],
+                 db10_round(fit[idx].path_loss), fit[idx].tx_max, fit[idx].points);
+        draw_text(2, y, buf);
+        y += 10;
+    }
+    
+    DMD_updateDisplay();
+    return true;
+}
+
+bool lcd_ui_show_env_top(void)
+{
+    if (!lcd_initialized) {
+        return false;
+    }
+    
+    topk_item_t top[9];
+    uint32_t total;
+    uint8_t n;
+    char buf[32];
+    uint8_t y;
+    
+    n = losstst_get_env_top(top, sizeof(top) / sizeof(top[0]), &total);
+    if (0 == n) {
+        return false;
+    }
+    
+    GLIB_clear(&glibContext);
+    GLIB_setFont(&glibContext, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+    
+    snprintf(buf, sizeof(buf), "Top Adv %lu rpt", (unsigned long)total);
+    draw_text(2, 2, buf);
+    GLIB_drawLineH(&glibContext, 0, 127, 12);
+    draw_text(2, 16, "Address        % dBm");
+    
+    y = 28;
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t *a = top[i].addr;
+        
+        snprintf(buf, sizeof(buf), "%02X%02X%02X%02X%02X%02X%4lu%4d",
+                 a[5], a[4], a[3], a[2], a[1], a[0],
+                 (unsigned long)((uint64_t)top[i].count * 100 / total), top[i].rssi);
+        draw_text(2, y, buf);
+        y += 11;
+    }
+    
+    DMD_updateDisplay();
+    return true;
+}
+
 /* ==================== Selection Control Implementation ==================== */
 
 /**
@@ -795,11 +960,14 @@ static void draw_sub_menu(void)
             
         case 4: // Channel
         {
-            max_sub_items = 4;  // 3 channels + Back
+            max_sub_items = 7;  // 3 channels + Sweep + controller switches + Back
             const char* ch_items[] = {
                 cached_param->inhibit_ch37 ? "[X] Ch37 OFF" : "[ ] Ch37 ON",
                 cached_param->inhibit_ch38 ? "[X] Ch38 OFF" : "[ ] Ch38 ON",
                 cached_param->inhibit_ch39 ? "[X] Ch39 OFF" : "[ ] Ch39 ON",
+                cached_param->channel_sweep ? "[X] Sweep" : "[ ] Sweep",
+                (cached_param->ctrl_switches & LOSSTST_CTRL_EARLY_ABORT) ? "[X] Early abort" : "[ ] Early abort",
+                (cached_param->ctrl_switches & LOSSTST_CTRL_ADAPTIVITY) ? "[X] Adaptivity" : "[ ] Adaptivity",
                 "< Back"
             };
             
@@ -855,10 +1023,31 @@ static void draw_sub_menu(void)
             break;
         }
             
-        case 7: // Start Task
+        case 7: // Burst scheduling
         {
-            max_sub_items = 5;  // 4 tasks + Back
-            const char* items[] = {"Sender", "Scanner", "Numcast", "Envmon", "< Back"};
+            max_sub_items = 4;  // 3 modes + Back
+            const char* items[] = {"Alternate", "Concurrent", "Concur+ShortCD", "< Back"};
+            
+            for (uint8_t i = 0; i < max_sub_items; i++) {
+                if (i < sub_scroll_offset || i >= sub_scroll_offset + MAX_VISIBLE_ITEMS) {
+                    continue;
+                }
+                
+                uint8_t visible_index = i - sub_scroll_offset;
+                uint8_t y = BASE_Y + (visible_index * LINE_HEIGHT);
+                
+                if (sub_selection == i) draw_selection_triangle(2, y+2);
+                draw_text(text_x, y, items[i]);
+            }
+            break;
+        }
+            
+        case 8: // Start Task
+        {
+            max_sub_items = 10;  // 9 tasks + Back
+            const char* items[] = {"Sender", "Scanner", "Numcast", "Envmon", "Ping",
+                                   "Tput Source", "Tput Sink", "Generator", "Soak Scanner",
+                                   "< Back"};
             
             for (uint8_t i = 0; i < max_sub_items; i++) {
                 if (i < sub_scroll_offset || i >= sub_scroll_offset + MAX_VISIBLE_ITEMS) {
@@ -946,12 +1135,15 @@ void lcd_ui_expand_selection(void)
     
     if (menu_mode == LCD_MODE_MAIN_MENU) {
         // Special handling: Stop Task (no sub-menu)
-        if (current_selection == 8) {
+        if (current_selection == 9) {
             // Stop all tasks directly
             sender_task_tgr(-1);
             scanner_task_tgr(-1);
             numcst_task_tgr(-1);
             envmon_task_tgr(-1);
+            ping_task_tgr(-1);
+            tput_task_tgr(-1);
+            gen_task_tgr(-1);
             
             // Stay in main menu, just redraw
             if (cached_param != NULL) {
@@ -1034,6 +1226,15 @@ void lcd_ui_expand_selection(void)
                             case 2:
                                 cached_param->inhibit_ch39 = !cached_param->inhibit_ch39;
                                 break;
+                            case 3:
+                                cached_param->channel_sweep = !cached_param->channel_sweep;
+                                break;
+                            case 4:
+                                cached_param->ctrl_switches ^= LOSSTST_CTRL_EARLY_ABORT;
+                                break;
+                            case 5:
+                                cached_param->ctrl_switches ^= LOSSTST_CTRL_ADAPTIVITY;
+                                break;
                         }
                         break;
                         
@@ -1053,12 +1254,21 @@ void lcd_ui_expand_selection(void)
                         }
                         break;
                         
-                    case 7: // Start Task - trigger task
+                    case 7: // Burst scheduling - set mode
+                        if (sub_selection < 3) {
+                            cached_param->concurrent_burst = (sub_selection != 0);
+                            cached_param->short_countdown = (sub_selection == 2);
+                        }
+                        break;
+                        
+                    case 8: // Start Task - trigger task
                         switch (sub_selection) {
                             case 0: // Sender
                                 sender_task_tgr(1);
                                 break;
                             case 1: // Scanner
+                            case 8: // Scanner rounds until stopped, with change detection
+                                cached_param->soak = (sub_selection == 8);
                                 scanner_task_tgr(1);
                                 break;
                             case 2: // Numcast
@@ -1067,6 +1277,17 @@ void lcd_ui_expand_selection(void)
                             case 3: // Envmon
                                 envmon_task_tgr(1);
                                 break;
+                            case 4: // Ping
+                                ping_task_tgr(1);
+                                break;
+                            case 5: // Throughput source (peripheral, streams)
+                            case 6: // Throughput sink (central, measures)
+                                cached_param->tput_source = (sub_selection == 5);
+                                tput_task_tgr(1);
+                                break;
+                            case 7: // Traffic generator
+                                gen_task_tgr(1);
+                                break;
                         }
                         break;
                 }
@@ -64,6 +64,9 @@ int lcd_ui_init(void);
  *                  - "Scanner"
  *                  - "NumCast"
  *                  - "EnvMon"
+ *                  - "Ping"
+ *                  - "Tput"
+ *                  - "Generator"
  * @param status Status string:
  *               - "Ready" - Test configured, waiting to start
  *               - "Running" - Test in progress
@@ -129,6 +132,37 @@ void lcd_ui_clear(void);
  */
 bool lcd_ui_is_ready(void);
 
+/**
+ * @brief Display per-channel packet error rate
+ * 
+ * Shows one row per received PHY with the PER (%) on advertising
+ * channels 37, 38 and 39, taken from losstst_get_result().
+ * 
+ * @note Meaningful after a scanner run in channel sweep mode
+ */
+void lcd_ui_show_channel_per(void);
+
+/**
+ * @brief Display the link budget fitted from a tx power sweep
+ * 
+ * Shows per PHY the sensitivity at 30.8 %, 10 % and 1 % PER, the margin
+ * at the highest swept tx power and the path loss, taken from
+ * losstst_get_link_fit(). PHYs without a valid fit are left out.
+ * 
+ * @return true if the screen was drawn, false if no PHY has a fit yet
+ */
+bool lcd_ui_show_link_fit(void);
+
+/**
+ * @brief Display the advertisers with the most reports of the envmon run
+ * 
+ * One line per advertiser from losstst_get_env_top(): address, share of
+ * all reports and mean RSSI.
+ * 
+ * @return true if the screen was drawn, false if nothing was received yet
+ */
+bool lcd_ui_show_env_top(void);
+
 /* ==================== Selection Control (Button Navigation) ==================== */
 
 /**
@@ -0,0 +1,224 @@
+/**
+ * @file linkfit.c
+ * @brief Path Loss and PER-vs-RSSI Fitting
+ *
+ * Implementation of linkfit.h. The logistic fit runs Newton steps on the
+ * binomial log-likelihood (IRLS) over the 2x2 normal equations. A small
+ * ridge term on the slope keeps the fit finite when a sweep jumps from no
+ * loss to total loss between two levels (perfect separation). A step that
+ * does not raise the likelihood is halved; a full Newton step from the flat
+ * start overshoots when a single level far below the others carries all
+ * the loss, and the undamped iteration then cycles between two points.
+ */
+
+#include "linkfit.h"
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#define LINKFIT_RIDGE       0.5f    /* Slope penalty (likelihood units per (1/dB)^2) */
+#define LINKFIT_RIDGE_B0    1e-3f   /* Keeps the system solvable if all weights vanish */
+#define LINKFIT_MAX_STEP    5.0f    /* Newton step limit per coefficient */
+#define LINKFIT_HALVINGS    8       /* Step halvings before giving up on an iteration */
+#define LINKFIT_STEP_DONE   1e-5f   /* Newton step treated as converged */
+
+void linkfit_reset(linkfit_t *fit)
+{
+    if (fit == NULL) {
+        return;
+    }
+
+    memset(fit, 0, sizeof(*fit));
+}
+
+int linkfit_add(linkfit_t *fit, int8_t tx_dbm, int8_t rssi, uint16_t rcv, uint16_t exp)
+{
+    linkfit_point_t *pt = NULL;
+
+    if (fit == NULL || 0 == exp || rcv > exp) {
+        return -EINVAL;
+    }
+
+    for (uint8_t i = 0; i < fit->n; i++) {
+        if (fit->pt[i].tx_dbm == tx_dbm) {
+            pt = &fit->pt[i];
+            break;
+        }
+    }
+    if (pt == NULL) {
+        if (fit->n >= LINKFIT_MAX_POINTS) {
+            return -ENOSPC;
+        }
+        pt = &fit->pt[fit->n++];
+        memset(pt, 0, sizeof(*pt));
+        pt->tx_dbm = tx_dbm;
+    }
+
+    pt->rcv += rcv;
+    pt->exp += exp;
+    if (0 < rcv) {
+        pt->rssi_sum += rssi;
+        pt->rssi_n++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Likelihood terms of the fit at one point of the coefficients
+ */
+typedef struct {
+    float ll;                  /**< Penalised log-likelihood of the lost packets */
+    float g0, g1;              /**< Gradient */
+    float h00, h01, h11;       /**< Negative Hessian */
+} linkfit_eval_t;
+
+/**
+ * @brief Penalised binomial log-likelihood with its gradient and Hessian
+ */
+static void linkfit_eval(const linkfit_t *fit, float x_off, float b0, float b1,
+                         linkfit_eval_t *ev)
+{
+    ev->ll = -0.5f * (LINKFIT_RIDGE_B0 * b0 * b0 + LINKFIT_RIDGE * b1 * b1);
+    ev->g0 = -LINKFIT_RIDGE_B0 * b0;
+    ev->g1 = -LINKFIT_RIDGE * b1;
+    ev->h00 = LINKFIT_RIDGE_B0;
+    ev->h01 = 0.0f;
+    ev->h11 = LINKFIT_RIDGE;
+
+    for (uint8_t i = 0; i < fit->n; i++) {
+        const linkfit_point_t *pt = &fit->pt[i];
+        float x = pt->tx_dbm - x_off;
+        float eta = b0 + b1 * x;
+        /* One exponential for both p and log(1 + e^eta), without overflow */
+        float e = expf(-fabsf(eta));
+        float p = ((eta >= 0.0f) ? 1.0f : e) / (1.0f + e);
+        float n = (float)pt->exp;
+        float k = (float)(pt->exp - pt->rcv);
+        float w = n * p * (1.0f - p);
+        float r = k - n * p;
+
+        ev->ll += k * eta - n * (fmaxf(eta, 0.0f) + log1pf(e));
+        ev->g0 += r;
+        ev->g1 += r * x;
+        ev->h00 += w;
+        ev->h01 += w * x;
+        ev->h11 += w * x * x;
+    }
+}
+
+int linkfit_solve(const linkfit_t *fit, linkfit_result_t *result)
+{
+    float pl_sum = 0.0f;
+    uint32_t pl_n = 0;
+    uint32_t lost = 0, total = 0;
+    float x_sum = 0.0f;
+    float b0, b1;
+    float per;
+    float x_off;
+    linkfit_eval_t ev;
+
+    if (fit == NULL || result == NULL) {
+        return -EINVAL;
+    }
+
+    memset(result, 0, sizeof(*result));
+    if (fit->n < 3) {
+        return -EAGAIN;
+    }
+
+    /* Path loss over all rounds with packets */
+    for (uint8_t i = 0; i < fit->n; i++) {
+        const linkfit_point_t *pt = &fit->pt[i];
+
+        pl_sum += (float)pt->tx_dbm * pt->rssi_n - (float)pt->rssi_sum;
+        pl_n += pt->rssi_n;
+        lost += pt->exp - pt->rcv;
+        total += pt->exp;
+        if (0 == i || pt->tx_dbm > result->tx_max_dbm) {
+            result->tx_max_dbm = pt->tx_dbm;
+        }
+    }
+    if (0 == pl_n) {
+        return -EAGAIN;
+    }
+    result->points = fit->n;
+    result->path_loss_db = pl_sum / pl_n;
+
+    /* Centre the predicted RSSI for conditioning */
+    for (uint8_t i = 0; i < fit->n; i++) {
+        x_sum += fit->pt[i].tx_dbm - result->path_loss_db;
+    }
+    result->rssi_ref = x_sum / fit->n;
+
+    /* Start from a flat curve at the overall PER */
+    per = (float)lost / total;
+    per = fminf(fmaxf(per, 0.01f), 0.99f);
+    b0 = logf(per / (1.0f - per));
+    b1 = 0.0f;
+    x_off = result->path_loss_db + result->rssi_ref;
+    linkfit_eval(fit, x_off, b0, b1, &ev);
+
+    for (uint8_t it = 0; it < LINKFIT_ITERATIONS; it++) {
+        float det = ev.h00 * ev.h11 - ev.h01 * ev.h01;
+        float d0, d1, scale;
+        uint8_t half;
+
+        if (!(det > 0.0f)) {
+            break;
+        }
+        d0 = (ev.h11 * ev.g0 - ev.h01 * ev.g1) / det;
+        d1 = (ev.h00 * ev.g1 - ev.h01 * ev.g0) / det;
+        if (fabsf(d0) < LINKFIT_STEP_DONE && fabsf(d1) < LINKFIT_STEP_DONE) {
+            break;
+        }
+
+        /* Limit the step along its direction, then halve until it helps */
+        scale = fmaxf(fabsf(d0), fabsf(d1)) / LINKFIT_MAX_STEP;
+        if (scale > 1.0f) {
+            d0 /= scale;
+            d1 /= scale;
+        }
+        for (half = 0; half < LINKFIT_HALVINGS; half++) {
+            linkfit_eval_t next;
+
+            linkfit_eval(fit, x_off, b0 + d0, b1 + d1, &next);
+            if (next.ll >= ev.ll) {
+                ev = next;
+                break;
+            }
+            d0 *= 0.5f;
+            d1 *= 0.5f;
+        }
+        if (LINKFIT_HALVINGS == half) {
+            /* No ascent left at float resolution */
+            break;
+        }
+        b0 += d0;
+        b1 += d1;
+    }
+
+    result->b0 = b0;
+    result->b1 = b1;
+    if (!(b1 < 0.0f)) {
+        return -EDOM;
+    }
+
+    result->sens_dbm[0] = linkfit_rssi_at(result, LINKFIT_PER_REF);
+    result->sens_dbm[1] = linkfit_rssi_at(result, LINKFIT_PER_10);
+    result->sens_dbm[2] = linkfit_rssi_at(result, LINKFIT_PER_1);
+    result->margin_db = (result->tx_max_dbm - result->path_loss_db) - result->sens_dbm[0];
+    return 0;
+}
+
+float linkfit_rssi_at(const linkfit_result_t *result, uint16_t per_permille)
+{
+    float p;
+
+    if (result == NULL || !(result->b1 < 0.0f)) {
+        return 0.0f;
+    }
+
+    p = (float)per_permille / 1000.0f;
+    p = fminf(fmaxf(p, 0.001f), 0.999f);
+    return result->rssi_ref + (logf(p / (1.0f - p)) - result->b0) / result->b1;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file linkfit.h
+ * @brief Path Loss and PER-vs-RSSI Fitting
+ *
+ * Turns (tx power, RSSI, PER) tuples of a tx power sweep into a link
+ * budget. Rounds at the same tx power are merged into one point, so the
+ * state is bounded by the number of tx power levels.
+ *
+ * Features:
+ * - Path loss as mean of tx power - RSSI over points with packets
+ * - Logistic PER-vs-RSSI fit by IRLS with a fixed iteration count
+ *   (single precision, binomial weights from the packet counts)
+ * - Sensitivity at any PER and margin at the highest swept tx power
+ *
+ * The PER curve is fitted against the RSSI predicted from tx power and
+ * path loss. The measured RSSI of a lossy round is biased high because only
+ * the stronger packets get through, and a round without packets has none.
+ *
+ * @note No Bluetooth stack dependency, so the fitter can be checked against
+ *       a double precision reference on a host build
+ */
+
+#ifndef LINKFIT_H
+#define LINKFIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINKFIT_MAX_POINTS  16      /* Distinct tx power levels */
+#define LINKFIT_ITERATIONS  20      /* IRLS iterations */
+
+/* Sensitivity PER points in 1/1000: 30.8 % (spec reference), 10 %, 1 % */
+#define LINKFIT_PER_REF     308
+#define LINKFIT_PER_10      100
+#define LINKFIT_PER_1       10
+
+/**
+ * @brief Merged rounds at one tx power
+ */
+typedef struct {
+    int8_t tx_dbm;             /**< Transmitter power */
+    uint16_t rssi_n;           /**< Rounds with packets */
+    int32_t rssi_sum;          /**< Sum of the round mean RSSI (dBm) */
+    uint32_t rcv;              /**< Packets received */
+    uint32_t exp;              /**< Packets expected */
+} linkfit_point_t;
+
+/**
+ * @brief Fitter input
+ */
+typedef struct {
+    uint8_t n;                                 /**< Points in use */
+    linkfit_point_t pt[LINKFIT_MAX_POINTS];    /**< Points */
+} linkfit_t;
+
+/**
+ * @brief Fitter output
+ *
+ * logit(PER) = b0 + b1 * (RSSI - rssi_ref)
+ */
+typedef struct {
+    uint8_t points;            /**< Points used */
+    float path_loss_db;        /**< Mean of tx power - RSSI */
+    float b0;                  /**< Logit intercept at rssi_ref */
+    float b1;                  /**< Logit slope (1/dB, negative) */
+    float rssi_ref;            /**< Centre of the fitted RSSI range (dBm) */
+    int8_t tx_max_dbm;         /**< Highest swept tx power */
+    float sens_dbm[3];         /**< RSSI at 30.8 %, 10 % and 1 % PER */
+    float margin_db;           /**< RSSI at tx_max_dbm above the 30.8 % sensitivity */
+} linkfit_result_t;
+
+/**
+ * @brief Clear all points
+ *
+ * @param fit Fitter input
+ */
+void linkfit_reset(linkfit_t *fit);
+
+/**
+ * @brief Add one round
+ *
+ * @param fit Fitter input
+ * @param tx_dbm Transmitter power of the round
+ * @param rssi Mean RSSI of the round (dBm, ignored if rcv is 0)
+ * @param rcv Packets received
+ * @param exp Packets expected (>0)
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -ENOSPC if all points are taken by other tx power levels
+ */
+int linkfit_add(linkfit_t *fit, int8_t tx_dbm, int8_t rssi, uint16_t rcv, uint16_t exp);
+
+/**
+ * @brief Fit path loss and the PER curve
+ *
+ * @param fit Fitter input
+ * @param result Output result
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -EAGAIN with fewer than 3 tx power levels or no packet at all,
+ *         -EDOM if PER does not fall with RSSI
+ */
+int linkfit_solve(const linkfit_t *fit, linkfit_result_t *result);
+
+/**
+ * @brief RSSI at which the fitted curve reaches a PER
+ *
+ * @param result Result of linkfit_solve()
+ * @param per_permille PER in 1/1000 (1-999)
+ * @return RSSI in dBm
+ */
+float linkfit_rssi_at(const linkfit_result_t *result, uint16_t per_permille);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINKFIT_H
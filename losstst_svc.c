@@ -9,6 +9,18 @@
 #include "losstst_svc.h"
 #include "ble_log.h"
 #include "lcd_ui.h"
+#include "tput_stats.h"
+#include "gen_plan.h"
+#include "chgdet.h"
+#include "linkfit.h"
+#include "rptq.h"
+#include "rstore.h"
+#include "rjournal.h"
+#include "mx25.h"
+#include "wallclock.h"
+#include "topk.h"
+#include "scan_phase.h"
+#include "app.h"
 #include <string.h>
 #include <stdio.h>
 #include <stddef.h>
@@ -19,6 +31,13 @@
 #include "sl_status.h"
 #include "gatt_db.h"
 #include "sl_sleeptimer.h"
+#include "sl_component_catalog.h"
+#include "sl_btctrl_config.h"
+#include "sl_btctrl_linklayer_defs.h"
+#include "sl_btctrl_scheduler_priority_config.h"
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+#include "nvm3_default.h"
+#endif
 
 /* CMSIS-RTOS2 headers for task management */
 #include "cmsis_os2.h"
@@ -45,6 +64,15 @@
     #define DEBUG_PRINT(fmt, ...) printf(fmt, ##__VA_ARGS__)
 #endif
 
+/* A line per report heard while scanning: more than the UART keeps up with */
+#define CHK_FORM_PARSER 0  /* Set to 1 to enable burst form parser prints */
+
+#if CHK_FORM_PARSER
+    #define PARSE_PRINT(fmt, ...) DEBUG_PRINT(fmt, ##__VA_ARGS__)
+#else
+    #define PARSE_PRINT(fmt, ...) do { } while (0)
+#endif
+
 /* ================== Advertising Options Presets ================== */
 /* Pre-defined advertising option combinations for common use cases */
 #define BT4_ADV_OPT_CLR_MASK (BT_LE_ADV_OPT_USE_TX_POWER | BT_LE_ADV_OPT_ANONYMOUS | \
@@ -211,6 +239,12 @@
 #define MANUFACTURER_ID    0xFFFF
 #define LOSS_TEST_FORM_ID  0xBAAB
 #define LOSS_TEST_BURST_COUNT 250
+#define LOSS_TEST_SHORT_PRE_CNT (-1)   /* Countdown start once the scanner acked */
+#define LOSS_TEST_PING_FORM_ID  0xBAAC
+#define LOSS_TEST_TPUT_FORM_ID  0xBAAD
+#define LOSS_TEST_TIME_FORM_ID  0xBAAE
+#define ENV_TOP_REPORT_MS       5000    /* Envmon top advertiser report period (log and LCD) */
+#define ENV_TOP_LOG             5       /* Advertisers logged per report */
 
 /* BLE AD Types */
 #define BT_DATA_FLAGS              0x01
@@ -319,6 +353,45 @@ typedef struct __attribute__((__packed__)) {
     uint16_t number_cast_form[4]; /* Number cast values */
 } numcast_info_t;
 
+/**
+ * @brief Ping request/echo structure
+ * 
+ * The initiator advertises a request with resp_dly = PING_REQUEST; the
+ * responder echoes seq, tx_tm and eui back, first with PING_ECHO_SYNC and
+ * then with its delay once the echo was sent.
+ */
+typedef struct __attribute__((__packed__)) {
+    uint16_t man_id;      /* Manufacturer ID (0xFFFF) */
+    uint16_t form_id;     /* Form ID (LOSS_TEST_PING_FORM_ID) */
+    uint16_t seq;         /* Ping sequence number */
+    uint32_t tx_tm;       /* Initiator uptime (ms) when the ping was queued */
+    uint16_t resp_dly;    /* Responder delay from request to echo sent (ms) */
+    struct __attribute__((scalar_storage_order("big-endian"))) {
+        uint64_t eui_64;  /* Initiator EUI-64 address */
+    } eui;
+} ping_info_t;
+
+/**
+ * @brief Throughput source advertisement
+ */
+typedef struct __attribute__((__packed__)) {
+    uint16_t man_id;      /* Manufacturer ID (0xFFFF) */
+    uint16_t form_id;     /* Form ID (LOSS_TEST_TPUT_FORM_ID) */
+    struct __attribute__((scalar_storage_order("big-endian"))) {
+        uint64_t eui_64;  /* Source EUI-64 address */
+    } eui;
+} tput_info_t;
+
+/**
+ * @brief Time beacon
+ */
+typedef struct __attribute__((__packed__)) {
+    uint16_t man_id;      /* Manufacturer ID (0xFFFF) */
+    uint16_t form_id;     /* Form ID (LOSS_TEST_TIME_FORM_ID) */
+    uint32_t sec;         /* UTC seconds since 1970 when the event was started */
+    uint16_t ms;          /* Milliseconds of sec */
+} time_info_t;
+
 typedef uint8_t adv_handle_t;  /* Advertising handle (0-based index) */
 
 /* TX power set value pair (sv: set value, pv: actual power value) */
@@ -335,6 +408,21 @@ static bool cfg_non_ANONYMOUS;
 static int8_t cfg_interval_sel_idx;
 static int8_t cfg_totalnum_sel_idx;
 static bool uni_cast_method;
+static bool round_concurrent_burst;   /* Burst all enabled PHYs in one cycle */
+static bool round_short_countdown;    /* Shorten countdown once scanner acked */
+static bool sndr_peer_acked;          /* Scanner acknowledged the previous burst */
+/* Per-set interval offsets (0.625 ms units) so concurrent sets drift apart */
+static const uint8_t concurrent_stagger[4] = {0, 3, 7, 11};
+static bool round_channel_sweep;      /* Rotate single-channel maps per burst */
+static uint16_t chsweep_rcv[4][3];    /* Received per PHY and channel 37/38/39 */
+static uint16_t chsweep_flow[4];      /* Highest burst flow seen per PHY */
+static bool round_soak;               /* Restart scanner rounds and watch for change points */
+static rptq_mon_t rx_queue;           /* Controller report queue monitor */
+static int8_t rx_queue_stream;        /* Burst stream of the report being parsed (-1: other) */
+static uint8_t prio_profile_cur;     /* Scheduler priority profile in effect */
+static uint16_t scan_interval_cur;   /* Scan interval (0.625 ms), 0 while not scanning */
+static int64_t scan_window_tm;       /* Scan windows accounted up to this uptime */
+static uint32_t scan_window_cnt;     /* Scan windows scheduled since the round started */
 static SV_PV_PWR_ST txpwr_setval[2][20];
 static uint8_t txpwr_idx = 20;  /* Initialize to array size to trigger init on first use */
 static const adv_param_t *non_connectable_adv_param_x[][4] ={
@@ -416,6 +504,9 @@ const int8_t sender_tgr=1;
 const int8_t scanner_tgr=2;
 const int8_t numcst_tgr=3;
 const int8_t envmon_tgr=4;
+const int8_t ping_tgr=5;
+const int8_t tput_tgr=6;
+const int8_t gen_tgr=7;
 
 static int8_t losstst_task_val;
 
@@ -434,6 +525,9 @@ static ext_adv_status_t ext_adv_status[MAX_ADV_SETS] = {
     {.u8_val = 0}, {.u8_val = 0}
 };
 
+/* Sets whose next start applies the duration/event limit (bit per set) */
+static uint8_t adv_limited_start;
+
 /* RSSI tracking structures */
 typedef struct {
     int64_t expired_tm;
@@ -533,8 +627,7 @@ bool scanner_inactive;          /**< Scanner inactive flag */
 uint64_t number_cast_val;       /**< Number cast value */
 uint64_t number_cast_rxval;     /**< Number cast received value */
 bool number_cast_auto;          /**< Number cast auto mode flag */
-static int16_t precnt_rcv[4];
-static rssi_stamp_t env_rssi_rec[4][256];
+static scan_phase_t scan_phase;    /* Received countdowns and the scan PHY prediction */
 
 typedef bool (*envmon_task_abort)(void);
 typedef bool (*sender_task_abort)(void);
@@ -545,7 +638,6 @@ static envmon_task_abort envmon_abort_p;
 static sender_task_abort sender_abort_p;
 static scanner_task_abort scanner_abort_p;
 static numcast_task_abort numcast_abort_p;
-static int8_t env_rssi[4][3];
 
 /* Silicon Labs advertisement info structure (equivalent to Nordic's bt_hci_evt_le_ext_advertising_info) */
 typedef struct {
@@ -591,17 +683,78 @@ static uint32_t env_stats[4];
 static uint16_t sndr_id;
 static int8_t sndr_txpower;
 static char rcv_msg_str[3][80];
-static int64_t numcst_rssi_rec_tm;
-static rssi_stamp_t numcst_rssi_rec[32];
-static int8_t numcst_rssi[3];
-static int64_t numcst_phy_stamp_tm[4] = {0, 0, 0, 0};
-static uint8_t numcst_src_node[2] = {0, 0};
-static uint16_t numcst_rssi_idx = 0;
-static rcv_stamp_t rcv_stamp[4];  /* Current burst state */
 static char rssi_str[3][5];
 static char tx_pwr_str[5];
 static dev_found_param_t dev_chr;  /* Device found parser state */
-static uint32_t env_rssi_idx[4];   /* Environment RSSI index per PHY */
+
+/* ================== Mode Arena ================== */
+
+/*
+ * Sender, scanner, numcast and envmon never run at the same time, so their
+ * private state shares one arena. The mode's setup function claims it
+ * (mode_arena_claim()) and initialises its own member; the other members
+ * are invalid from then on.
+ *
+ * The scanner trace is sized to use the space the envmon RSSI records
+ * need anyway.
+ */
+#define RX_TRACE_LEN            1024
+#define ENV_RSSI_REC_LEN        256     /* Power of 2 */
+#define NUMCST_RSSI_REC_LEN     32      /* Power of 2 */
+#ifndef MODE_ARENA_POISON
+#define MODE_ARENA_POISON       0       /* 1: fill the arena with 0xA5 on every claim */
+#endif
+
+typedef union {
+    struct {
+        int64_t burst_tm[4];        /* Burst start stamp per set */
+        uint16_t burst_intv[4];     /* Achieved burst interval (0.1 ms) per set */
+        uint32_t burst_adv_int[4];  /* Burst advertising interval (0.625 ms) per set */
+        uint16_t burst_skip[4];     /* Events missing in the last burst per set */
+    } sender;
+    struct {
+        rcv_stamp_t rcv_stamp[4];   /* Current burst state */
+        losstst_trace_entry_t trace[RX_TRACE_LEN];  /* Burst packets of the round */
+        uint16_t trace_n;
+        uint16_t trace_lost;        /* Burst packets beyond RX_TRACE_LEN */
+    } scanner;
+    struct {
+        rssi_stamp_t rssi_rec[NUMCST_RSSI_REC_LEN];
+        int64_t rssi_rec_tm;
+        int64_t phy_stamp_tm[4];
+        uint16_t rssi_idx;
+        int8_t rssi[3];
+        uint8_t src_node[2];
+    } numcast;
+    struct {
+        rssi_stamp_t rssi_rec[4][ENV_RSSI_REC_LEN];
+        uint32_t rssi_idx[4];       /* RSSI record index per PHY */
+        int8_t rssi[4][3];
+        topk_t top;                 /* Advertisers by report count */
+        int64_t top_report_tm;      /* Uptime of the next top list report */
+    } envmon;
+} mode_arena_t;
+
+static mode_arena_t mode_arena;
+static int8_t mode_arena_owner;     /* *_tgr of the mode that set the arena up, 0: none */
+
+/**
+ * @brief Hand the arena to a mode
+ * 
+ * Called by the mode's setup function before it initialises its member.
+ * With MODE_ARENA_POISON the whole arena is filled with 0xA5 first, so
+ * state a setup function forgets to initialise, or state read by another
+ * mode, shows up as 0xA5A5... instead of a left-over value.
+ * 
+ * @param owner *_tgr of the mode
+ */
+static void mode_arena_claim(int8_t owner)
+{
+#if MODE_ARENA_POISON
+    memset(&mode_arena, 0xA5, sizeof(mode_arena));
+#endif
+    mode_arena_owner = owner;
+}
 
 static const uint16_t value_interval[][2]={
 	{VALUE_ADV_INT_MIN_0, VALUE_ADV_INT_MAX_0}, //BLUETOOTH CORE SPEC 5.4, Vol 3, Part C, p.1376 ; TGAP(adv_fast_interval1)
@@ -628,6 +781,18 @@ int64_t platform_uptime_get(void) {
     return (int64_t)ms;
 }
 
+/**
+ * @brief Get system uptime in microseconds
+ * 
+ * Resolution is one sleeptimer tick (about 30 us at 32768 Hz).
+ * 
+ * @return Uptime in microseconds, wraps at 2^32
+ */
+static uint32_t platform_uptime_us(void) {
+    uint64_t ticks = sl_sleeptimer_get_tick_count64();
+    return (uint32_t)((ticks * 1000000u) / sl_sleeptimer_get_timer_frequency());
+}
+
 /**
  * @brief Check if platform can yield to other tasks
  * 
@@ -745,6 +910,33 @@ static uint8_t get_adv_channel_map(bool inhibit_ch37, bool inhibit_ch38, bool in
     return channel_map;
 }
 
+/**
+ * @brief Advertising channel of a burst in channel sweep mode
+ *
+ * Derived from the flow count carried in every packet, so the scanner
+ * attributes packets without extra signalling. Bursts rotate 37, 38, 39
+ * starting with flow 1.
+ *
+ * @param flw_cnt Flow count of the burst (1-based)
+ * @return Channel slot (0=37, 1=38, 2=39)
+ */
+static uint8_t chsweep_channel(uint16_t flw_cnt)
+{
+    return (uint8_t)((flw_cnt + 2) % 3);
+}
+
+/**
+ * @brief Number of bursts sent on a channel up to a flow count
+ *
+ * @param ch Channel slot (0=37, 1=38, 2=39)
+ * @param flw_cnt Highest flow count
+ * @return Burst count on that channel among flows 1..flw_cnt
+ */
+static uint16_t chsweep_bursts(uint8_t ch, uint16_t flw_cnt)
+{
+    return (uint16_t)((flw_cnt + 2 - ch) / 3);
+}
+
 /**
  * @brief Convert advertising options to Silicon Labs flags
  */
@@ -891,6 +1083,24 @@ static int platform_create_adv_set(const adv_param_t *param,
         
     }
     
+    /**
+     * @brief Apply duration and event limit of the next start
+     * 
+     * Silicon Labs takes both from the timing configuration, so the
+     * interval is re-applied together with the limits.
+     */
+    static int platform_set_adv_limit(adv_handle_t handle,
+                                      const adv_param_t *param,
+                                      const adv_start_param_t *start_param)
+    {
+        sl_status_t status = sl_bt_advertiser_set_timing(handle,
+                                                         param->interval_min,
+                                                         param->interval_max,
+                                                         start_param->timeout,
+                                                         start_param->num_events);
+        return (status == SL_STATUS_OK) ? 0 : -EIO;
+    }
+    
     static int platform_set_adv_data(adv_handle_t handle,
                                      adv_data_t *data, uint8_t data_len)
     {
@@ -1234,6 +1444,16 @@ int update_adv(uint8_t index,
         //                                      ? adv_start_param 
         //                                      : &p_adv_default_start_param;
         
+        /* Limits only take effect from the next start */
+        bool limited = (adv_start_param != NULL) && (adv_limited_start & (1u << index));
+        if (limited) {
+            platform_stop_adv(ext_adv[index]);
+            err = platform_set_adv_limit(ext_adv[index], &stored_adv_params[index], adv_start_param);
+            if (err) {
+                if (retval == 0) retval = err;
+            }
+        }
+        
         /* Silicon Labs needs options to determine extended/legacy and flags */
         err = platform_start_adv(ext_adv[index],// start_param, 
                                 stored_adv_params[index].options);
@@ -1242,12 +1462,40 @@ int update_adv(uint8_t index,
             if (retval == 0) retval = err;
         } else {
             ext_adv_status[index].start = 1;
+            if (limited) {
+                /* The stop flag now marks the end of this limited start */
+                ext_adv_status[index].stop = 0;
+            }
         }
     }
     
     return retval;
 }
 
+/**
+ * @brief Start advertising with the duration/event limit of the start parameters
+ * 
+ * update_adv() leaves the timing of a running set alone; this variant stops
+ * the set, programs the limit and clears the stop flag, so that flag is set
+ * again by the advertiser timeout of this start. Used for the sender bursts
+ * and the generator on-windows, which wait on that timeout.
+ */
+static int update_adv_limited(uint8_t index,
+                              const adv_param_t *adv_param,
+                              adv_data_t *adv_data,
+                              const adv_start_param_t *adv_start_param)
+{
+    int err;
+    
+    if (index >= MAX_ADV_SETS) {
+        return -EINVAL;
+    }
+    adv_limited_start |= (uint8_t)(1u << index);
+    err = update_adv(index, adv_param, adv_data, adv_start_param);
+    adv_limited_start &= (uint8_t)~(1u << index);
+    return err;
+}
+
 const ext_adv_status_t* get_adv_status(uint8_t index)
 {
     if (index >= num_adv_set) {
@@ -1343,6 +1591,19 @@ int set_adv_tx_power(int8_t tx_power_dbm, uint8_t num_handles)
 
 /* ================== Scanner Control Implementation ================== */
 
+/**
+ * @brief Count the scan windows scheduled since the last call
+ */
+static void scan_window_account(void)
+{
+    int64_t now = platform_uptime_get();
+    
+    if (scan_interval_cur) {
+        scan_window_cnt += (uint32_t)(((now - scan_window_tm) * 1000) / (scan_interval_cur * 625));
+    }
+    scan_window_tm = now;
+}
+
 int passive_scan_control(int8_t method)
 {
     if (!svc_init_success) {
@@ -1367,6 +1628,8 @@ int passive_scan_control(int8_t method)
     if (method < 0) {
         /* Stop scanning */
         status = sl_bt_scanner_stop();
+        scan_window_account();
+        scan_interval_cur = 0;
         scan_method = -1;
         return (status == SL_STATUS_OK) ? 0 : -EIO;
     }
@@ -1374,6 +1637,8 @@ int passive_scan_control(int8_t method)
     if (method != scan_method) {
         /* Stop current scanning */
         sl_bt_scanner_stop();
+        scan_window_account();
+        scan_interval_cur = 0;
         
         /* Determine PHY and timing parameters */
         switch (method) {
@@ -1429,6 +1694,8 @@ int passive_scan_control(int8_t method)
             return -EIO;
         }
         
+        scan_interval_cur = scan_interval;
+        scan_window_tm = platform_uptime_get();
         scan_method = method;
     }
 
@@ -1512,6 +1779,12 @@ int sender_setup(const test_param_t *param)
     round_phy_sel[1] = param->phy_1m;
     round_phy_sel[2] = param->phy_s8;
     round_phy_sel[3] = param->phy_ble4;
+    round_concurrent_burst = param->concurrent_burst;
+    round_short_countdown = param->short_countdown;
+    round_channel_sweep = param->channel_sweep;
+    sndr_peer_acked = false;
+    mode_arena_claim(sender_tgr);
+    memset(&mode_arena.sender, 0, sizeof(mode_arena.sender));
     
     /* Reset device info structures */
     device_info_form[0].pre_cnt = INT16_MIN;
@@ -1713,6 +1986,40 @@ void scanner_peek_msg(void)
     *(uint16_t *)(peek_msg_str[3]) = MANUFACTURER_ID;
 }
 
+static void soak_reset(void);
+static void journal_update(void);
+static void journal_clear(void);
+static void journal_check(void);
+static void journal_commit(void);
+
+/**
+ * @brief Reset the counters of a scanner round
+ * 
+ * Marks the scanner inactive, so the next losstst_scanner() call starts
+ * a fresh round.
+ */
+static void scanner_round_reset(void)
+{
+    sub_total_snd_2m = 0;
+    sub_total_snd_1m = 0;
+    sub_total_snd_s8 = 0;
+    sub_total_snd_ble4 = 0;
+    sub_total_rcv[0] = 0;
+    sub_total_rcv[1] = 0;
+    sub_total_rcv[2] = 0;
+    sub_total_rcv[3] = 0;
+    
+    /* Reset reception statistics */
+    memset(rec_sets, 0, sizeof(rec_sets));
+    memset(chsweep_rcv, 0, sizeof(chsweep_rcv));
+    memset(chsweep_flow, 0, sizeof(chsweep_flow));
+    mode_arena.scanner.trace_n = 0;
+    mode_arena.scanner.trace_lost = 0;
+    journal_clear();
+    
+    scanner_inactive = true;
+}
+
 int scanner_setup(const test_param_t *param)
 {
     if (!svc_init_success || param == NULL) {
@@ -1728,19 +2035,17 @@ int scanner_setup(const test_param_t *param)
     round_phy_sel[1] = param->phy_1m;
     round_phy_sel[2] = param->phy_s8;
     round_phy_sel[3] = param->phy_ble4;
+    round_channel_sweep = param->channel_sweep;
+    round_soak = param->soak;
     
-    /* Reset all counters */
-    sub_total_snd_2m = 0;
-    sub_total_snd_1m = 0;
-    sub_total_snd_s8 = 0;
-    sub_total_snd_ble4 = 0;
-    sub_total_rcv[0] = 0;
-    sub_total_rcv[1] = 0;
-    sub_total_rcv[2] = 0;
-    sub_total_rcv[3] = 0;
+    mode_arena_claim(scanner_tgr);
+    memset(mode_arena.scanner.rcv_stamp, 0, sizeof(mode_arena.scanner.rcv_stamp));
     
-    /* Reset reception statistics */
-    memset(rec_sets, 0, sizeof(rec_sets));
+    /* Reset all counters */
+    scanner_round_reset();
+    if (round_soak) {
+        soak_reset();
+    }
     
     /* Set config flags */
     ignore_rcv_resp = param->ignore_rcv_resp;
@@ -1755,10 +2060,6 @@ int scanner_setup(const test_param_t *param)
     scanner_abort_p = param->scanner_abort;
     numcast_abort_p = param->numcast_abort;
     
-    /* Set scanner inactive flag */
-    extern bool scanner_inactive;
-    scanner_inactive = true;
-    
     /* Generate initial status message */
     scanner_peek_msg();
     
@@ -1815,6 +2116,9 @@ int numcast_setup(const test_param_t *param)
     extern uint64_t number_cast_val;
     number_cast_val = *(uint64_t *)p_number_cast_form;
     
+    mode_arena_claim(numcst_tgr);
+    memset(&mode_arena.numcast, 0, sizeof(mode_arena.numcast));
+    
     /* Set config flags */
     inhibit_ch37 = param->inhibit_ch37;
     inhibit_ch38 = param->inhibit_ch38;
@@ -1897,6 +2201,13 @@ int envmon_setup(const test_param_t *param)
     if (err) {
     }
     
+    mode_arena_claim(envmon_tgr);
+    memset(mode_arena.envmon.rssi_rec, 0, sizeof(mode_arena.envmon.rssi_rec));
+    memset(mode_arena.envmon.rssi_idx, 0, sizeof(mode_arena.envmon.rssi_idx));
+    memset(mode_arena.envmon.rssi, 0, sizeof(mode_arena.envmon.rssi));
+    topk_reset(&mode_arena.envmon.top);
+    mode_arena.envmon.top_report_tm = platform_uptime_get() + ENV_TOP_REPORT_MS;
+    
     /* Update LCD display */
     lcd_ui_update(param, "EnvMon", "Ready");
     
@@ -2005,6 +2316,12 @@ int8_t sender_task_tgr(int8_t set) { return losstst_task_tgr( set, sender_tgr  )
 int8_t sender_task_status(void) { return losstst_task_status( sender_tgr ); }
 int8_t envmon_task_tgr(int8_t set) { return losstst_task_tgr( set, envmon_tgr  ); }
 int8_t envmon_task_status(void) { return losstst_task_status( envmon_tgr ); }
+int8_t ping_task_tgr(int8_t set) { return losstst_task_tgr( set, ping_tgr  ); }
+int8_t ping_task_status(void) { return losstst_task_status( ping_tgr ); }
+int8_t tput_task_tgr(int8_t set) { return losstst_task_tgr( set, tput_tgr  ); }
+int8_t tput_task_status(void) { return losstst_task_status( tput_tgr ); }
+int8_t gen_task_tgr(int8_t set) { return losstst_task_tgr( set, gen_tgr  ); }
+int8_t gen_task_status(void) { return losstst_task_status( gen_tgr ); }
 
 /* ===============================================
  * Configuration Enumeration and Getter Functions
@@ -2216,6 +2533,8 @@ int losstst_init(void)
 {
     int err;
     
+    journal_check();
+    
     /* 第一層：核心 BLE 初始化 */
     // 修改：不自动启动广告，等待用户通过 LCD 触发
     err = ble_test_init(false, false);  // auto_start_scan=true, auto_start_adv=false
@@ -2240,6 +2559,72 @@ const char* get_peek_msg_buffer(uint8_t index)
     return peek_msg_str[index];
 }
 
+/**
+ * @brief Restart report queue accounting for a scanner round
+ * 
+ * Also clears the controller packet counters, so they cover the round.
+ */
+static void rx_queue_reset(void)
+{
+    uint16_t tx, rx, crc, fail;
+    
+    rptq_mon_init(&rx_queue, SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS, RPTQ_DRAIN_GAP_US);
+    sl_bt_system_get_counters(1, &tx, &rx, &crc, &fail);
+    scan_window_tm = platform_uptime_get();
+    scan_window_cnt = 0;
+}
+
+int losstst_get_rxq_stats(losstst_rxq_stats_t *stats)
+{
+    uint16_t tx;
+    
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->queue_depth = rx_queue.depth;
+    stats->reports = rx_queue.reports;
+    stats->drains = rx_queue.drains;
+    stats->sat_drains = rx_queue.sat_drains;
+    stats->max_drain = (rx_queue.run > rx_queue.max_run) ? rx_queue.run : rx_queue.max_run;
+    if (SL_STATUS_OK != sl_bt_system_get_counters(0, &tx, &stats->ctrl_rx,
+                                                  &stats->ctrl_crc, &stats->ctrl_fail)) {
+        return -EIO;
+    }
+    return 0;
+}
+
+int losstst_get_result(uint8_t index, losstst_result_t *result)
+{
+    if (index >= 4 || result == NULL) {
+        return -EINVAL;
+    }
+    
+    memset(result, 0, sizeof(*result));
+    result->rcv = rcv_ratio_val[index][0];
+    result->exp = rcv_ratio_val[index][1];
+    
+    /* Split the loss into controller queue drops and the rest */
+    if (result->exp > result->rcv) {
+        uint32_t lost = result->exp - result->rcv;
+        uint32_t host = rptq_mon_host_lost(&rx_queue, index);
+        
+        result->host_lost = (uint16_t)((host < lost) ? host : lost);
+        result->rf_lost = (uint16_t)(lost - result->host_lost);
+    }
+    
+    /* Expected per channel follows from the sweep order, so lost bursts count */
+    if (round_channel_sweep) {
+        for (uint8_t ch = 0; ch < 3; ch++) {
+            result->ch[ch].rcv = chsweep_rcv[index][ch];
+            result->ch[ch].exp = LOSS_TEST_BURST_COUNT * chsweep_bursts(ch, chsweep_flow[index]);
+        }
+    }
+    
+    return 0;
+}
+
 /* ================== Burst Test Functions Implementation ================== */
 
 /**
@@ -2253,10 +2638,24 @@ const char* get_peek_msg_buffer(uint8_t index)
  * 
  * @param adv_handle Advertising handle that completed
  */
+static void gen_adv_done(uint8_t index);
+static bool ping_adv_sent(uint8_t adv_handle);
+
 void losstst_adv_sent_handler(adv_handle_t adv_handle)
 {
-    uint8_t index = adv_handle;
+    uint8_t index;
+    
+    /* Ping send stamps; the echo set is not one of the indexed sets */
+    if (ping_adv_sent(adv_handle)) {
+        return;
+    }
     
+    /* Sets are created on first use, so the stack handle is not the index */
+    for (index = 0; index < num_adv_set; index++) {
+        if (ext_adv_status[index].initialized && ext_adv[index] == adv_handle) {
+            break;
+        }
+    }
     if (num_adv_set <= index) {
         return;
     }
@@ -2264,6 +2663,11 @@ void losstst_adv_sent_handler(adv_handle_t adv_handle)
     /* Mark advertising as stopped */
     ext_adv_status[index].stop = 1;
     
+    /* Generator on-window completed */
+    if (0 != gen_task_tgr(0)) {
+        gen_adv_done(index);
+    }
+    
     /* Handle sender abort flag for PHY test sets (index 0-3) */
     if (index < ARRAY_SIZE(sndr_abort_flag) && sndr_abort_flag[index]) {
         sndr_abort_flag[index] = false;
@@ -2349,6 +2753,30 @@ void sender_finit(void)
     
 }
 
+/**
+ * @brief Record the achieved interval of sets that finished their burst
+ *
+ * An event the scheduler pre-empts is not counted against the burst's
+ * event budget, so every skipped event stretches the burst by one
+ * interval plus advDelay (0-10 ms, 5 ms on average).
+ *
+ * @param lc_phy_sel PHYs bursting in this cycle
+ * @param now Current uptime (ms)
+ */
+static void snd_burst_stamp(const bool *lc_phy_sel, int64_t now)
+{
+    for (int idx = 0; idx <= 3; idx++) {
+        if (lc_phy_sel[idx] && ext_adv_status[idx].stop && 2 == snd_state_val[idx]) {
+            int64_t dur_us = (now - mode_arena.sender.burst_tm[idx]) * 1000;
+            int64_t events = dur_us / ((int64_t)mode_arena.sender.burst_adv_int[idx] * 625 + 5000);
+            
+            mode_arena.sender.burst_intv[idx] = (uint16_t)(((now - mode_arena.sender.burst_tm[idx]) * 10) / LOSS_TEST_BURST_COUNT);
+            mode_arena.sender.burst_skip[idx] = (uint16_t)((events > LOSS_TEST_BURST_COUNT) ? events - LOSS_TEST_BURST_COUNT : 0);
+            snd_state_val[idx] = 3;
+        }
+    }
+}
+
 int losstst_sender(void)
 {
     if (!svc_init_success) {
@@ -2361,6 +2789,7 @@ int losstst_sender(void)
     bool lc_phy_sel[4] = {false, false, false, false};
     bool abort = false;
     int64_t uptime_64_barrier, period_msec, pitch_msec;
+    uint16_t ctrl_tx, ctrl_rx, ctrl_crc, ctrl_fail;
     
     /* Determine which PHYs still need transmission */
     sub_phy0 = (round_phy_sel[0]) ? sub_total_snd_2m : round_total_num;
@@ -2370,7 +2799,13 @@ int losstst_sender(void)
     //sub_phy3 = (round_phy_sel[3]) ? sub_total_snd_ble4 : round_total_num;
     
     /* Select PHYs for this burst cycle */
-    if (sub_phy1 <= sub_phy2) {
+    if (round_concurrent_burst) {
+        /* Every enabled PHY bursts in this cycle on its own advertising set */
+        lc_phy_sel[0] = round_phy_sel[0];
+        lc_phy_sel[1] = round_phy_sel[1];
+        lc_phy_sel[2] = round_phy_sel[2];
+        lc_phy_sel[3] = round_phy_sel[3];
+    } else if (sub_phy1 <= sub_phy2) {
         lc_phy_sel[0] = round_phy_sel[0];
         lc_phy_sel[1] = round_phy_sel[1];
         lc_phy_sel[3] = round_phy_sel[3];
@@ -2386,7 +2821,8 @@ int losstst_sender(void)
         
         /* ========== Phase 1: Pre-burst countdown (3 seconds) ========== */
         uptime_64_barrier = platform_uptime_get();
-        lc_pre_cnt = -3;
+        /* The scanner is already locked on once it acked the previous burst */
+        lc_pre_cnt = (round_short_countdown && sndr_peer_acked) ? LOSS_TEST_SHORT_PRE_CNT : -3;
         
         /* Initialize pre-burst progress */
         for (int idx = 0; idx <= 3; idx++) {
@@ -2456,6 +2892,10 @@ int losstst_sender(void)
         
         /* ========== Phase 2: Burst transmission ========== */
         period_msec = LOSS_TEST_BURST_COUNT * value_interval[round_adv_param_index][1];
+        if (round_concurrent_burst) {
+            /* Slowest staggered set bounds the burst */
+            period_msec += (LOSS_TEST_BURST_COUNT * concurrent_stagger[3] * 10) / 16;
+        }
         int32_t period_sec = 1 + period_msec / 1000;
         
         /* Initialize burst progress counter */
@@ -2489,14 +2929,27 @@ int losstst_sender(void)
         }
         
         /* Start burst advertising (250 events per PHY) */
+        sl_bt_system_get_counters(1, &ctrl_tx, &ctrl_rx, &ctrl_crc, &ctrl_fail);
         for (int idx = 0; idx <= 3; idx++) {
             if (lc_phy_sel[idx]) {
                 /* Use configured interval for burst transmission */
-                const adv_param_t *work_adv_param = non_connectable_adv_param_x[round_adv_param_index][idx];
+                adv_param_t work_adv_param = *non_connectable_adv_param_x[round_adv_param_index][idx];
+                if (round_concurrent_burst) {
+                    /* Distinct intervals keep the sets from colliding on every event */
+                    work_adv_param.interval_min += concurrent_stagger[idx];
+                    work_adv_param.interval_max += concurrent_stagger[idx];
+                }
                 if (idx == 3) {
                     device_info_bt4_form.device_info = device_info_form[3];
                 }
-                update_adv(idx, work_adv_param, ratio_test_data_set[idx], p_adv_burst_start_param);
+                if (round_channel_sweep) {
+                    /* One primary channel per burst, picked from the flow count */
+                    sl_bt_advertiser_set_channel_map(ext_adv[idx],
+                                                     1 << chsweep_channel(device_info_form[idx].flw_cnt));
+                }
+                update_adv_limited(idx, &work_adv_param, ratio_test_data_set[idx], p_adv_burst_start_param);
+                mode_arena.sender.burst_tm[idx] = platform_uptime_get();
+                mode_arena.sender.burst_adv_int[idx] = work_adv_param.interval_min;
                 snd_state_val[idx] = 2;
             }
         }
@@ -2505,11 +2958,12 @@ int losstst_sender(void)
         uptime_64_barrier += period_msec;
         pitch_msec = 1000 + platform_uptime_get();
         
+        int64_t now = platform_uptime_get();
         while (((lc_phy_sel[0] && !ext_adv_status[0].stop)
                 || (lc_phy_sel[1] && !ext_adv_status[1].stop)
                 || (lc_phy_sel[2] && !ext_adv_status[2].stop)
                 || (lc_phy_sel[3] && !ext_adv_status[3].stop))
-            && (uptime_64_barrier > (period_msec = platform_uptime_get()))) {
+            && uptime_64_barrier > now) {
             
             if (platform_can_yield()) {
                 platform_yield();
@@ -2522,8 +2976,10 @@ int losstst_sender(void)
                 }
             }
             
+            snd_burst_stamp(lc_phy_sel, now);
+            
             /* Update countdown every second */
-            if (period_msec >= pitch_msec) {
+            if (now >= pitch_msec) {
                 pitch_msec += 1000;
                 period_sec--;
                 
@@ -2533,10 +2989,14 @@ int losstst_sender(void)
                         if (idx == 3) {
                             device_info_bt4_form.device_info = device_info_form[3];
                         }
-                        update_adv(idx, NULL, ratio_test_data_set[idx], NULL);
+                        /* A set that finished its events must not be restarted */
+                        if (!ext_adv_status[idx].stop) {
+                            update_adv(idx, NULL, ratio_test_data_set[idx], NULL);
+                        }
                     }
                 }
             }
+            now = platform_uptime_get();
         }
         
         if (abort) {
@@ -2544,6 +3004,7 @@ int losstst_sender(void)
             sender_finit();
             return -1;
         }
+        snd_burst_stamp(lc_phy_sel, platform_uptime_get());
         
         /* ========== Phase 3: Post-burst reporting ========== */
         ack_remote_resp[0] = ack_remote_resp[1] = ack_remote_resp[2] = ack_remote_resp[3] = false;
@@ -2557,6 +3018,12 @@ int losstst_sender(void)
                     device_info_bt4_form.device_info = device_info_form[3];
                 }
                 
+                /* Back to the configured map so the report reaches the scanner */
+                if (round_channel_sweep) {
+                    sl_bt_advertiser_set_channel_map(ext_adv[idx],
+                                                     get_adv_channel_map(inhibit_ch37, inhibit_ch38, inhibit_ch39));
+                }
+                
                 /* Use group 3 parameters (1 second interval) for post-burst */
                 const adv_param_t *work_adv_param = non_connectable_adv_param_x[3][idx];
                 update_adv(idx, work_adv_param, ratio_test_data_set[idx], p_adv_default_start_param);
@@ -2623,6 +3090,20 @@ int losstst_sender(void)
         
         snd_state_val[0] = snd_state_val[1] = snd_state_val[2] = snd_state_val[3] = 0;
         
+        /* Scanner lock-on: every PHY of this cycle acknowledged its burst */
+        sndr_peer_acked = !ignore_rcv_resp
+            && (!lc_phy_sel[0] || ack_remote_resp[0])
+            && (!lc_phy_sel[1] || ack_remote_resp[1])
+            && (!lc_phy_sel[2] || ack_remote_resp[2])
+            && (!lc_phy_sel[3] || ack_remote_resp[3]);
+        
+        for (int idx = 0; idx <= 3; idx++) {
+            if (lc_phy_sel[idx] && mode_arena.sender.burst_intv[idx]) {
+                DEBUG_PRINT("[SND] set %d burst interval %u.%u ms, %u events pre-empted\n", idx,
+                            mode_arena.sender.burst_intv[idx] / 10, mode_arena.sender.burst_intv[idx] % 10, mode_arena.sender.burst_skip[idx]);
+            }
+        }
+        
         /* ========== Phase 4: Check for completion ========== */
         /* Check each PHY for completion */
         if (lc_phy_sel[0] && sub_total_snd_2m >= round_total_num) {
@@ -2680,42 +3161,2663 @@ int losstst_sender(void)
     return retval;
 }
 
-int losstst_scanner(void)
+/* ================== Ping (Round-Trip Latency) ================== */
+
+/*
+ * The initiator (ping task) advertises a request per enabled PHY on its own
+ * set as a single advertising event and scans for echoes. Any active scanner
+ * acts as responder: it echoes the request on the same PHY, as a single event
+ * on a set of its own, then advertises the echo again with the time from the
+ * request report to the echo's adv-sent event. Both ends take their send
+ * time from the advertiser timeout that ends the single event, so the RTT
+ * is two advertising hops without the queueing and advertising delay of
+ * either side; the initiator subtracts the responder delay from it.
+ */
+#define PING_SAMPLES      100          /* Pings per PHY */
+#define PING_TIMEOUT_MS   500          /* Echo wait before a ping counts as lost */
+#define PING_GAP_MS       20           /* Pause between echo and next ping */
+#define PING_REQUEST      UINT16_MAX   /* resp_dly marker of a request */
+#define PING_ECHO_SYNC    (UINT16_MAX - 1) /* resp_dly of an echo, delay still unknown */
+#define PING_FOLLOW_EVENTS 3           /* Events of the echo that carries the delay */
+#define PING_ECHO_MS      1000         /* Echo set stuck guard */
+
+static const adv_start_param_t p_adv_ping_start_param[] = BT_LE_EXT_ADV_START_PARAM(0, 1);
+static const adv_start_param_t p_adv_ping_follow_param[] = BT_LE_EXT_ADV_START_PARAM(0, PING_FOLLOW_EVENTS);
+
+typedef bool (*ping_task_abort)(void);
+
+static ping_task_abort ping_abort_p;
+static ping_info_t ping_form[4];                /* Outstanding request per PHY */
+static adv_data_t ping_data_set[4][3];
+static volatile bool ping_wait[4];              /* Request outstanding */
+static int64_t ping_tm[4];                      /* Uptime of last request or echo */
+static volatile int64_t ping_sent_tm[4];        /* Request adv-sent event (0 = pending) */
+static volatile int64_t ping_sync_tm[4];        /* Echo reception (0 = none yet) */
+static uint16_t ping_sent[4];
+static volatile uint16_t ping_rtt_cnt[4];
+static uint16_t ping_rtt[4][PING_SAMPLES];      /* RTT samples (ms) */
+
+static ping_info_t ping_echo_req[4];            /* Request awaiting its echo */
+static int64_t ping_echo_rcv_tm[4];
+static volatile bool ping_echo_pending[4];
+static ping_info_t ping_echo_form;              /* Echo being advertised */
+static adv_data_t ping_echo_data[3];
+static int64_t ping_echo_rx_tm;                 /* Request report of that echo */
+static int64_t ping_echo_start_tm;
+static uint8_t ping_echo_handle = 0xFF;         /* Echo set, apart from sets 0-3 */
+static volatile int8_t ping_echo_idx = -1;      /* PHY of the echo on air (-1 = idle) */
+static volatile bool ping_echo_follow;          /* Echo carries the delay */
+
+/**
+ * @brief Build flags + ping form advertising data
+ */
+static void ping_prepare_data(adv_data_t *data_set, const ping_info_t *form)
 {
-    if (!svc_init_success) {
-        return -1;
+    data_set[0] = (adv_data_t){
+        .type = BT_DATA_FLAGS,
+        .data_len = 1,
+        .data = p_common_adv_flags
+    };
+    data_set[1] = (adv_data_t){
+        .type = BT_DATA_MANUFACTURER_DATA,
+        .data_len = sizeof(ping_info_t),
+        .data = (const uint8_t *)form
+    };
+    data_set[2] = (adv_data_t){
+        .type = 0,
+        .data = NULL,
+        .data_len = 0
+    };
+}
+
+/**
+ * @brief Handle a received ping request or echo
+ *
+ * Runs in Bluetooth event context; the responder only queues the echo.
+ *
+ * @param idx PHY index (0=2M, 1=1M, 2=Coded, 3=BLE4)
+ * @param form Received ping form
+ */
+static void ping_packet_rcv(uint8_t idx, const ping_info_t *form)
+{
+    int64_t now = platform_uptime_get();
+    uint64_t eui = form->eui.eui_64;
+
+    if (0 != ping_task_tgr(0)) {
+        uint64_t own_eui = ping_form[idx].eui.eui_64;
+
+        /* Only the echoes of our outstanding, sent request count */
+        if (PING_REQUEST == form->resp_dly || eui != own_eui || !ping_wait[idx]
+            || form->seq != ping_form[idx].seq || 0 == ping_sent_tm[idx]) {
+            return;
+        }
+        if (PING_ECHO_SYNC == form->resp_dly) {
+            /* The echo itself; its delay follows */
+            if (0 == ping_sync_tm[idx]) {
+                ping_sync_tm[idx] = now;
+            }
+            return;
+        }
+        if (0 == ping_sync_tm[idx]) {
+            /* Echo missed, the delay alone does not time anything */
+            return;
+        }
+        uint32_t rtt = (uint32_t)(ping_sync_tm[idx] - ping_sent_tm[idx]);
+        rtt = (rtt > form->resp_dly) ? rtt - form->resp_dly : 0;
+        if (ping_rtt_cnt[idx] < PING_SAMPLES) {
+            ping_rtt[idx][ping_rtt_cnt[idx]++] = (rtt > UINT16_MAX) ? UINT16_MAX : (uint16_t)rtt;
+        }
+        ping_tm[idx] = now;
+        ping_wait[idx] = false;
+    } else if (0 != scanner_task_tgr(0)) {
+        uint64_t req_eui = ping_echo_req[idx].eui.eui_64;
+
+        /* The request repeats every advertising event; echo each one once */
+        if (PING_REQUEST != form->resp_dly || ping_echo_pending[idx]
+            || (form->seq == ping_echo_req[idx].seq && form->tx_tm == ping_echo_req[idx].tx_tm
+                && eui == req_eui)) {
+            return;
+        }
+        ping_echo_req[idx] = *form;
+        ping_echo_rcv_tm[idx] = now;
+        ping_echo_pending[idx] = true;
     }
+}
+
+static bool ping_form_parser(adv_data_t *data, void *user_data)
+{
+    dev_found_param_t *dev_chr_p = (dev_found_param_t *)user_data;
     
-    int retval = 1;
-    int64_t period_msec, uptime_64_barrier;
-    bool abort = false;
-    static int8_t round_scan_method;
-    static int8_t next_scan_method = 0;
-    static int16_t assign;
-    static int64_t cntdn = 0;
-    static int64_t complete_mark, complete_elapse;
-    static bool phy_mark[4];
-    static int64_t hrtbt, hrtbt_stamp;
-    static bool first_round;
-    
-    /* Initialize on first call or after inactive period */
-    if (scanner_inactive) {
-        memset(rcv_stamp, 0, sizeof(rcv_stamp));
-        scanner_inactive = false;
-        memset(rcv_ratio_val, 0, sizeof(rcv_ratio_val));
-        
-        /* Determine scan method based on PHY selection */
+    /* Check for FLAGS element */
+    if (BT_DATA_FLAGS == data->type) {
+        if (0 == dev_chr_p->step_raw) {
+            dev_chr_p->step_flag++;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    }
+    /* Check for MANUFACTURER_DATA element */
+    else if (1 == dev_chr_p->step_flag && BT_DATA_MANUFACTURER_DATA == data->type
+             && sizeof(ping_info_t) == data->data_len) {
+        ping_info_t form;
+        sl_adv_info_t *adv_info_p = dev_chr_p->adv_info_p;
+        int8_t idx;
+        
+        memcpy(&form, data->data, sizeof(form));
+        
+        /* Determine PHY index from primary and secondary PHY */
+        if (1 == adv_info_p->prim_phy && 2 == adv_info_p->sec_phy) {
+            idx = 0;  /* 2M PHY */
+        } else if (1 == adv_info_p->prim_phy && 1 == adv_info_p->sec_phy) {
+            idx = 1;  /* 1M PHY */
+        } else if (3 == adv_info_p->prim_phy && 3 == adv_info_p->sec_phy) {
+            idx = 2;  /* Coded PHY S=8 */
+        } else if (1 == adv_info_p->prim_phy && 0 == adv_info_p->sec_phy) {
+            idx = 3;  /* BLE4 (legacy advertising) */
+        } else {
+            dev_chr_p->step_fail = 1;
+            return false;
+        }
+        
+        if (MANUFACTURER_ID == form.man_id && LOSS_TEST_PING_FORM_ID == form.form_id) {
+            ping_packet_rcv(idx, &form);
+            dev_chr_p->step_success = 1;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    } else {
+        dev_chr_p->step_fail = 1;
+    }
+    
+    /* Continue parsing if not completed */
+    return (dev_chr_p->step_completed) ? false : true;
+}
+
+/**
+ * @brief Start the echo of a PHY on the echo set (responder side)
+ *
+ * The echo goes out as a single event; ping_echo_sent() follows up with the
+ * delay once that event was sent.
+ *
+ * @param idx PHY index (0=2M, 1=1M, 2=Coded, 3=BLE4)
+ * @return 0 on success, -ENOMEM without a free set, -EIO on a stack error
+ */
+static int ping_echo_start(uint8_t idx)
+{
+    const adv_param_t *work_adv_param = non_connectable_adv_param_x[0][idx];
+    int16_t tx_power = round_tx_pwr * 10;
+    
+    if (0xFF == ping_echo_handle) {
+        if (SL_STATUS_OK != sl_bt_advertiser_create_set(&ping_echo_handle)) {
+            ping_echo_handle = 0xFF;
+            return -ENOMEM;
+        }
+    }
+    
+    ping_echo_form = ping_echo_req[idx];
+    ping_echo_form.resp_dly = PING_ECHO_SYNC;
+    ping_echo_rx_tm = ping_echo_rcv_tm[idx];
+    ping_prepare_data(ping_echo_data, &ping_echo_form);
+    
+    platform_stop_adv(ping_echo_handle);
+    sl_bt_advertiser_set_tx_power(ping_echo_handle, tx_power, &tx_power);
+    if (platform_update_adv_param(ping_echo_handle, work_adv_param)
+        || platform_set_adv_data(ping_echo_handle, ping_echo_data, 2)
+        || platform_set_adv_limit(ping_echo_handle, work_adv_param, p_adv_ping_start_param)
+        || platform_start_adv(ping_echo_handle, work_adv_param->options)) {
+        return -EIO;
+    }
+    ping_echo_follow = false;
+    ping_echo_start_tm = platform_uptime_get();
+    ping_echo_idx = (int8_t)idx;
+    return 0;
+}
+
+/**
+ * @brief Advertiser timeout of the echo set
+ *
+ * Called from losstst_adv_sent_handler() in Bluetooth event context. The
+ * echo was sent: advertise it again with the delay from the request report
+ * up to now. The end of that follow-up frees the set.
+ */
+static void ping_echo_sent(void)
+{
+    int8_t idx = ping_echo_idx;
+    
+    if (idx < 0) {
+        return;
+    }
+    if (ping_echo_follow) {
+        ping_echo_idx = -1;
+        return;
+    }
+    
+    const adv_param_t *work_adv_param = non_connectable_adv_param_x[0][idx];
+    int64_t dly = platform_uptime_get() - ping_echo_rx_tm;
+    
+    ping_echo_form.resp_dly = (PING_ECHO_SYNC <= dly) ? (PING_ECHO_SYNC - 1) : (uint16_t)dly;
+    ping_echo_follow = true;
+    if (platform_set_adv_data(ping_echo_handle, ping_echo_data, 2)
+        || platform_set_adv_limit(ping_echo_handle, work_adv_param, p_adv_ping_follow_param)
+        || platform_start_adv(ping_echo_handle, work_adv_param->options)) {
+        ping_echo_idx = -1;
+    }
+}
+
+/**
+ * @brief Advertiser timeout hook of the ping
+ *
+ * Stamps the send time of an outstanding request.
+ *
+ * @param adv_handle Advertising handle that completed sending
+ * @return true if the handle is the echo set
+ */
+static bool ping_adv_sent(uint8_t adv_handle)
+{
+    if (0xFF != ping_echo_handle && adv_handle == ping_echo_handle) {
+        ping_echo_sent();
+        return true;
+    }
+    if (0 != ping_task_tgr(0) && adv_handle <= 3
+        && ping_wait[adv_handle] && 0 == ping_sent_tm[adv_handle]) {
+        ping_sent_tm[adv_handle] = platform_uptime_get();
+    }
+    return false;
+}
+
+/**
+ * @brief Advertise queued echoes (responder side)
+ *
+ * The echo set carries one echo at a time; requests of other PHYs wait
+ * until it is free.
+ */
+static void ping_echo_service(void)
+{
+    if (ping_echo_idx >= 0) {
+        if (platform_uptime_get() - ping_echo_start_tm < PING_ECHO_MS) {
+            return;
+        }
+        /* Timeout event lost: take the set back */
+        platform_stop_adv(ping_echo_handle);
+        ping_echo_idx = -1;
+    }
+    
+    for (int idx = 0; idx <= 3; idx++) {
+        if (!ping_echo_pending[idx]) {
+            continue;
+        }
+        ping_echo_pending[idx] = false;
+        if (0 == ping_echo_start((uint8_t)idx)) {
+            break;
+        }
+    }
+}
+
+static int ping_rtt_cmp(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+int losstst_get_ping_stats(uint8_t index, losstst_ping_stats_t *stats)
+{
+    uint16_t sorted[PING_SAMPLES];
+    uint16_t n;
+    
+    if (index >= 4 || stats == NULL) {
+        return -EINVAL;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    n = ping_rtt_cnt[index];
+    stats->sent = ping_sent[index];
+    stats->echoed = n;
+    if (0 == n) {
+        return 0;
+    }
+    
+    memcpy(sorted, ping_rtt[index], n * sizeof(sorted[0]));
+    qsort(sorted, n, sizeof(sorted[0]), ping_rtt_cmp);
+    
+    stats->rtt_min = sorted[0];
+    stats->rtt_median = (n & 1) ? sorted[n / 2] : (uint16_t)((sorted[n / 2 - 1] + sorted[n / 2]) / 2);
+    stats->rtt_p99 = sorted[(99 * n + 99) / 100 - 1];  /* Nearest rank */
+    
+    return 0;
+}
+
+int ping_setup(const test_param_t *param)
+{
+    if (!svc_init_success || param == NULL) {
+        return -EINVAL;
+    }
+    
+    int err = 0;
+    
+    /* Initialize application layer variables */
+    round_tx_pwr = param->txpwr;
+    round_phy_sel[0] = param->phy_2m;
+    round_phy_sel[1] = param->phy_1m;
+    round_phy_sel[2] = param->phy_s8;
+    round_phy_sel[3] = param->phy_ble4;
+    inhibit_ch37 = param->inhibit_ch37;
+    inhibit_ch38 = param->inhibit_ch38;
+    inhibit_ch39 = param->inhibit_ch39;
+    non_ANONYMOUS = param->non_ANONYMOUS;
+    ping_abort_p = param->ping_abort;
+    
+    /* Reset initiator state */
+    for (int idx = 0; idx <= 3; idx++) {
+        ping_form[idx] = (ping_info_t){
+            .man_id = MANUFACTURER_ID,
+            .form_id = LOSS_TEST_PING_FORM_ID,
+            .resp_dly = PING_REQUEST
+        };
+        ping_form[idx].eui.eui_64 = device_info_form[idx].eui.eui_64;
+        ping_prepare_data(ping_data_set[idx], &ping_form[idx]);
+        ping_wait[idx] = false;
+        ping_tm[idx] = 0;
+        ping_sent_tm[idx] = 0;
+        ping_sync_tm[idx] = 0;
+    }
+    memset(ping_sent, 0, sizeof(ping_sent));
+    memset((void *)ping_rtt_cnt, 0, sizeof(ping_rtt_cnt));
+    
+    /* Stop all advertising */
+    err = stop_all_advertising();
+    if (err) {
+    }
+    
+    err = set_adv_tx_power(param->txpwr, 4);
+    if (err) {
+        return err;
+    }
+    
+    adv_param_mask[0] = (non_ANONYMOUS) ? BT_LE_ADV_OPT_ANONYMOUS : 0;
+    adv_param_mask[1] = ((non_ANONYMOUS) ? BT_LE_ADV_OPT_USE_IDENTITY : 0);
+    
+    /* Echoes may arrive on either primary PHY */
+    err = passive_scan_control(0);
+    if (err) {
+        return err;
+    }
+    
+    /* Update LCD display */
+    lcd_ui_update(param, "Ping", "Ready");
+    
+    return 0;
+}
+
+int losstst_ping(void)
+{
+    if (!svc_init_success) {
+        return -1;
+    }
+    
+    int64_t now = platform_uptime_get();
+    bool busy = false;
+    
+    /* Check for abort condition */
+    if (ping_abort_p != NULL && ping_abort_p()) {
+        blocking_adv(0);
+        blocking_adv(1);
+        blocking_adv(2);
+        blocking_adv(3);
+        return -1;
+    }
+    
+    for (int idx = 0; idx <= 3; idx++) {
+        if (!round_phy_sel[idx]) {
+            continue;
+        }
+        
+        if (ping_wait[idx]) {
+            if (now - ping_tm[idx] < PING_TIMEOUT_MS) {
+                busy = true;
+                continue;
+            }
+            /* Request or echo lost */
+            ping_wait[idx] = false;
+            ping_tm[idx] = now;
+        }
+        
+        if (ping_sent[idx] >= PING_SAMPLES) {
+            continue;
+        }
+        busy = true;
+        if (now - ping_tm[idx] < PING_GAP_MS) {
+            continue;
+        }
+        
+        /* Queue the next request on the fastest interval group */
+        adv_param_t work_adv_param = *non_connectable_adv_param_x[0][idx];
+        work_adv_param.options |= adv_param_mask[1];
+        work_adv_param.options &= ~adv_param_mask[0];
+        
+        ping_form[idx].seq++;
+        ping_form[idx].tx_tm = (uint32_t)now;
+        ping_tm[idx] = now;
+        ping_sent_tm[idx] = 0;
+        ping_sync_tm[idx] = 0;
+        ping_wait[idx] = true;
+        ping_sent[idx]++;
+        /* One event: its advertiser timeout stamps the send time */
+        update_adv_limited(idx, &work_adv_param, ping_data_set[idx], p_adv_ping_start_param);
+        sl_bt_advertiser_set_channel_map(ext_adv[idx],
+                                         get_adv_channel_map(inhibit_ch37, inhibit_ch38, inhibit_ch39));
+    }
+    
+    if (busy) {
+        if (platform_can_yield()) {
+            platform_yield();
+        }
+        return 1;
+    }
+    
+    /* All PHYs done: report the RTT distribution */
+    for (int idx = 0; idx <= 3; idx++) {
+        losstst_ping_stats_t stats;
+        
+        if (!round_phy_sel[idx]) {
+            continue;
+        }
+        blocking_adv(idx);
+        losstst_get_ping_stats(idx, &stats);
+        DEBUG_PRINT("[PING] %s: %u/%u RTT min %u med %u p99 %u ms\n",
+                    (3 == idx) ? "BLE4" : ((2 == idx) ? "S8" : ((1 == idx) ? "1M" : "2M")),
+                    stats.echoed, stats.sent, stats.rtt_min, stats.rtt_median, stats.rtt_p99);
+    }
+    
+    return 0;
+}
+
+/* ================== Connection Throughput ================== */
+
+/*
+ * The source advertises a connectable throughput form on the 1M set. The
+ * sink scans for it, connects as central and negotiates PHY, data length
+ * and ATT MTU. Once the sink subscribes, the source streams MTU-3 byte
+ * notifications on the log characteristic (same GATT database on both
+ * ends), each starting with a 32-bit sequence number. When the stack has
+ * the L2CAP feature, the sink then opens a credit based channel and the
+ * source streams single K-frame SDUs on it for a second phase. The sink
+ * measures both phases; the source counts backpressure.
+ */
+#if defined(SL_CATALOG_BLUETOOTH_FEATURE_L2CAP_PRESENT)
+#define TPUT_COC               1
+#else
+#define TPUT_COC               0
+#endif
+#define TPUT_ADV_SET           1           /* 1M advertising set */
+#define TPUT_CHAR_HANDLE       gattdb_log_output   /* Log Output, shared with the BLE log */
+#define TPUT_NO_CONN           0xFF
+#define TPUT_MAX_MTU           247         /* One notification per 251 octet PDU */
+#define TPUT_MAX_DATA_LEN      251
+#define TPUT_MAX_TX_TIME_US    17040       /* 251 octets on Coded S=8 */
+#define TPUT_CONN_INTERVAL     24          /* 30 ms (1.25 ms units) */
+#define TPUT_SUPERVISION_TMO   100         /* 1 s (10 ms units) */
+#define TPUT_PHASE_MS          10000       /* Measurement per transport */
+#define TPUT_WINDOW_MS         500         /* Throughput window */
+#define TPUT_STALL_MIN_MS      30          /* Stall threshold floor */
+#define TPUT_STALL_INTERVALS   3           /* Stall threshold in connection intervals */
+#define TPUT_SEARCH_MS         60000       /* Sink scan / source advertising timeout */
+#define TPUT_CONNECT_MS        5000        /* Connection and negotiation timeout */
+#define TPUT_MTU_WAIT_MS       1000        /* Subscribe with the default MTU after this */
+#define TPUT_PUMP_BURST        16          /* Sends per iteration */
+#define TPUT_COC_SPSM          0x0080      /* Dynamic LE protocol/service multiplexer */
+#define TPUT_COC_CREDITS       16          /* K-frames granted by the sink */
+
+typedef bool (*tput_task_abort)(void);
+
+typedef enum {
+    TPUT_SEARCH = 0,    /* Sink scanning / source advertising */
+    TPUT_CONNECTING,    /* Sink: connection initiated */
+    TPUT_NEGOTIATE,     /* PHY, data length and MTU exchange */
+    TPUT_GATT,          /* Notification phase */
+    TPUT_COC_OPEN,      /* Sink: channel requested */
+    TPUT_COC_RUN,       /* Credit based channel phase */
+    TPUT_DONE
+} tput_state_t;
+
+static tput_task_abort tput_abort_p;
+static bool tput_source;
+static volatile tput_state_t tput_state;
+static int64_t tput_tm;                         /* Start of the current state */
+static tput_info_t tput_form;
+static adv_data_t tput_data_set[3];
+static bd_addr tput_peer;
+static uint8_t tput_peer_type;              /* sl_bt_gap_address_type_t of the peer */
+static volatile bool tput_peer_found;
+static volatile uint8_t tput_conn = TPUT_NO_CONN;
+static volatile uint16_t tput_interval;         /* 1.25 ms units */
+static volatile uint8_t tput_phy;
+static volatile uint16_t tput_data_len;         /* Source to sink direction */
+static volatile uint16_t tput_mtu;
+static volatile bool tput_mtu_done;
+static volatile bool tput_subscribed;           /* Source: notifications enabled */
+static uint32_t tput_seq;                       /* Source: next sequence number */
+static uint32_t tput_rx_seq[2];                 /* Sink: expected sequence number */
+static tput_stats_t tput_st[2];                 /* 0=GATT, 1=CoC */
+static losstst_tput_result_t tput_res[2];
+static uint8_t tput_buf[TPUT_MAX_DATA_LEN];
+#if TPUT_COC
+static volatile uint16_t tput_cid;              /* 0 = no channel */
+static volatile uint16_t tput_coc_credit;       /* Source: K-frames we may send */
+static uint16_t tput_coc_pdu;                   /* K-frame size */
+static uint16_t tput_coc_used;                  /* Sink: K-frames not yet credited back */
+#endif
+
+/**
+ * @brief Build flags + throughput form advertising data
+ */
+static void tput_prepare_data(void)
+{
+    tput_data_set[0] = (adv_data_t){
+        .type = BT_DATA_FLAGS,
+        .data_len = 1,
+        .data = p_common_adv_flags
+    };
+    tput_data_set[1] = (adv_data_t){
+        .type = BT_DATA_MANUFACTURER_DATA,
+        .data_len = sizeof(tput_info_t),
+        .data = (const uint8_t *)&tput_form
+    };
+    tput_data_set[2] = (adv_data_t){
+        .type = 0,
+        .data = NULL,
+        .data_len = 0
+    };
+}
+
+static bool tput_form_parser(adv_data_t *data, void *user_data)
+{
+    dev_found_param_t *dev_chr_p = (dev_found_param_t *)user_data;
+    
+    /* Check for FLAGS element */
+    if (BT_DATA_FLAGS == data->type) {
+        if (0 == dev_chr_p->step_raw) {
+            dev_chr_p->step_flag++;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    }
+    /* Check for MANUFACTURER_DATA element */
+    else if (1 == dev_chr_p->step_flag && BT_DATA_MANUFACTURER_DATA == data->type
+             && sizeof(tput_info_t) == data->data_len) {
+        tput_info_t form;
+        
+        memcpy(&form, data->data, sizeof(form));
+        if (MANUFACTURER_ID == form.man_id && LOSS_TEST_TPUT_FORM_ID == form.form_id) {
+            /* The first source found is the peer */
+            if (!tput_source && TPUT_SEARCH == tput_state && !tput_peer_found) {
+                tput_peer = dev_chr_p->adv_info_p->address;
+                tput_peer_type = dev_chr_p->adv_info_p->address_type;
+                tput_peer_found = true;
+            }
+            dev_chr_p->step_success = 1;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    } else {
+        dev_chr_p->step_fail = 1;
+    }
+    
+    /* Continue parsing if not completed */
+    return (dev_chr_p->step_completed) ? false : true;
+}
+
+/**
+ * @brief Account a payload received by the sink
+ *
+ * @param transport 0=GATT, 1=CoC
+ * @param data Payload starting with the sequence number
+ * @param len Payload length
+ */
+static void tput_sink_rcv(uint8_t transport, const uint8_t *data, uint16_t len)
+{
+    uint32_t seq;
+    
+    if (len < sizeof(seq)) {
+        return;
+    }
+    memcpy(&seq, data, sizeof(seq));
+    
+    /* The link layer retransmits, so a gap means payloads dropped above it */
+    if (seq > tput_rx_seq[transport] && 0 != tput_st[transport].packets) {
+        uint32_t lost = tput_res[transport].seq_lost + (seq - tput_rx_seq[transport]);
+        tput_res[transport].seq_lost = (lost > UINT16_MAX) ? UINT16_MAX : (uint16_t)lost;
+    }
+    tput_rx_seq[transport] = seq + 1;
+    tput_stats_feed(&tput_st[transport], (uint32_t)platform_uptime_get(), len);
+}
+
+/**
+ * @brief Start measuring a transport on the sink
+ */
+static void tput_phase_start(uint8_t transport)
+{
+    /* A retransmitted PDU delays delivery by at least one connection event */
+    uint32_t stall_ms = (uint32_t)tput_interval * 5 / 4 * TPUT_STALL_INTERVALS;
+    
+    if (stall_ms < TPUT_STALL_MIN_MS) {
+        stall_ms = TPUT_STALL_MIN_MS;
+    }
+    tput_stats_init(&tput_st[transport], TPUT_WINDOW_MS, stall_ms);
+    tput_rx_seq[transport] = 0;
+    tput_tm = platform_uptime_get();
+}
+
+/**
+ * @brief Close a sink phase and fill its result
+ *
+ * @param transport 0=GATT, 1=CoC
+ * @param payload Application bytes per SDU
+ * @param overhead Protocol bytes per SDU (ATT + L2CAP headers)
+ */
+static void tput_phase_end(uint8_t transport, uint16_t payload, uint16_t overhead)
+{
+    tput_stats_t *st = &tput_st[transport];
+    losstst_tput_result_t *res = &tput_res[transport];
+    uint16_t sdu = payload + overhead;
+    
+    tput_stats_finish(st, (uint32_t)platform_uptime_get());
+    
+    /* SDUs larger than the data length are fragmented over several PDUs */
+    if (sdu <= tput_data_len) {
+        res->capacity_bps = tput_stats_capacity_bps(tput_phy, sdu, payload);
+    } else {
+        res->capacity_bps = tput_stats_capacity_bps(tput_phy, tput_data_len,
+                                                    (uint16_t)((uint32_t)tput_data_len * payload / sdu));
+    }
+    res->bytes = (uint32_t)st->total_bytes;
+    res->goodput_bps = tput_stats_goodput_bps(st);
+    res->win_min_bps = st->win_min_bps;
+    res->win_max_bps = st->win_max_bps;
+    res->stalls = (st->stalls > UINT16_MAX) ? UINT16_MAX : (uint16_t)st->stalls;
+    res->stall_ms = (st->stall_total_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)st->stall_total_ms;
+    res->max_gap_ms = (st->max_gap_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)st->max_gap_ms;
+    res->conn_interval = tput_interval;
+    res->data_len = tput_data_len;
+    res->mtu = tput_mtu;
+    res->phy = tput_phy;
+    res->util_pct = tput_stats_utilisation(st, res->capacity_bps);
+}
+
+/**
+ * @brief Queue payloads on the source until the stack runs out of buffers
+ */
+static void tput_source_pump(void)
+{
+    for (int n = 0; n < TPUT_PUMP_BURST; n++) {
+        sl_status_t sc;
+        uint8_t transport;
+        uint16_t len;
+        
+#if TPUT_COC
+        if (0 != tput_cid) {
+            if (0 == tput_coc_credit) {
+                return;
+            }
+            /* Single K-frame SDU: length header, then payload */
+            len = tput_coc_pdu - 2;
+            tput_buf[0] = (uint8_t)len;
+            tput_buf[1] = (uint8_t)(len >> 8);
+            memcpy(&tput_buf[2], &tput_seq, sizeof(tput_seq));
+            sc = sl_bt_l2cap_channel_send_data(tput_conn, tput_cid, tput_coc_pdu, tput_buf);
+            transport = 1;
+        } else
+#endif
+        if (tput_subscribed) {
+            len = tput_mtu - 3;
+            memcpy(tput_buf, &tput_seq, sizeof(tput_seq));
+            sc = sl_bt_gatt_server_send_notification(tput_conn, TPUT_CHAR_HANDLE, len, tput_buf);
+            transport = 0;
+        } else {
+            return;
+        }
+        
+        if (SL_STATUS_NO_MORE_RESOURCE == sc) {
+            tput_res[transport].backpressure++;
+            return;
+        }
+        if (SL_STATUS_OK != sc) {
+            return;
+        }
+#if TPUT_COC
+        if (1 == transport) {
+            tput_coc_credit--;
+        }
+#endif
+        tput_seq++;
+        tput_res[transport].bytes += len;
+    }
+}
+
+bool losstst_tput_event(sl_bt_msg_t *evt)
+{
+    /* A link closed on abort reports its close after the trigger is gone */
+    if (NULL == evt || (0 == tput_task_tgr(0) && TPUT_NO_CONN == tput_conn)) {
+        return false;
+    }
+    
+    switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_connection_opened_id: {
+        sl_bt_evt_connection_opened_t *e = &evt->data.evt_connection_opened;
+        
+        if (tput_source ? (e->advertiser != ext_adv[TPUT_ADV_SET] || TPUT_NO_CONN != tput_conn)
+                        : (e->connection != tput_conn)) {
+            return false;
+        }
+        tput_conn = e->connection;
+        tput_state = TPUT_NEGOTIATE;
+        tput_tm = platform_uptime_get();
+        
+        /* Source sends, but both ends ask for the long data length */
+        sl_bt_connection_set_data_length(tput_conn, TPUT_MAX_DATA_LEN, TPUT_MAX_TX_TIME_US);
+        if (!tput_source) {
+            sl_bt_connection_set_preferred_phy(tput_conn, tput_phy, tput_phy);
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_connection_parameters_id:
+        if (evt->data.evt_connection_parameters.connection != tput_conn) {
+            return false;
+        }
+        tput_interval = evt->data.evt_connection_parameters.interval;
+        return true;
+    
+    case sl_bt_evt_connection_phy_status_id:
+        if (evt->data.evt_connection_phy_status.connection != tput_conn) {
+            return false;
+        }
+        tput_phy = evt->data.evt_connection_phy_status.phy;
+        return true;
+    
+    case sl_bt_evt_connection_data_length_id: {
+        sl_bt_evt_connection_data_length_t *e = &evt->data.evt_connection_data_length;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        tput_data_len = tput_source ? e->tx_data_len : e->rx_data_len;
+        return true;
+    }
+    
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+        if (evt->data.evt_gatt_mtu_exchanged.connection != tput_conn) {
+            return false;
+        }
+        tput_mtu = evt->data.evt_gatt_mtu_exchanged.mtu;
+        tput_mtu_done = true;
+        return true;
+    
+    case sl_bt_evt_gatt_server_characteristic_status_id: {
+        sl_bt_evt_gatt_server_characteristic_status_t *e = &evt->data.evt_gatt_server_characteristic_status;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        if (TPUT_CHAR_HANDLE == e->characteristic && sl_bt_gatt_server_client_config == e->status_flags) {
+            tput_subscribed = (0 != (e->client_config_flags & sl_bt_gatt_server_notification));
+            if (tput_subscribed) {
+                tput_seq = 0;
+                tput_state = TPUT_GATT;
+            }
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_gatt_characteristic_value_id: {
+        sl_bt_evt_gatt_characteristic_value_t *e = &evt->data.evt_gatt_characteristic_value;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        if (TPUT_GATT == tput_state && TPUT_CHAR_HANDLE == e->characteristic
+            && sl_bt_gatt_handle_value_notification == e->att_opcode) {
+            tput_sink_rcv(0, e->value.data, e->value.len);
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_gatt_procedure_completed_id:
+        return (evt->data.evt_gatt_procedure_completed.connection == tput_conn);
+    
+#if TPUT_COC
+    case sl_bt_evt_l2cap_le_channel_open_request_id: {
+        sl_bt_evt_l2cap_le_channel_open_request_t *e = &evt->data.evt_l2cap_le_channel_open_request;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        if (!tput_source || TPUT_COC_SPSM != e->spsm) {
+            sl_bt_l2cap_send_le_channel_open_response(e->connection, e->cid, 0, 0, 0,
+                                                      sl_bt_l2cap_connection_result_spsm_not_supported);
+            return true;
+        }
+        /* The source only sends; grant the minimum */
+        if (SL_STATUS_OK == sl_bt_l2cap_send_le_channel_open_response(e->connection, e->cid,
+                                                                      TPUT_MAX_DATA_LEN, TPUT_MAX_DATA_LEN - 4, 1,
+                                                                      sl_bt_l2cap_connection_result_successful)) {
+            tput_coc_pdu = (e->max_pdu < e->max_sdu + 2) ? e->max_pdu : e->max_sdu + 2;
+            if (tput_coc_pdu > TPUT_MAX_DATA_LEN) {
+                tput_coc_pdu = TPUT_MAX_DATA_LEN;
+            }
+            tput_coc_credit = e->credit;
+            tput_seq = 0;
+            tput_cid = e->cid;
+            tput_state = TPUT_COC_RUN;
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_l2cap_le_channel_open_response_id: {
+        sl_bt_evt_l2cap_le_channel_open_response_t *e = &evt->data.evt_l2cap_le_channel_open_response;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        if (TPUT_COC_OPEN == tput_state) {
+            if (sl_bt_l2cap_connection_result_successful == e->errorcode) {
+                tput_coc_used = 0;
+                tput_phase_start(1);
+                tput_state = TPUT_COC_RUN;
+            } else {
+                tput_cid = 0;
+                tput_state = TPUT_DONE;
+            }
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_l2cap_channel_data_id: {
+        sl_bt_evt_l2cap_channel_data_t *e = &evt->data.evt_l2cap_channel_data;
+        
+        if (e->connection != tput_conn) {
+            return false;
+        }
+        if (TPUT_COC_RUN == tput_state && e->cid == tput_cid && e->data.len > 2) {
+            tput_sink_rcv(1, &e->data.data[2], e->data.len - 2);
+            
+            /* Hand credits back in halves to keep the source busy */
+            if (++tput_coc_used >= TPUT_COC_CREDITS / 2
+                && SL_STATUS_OK == sl_bt_l2cap_channel_send_credit(tput_conn, tput_cid, tput_coc_used)) {
+                tput_coc_used = 0;
+            }
+        }
+        return true;
+    }
+    
+    case sl_bt_evt_l2cap_channel_credit_id:
+        if (evt->data.evt_l2cap_channel_credit.connection != tput_conn) {
+            return false;
+        }
+        if (evt->data.evt_l2cap_channel_credit.cid == tput_cid) {
+            tput_coc_credit += evt->data.evt_l2cap_channel_credit.credit;
+        }
+        return true;
+    
+    case sl_bt_evt_l2cap_channel_closed_id:
+        if (evt->data.evt_l2cap_channel_closed.connection != tput_conn) {
+            return false;
+        }
+        if (evt->data.evt_l2cap_channel_closed.cid == tput_cid) {
+            tput_cid = 0;
+        }
+        return true;
+#endif
+    
+    case sl_bt_evt_connection_closed_id:
+        if (evt->data.evt_connection_closed.connection != tput_conn) {
+            return false;
+        }
+        tput_conn = TPUT_NO_CONN;
+        tput_subscribed = false;
+#if TPUT_COC
+        tput_cid = 0;
+#endif
+        /* A running sink phase is closed by losstst_tput() */
+        if (tput_source || (TPUT_GATT != tput_state && TPUT_COC_RUN != tput_state)) {
+            tput_state = TPUT_DONE;
+        }
+        return true;
+    
+    default:
+        return false;
+    }
+}
+
+bool losstst_tput_connected(void)
+{
+    return (TPUT_NO_CONN != tput_conn);
+}
+
+int losstst_get_tput_result(uint8_t transport, losstst_tput_result_t *result)
+{
+    if (transport >= 2 || result == NULL) {
+        return -EINVAL;
+    }
+    
+    *result = tput_res[transport];
+    return 0;
+}
+
+int tput_setup(const test_param_t *param)
+{
+    if (!svc_init_success || param == NULL) {
+        return -EINVAL;
+    }
+    
+    int err = 0;
+    uint16_t max_mtu;
+    
+    /* Initialize application layer variables */
+    round_tx_pwr = param->txpwr;
+    round_phy_sel[0] = param->phy_2m;
+    round_phy_sel[1] = param->phy_1m;
+    round_phy_sel[2] = param->phy_s8;
+    round_phy_sel[3] = param->phy_ble4;
+    inhibit_ch37 = param->inhibit_ch37;
+    inhibit_ch38 = param->inhibit_ch38;
+    inhibit_ch39 = param->inhibit_ch39;
+    tput_abort_p = param->tput_abort;
+    tput_source = param->tput_source;
+    
+    /* Connection PHY: first selected of 2M, 1M, Coded */
+    tput_phy = round_phy_sel[0] ? sl_bt_gap_phy_2m :
+               (round_phy_sel[1] ? sl_bt_gap_phy_1m :
+               (round_phy_sel[2] ? sl_bt_gap_phy_coded : sl_bt_gap_phy_1m));
+    
+    /* Reset link and result state */
+    tput_state = TPUT_SEARCH;
+    tput_tm = platform_uptime_get();
+    tput_peer_found = false;
+    tput_conn = TPUT_NO_CONN;
+    tput_interval = TPUT_CONN_INTERVAL;
+    tput_data_len = 27;
+    tput_mtu = 23;
+    tput_mtu_done = false;
+    tput_subscribed = false;
+#if TPUT_COC
+    tput_cid = 0;
+    tput_coc_credit = 0;
+#endif
+    memset(tput_res, 0, sizeof(tput_res));
+    memset(tput_buf, 0xA5, sizeof(tput_buf));
+    
+    /* Stop all advertising */
+    err = stop_all_advertising();
+    if (err) {
+    }
+    
+    err = set_adv_tx_power(param->txpwr, 4);
+    if (err) {
+        return err;
+    }
+    
+    if (SL_STATUS_OK != sl_bt_gatt_set_max_mtu(TPUT_MAX_MTU, &max_mtu)) {
+        return -EIO;
+    }
+    
+    if (tput_source) {
+        adv_param_t work_adv_param = *non_connectable_adv_param_x[0][TPUT_ADV_SET];
+        
+        passive_scan_control(-1);
+        
+        /* Connectable extended advertising cannot be anonymous */
+        work_adv_param.options |= BT_LE_ADV_OPT_CONNECTABLE;
+        work_adv_param.options &= ~BT_LE_ADV_OPT_ANONYMOUS;
+        tput_form = (tput_info_t){
+            .man_id = MANUFACTURER_ID,
+            .form_id = LOSS_TEST_TPUT_FORM_ID
+        };
+        tput_form.eui.eui_64 = device_info_form[TPUT_ADV_SET].eui.eui_64;
+        tput_prepare_data();
+        err = update_adv(TPUT_ADV_SET, &work_adv_param, tput_data_set, p_adv_default_start_param);
+        if (err) {
+            return err;
+        }
+        sl_bt_advertiser_set_channel_map(ext_adv[TPUT_ADV_SET],
+                                         get_adv_channel_map(inhibit_ch37, inhibit_ch38, inhibit_ch39));
+    } else {
+        /* Long intervals with unlimited event length favour throughput */
+        if (SL_STATUS_OK != sl_bt_connection_set_default_parameters(TPUT_CONN_INTERVAL, TPUT_CONN_INTERVAL, 0,
+                                                                    TPUT_SUPERVISION_TMO, 0, 0xFFFF)) {
+            return -EIO;
+        }
+        err = passive_scan_control(1);
+        if (err) {
+            return err;
+        }
+    }
+    
+    /* Update LCD display */
+    lcd_ui_update(param, "Tput", "Ready");
+    
+    return 0;
+}
+
+/**
+ * @brief Print one transport result of the sink
+ */
+static void tput_report(uint8_t transport)
+{
+    const losstst_tput_result_t *res = &tput_res[transport];
+    
+    DEBUG_PRINT("[TPUT] %s: %lu bps (win %lu-%lu) cap %lu bps util %u%%\n",
+                transport ? "CoC" : "GATT", (unsigned long)res->goodput_bps,
+                (unsigned long)res->win_min_bps, (unsigned long)res->win_max_bps,
+                (unsigned long)res->capacity_bps, res->util_pct);
+    DEBUG_PRINT("[TPUT] %s: %u stalls %u ms, max gap %u ms, lost %u\n",
+                transport ? "CoC" : "GATT", res->stalls, res->stall_ms, res->max_gap_ms, res->seq_lost);
+}
+
+int losstst_tput(void)
+{
+    if (!svc_init_success) {
+        return -1;
+    }
+    
+    int64_t now = platform_uptime_get();
+    
+    /* Check for abort condition */
+    if (tput_abort_p != NULL && tput_abort_p()) {
+        if (TPUT_NO_CONN != tput_conn) {
+            sl_bt_connection_close(tput_conn);
+        }
+        passive_scan_control(-1);
+        blocking_adv(TPUT_ADV_SET);
+        return -1;
+    }
+    
+    switch (tput_state) {
+    case TPUT_SEARCH:
+        if (now - tput_tm >= TPUT_SEARCH_MS) {
+            passive_scan_control(-1);
+            blocking_adv(TPUT_ADV_SET);
+            return -ETIMEDOUT;
+        }
+        if (!tput_source && tput_peer_found) {
+            uint8_t conn;
+            
+            passive_scan_control(-1);
+            if (SL_STATUS_OK == sl_bt_connection_open(tput_peer, tput_peer_type,
+                                                      sl_bt_gap_phy_1m, &conn)) {
+                tput_conn = conn;
+                tput_state = TPUT_CONNECTING;
+                tput_tm = now;
+            } else {
+                tput_peer_found = false;
+                passive_scan_control(1);
+            }
+        }
+        break;
+    
+    case TPUT_CONNECTING:
+    case TPUT_NEGOTIATE:
+        if (now - tput_tm >= TPUT_CONNECT_MS) {
+            if (TPUT_NO_CONN != tput_conn) {
+                sl_bt_connection_close(tput_conn);
+            }
+            return -ETIMEDOUT;
+        }
+        /* The stack exchanges the MTU by itself; subscribe afterwards */
+        if (!tput_source && TPUT_NEGOTIATE == tput_state
+            && (tput_mtu_done || now - tput_tm >= TPUT_MTU_WAIT_MS)
+            && SL_STATUS_OK == sl_bt_gatt_set_characteristic_notification(tput_conn, TPUT_CHAR_HANDLE,
+                                                                          sl_bt_gatt_notification)) {
+            tput_phase_start(0);
+            tput_state = TPUT_GATT;
+        }
+        break;
+    
+    case TPUT_GATT:
+        if (tput_source) {
+            tput_source_pump();
+            break;
+        }
+        tput_stats_tick(&tput_st[0], (uint32_t)now);
+        if (now - tput_tm < TPUT_PHASE_MS && TPUT_NO_CONN != tput_conn) {
+            break;
+        }
+        tput_phase_end(0, tput_mtu - 3, 3 + 4);
+        if (TPUT_NO_CONN == tput_conn) {
+            tput_state = TPUT_DONE;
+            break;
+        }
+        sl_bt_gatt_set_characteristic_notification(tput_conn, TPUT_CHAR_HANDLE, sl_bt_gatt_disable);
+#if TPUT_COC
+        {
+            uint16_t cid;
+            
+            /* One K-frame per PDU: L2CAP header takes 4 octets */
+            tput_coc_pdu = tput_data_len - 4;
+            if (SL_STATUS_OK == sl_bt_l2cap_open_le_channel(tput_conn, TPUT_COC_SPSM, tput_coc_pdu - 2,
+                                                            tput_coc_pdu, TPUT_COC_CREDITS, &cid)) {
+                tput_cid = cid;
+                tput_state = TPUT_COC_OPEN;
+                tput_tm = now;
+                break;
+            }
+        }
+#endif
+        tput_state = TPUT_DONE;
+        break;
+    
+#if TPUT_COC
+    case TPUT_COC_OPEN:
+        if (now - tput_tm >= TPUT_CONNECT_MS) {
+            tput_state = TPUT_DONE;
+        }
+        break;
+    
+    case TPUT_COC_RUN:
+        if (tput_source) {
+            tput_source_pump();
+            break;
+        }
+        tput_stats_tick(&tput_st[1], (uint32_t)now);
+        if (now - tput_tm < TPUT_PHASE_MS && TPUT_NO_CONN != tput_conn) {
+            break;
+        }
+        tput_phase_end(1, tput_coc_pdu - 2, 2 + 4);
+        if (0 != tput_cid) {
+            sl_bt_l2cap_close_channel(tput_conn, tput_cid);
+        }
+        tput_state = TPUT_DONE;
+        break;
+#endif
+    
+    case TPUT_DONE:
+    default:
+        if (TPUT_NO_CONN != tput_conn) {
+            /* Sink ends the test; the source follows on the close event */
+            if (!tput_source) {
+                sl_bt_connection_close(tput_conn);
+            }
+            break;
+        }
+        blocking_adv(TPUT_ADV_SET);
+        if (tput_source) {
+            DEBUG_PRINT("[TPUT] Source: GATT %lu B, CoC %lu B, backpressure %lu/%lu\n",
+                        (unsigned long)tput_res[0].bytes, (unsigned long)tput_res[1].bytes,
+                        (unsigned long)tput_res[0].backpressure, (unsigned long)tput_res[1].backpressure);
+            return 0;
+        }
+        DEBUG_PRINT("[TPUT] PHY %u, interval %u, data length %u, MTU %u\n",
+                    tput_phy, tput_interval, tput_data_len, tput_mtu);
+        tput_report(0);
+#if TPUT_COC
+        tput_report(1);
+#endif
+        return 0;
+    }
+    
+    if (platform_can_yield()) {
+        platform_yield();
+    }
+    return 1;
+}
+
+/* ================== Traffic Generator ================== */
+
+/*
+ * Loads the channel with background traffic from every advertising set.
+ * gen_plan_build() splits "N devices every X ms" over the sets; each set
+ * emulates its share with a fresh non-resolvable random address per
+ * on-window. An on-window is a fixed number of advertising events, so the
+ * advertiser timeout reported through losstst_adv_sent_handler() marks
+ * its completion and gives the achieved rate. The duty cycle sets the
+ * on-window share of each GEN_DUTY_PERIOD_MS period.
+ */
+#define GEN_DUTY_PERIOD_MS     1000        /* On/off period */
+#define GEN_WINDOW_TIMEOUT_MS  2000        /* Safety stop of an on-window */
+#define GEN_MIN_INTERVAL       32          /* 20 ms (0.625 ms units) */
+#define GEN_MAX_PAYLOAD        200         /* Manufacturer data, extended sets */
+#define GEN_MAX_PAYLOAD_BT4    26          /* Manufacturer data, legacy set */
+#define GEN_REPORT_MS          5000        /* Rate report period */
+
+typedef bool (*gen_task_abort)(void);
+
+static gen_task_abort gen_abort_p;
+static gen_plan_t gen_plan;
+static uint8_t gen_duty;                        /* On-window share (%) */
+static adv_param_t gen_param[MAX_ADV_SETS];
+static adv_data_t gen_data_set[MAX_ADV_SETS][3];
+static uint8_t gen_payload[MAX_ADV_SETS][GEN_MAX_PAYLOAD];
+static uint16_t gen_window_events[MAX_ADV_SETS]; /* Events per on-window */
+static bool gen_running[MAX_ADV_SETS];
+static volatile bool gen_done[MAX_ADV_SETS];    /* On-window completed */
+static volatile int64_t gen_done_tm[MAX_ADV_SETS];
+static int64_t gen_start_tm[MAX_ADV_SETS];
+static int64_t gen_next_tm[MAX_ADV_SETS];
+static uint32_t gen_events[MAX_ADV_SETS];       /* Completed advertising events */
+static uint32_t gen_overruns;                   /* On-windows that did not complete */
+static int64_t gen_begin_tm;
+static int64_t gen_report_tm;
+static uint32_t gen_rand_state;
+
+/**
+ * @brief xorshift32, seeded from the stack's random source
+ */
+static uint32_t gen_rand(void)
+{
+    uint32_t x = gen_rand_state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen_rand_state = x;
+    return x;
+}
+
+/**
+ * @brief Give a set a new non-resolvable random address
+ *
+ * The set must not be advertising.
+ */
+static void gen_randomize_address(uint8_t index)
+{
+    bd_addr addr;
+    bd_addr addr_out;
+    uint32_t r0 = gen_rand();
+    uint32_t r1 = gen_rand();
+    
+    memcpy(&addr.addr[0], &r0, 4);
+    memcpy(&addr.addr[4], &r1, 2);
+    addr.addr[5] &= 0x3F;   /* Two most significant bits 0b00: non-resolvable */
+    sl_bt_advertiser_set_random_address(ext_adv[index], sl_bt_gap_random_nonresolvable_address,
+                                        addr, &addr_out);
+}
+
+/**
+ * @brief Advertiser timeout of a generator set
+ *
+ * Called from losstst_adv_sent_handler() in Bluetooth event context.
+ */
+static void gen_adv_done(uint8_t index)
+{
+    if (index < MAX_ADV_SETS && gen_running[index]) {
+        gen_done_tm[index] = platform_uptime_get();
+        gen_done[index] = true;
+    }
+}
+
+/**
+ * @brief Start the next on-window of a set
+ */
+static void gen_window_start(uint8_t index, int64_t now)
+{
+    adv_start_param_t start_param = {
+        /* Safety stop in case the controller cannot fit the events */
+        .timeout = GEN_WINDOW_TIMEOUT_MS / 10,
+        .num_events = gen_window_events[index]
+    };
+    
+    blocking_adv(index);
+    gen_randomize_address(index);
+    gen_done[index] = false;
+    gen_running[index] = true;
+    gen_start_tm[index] = now;
+    gen_next_tm[index] = now + GEN_DUTY_PERIOD_MS;
+    if (update_adv_limited(index, &gen_param[index], gen_data_set[index], &start_param)) {
+        gen_running[index] = false;
+        return;
+    }
+    sl_bt_advertiser_set_channel_map(ext_adv[index],
+                                     get_adv_channel_map(inhibit_ch37, inhibit_ch38, inhibit_ch39));
+}
+
+/**
+ * @brief Stop all generator sets and return to identity addresses
+ */
+static void gen_teardown(void)
+{
+    for (uint8_t i = 0; i < gen_plan.sets; i++) {
+        blocking_adv(i);
+        gen_running[i] = false;
+        sl_bt_advertiser_clear_random_address(ext_adv[i]);
+    }
+}
+
+int losstst_get_gen_stats(losstst_gen_stats_t *stats)
+{
+    int64_t elapsed;
+    uint32_t events = 0;
+    
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+    
+    for (uint8_t i = 0; i < gen_plan.sets; i++) {
+        events += gen_events[i];
+    }
+    elapsed = platform_uptime_get() - gen_begin_tm;
+    
+    stats->sets = gen_plan.sets;
+    stats->events = events;
+    stats->overruns = gen_overruns;
+    stats->target_mpps = gen_plan.target_mpps;
+    stats->planned_mpps = (uint32_t)(((uint64_t)gen_plan.planned_mpps * gen_duty) / 100u);
+    stats->achieved_mpps = (elapsed > 0) ? (uint32_t)(((uint64_t)events * 1000000u) / (uint64_t)elapsed) : 0;
+    return 0;
+}
+
+int gen_setup(const test_param_t *param)
+{
+    if (!svc_init_success || param == NULL) {
+        return -EINVAL;
+    }
+    
+    int err = 0;
+    uint8_t phys[4];
+    uint8_t phy_cnt = 0;
+    uint32_t seed = 0;
+    size_t seed_len;
+    
+    /* Initialize application layer variables */
+    round_tx_pwr = param->txpwr;
+    round_phy_sel[0] = param->phy_2m;
+    round_phy_sel[1] = param->phy_1m;
+    round_phy_sel[2] = param->phy_s8;
+    round_phy_sel[3] = param->phy_ble4;
+    inhibit_ch37 = param->inhibit_ch37;
+    inhibit_ch38 = param->inhibit_ch38;
+    inhibit_ch39 = param->inhibit_ch39;
+    gen_abort_p = param->gen_abort;
+    gen_duty = (0 == param->gen_duty || 100 < param->gen_duty) ? 100 : param->gen_duty;
+    
+    for (uint8_t idx = 0; idx <= 3; idx++) {
+        if (round_phy_sel[idx]) {
+            phys[phy_cnt++] = idx;
+        }
+    }
+    if (0 == phy_cnt) {
+        phys[phy_cnt++] = 1;   /* 1M */
+    }
+    
+    err = gen_plan_build(param->gen_devices, param->gen_interval_ms, num_adv_set,
+                         GEN_MIN_INTERVAL, &gen_plan);
+    if (-EINVAL == err) {
+        return err;
+    }
+    DEBUG_PRINT("[GEN] %u devices @ %u ms on %u sets: %lu/%lu mpps (%u permille off%s)\n",
+                param->gen_devices, param->gen_interval_ms, gen_plan.sets,
+                (unsigned long)gen_plan.planned_mpps, (unsigned long)gen_plan.target_mpps,
+                gen_plan.error_permille, gen_plan.clamped ? ", min interval" : "");
+    
+    if (SL_STATUS_OK != sl_bt_system_get_random_data(sizeof(seed), sizeof(seed), &seed_len, (uint8_t *)&seed)
+        || 0 == seed) {
+        seed = (uint32_t)platform_uptime_get() | 1u;
+    }
+    gen_rand_state = seed;
+    
+    /* Stop all advertising */
+    err = stop_all_advertising();
+    if (err) {
+    }
+    passive_scan_control(-1);
+    
+    err = set_adv_tx_power(param->txpwr, num_adv_set);
+    if (err) {
+        return err;
+    }
+    
+    /* PHYs round robin over the sets, payload padded to the requested size */
+    for (uint8_t i = 0; i < gen_plan.sets; i++) {
+        uint8_t phy = phys[i % phy_cnt];
+        uint8_t len = param->gen_payload;
+        uint8_t max_len = (3 == phy) ? GEN_MAX_PAYLOAD_BT4 : GEN_MAX_PAYLOAD;
+        uint32_t on_ms = (uint32_t)GEN_DUTY_PERIOD_MS * gen_duty / 100u;
+        
+        if (len < 4) {
+            len = 4;
+        } else if (len > max_len) {
+            len = max_len;
+        }
+        
+        gen_param[i] = *non_connectable_adv_param_x[0][phy];
+        gen_param[i].interval_min = gen_plan.set[i].interval;
+        gen_param[i].interval_max = gen_plan.set[i].interval;
+        gen_param[i].options &= ~(BT_LE_ADV_OPT_ANONYMOUS | BT_LE_ADV_OPT_USE_IDENTITY);
+        
+        /* Manufacturer ID, then the set index as filler */
+        memset(gen_payload[i], i, len);
+        gen_payload[i][0] = (uint8_t)MANUFACTURER_ID;
+        gen_payload[i][1] = (uint8_t)(MANUFACTURER_ID >> 8);
+        gen_data_set[i][0] = (adv_data_t){
+            .type = BT_DATA_FLAGS,
+            .data_len = 1,
+            .data = p_common_adv_flags
+        };
+        gen_data_set[i][1] = (adv_data_t){
+            .type = BT_DATA_MANUFACTURER_DATA,
+            .data_len = len,
+            .data = gen_payload[i]
+        };
+        gen_data_set[i][2] = (adv_data_t){
+            .type = 0,
+            .data = NULL,
+            .data_len = 0
+        };
+        
+        gen_window_events[i] = gen_plan_events(&gen_plan.set[i], on_ms);
+        gen_running[i] = false;
+        gen_done[i] = false;
+        gen_events[i] = 0;
+        /* Stagger window starts so sets do not align */
+        gen_next_tm[i] = platform_uptime_get() + (int64_t)i * GEN_DUTY_PERIOD_MS / gen_plan.sets;
+    }
+    gen_overruns = 0;
+    gen_begin_tm = platform_uptime_get();
+    gen_report_tm = gen_begin_tm + GEN_REPORT_MS;
+    
+    /* Update LCD display */
+    lcd_ui_update(param, "Generator", "Ready");
+    
+    return 0;
+}
+
+int losstst_generator(void)
+{
+    if (!svc_init_success) {
+        return -1;
+    }
+    
+    int64_t now = platform_uptime_get();
+    
+    /* Check for abort condition */
+    if (gen_abort_p != NULL && gen_abort_p()) {
+        gen_teardown();
+        return -1;
+    }
+    
+    for (uint8_t i = 0; i < gen_plan.sets; i++) {
+        if (gen_running[i]) {
+            if (gen_done[i]) {
+                gen_running[i] = false;
+                /* Ended by the safety timeout: event count unknown */
+                if (gen_done_tm[i] - gen_start_tm[i] < GEN_WINDOW_TIMEOUT_MS) {
+                    gen_events[i] += gen_window_events[i];
+                } else {
+                    gen_overruns++;
+                }
+            } else if (now - gen_start_tm[i] >= GEN_WINDOW_TIMEOUT_MS + GEN_DUTY_PERIOD_MS) {
+                /* Completion never reported */
+                blocking_adv(i);
+                gen_running[i] = false;
+                gen_overruns++;
+            }
+        }
+        if (!gen_running[i] && now >= gen_next_tm[i]) {
+            gen_window_start(i, now);
+        }
+    }
+    
+    if (now >= gen_report_tm) {
+        losstst_gen_stats_t stats;
+        
+        gen_report_tm = now + GEN_REPORT_MS;
+        losstst_get_gen_stats(&stats);
+        DEBUG_PRINT("[GEN] %lu.%03lu pkt/s (plan %lu.%03lu), overruns %lu\n",
+                    (unsigned long)(stats.achieved_mpps / 1000), (unsigned long)(stats.achieved_mpps % 1000),
+                    (unsigned long)(stats.planned_mpps / 1000), (unsigned long)(stats.planned_mpps % 1000),
+                    (unsigned long)stats.overruns);
+        lcd_ui_show_progress(stats.achieved_mpps / 1000, stats.planned_mpps / 1000, 0);
+    }
+    
+    if (platform_can_yield()) {
+        platform_yield();
+    }
+    return 1;
+}
+
+/* ================== Link Budget Fitting ================== */
+
+/*
+ * Every finished scanner round adds its (tx power, RSSI, PER) tuple per
+ * PHY. Stepping the sender through its tx power levels (enum_txpower) and
+ * running a scanner round per level gives the sweep the fit needs.
+ * Points accumulate across runs until losstst_link_fit_reset().
+ */
+static linkfit_t link_fit[4];
+
+/**
+ * @brief Convert dB to 0.1 dB, rounded
+ */
+static int16_t link_fit_db10(float db)
+{
+    return (int16_t)((db < 0.0f) ? (db * 10.0f - 0.5f) : (db * 10.0f + 0.5f));
+}
+
+int losstst_link_fit_round(void)
+{
+    losstst_result_t result[4];
+    bool tx_known = false;
+    int8_t tx_dbm = 0;
+    
+    if (!svc_init_success) {
+        return -EINVAL;
+    }
+    
+    /* The sender uses one tx power for all PHYs, any PHY with packets tells it */
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        losstst_get_result(idx, &result[idx]);
+        if (round_phy_sel[idx] && 0 < result[idx].rcv && !tx_known) {
+            tx_dbm = remote_tx_pwr[idx];
+            tx_known = true;
+        }
+    }
+    if (!tx_known) {
+        return -ENODATA;
+    }
+    
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        if (!round_phy_sel[idx] || 0 == result[idx].exp) {
+            continue;
+        }
+        linkfit_add(&link_fit[idx], tx_dbm, rcv_rssi_val[idx][0],
+                    (result[idx].rcv < result[idx].exp) ? result[idx].rcv : result[idx].exp,
+                    result[idx].exp);
+    }
+    return 0;
+}
+
+void losstst_link_fit_reset(void)
+{
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        linkfit_reset(&link_fit[idx]);
+    }
+}
+
+int losstst_get_link_fit(uint8_t index, losstst_link_fit_t *fit)
+{
+    linkfit_result_t res;
+    int err;
+    
+    if (index >= 4 || fit == NULL) {
+        return -EINVAL;
+    }
+    
+    memset(fit, 0, sizeof(*fit));
+    fit->points = link_fit[index].n;
+    
+    err = linkfit_solve(&link_fit[index], &res);
+    if (err) {
+        return err;
+    }
+    
+    fit->path_loss = link_fit_db10(res.path_loss_db);
+    fit->tx_max = res.tx_max_dbm;
+    for (uint8_t i = 0; i < 3; i++) {
+        fit->sens[i] = link_fit_db10(res.sens_dbm[i]);
+    }
+    fit->margin = link_fit_db10(res.margin_db);
+    return 0;
+}
+
+/* ================== Soak Monitoring ================== */
+
+/*
+ * Each finished scanner round feeds its PER and mean RSSI per PHY into a
+ * CUSUM and a Page-Hinkley detector. Only change points are persisted, in
+ * a fixed ring of NVM3 objects, and otherwise only running summaries are
+ * kept, so memory stays constant over days.
+ */
+#define SOAK_NVM3_KEY_COUNT     0x0A100     /* Change points logged so far (uint32_t) */
+#define SOAK_NVM3_KEY_BASE      0x0A101     /* First ring slot */
+#define SOAK_LOG_SLOTS          32
+
+/* Detector tuning: PER in percent, RSSI in dBm */
+#define SOAK_WARMUP_ROUNDS      30
+#define SOAK_CUSUM_K            0.5f
+#define SOAK_CUSUM_H            6.0f
+#define SOAK_PER_SD_FLOOR       0.5f
+#define SOAK_RSSI_SD_FLOOR      1.0f
+#define SOAK_PH_PER_DELTA       0.5f
+#define SOAK_PH_PER_LAMBDA      8.0f
+#define SOAK_PH_RSSI_DELTA      1.0f
+#define SOAK_PH_RSSI_LAMBDA     15.0f
+
+typedef struct {
+    chgdet_cusum_t cusum;
+    chgdet_ph_t ph;
+} soak_det_t;
+
+static soak_det_t soak_det[4][2];               /* Per PHY: PER, RSSI */
+static losstst_soak_summary_t soak_sum[4];
+static uint32_t soak_rounds;
+static uint32_t soak_logged;                     /* Change points in the NVM3 ring */
+
+/**
+ * @brief Persist one change point
+ */
+static void soak_log_change(const losstst_soak_event_t *event)
+{
+    DEBUG_PRINT("[SOAK] round %lu, %lu s: PHY %u %s %s %s at %d\n",
+                (unsigned long)event->round, (unsigned long)event->uptime_s, event->phy,
+                event->metric ? "RSSI" : "PER", (CHGDET_UP == event->dir) ? "up" : "down",
+                event->detector ? "(PH)" : "(CUSUM)", event->value);
+
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+    if (SL_STATUS_OK != nvm3_writeData(nvm3_defaultHandle,
+                                       SOAK_NVM3_KEY_BASE + (soak_logged % SOAK_LOG_SLOTS),
+                                       event, sizeof(*event))) {
+        return;
+    }
+    soak_logged++;
+    nvm3_writeData(nvm3_defaultHandle, SOAK_NVM3_KEY_COUNT, &soak_logged, sizeof(soak_logged));
+#else
+    soak_logged++;
+#endif
+}
+
+/**
+ * @brief Feed one metric sample to both detectors of a PHY
+ */
+static void soak_feed(uint8_t phy, uint8_t metric, float x, int16_t value)
+{
+    soak_det_t *det = &soak_det[phy][metric];
+    int dir[2];
+    
+    dir[0] = chgdet_cusum_update(&det->cusum, x);
+    dir[1] = chgdet_ph_update(&det->ph, x);
+    
+    for (uint8_t i = 0; i < 2; i++) {
+        if (CHGDET_NONE != dir[i]) {
+            losstst_soak_event_t event = {
+                .round = soak_rounds,
+                .uptime_s = (uint32_t)(platform_uptime_get() / 1000),
+                .phy = phy,
+                .metric = metric,
+                .detector = i,
+                .dir = (int8_t)dir[i],
+                .value = value,
+            };
+            soak_sum[phy].change_points++;
+            soak_log_change(&event);
+        }
+    }
+}
+
+static void soak_reset(void)
+{
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        chgdet_cusum_init(&soak_det[idx][0].cusum, SOAK_CUSUM_K, SOAK_CUSUM_H,
+                          SOAK_PER_SD_FLOOR, SOAK_WARMUP_ROUNDS);
+        chgdet_ph_init(&soak_det[idx][0].ph, SOAK_PH_PER_DELTA, SOAK_PH_PER_LAMBDA,
+                       SOAK_WARMUP_ROUNDS);
+        chgdet_cusum_init(&soak_det[idx][1].cusum, SOAK_CUSUM_K, SOAK_CUSUM_H,
+                          SOAK_RSSI_SD_FLOOR, SOAK_WARMUP_ROUNDS);
+        chgdet_ph_init(&soak_det[idx][1].ph, SOAK_PH_RSSI_DELTA, SOAK_PH_RSSI_LAMBDA,
+                       SOAK_WARMUP_ROUNDS);
+    }
+    memset(soak_sum, 0, sizeof(soak_sum));
+    soak_rounds = 0;
+    
+    /* Continue the ring of an earlier run */
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+    if (SL_STATUS_OK != nvm3_readData(nvm3_defaultHandle, SOAK_NVM3_KEY_COUNT,
+                                      &soak_logged, sizeof(soak_logged))) {
+        soak_logged = 0;
+    }
+#else
+    soak_logged = 0;
+#endif
+}
+
+int losstst_soak_round(void)
+{
+    losstst_result_t result;
+    int16_t rssi = 0;
+    
+    if (!svc_init_success || !round_soak) {
+        return -EINVAL;
+    }
+    
+    soak_rounds++;
+    
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        losstst_soak_summary_t *sum = &soak_sum[idx];
+        uint16_t per;
+        
+        if (!round_phy_sel[idx]) {
+            continue;
+        }
+        
+        /* A round without any packet of this PHY counts as total loss */
+        losstst_get_result(idx, &result);
+        if (0 == result.exp) {
+            per = 1000;
+        } else if (result.rcv >= result.exp) {
+            per = 0;
+        } else {
+            per = (uint16_t)(1000u - (1000u * result.rcv) / result.exp);
+        }
+        
+        if (0 == sum->rounds) {
+            sum->per_min = sum->per_max = per;
+        } else {
+            sum->per_min = (per < sum->per_min) ? per : sum->per_min;
+            sum->per_max = (per > sum->per_max) ? per : sum->per_max;
+        }
+        sum->per_sum += per;
+        sum->rounds++;
+        sum->per_last = per;
+        soak_feed(idx, 0, per / 10.0f, (int16_t)per);
+        
+        if (0 == result.rcv) {
+            sum->silent++;
+            continue;
+        }
+        
+        rssi = rcv_rssi_val[idx][0];
+        if (1 == sum->rounds - sum->silent) {   /* First round with packets */
+            sum->rssi_min = sum->rssi_max = (int8_t)rssi;
+        } else {
+            sum->rssi_min = (rssi < sum->rssi_min) ? (int8_t)rssi : sum->rssi_min;
+            sum->rssi_max = (rssi > sum->rssi_max) ? (int8_t)rssi : sum->rssi_max;
+        }
+        sum->rssi_last = (int8_t)rssi;
+        soak_feed(idx, 1, (float)rssi, rssi);
+    }
+    
+    lcd_ui_show_progress(soak_rounds, 0, (int8_t)rssi);
+    
+    /* Next round */
+    scanner_round_reset();
+    return 0;
+}
+
+int losstst_get_soak_summary(uint8_t index, losstst_soak_summary_t *summary)
+{
+    if (index >= 4 || summary == NULL) {
+        return -EINVAL;
+    }
+    
+    *summary = soak_sum[index];
+    return 0;
+}
+
+int losstst_get_soak_event(uint32_t seq, losstst_soak_event_t *event)
+{
+    if (event == NULL) {
+        return -EINVAL;
+    }
+    
+    /* Older entries are overwritten */
+    if (seq >= soak_logged || soak_logged - seq > SOAK_LOG_SLOTS) {
+        return -ENOENT;
+    }
+    
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+    if (SL_STATUS_OK != nvm3_readData(nvm3_defaultHandle, SOAK_NVM3_KEY_BASE + (seq % SOAK_LOG_SLOTS),
+                                      event, sizeof(*event))) {
+        return -EIO;
+    }
+    return 0;
+#else
+    return -ENOENT;
+#endif
+}
+
+/* ================== Scheduler Priority Profiles ================== */
+
+/*
+ * Scanner, advertiser and connections share one radio; the controller
+ * scheduler gives it to the task with the lowest priority value. A task
+ * that loses starts over at a higher priority: scanner and advertiser by
+ * their step per pre-empted window or event until they reach max,
+ * connections as the supervision timeout approaches. The default
+ * configuration favours the log connection, which costs a scanner round
+ * whole scan windows whenever a connection event falls into one.
+ * tools/sched_model.py mirrors this table to estimate the lost coverage.
+ */
+static const sl_btctrl_ll_priorities prio_profiles[LOSSTST_PRIO_COUNT] = {
+    [LOSSTST_PRIO_DEFAULT] = SL_BTCTRL_SCHEDULER_PRIORITIES,
+    [LOSSTST_PRIO_SCAN_EXCLUSIVE] = {
+        .scan_min = 20, .scan_max = 10,
+        .adv_min = 220, .adv_max = 200,
+        .conn_min = 240, .conn_max = 5,
+        .init_min = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MIN,
+        .init_max = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MAX,
+        .rail_mapping_offset = SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN,
+        .rail_mapping_range = (SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MAX
+                               - SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN),
+        .adv_step = 4, .scan_step = 4,
+        .pawr_tx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MIN,
+        .pawr_tx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MAX,
+        .pawr_rx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MIN,
+        .pawr_rx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MAX,
+    },
+    [LOSSTST_PRIO_ADV_EXCLUSIVE] = {
+        .scan_min = 220, .scan_max = 200,
+        .adv_min = 20, .adv_max = 10,
+        .conn_min = 240, .conn_max = 5,
+        .init_min = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MIN,
+        .init_max = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MAX,
+        .rail_mapping_offset = SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN,
+        .rail_mapping_range = (SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MAX
+                               - SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN),
+        .adv_step = 4, .scan_step = 4,
+        .pawr_tx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MIN,
+        .pawr_tx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MAX,
+        .pawr_rx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MIN,
+        .pawr_rx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MAX,
+    },
+    [LOSSTST_PRIO_SHARED] = {
+        .scan_min = 160, .scan_max = 100,
+        .adv_min = 160, .adv_max = 100,
+        .conn_min = 200, .conn_max = 0,
+        .init_min = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MIN,
+        .init_max = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MAX,
+        .rail_mapping_offset = SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN,
+        .rail_mapping_range = (SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MAX
+                               - SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN),
+        .adv_step = 8, .scan_step = 8,
+        .pawr_tx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MIN,
+        .pawr_tx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MAX,
+        .pawr_rx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MIN,
+        .pawr_rx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MAX,
+    },
+    [LOSSTST_PRIO_LOG_FRIENDLY] = {
+        .scan_min = SL_BT_CONTROLLER_SCHEDULER_PRI_SCAN_MIN,
+        .scan_max = SL_BT_CONTROLLER_SCHEDULER_PRI_SCAN_MAX,
+        .adv_min = SL_BT_CONTROLLER_SCHEDULER_PRI_ADV_MIN,
+        .adv_max = SL_BT_CONTROLLER_SCHEDULER_PRI_ADV_MAX,
+        .conn_min = 40, .conn_max = 0,
+        .init_min = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MIN,
+        .init_max = SL_BT_CONTROLLER_SCHEDULER_PRI_INIT_MAX,
+        .rail_mapping_offset = SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN,
+        .rail_mapping_range = (SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MAX
+                               - SL_BT_CONTROLLER_SCHEDULER_PRI_RAIL_WINDOW_MIN),
+        .adv_step = SL_BT_CONTROLLER_SCHEDULER_PRI_ADV_STEP,
+        .scan_step = SL_BT_CONTROLLER_SCHEDULER_PRI_SCAN_STEP,
+        .pawr_tx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MIN,
+        .pawr_tx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_TX_MAX,
+        .pawr_rx_min = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MIN,
+        .pawr_rx_max = SL_BT_CONTROLLER_SCHEDULER_PRI_PAWR_RX_MAX,
+    },
+};
+
+static const char *const prio_names[LOSSTST_PRIO_COUNT] = {
+    [LOSSTST_PRIO_DEFAULT] = "default",
+    [LOSSTST_PRIO_SCAN_EXCLUSIVE] = "scanner-exclusive",
+    [LOSSTST_PRIO_ADV_EXCLUSIVE] = "advertiser-exclusive",
+    [LOSSTST_PRIO_SHARED] = "shared",
+    [LOSSTST_PRIO_LOG_FRIENDLY] = "log-friendly",
+};
+
+int losstst_prio_apply(uint8_t profile)
+{
+    sl_status_t status;
+    
+    if (profile >= LOSSTST_PRIO_COUNT) {
+        return -EINVAL;
+    }
+    
+    status = sl_bt_system_linklayer_configure(sl_bt_system_linklayer_config_key_set_priority_table,
+                                              sizeof(prio_profiles[profile]),
+                                              (const uint8_t *)&prio_profiles[profile]);
+    if (status != SL_STATUS_OK) {
+        DEBUG_PRINT("[PRIO] %s rejected: 0x%04lx\n", prio_names[profile], (unsigned long)status);
+        return -EIO;
+    }
+    
+    prio_profile_cur = profile;
+    return 0;
+}
+
+/*
+ * The controller starts with early abort as configured and adaptivity
+ * only if the AFH component initialised it.
+ */
+#if defined(SL_CATALOG_BLUETOOTH_FEATURE_AFH_PRESENT)
+#define CTRL_SWITCH_AFH         LOSSTST_CTRL_ADAPTIVITY
+#else
+#define CTRL_SWITCH_AFH         0
+#endif
+#define CTRL_SWITCH_BUILD       ((SL_BT_CONTROLLER_SCANNER_RECEPTION_EARLY_ABORT ? LOSSTST_CTRL_EARLY_ABORT : 0) \
+                                 | CTRL_SWITCH_AFH)
+
+static uint8_t ctrl_switch_cur = CTRL_SWITCH_BUILD;    /* Switches in effect */
+
+int losstst_ctrl_apply(uint8_t switches)
+{
+    uint8_t changed = (uint8_t)(switches ^ ctrl_switch_cur);
+    sl_status_t status;
+    int err = 0;
+    
+    if (changed & LOSSTST_CTRL_EARLY_ABORT) {
+        uint32_t flags = SL_BTCTRL_CONFIG_FLAG_SCANNER_RECEPTION_EARLY_ABORT;
+        
+        status = sl_bt_system_linklayer_configure((switches & LOSSTST_CTRL_EARLY_ABORT)
+                                                  ? sl_bt_system_linklayer_config_key_set_flags
+                                                  : sl_bt_system_linklayer_config_key_clr_flags,
+                                                  sizeof(flags), (const uint8_t *)&flags);
+        if (status == SL_STATUS_OK) {
+            ctrl_switch_cur ^= LOSSTST_CTRL_EARLY_ABORT;
+        } else {
+            DEBUG_PRINT("[CTRL] Early abort refused: 0x%04lx\n", (unsigned long)status);
+            err = -ENOTSUP;
+        }
+    }
+    
+    if (changed & LOSSTST_CTRL_ADAPTIVITY) {
+        uint32_t adaptivity = (switches & LOSSTST_CTRL_ADAPTIVITY)
+                              ? SL_BTCTRL_CHANNELMAP_FLAG_ACTIVE_ADAPTIVITY : 0;
+        
+        status = sl_bt_system_linklayer_configure(sl_bt_system_linklayer_config_key_set_channelmap_flags,
+                                                  sizeof(adaptivity), (const uint8_t *)&adaptivity);
+        if (status == SL_STATUS_OK) {
+            ctrl_switch_cur ^= LOSSTST_CTRL_ADAPTIVITY;
+        } else {
+            DEBUG_PRINT("[CTRL] Adaptivity refused: 0x%04lx\n", (unsigned long)status);
+            err = -ENOTSUP;
+        }
+    }
+    
+    return err;
+}
+
+uint8_t losstst_ctrl_active(void)
+{
+    return ctrl_switch_cur;
+}
+
+uint8_t losstst_ctrl_default(void)
+{
+    return CTRL_SWITCH_BUILD;
+}
+
+const char *losstst_prio_name(uint8_t profile)
+{
+    return (profile < LOSSTST_PRIO_COUNT) ? prio_names[profile] : "?";
+}
+
+int losstst_get_prio_stats(losstst_prio_stats_t *stats)
+{
+    uint16_t tx, rx, crc;
+    
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->profile = prio_profile_cur;
+    scan_window_account();
+    stats->scan_windows = (uint16_t)((scan_window_cnt > UINT16_MAX) ? UINT16_MAX : scan_window_cnt);
+    if (sender_tgr == mode_arena_owner) {
+        memcpy(stats->adv_skipped, mode_arena.sender.burst_skip, sizeof(stats->adv_skipped));
+    }
+    if (SL_STATUS_OK != sl_bt_system_get_counters(0, &tx, &rx, &crc, &stats->ctrl_fail)) {
+        return -EIO;
+    }
+    return 0;
+}
+
+/* ================== Wall Clock ================== */
+
+/*
+ * UTC time for the result records (wallclock.h). A phone sets it through
+ * the Current Time characteristic; that node then broadcasts a time beacon
+ * every TIME_BEACON_PERIOD_MS, which nodes adopt while a test mode scans.
+ * Each beacon is one legacy advertising event started right after the
+ * stamp is taken, so a receiver is off by the advDelay (0-10 ms) and the
+ * report latency. A beacon is not relayed, so there is one hop and no
+ * loop. The time is checkpointed to NVM3 and comes back after a reset as
+ * a lower bound.
+ */
+#define TIME_BEACON_PERIOD_MS   1000
+#define TIME_BEACON_INTERVAL    1600        /* 1 s (0.625 ms units); one event per start */
+#define TIME_CHECKPOINT_MS      (3600 * 1000LL)
+#define TIME_NVM3_KEY           0x0A200     /* time_checkpoint_t */
+
+typedef struct {
+    uint32_t sec;              /* UTC when written (s since 1970) */
+    uint8_t source;            /* Source of the time (WALLCLOCK_SRC_*) */
+} time_checkpoint_t;
+
+static wallclock_t wall_clock;
+static int64_t time_saved_ms = INT64_MIN;   /* Uptime of the last checkpoint */
+static uint8_t time_saved_src;              /* Source at the last checkpoint */
+static uint8_t time_beacon_handle = 0xFF;
+static sl_sleeptimer_timer_handle_t time_beacon_timer;
+static volatile bool time_beacon_due;
+
+/**
+ * @brief Write the current time to NVM3
+ */
+static void time_checkpoint(void)
+{
+    time_checkpoint_t cp;
+    wallclock_stamp_t stamp;
+    int64_t now = platform_uptime_get();
+    
+    if (0 != wallclock_now(&wall_clock, now, &stamp)) {
+        return;
+    }
+    cp.sec = stamp.sec;
+    cp.source = wallclock_source(&wall_clock);
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+    if (SL_STATUS_OK != nvm3_writeData(nvm3_defaultHandle, TIME_NVM3_KEY, &cp, sizeof(cp))) {
+        return;
+    }
+#endif
+    time_saved_ms = now;
+    time_saved_src = cp.source;
+}
+
+/**
+ * @brief Hand the time to the sleeptimer wall clock (sl_sleeptimer_get_time())
+ */
+static void time_sleeptimer_sync(void)
+{
+#if SL_SLEEPTIMER_WALLCLOCK_CONFIG
+    wallclock_stamp_t stamp;
+    
+    if (0 == wallclock_now(&wall_clock, platform_uptime_get(), &stamp)) {
+        sl_sleeptimer_set_time(stamp.sec);
+    }
+#endif
+}
+
+/**
+ * @brief Timer callback: wake the application task for the next beacon
+ */
+static void time_beacon_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+    (void)handle;
+    (void)data;
+    
+    time_beacon_due = true;
+    app_proceed();
+}
+
+/**
+ * @brief Stamp and start one time beacon event
+ */
+static void time_beacon_send(void)
+{
+    uint8_t ad[3 + 2 + sizeof(time_info_t)];
+    time_info_t form = {
+        .man_id = MANUFACTURER_ID,
+        .form_id = LOSS_TEST_TIME_FORM_ID,
+    };
+    wallclock_stamp_t stamp;
+    
+    if (0xFF == time_beacon_handle) {
+        if (SL_STATUS_OK != sl_bt_advertiser_create_set(&time_beacon_handle)) {
+            return;
+        }
+        if (SL_STATUS_OK != sl_bt_advertiser_set_timing(time_beacon_handle, TIME_BEACON_INTERVAL,
+                                                        TIME_BEACON_INTERVAL, 0, 1)) {
+            sl_bt_advertiser_delete_set(time_beacon_handle);
+            time_beacon_handle = 0xFF;
+            return;
+        }
+    }
+    
+    if (0 != wallclock_now(&wall_clock, platform_uptime_get(), &stamp)) {
+        return;
+    }
+    form.sec = stamp.sec;
+    form.ms = stamp.ms;
+    ad[0] = 2;
+    ad[1] = BT_DATA_FLAGS;
+    ad[2] = 0x06;                   /* General discoverable, BR/EDR not supported */
+    ad[3] = 1 + sizeof(form);
+    ad[4] = BT_DATA_MANUFACTURER_DATA;
+    memcpy(&ad[5], &form, sizeof(form));
+    
+    /* The last event ended by now (max_events = 1); stop is a no-op then */
+    sl_bt_advertiser_stop(time_beacon_handle);
+    if (SL_STATUS_OK == sl_bt_legacy_advertiser_set_data(time_beacon_handle,
+                                                         sl_bt_advertiser_advertising_data_packet,
+                                                         sizeof(ad), ad)) {
+        sl_bt_legacy_advertiser_start(time_beacon_handle, sl_bt_legacy_advertiser_non_connectable);
+    }
+}
+
+/**
+ * @brief Adopt a time beacon
+ */
+static bool time_form_parser(adv_data_t *data, void *user_data)
+{
+    dev_found_param_t *dev_chr_p = (dev_found_param_t *)user_data;
+    
+    /* Check for FLAGS element */
+    if (BT_DATA_FLAGS == data->type) {
+        if (0 == dev_chr_p->step_raw) {
+            dev_chr_p->step_flag++;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    }
+    /* Check for MANUFACTURER_DATA element */
+    else if (1 == dev_chr_p->step_flag && BT_DATA_MANUFACTURER_DATA == data->type
+             && sizeof(time_info_t) == data->data_len) {
+        time_info_t form;
+        
+        memcpy(&form, data->data, sizeof(form));
+        if (MANUFACTURER_ID == form.man_id && LOSS_TEST_TIME_FORM_ID == form.form_id) {
+            wallclock_stamp_t stamp = {
+                .sec = form.sec,
+                .ms = form.ms,
+            };
+            
+            /* Refused while the phone's own time is fresh */
+            if (0 == wallclock_set(&wall_clock, platform_uptime_get(), &stamp, WALLCLOCK_SRC_BEACON)) {
+                time_sleeptimer_sync();
+            }
+            dev_chr_p->step_success = 1;
+        } else {
+            dev_chr_p->step_fail = 1;
+        }
+    } else {
+        dev_chr_p->step_fail = 1;
+    }
+    
+    /* Continue parsing if not completed */
+    return (dev_chr_p->step_completed) ? false : true;
+}
+
+int losstst_time_init(void)
+{
+    wallclock_init(&wall_clock);
+#if defined(SL_CATALOG_NVM3_DEFAULT_PRESENT)
+    time_checkpoint_t cp;
+    wallclock_stamp_t stamp = {0};
+    uint32_t type;
+    size_t len;
+    
+    if (SL_STATUS_OK != nvm3_getObjectInfo(nvm3_defaultHandle, TIME_NVM3_KEY, &type, &len)
+        || sizeof(cp) != len) {
+        return -ENOENT;
+    }
+    if (SL_STATUS_OK != nvm3_readData(nvm3_defaultHandle, TIME_NVM3_KEY, &cp, sizeof(cp))) {
+        return -EIO;
+    }
+    stamp.sec = cp.sec;
+    wallclock_set(&wall_clock, platform_uptime_get(), &stamp, WALLCLOCK_SRC_RESTORED);
+    time_sleeptimer_sync();
+    time_saved_src = WALLCLOCK_SRC_RESTORED;
+    DEBUG_PRINT("[TIME] Restored %lu (%s)\n", (unsigned long)cp.sec, wallclock_source_name(cp.source));
+    return 0;
+#else
+    return -ENOENT;
+#endif
+}
+
+int losstst_time_set(const uint8_t *val, uint16_t len)
+{
+    wallclock_stamp_t stamp;
+    int err;
+    
+    err = wallclock_from_cts(val, len, &stamp);
+    if (err) {
+        return err;
+    }
+    err = wallclock_set(&wall_clock, platform_uptime_get(), &stamp, WALLCLOCK_SRC_GATT);
+    if (err) {
+        return err;
+    }
+    time_sleeptimer_sync();
+    time_checkpoint();
+    
+    /* Start beaconing */
+    time_beacon_due = true;
+    sl_sleeptimer_restart_periodic_timer_ms(&time_beacon_timer, TIME_BEACON_PERIOD_MS,
+                                            time_beacon_cb, NULL, 0, 0);
+    return 0;
+}
+
+int losstst_time_get(wallclock_stamp_t *stamp)
+{
+    int err;
+    
+    err = wallclock_now(&wall_clock, platform_uptime_get(), stamp);
+    if (err) {
+        return err;
+    }
+    return wallclock_source(&wall_clock);
+}
+
+void losstst_time_poll(void)
+{
+    uint8_t source = wallclock_source(&wall_clock);
+    
+    if (time_beacon_due) {
+        time_beacon_due = false;
+        if (WALLCLOCK_SRC_GATT == source) {
+            time_beacon_send();
+        } else {
+            /* A fresher beacon took over after the hold time */
+            sl_sleeptimer_stop_timer(&time_beacon_timer);
+        }
+    }
+    
+    /* Checkpoint a new source at once, the running time once an hour */
+    if (source > WALLCLOCK_SRC_RESTORED
+        && (source != time_saved_src || platform_uptime_get() - time_saved_ms >= TIME_CHECKPOINT_MS)) {
+        time_checkpoint();
+    }
+}
+
+bool losstst_time_beacon_alloc(void)
+{
+    return (0xFF != time_beacon_handle);
+}
+
+/* ================== Result Store ================== */
+
+/*
+ * Round results and the burst packet trace go to a record log on the MX25
+ * serial flash (rstore.h), which holds far more than the NVM3 region. The
+ * store is only written after a round ended: a sector erase blocks for
+ * tens of ms and would show up as host loss during a burst.
+ */
+#define STORE_MAX_SECTORS       256     /* Index for up to 1 MB of flash */
+#define STORE_REC_MAX           512     /* Largest record written (query buffer) */
+#define STORE_TRACE_PER_REC     (STORE_REC_MAX / sizeof(losstst_trace_entry_t))
+
+typedef struct {
+    losstst_store_cb_t cb;
+    void *ctx;
+} store_query_t;
+
+static rstore_t result_store;
+static rstore_sector_t store_index[STORE_MAX_SECTORS];
+static bool store_mounted;
+
+static int store_read(void *ctx, uint32_t addr, void *buf, uint32_t len)
+{
+    (void)ctx;
+    return mx25_read(addr, buf, len);
+}
+
+static int store_program(void *ctx, uint32_t addr, const void *buf, uint32_t len)
+{
+    (void)ctx;
+    return mx25_program(addr, buf, len);
+}
+
+static int store_erase(void *ctx, uint32_t addr)
+{
+    (void)ctx;
+    return mx25_erase(addr);
+}
+
+static rstore_flash_t store_flash = {
+    .read = store_read,
+    .program = store_program,
+    .erase = store_erase,
+};
+
+/**
+ * @brief Hand a record to the user callback
+ */
+static bool store_query_cb(void *ctx, const rstore_rec_t *rec, const void *data)
+{
+    store_query_t *query = ctx;
+    
+    if (data == NULL) {
+        return true;    /* Not written by this firmware */
+    }
+    return query->cb(query->ctx, rec->type, rec->round, data, rec->len);
+}
+
+int losstst_store_init(void)
+{
+    uint32_t sectors;
+    int err;
+    
+    err = mx25_init();
+    if (err) {
+        return err;
+    }
+    
+    sectors = mx25_size() / MX25_SECTOR_SIZE;
+    store_flash.sectors = (uint16_t)((sectors > STORE_MAX_SECTORS) ? STORE_MAX_SECTORS : sectors);
+    
+    mx25_acquire();
+    err = rstore_mount(&result_store, &store_flash, store_index);
+    mx25_release();
+    if (err) {
+        return err;
+    }
+    
+    store_mounted = true;
+    DEBUG_PRINT("[STORE] %u sectors, last round %lu, %lu torn\n", store_flash.sectors,
+                (unsigned long)result_store.last_round, (unsigned long)result_store.skipped);
+    journal_commit();
+    return 0;
+}
+
+/**
+ * @brief Build the result record of the scanner round so far
+ */
+static void store_result_fill(losstst_store_result_t *rec)
+{
+    losstst_prio_stats_t prio;
+    wallclock_stamp_t stamp;
+    
+    memset(rec, 0, sizeof(*rec));
+    rec->uptime_s = (uint32_t)(platform_uptime_get() / 1000);
+    if (scanner_tgr == mode_arena_owner) {
+        rec->trace_lost = mode_arena.scanner.trace_lost;
+    }
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        if (round_phy_sel[idx]) {
+            rec->phy_sel |= (uint8_t)(1u << idx);
+        }
+        rec->tx_pwr[idx] = remote_tx_pwr[idx];
+        rec->rssi[idx] = rcv_rssi_val[idx][0];
+        losstst_get_result(idx, &rec->result[idx]);
+    }
+    if (0 == losstst_get_prio_stats(&prio)) {
+        rec->ctrl_fail = prio.ctrl_fail;
+        rec->scan_windows = prio.scan_windows;
+    }
+    rec->prio_profile = prio_profile_cur;
+    rec->ctrl_switches = ctrl_switch_cur;
+    if (0 == wallclock_now(&wall_clock, platform_uptime_get(), &stamp)) {
+        rec->wall_s = stamp.sec;
+        rec->wall_ms = stamp.ms;
+        rec->wall_src = wallclock_source(&wall_clock);
+    }
+}
+
+/* ================== Round Journal ================== */
+
+/*
+ * A brown-out in the middle of a scanner round would lose everything the
+ * round counted so far. Writing NVM3 or the serial flash per burst is too
+ * slow and wears the flash, so the scanner keeps the result record of the
+ * round in retained RAM (rjournal.h, .noinit section) and rewrites it after
+ * every burst. After a reset losstst_init() finds it and
+ * losstst_store_init() commits it to the result store as a partial result.
+ *
+ * The journal carries the round id the result is stored as. A reset after
+ * the round was stored but before the journal was cleared finds the round
+ * in the store and drops the journal, so no round is stored twice.
+ */
+typedef struct {
+    uint32_t round;            /* Round id in the store, 0 if it was not mounted */
+    uint32_t bursts;           /* Bursts counted when written */
+    losstst_store_result_t rec;
+} journal_entry_t;
+
+_Static_assert(sizeof(journal_entry_t) <= RJOURNAL_MAX_DATA, "journal entry size");
+
+static rjournal_t round_journal __attribute__((section(".noinit")));
+static journal_entry_t journal_found;   /* Entry left by the last run */
+static bool journal_pending;            /* journal_found is still to be committed */
+static uint32_t journal_bursts;         /* Bursts at the last journal write */
+
+/**
+ * @brief Journal the scanner round after each burst
+ * 
+ * Bursts are counted from the burst numbers of the PHYs, so the journal
+ * is written once per burst and not per packet.
+ */
+static void journal_update(void)
+{
+    journal_entry_t entry;
+    uint32_t bursts = 0;
+    
+    for (uint8_t idx = 0; idx < 4; idx++) {
+        bursts += rec_sets[idx].flow;
+    }
+    if (bursts == journal_bursts) {
+        return;
+    }
+    journal_bursts = bursts;
+    
+    entry.round = store_mounted ? result_store.last_round + 1 : 0;
+    entry.bursts = bursts;
+    store_result_fill(&entry.rec);
+    entry.rec.partial = 1;
+    rjournal_write(&round_journal, &entry, sizeof(entry));
+}
+
+static void journal_clear(void)
+{
+    rjournal_clear(&round_journal);
+    journal_bursts = 0;
+}
+
+/**
+ * @brief Pick up the journal of a round cut short by a reset
+ */
+static void journal_check(void)
+{
+    journal_pending = (sizeof(journal_found) == rjournal_read(&round_journal, &journal_found,
+                                                              sizeof(journal_found)));
+    if (journal_pending) {
+        DEBUG_PRINT("[JRNL] Round %lu cut short after %lu bursts\n",
+                    (unsigned long)journal_found.round, (unsigned long)journal_found.bursts);
+    }
+}
+
+static bool journal_query_cb(void *ctx, const rstore_rec_t *rec, const void *data)
+{
+    (void)data;
+    
+    if (RSTORE_TYPE_RESULT == rec->type) {
+        *(bool *)ctx = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Store the journaled round as a partial result, unless it is stored
+ */
+static void journal_commit(void)
+{
+    uint8_t buf[sizeof(losstst_store_result_t)];
+    bool stored = false;
+    int err = 0;
+    
+    if (!journal_pending) {
+        return;
+    }
+    journal_pending = false;
+    
+    /* Fix the round id first, so a reset during the append retries it */
+    if (0 == journal_found.round) {
+        journal_found.round = result_store.last_round + 1;
+        rjournal_write(&round_journal, &journal_found, sizeof(journal_found));
+    }
+    
+    mx25_acquire();
+    if (0 > rstore_query(&result_store, journal_found.round, journal_found.round,
+                         buf, sizeof(buf), journal_query_cb, &stored)) {
+        stored = false;
+    }
+    if (!stored) {
+        err = rstore_append(&result_store, RSTORE_TYPE_RESULT, journal_found.round,
+                            &journal_found.rec, sizeof(journal_found.rec));
+    }
+    mx25_release();
+    
+    if (err) {
+        DEBUG_PRINT("[JRNL] Round %lu not committed: %d\n", (unsigned long)journal_found.round, err);
+        return;
+    }
+    DEBUG_PRINT("[JRNL] Round %lu %s\n", (unsigned long)journal_found.round,
+                stored ? "was stored already" : "committed as partial result");
+    journal_clear();
+}
+
+int32_t losstst_store_round(void)
+{
+    losstst_store_result_t rec;
+    uint16_t trace_n = 0;
+    uint32_t round;
+    int err;
+    
+    if (!store_mounted) {
+        journal_clear();
+        return -ENODEV;
+    }
+    
+    store_result_fill(&rec);
+    if (scanner_tgr == mode_arena_owner) {
+        trace_n = mode_arena.scanner.trace_n;
+    }
+    round = result_store.last_round + 1;
+    
+    mx25_acquire();
+    err = rstore_append(&result_store, RSTORE_TYPE_RESULT, round, &rec, sizeof(rec));
+    for (uint16_t i = 0; 0 == err && i < trace_n; i += STORE_TRACE_PER_REC) {
+        uint16_t n = (uint16_t)(((uint32_t)(trace_n - i) < STORE_TRACE_PER_REC) ? (uint32_t)(trace_n - i) : STORE_TRACE_PER_REC);
+        
+        err = rstore_append(&result_store, RSTORE_TYPE_TRACE, round, &mode_arena.scanner.trace[i],
+                            (uint16_t)(n * sizeof(mode_arena.scanner.trace[0])));
+    }
+    mx25_release();
+    
+    if (err) {
+        DEBUG_PRINT("[STORE] Round %lu not stored: %d\n", (unsigned long)round, err);
+        return err;
+    }
+    journal_clear();
+    return (int32_t)round;
+}
+
+int losstst_store_query(uint32_t round_lo, uint32_t round_hi, losstst_store_cb_t cb, void *ctx)
+{
+    static uint8_t buf[STORE_REC_MAX];
+    store_query_t query = {
+        .cb = cb,
+        .ctx = ctx,
+    };
+    int ret;
+    
+    if (cb == NULL) {
+        return -EINVAL;
+    }
+    if (!store_mounted) {
+        return -ENODEV;
+    }
+    
+    mx25_acquire();
+    ret = rstore_query(&result_store, round_lo, round_hi, buf, sizeof(buf), store_query_cb, &query);
+    mx25_release();
+    return ret;
+}
+
+int losstst_get_store_stats(losstst_store_stats_t *stats)
+{
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+    if (!store_mounted) {
+        return -ENODEV;
+    }
+    
+    stats->size = (uint32_t)store_flash.sectors * MX25_SECTOR_SIZE;
+    stats->last_round = result_store.last_round;
+    stats->records = result_store.records;
+    stats->erase_max = result_store.erase_max;
+    stats->skipped = result_store.skipped;
+    return 0;
+}
+
+/* ================== Scan Phase Scheduling ================== */
+
+/*
+ * Scan PHY of the idle period and bound of the reception window, predicted
+ * from the sender countdown (scan_phase.h).
+ */
+
+/**
+ * @brief Record a received pre_cnt and stamp the time it changed value
+ *
+ * @param index PHY index (0=2M, 1=1M, 2=Coded, 3=BLE4)
+ * @param pre_cnt Received pre_cnt field
+ */
+static void precnt_update(uint8_t index, int16_t pre_cnt)
+{
+    scan_phase_precnt(&scan_phase, index, pre_cnt, platform_uptime_get());
+}
+
+/**
+ * @brief Hold the scan PHY of the group predicted to burst next
+ *
+ * @param end_tm Uptime (ms) of the burst end: the pre_cnt 0 stamp, else the
+ *               predicted end, else 0 for now
+ */
+static void scan_phase_hold_next(int64_t end_tm)
+{
+    uint16_t flow[SCAN_PHASE_PHYS];
+    uint8_t done = 0;
+
+    for (int idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        flow[idx] = mode_arena.scanner.rcv_stamp[idx].rec.flow;
+        if (rec_sets[idx].complete) {
+            done |= 1u << idx;
+        }
+    }
+    scan_phase_hold(&scan_phase, scan_phase_next_method(&scan_phase, done, flow),
+                    end_tm, platform_uptime_get());
+}
+
+int losstst_scanner(void)
+{
+    if (!svc_init_success) {
+        return -1;
+    }
+    
+    int retval = 1;
+    int64_t period_msec, uptime_64_barrier;
+    bool abort = false;
+    static int8_t round_scan_method;
+    static int8_t next_scan_method = 0;
+    static int16_t assign;
+    static int64_t cntdn = 0;
+    static int64_t complete_mark, complete_elapse;
+    static bool phy_mark[4];
+    static int64_t hrtbt, hrtbt_stamp;
+    static bool first_round;
+    bool dual_phase;
+    bool phase_held = false;
+    int64_t burst_end_tm = 0;
+    
+    /* Initialize on first call or after inactive period */
+    if (scanner_inactive) {
+        memset(mode_arena.scanner.rcv_stamp, 0, sizeof(mode_arena.scanner.rcv_stamp));
+        scanner_inactive = false;
+        memset(rcv_ratio_val, 0, sizeof(rcv_ratio_val));
+        
+        /* Determine scan method based on PHY selection */
         round_scan_method = (round_phy_sel[2] && (round_phy_sel[3] || round_phy_sel[1] || round_phy_sel[0])) 
                           ? 0 : ((round_phy_sel[2]) ? 2 : 1);
         
         memset(rcv_stats, 0, sizeof(rcv_stats));
         memset(rcv_ratio_val, 0, sizeof(rcv_ratio_val));
         memset(rcv_rssi_val, 0, sizeof(rcv_rssi_val));
+        scan_phase_reset(&scan_phase);
+        memset(chsweep_rcv, 0, sizeof(chsweep_rcv));
+        memset(chsweep_flow, 0, sizeof(chsweep_flow));
+        rx_queue_reset();
         first_round = true;
     }
     
-    /* Start passive scanning */
-    passive_scan_control((2 == round_scan_method /*&& rc_party*/) ? 0 : round_scan_method);
+    /* Keep the round so far in retained RAM */
+    journal_update();
+    
+    scan_phase_round(&scan_phase,
+                     (uint8_t)((round_phy_sel[0] ? 0x1 : 0) | (round_phy_sel[1] ? 0x2 : 0)
+                               | (round_phy_sel[2] ? 0x4 : 0) | (round_phy_sel[3] ? 0x8 : 0)),
+                     (uint32_t)LOSS_TEST_BURST_COUNT * value_interval[round_adv_param_index][1]);
+    
+    /* Start passive scanning (dual PHY only while discovering) */
+    passive_scan_control((2 == round_scan_method /*&& rc_party*/) ? 0 : 
+                         ((0 == round_scan_method) ? scan_phase_method(&scan_phase, 0, platform_uptime_get())
+                                                   : round_scan_method));
     
     /* Calculate expected period */
     period_msec = LOSS_TEST_BURST_COUNT * value_interval[round_adv_param_index][1];
@@ -2737,42 +5839,44 @@ int losstst_scanner(void)
         return -1;
     }
     
+    /* Echo ping requests on the echo set */
+    ping_echo_service();
+    
     /* Stop all advertising before receiving */
-    blocking_adv(0);
-    blocking_adv(1);
-    blocking_adv(2);
-    blocking_adv(3);
+    for (int idx = 0; idx <= 3; idx++) {
+        blocking_adv(idx);
+    }
     
     /* Determine next scan method based on received pre-counts */
     next_scan_method = 0;
     
-    if (0 > (assign = precnt_rcv[0]) && round_phy_sel[0]) {
+    if (0 > (assign = scan_phase.pre_cnt[0]) && round_phy_sel[0]) {
         if (INT16_MIN != assign) {
             next_scan_method = 1;
-            cntdn = precnt_rcv[0] * -1000L;
+            cntdn = scan_phase.pre_cnt[0] * -1000L;
         }
-    } else if (0 > (assign = precnt_rcv[1]) && round_phy_sel[1]) {
+    } else if (0 > (assign = scan_phase.pre_cnt[1]) && round_phy_sel[1]) {
         if (INT16_MIN != assign) {
             next_scan_method = 1;
-            cntdn = precnt_rcv[1] * -1000L;
+            cntdn = scan_phase.pre_cnt[1] * -1000L;
         }
-    } else if (0 > (assign = precnt_rcv[2]) && round_phy_sel[2]) {
+    } else if (0 > (assign = scan_phase.pre_cnt[2]) && round_phy_sel[2]) {
         if (INT16_MIN != assign) {
             next_scan_method = 2;
-            cntdn = precnt_rcv[2] * -1000L;
+            cntdn = scan_phase.pre_cnt[2] * -1000L;
         }
-    } else if (0 > (assign = precnt_rcv[3]) && round_phy_sel[3]) {
+    } else if (0 > (assign = scan_phase.pre_cnt[3]) && round_phy_sel[3]) {
         if (INT16_MIN != assign) {
             next_scan_method = 1;
-            cntdn = precnt_rcv[3] * -1000L;
+            cntdn = scan_phase.pre_cnt[3] * -1000L;
         }
-    } else if (0 < (assign = precnt_rcv[0]) && round_phy_sel[0]) {
+    } else if (0 < (assign = scan_phase.pre_cnt[0]) && round_phy_sel[0]) {
         if (INT16_MAX != assign) next_scan_method = 1;
-    } else if (0 < (assign = precnt_rcv[1]) && round_phy_sel[1]) {
+    } else if (0 < (assign = scan_phase.pre_cnt[1]) && round_phy_sel[1]) {
         if (INT16_MAX != assign) next_scan_method = 1;
-    } else if (0 < (assign = precnt_rcv[2]) && round_phy_sel[2]) {
+    } else if (0 < (assign = scan_phase.pre_cnt[2]) && round_phy_sel[2]) {
         if (INT16_MAX != assign) next_scan_method = 2;
-    } else if (0 < (assign = precnt_rcv[3]) && round_phy_sel[3]) {
+    } else if (0 < (assign = scan_phase.pre_cnt[3]) && round_phy_sel[3]) {
         if (INT16_MAX != assign) next_scan_method = 1;
     } else {
         /* Check if all receptions complete */
@@ -2797,8 +5901,8 @@ int losstst_scanner(void)
     first_round = false;
     
     /* Check for completion timeout */
-    if (INT16_MAX == precnt_rcv[0] && INT16_MAX == precnt_rcv[1] && 
-        INT16_MAX == precnt_rcv[2] && INT16_MAX == precnt_rcv[3]) {
+    if (INT16_MAX == scan_phase.pre_cnt[0] && INT16_MAX == scan_phase.pre_cnt[1] && 
+        INT16_MAX == scan_phase.pre_cnt[2] && INT16_MAX == scan_phase.pre_cnt[3]) {
         if (0 == complete_mark) {
             complete_mark = platform_uptime_get();
         } else if (10000 < (complete_elapse += platform_uptime_get() - complete_mark)) {
@@ -2817,14 +5921,18 @@ int losstst_scanner(void)
     period_msec += cntdn;
     uptime_64_barrier = period_msec + platform_uptime_get();
     
-    /* Start scanning with selected method */
-    passive_scan_control(next_scan_method);
+    /* Both groups in one cycle (concurrent sender): keep 1M+Coded scanning */
+    dual_phase = (0 == round_scan_method) && scan_phase_concurrent(&scan_phase, platform_uptime_get());
+    
+    /* Start scanning with selected method (the countdown on 1M+Coded, see below) */
+    passive_scan_control((dual_phase || 0 == round_scan_method) ? 0 : next_scan_method);
     
     cntdn = 0;
     phy_mark[0] = phy_mark[1] = phy_mark[2] = phy_mark[3] = false;
     
-    /* Main reception loop */
-    while (uptime_64_barrier > platform_uptime_get()) {
+    /* Main reception loop, bounded by the predicted burst of the active group */
+    while (scan_phase_barrier(&scan_phase, dual_phase ? 0 : next_scan_method, uptime_64_barrier,
+                              platform_uptime_get()) > platform_uptime_get()) {
         /* Print received messages */
         if ('\0' != *rcv_msg_str[0]) {
             *rcv_msg_str[0] = '\0';
@@ -2843,63 +5951,71 @@ int losstst_scanner(void)
             break;
         }
         
+        /* Countdown on 1M+Coded, so a concurrent sender is heard on both
+         * countdowns; the active group alone from shortly before the burst */
+        if (0 == round_scan_method && !dual_phase && !phase_held) {
+            dual_phase = scan_phase_concurrent(&scan_phase, platform_uptime_get());
+            passive_scan_control(scan_phase_window_method(&scan_phase, next_scan_method,
+                                                          platform_uptime_get()));
+        }
+        
         /* Track PHY states for scan method 1 (1M/2M/BLE4) */
-        if (1 == next_scan_method) {
-            if (0 > (precnt_rcv[0])) {
-                if (INT16_MIN != precnt_rcv[0]) {
+        if (1 == next_scan_method || dual_phase) {
+            if (0 > (scan_phase.pre_cnt[0])) {
+                if (INT16_MIN != scan_phase.pre_cnt[0]) {
                     phy_mark[0] = true;
                     rcv_state_val[0] = 1;
                 }
-            } else if (0 < (precnt_rcv[0])) {
+            } else if (0 < (scan_phase.pre_cnt[0])) {
                 phy_mark[0] = true;
                 rcv_state_val[0] = 2;
-            } else if (0 == (precnt_rcv[0])) {
+            } else if (0 == (scan_phase.pre_cnt[0])) {
                 if (phy_mark[0]) rcv_state_val[0] = 3;
             }
             
-            if (0 > (precnt_rcv[1])) {
-                if (INT16_MIN != precnt_rcv[1]) {
+            if (0 > (scan_phase.pre_cnt[1])) {
+                if (INT16_MIN != scan_phase.pre_cnt[1]) {
                     phy_mark[1] = true;
                     rcv_state_val[1] = 1;
                 }
-            } else if (0 < (precnt_rcv[1])) {
+            } else if (0 < (scan_phase.pre_cnt[1])) {
                 phy_mark[1] = true;
                 rcv_state_val[1] = 2;
-            } else if (0 == (precnt_rcv[1])) {
+            } else if (0 == (scan_phase.pre_cnt[1])) {
                 if (phy_mark[1]) rcv_state_val[1] = 3;
             }
             
-            if (0 > (precnt_rcv[3])) {
-                if (INT16_MIN != precnt_rcv[3]) {
+            if (0 > (scan_phase.pre_cnt[3])) {
+                if (INT16_MIN != scan_phase.pre_cnt[3]) {
                     phy_mark[3] = true;
                     rcv_state_val[3] = 1;
                 }
-            } else if (0 < (precnt_rcv[3])) {
+            } else if (0 < (scan_phase.pre_cnt[3])) {
                 phy_mark[3] = true;
                 rcv_state_val[3] = 2;
-            } else if (0 == (precnt_rcv[3])) {
+            } else if (0 == (scan_phase.pre_cnt[3])) {
                 if (phy_mark[3]) rcv_state_val[3] = 3;
             }
             
-            rcv_state_val[2] = 0;
+            if (!dual_phase) rcv_state_val[2] = 0;
         }
         
         /* Track PHY states for scan method 2 (Coded PHY) */
-        if (2 == next_scan_method) {
-            if (0 > precnt_rcv[2]) {
-                if (INT16_MIN != precnt_rcv[2]) {
+        if (2 == next_scan_method || dual_phase) {
+            if (0 > scan_phase.pre_cnt[2]) {
+                if (INT16_MIN != scan_phase.pre_cnt[2]) {
                     phy_mark[2] = true;
                     rcv_state_val[2] = 1;
                 }
             }
-            if (0 < precnt_rcv[2]) {
+            if (0 < scan_phase.pre_cnt[2]) {
                 phy_mark[2] = true;
                 rcv_state_val[2] = 2;
             }
-            if (0 == precnt_rcv[2]) {
+            if (0 == scan_phase.pre_cnt[2]) {
                 if (phy_mark[2]) rcv_state_val[2] = 3;
             }
-            rcv_state_val[0] = rcv_state_val[1] = rcv_state_val[3] = 0;
+            if (!dual_phase) rcv_state_val[0] = rcv_state_val[1] = rcv_state_val[3] = 0;
         }
         
         /* Send response when burst complete */
@@ -2908,7 +6024,7 @@ int losstst_scanner(void)
                 abort = true;
                 break;
             }
-            if (phy_mark[idx] && 0 == precnt_rcv[idx]) {
+            if (phy_mark[idx] && 0 == scan_phase.pre_cnt[idx]) {
                 if (!ignore_rcv_resp) {
                     resp_burst_end_data[1].data = (const uint8_t *)&remote_resp_form[idx];
                     update_adv(idx, NULL, resp_burst_end_data, p_adv_1sec_start_param);
@@ -2916,11 +6032,24 @@ int losstst_scanner(void)
                 
                 rcv_state_val[idx] = 0;
                 phy_mark[idx] = false;
+                if (scan_phase.pre_cnt_tm[idx] > burst_end_tm) {
+                    burst_end_tm = scan_phase.pre_cnt_tm[idx];
+                }
             }
         }
         
         if (abort) break;
         
+        /* Burst end of the active group: switch to the group predicted next */
+        if (!phase_held && 0 != burst_end_tm && 0 == round_scan_method && !dual_phase
+            && !phy_mark[0] && !phy_mark[1] && !phy_mark[2] && !phy_mark[3]) {
+            scan_phase_hold_next(burst_end_tm);
+            passive_scan_control(scan_phase_method(&scan_phase, 0, platform_uptime_get()));
+            phase_held = true;
+        }
+        
+        ping_echo_service();
+        
         /* Exit loop if all PHYs inactive */
         if (!phy_mark[0] && !phy_mark[1] && !phy_mark[2] && !phy_mark[3]) {
             if (0 == cntdn) {
@@ -2935,11 +6064,20 @@ int losstst_scanner(void)
         }
     }
     
+    /* Stay on the PHY of the group the sender is predicted to burst next;
+     * without a pre_cnt 0 (window ended on the prediction), from its end */
+    if (abort || 0 != round_scan_method || dual_phase) {
+        /* A concurrent sender bursts both groups again: stay on dual-PHY scanning */
+        scan_phase.method = 0;
+    } else if (!phase_held) {
+        scan_phase_hold_next(scan_phase.end_tm);
+    }
+    
     /* Clear marked PHYs */
-    if (phy_mark[0]) precnt_rcv[0] = 0;
-    if (phy_mark[1]) precnt_rcv[1] = 0;
-    if (phy_mark[2]) precnt_rcv[2] = 0;
-    if (phy_mark[3]) precnt_rcv[3] = 0;
+    if (phy_mark[0]) scan_phase.pre_cnt[0] = 0;
+    if (phy_mark[1]) scan_phase.pre_cnt[1] = 0;
+    if (phy_mark[2]) scan_phase.pre_cnt[2] = 0;
+    if (phy_mark[3]) scan_phase.pre_cnt[3] = 0;
     
     rcv_state_val[0] = rcv_state_val[1] = rcv_state_val[2] = rcv_state_val[3] = 0;
     hrtbt = hrtbt_stamp = 0;
@@ -2953,7 +6091,9 @@ int losstst_scanner(void)
     //}
     
     /* Resume scanning */
-    passive_scan_control(((0 >= retval) || (2 == round_scan_method/* && rc_party*/)) ? 0 : round_scan_method);
+    passive_scan_control(((0 >= retval) || (2 == round_scan_method/* && rc_party*/)) ? 0 : 
+                         ((0 == round_scan_method) ? scan_phase_method(&scan_phase, 0, platform_uptime_get())
+                                                   : round_scan_method));
     
     return retval;
 }
@@ -2968,20 +6108,20 @@ int losstst_scanner(void)
  */
 static void numcst_rssi_calc(int64_t tm_stamp)
 {
-    if (llabs(numcst_rssi_rec_tm - tm_stamp) < 50) {
+    if (llabs(mode_arena.numcast.rssi_rec_tm - tm_stamp) < 50) {
         return;
     }
     
-    numcst_rssi_rec_tm = tm_stamp;
+    mode_arena.numcast.rssi_rec_tm = tm_stamp;
     int8_t cnt = 0;
     int16_t avg = 0;
     int8_t lower = 20;
     int8_t upper = -127;
     
-    for (unsigned int idx = 0; idx < ARRAY_SIZE(numcst_rssi_rec); idx++) {
-        int64_t rec_tm = numcst_rssi_rec[idx].expired_tm;
-        int8_t rec_rssi = numcst_rssi_rec[idx].rssi;
-        if (numcst_rssi_rec_tm <= rec_tm) {
+    for (unsigned int idx = 0; idx < ARRAY_SIZE(mode_arena.numcast.rssi_rec); idx++) {
+        int64_t rec_tm = mode_arena.numcast.rssi_rec[idx].expired_tm;
+        int8_t rec_rssi = mode_arena.numcast.rssi_rec[idx].rssi;
+        if (mode_arena.numcast.rssi_rec_tm <= rec_tm) {
             avg = avg + rec_rssi;
             cnt = cnt + 1;
             lower = (lower < rec_rssi) ? lower : rec_rssi;
@@ -2993,9 +6133,9 @@ static void numcst_rssi_calc(int64_t tm_stamp)
         avg /= cnt;
     }
     
-    numcst_rssi[0] = avg;
-    numcst_rssi[1] = (20 == lower) ? 0 : lower;
-    numcst_rssi[2] = (-127 == upper) ? 0 : upper;
+    mode_arena.numcast.rssi[0] = avg;
+    mode_arena.numcast.rssi[1] = (20 == lower) ? 0 : lower;
+    mode_arena.numcast.rssi[2] = (-127 == upper) ? 0 : upper;
 }
 
 int losstst_numcast(void)
@@ -3082,15 +6222,15 @@ static void env_rssi_calc(void)
 {
     int64_t expire_tm = platform_uptime_get();
     
-    for (unsigned int phy_idx = 0; phy_idx < ARRAY_SIZE(env_rssi_rec); phy_idx++) {
+    for (unsigned int phy_idx = 0; phy_idx < ARRAY_SIZE(mode_arena.envmon.rssi_rec); phy_idx++) {
         int16_t cnt = 0;
         int32_t avg = 0;
         int8_t lower = 20;
         int8_t upper = -127;
         
-        for (unsigned int idx = 0; idx < ARRAY_SIZE(env_rssi_rec[0]); idx++) {
-            int64_t rec_tm = env_rssi_rec[phy_idx][idx].expired_tm;
-            int8_t rec_rssi = env_rssi_rec[phy_idx][idx].rssi;
+        for (unsigned int idx = 0; idx < ARRAY_SIZE(mode_arena.envmon.rssi_rec[0]); idx++) {
+            int64_t rec_tm = mode_arena.envmon.rssi_rec[phy_idx][idx].expired_tm;
+            int8_t rec_rssi = mode_arena.envmon.rssi_rec[phy_idx][idx].rssi;
             if (expire_tm <= rec_tm) {
                 avg = avg + rec_rssi;
                 cnt = cnt + 1;
@@ -3103,14 +6243,52 @@ static void env_rssi_calc(void)
             avg /= cnt;
         }
         
-        env_rssi[phy_idx][0] = avg;
-        env_rssi[phy_idx][1] = (20 == lower) ? 0 : lower;
-        env_rssi[phy_idx][2] = (-127 == upper) ? 0 : upper;
+        mode_arena.envmon.rssi[phy_idx][0] = avg;
+        mode_arena.envmon.rssi[phy_idx][1] = (20 == lower) ? 0 : lower;
+        mode_arena.envmon.rssi[phy_idx][2] = (-127 == upper) ? 0 : upper;
+    }
+}
+
+/**
+ * @brief Log the advertisers with the most reports and show them on the LCD
+ */
+static void env_top_report(void)
+{
+    topk_item_t top[ENV_TOP_LOG];
+    uint32_t total;
+    uint8_t n = losstst_get_env_top(top, ARRAY_SIZE(top), &total);
+    
+    DEBUG_PRINT("[ENV] %lu reports, top %u:\n", (unsigned long)total, n);
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t *a = top[i].addr;
+        
+        DEBUG_PRINT("[ENV] %02X:%02X:%02X:%02X:%02X:%02X/%u %lu (-%lu) %lu%% %lu B %d dBm PHY 0x%X\n",
+                    a[5], a[4], a[3], a[2], a[1], a[0], top[i].addr_type,
+                    (unsigned long)top[i].count, (unsigned long)top[i].err,
+                    (unsigned long)((uint64_t)top[i].count * 100 / total),
+                    (unsigned long)top[i].bytes, top[i].rssi, top[i].phy_mask);
+    }
+    lcd_ui_show_env_top();
+}
+
+uint8_t losstst_get_env_top(topk_item_t *items, uint8_t max, uint32_t *total)
+{
+    if (envmon_tgr != mode_arena_owner) {
+        if (total != NULL) {
+            *total = 0;
+        }
+        return 0;
+    }
+    if (total != NULL) {
+        *total = mode_arena.envmon.top.total;
     }
+    return topk_get(&mode_arena.envmon.top, items, max);
 }
 
 int losstst_envmon(void)
 {
+    int64_t now;
+    
     if (!svc_init_success) {
         return -1;
     }
@@ -3118,6 +6296,12 @@ int losstst_envmon(void)
     /* Calculate environment RSSI statistics */
     env_rssi_calc();
     
+    now = platform_uptime_get();
+    if (now >= mode_arena.envmon.top_report_tm) {
+        mode_arena.envmon.top_report_tm = now + ENV_TOP_REPORT_MS;
+        env_top_report();
+    }
+    
     /* Check if envmon task is still active */
     return (0 != envmon_task_tgr(0)) ? 1 : 0;
 }
@@ -3144,12 +6328,12 @@ static void numcast_packet_evt(uint8_t idx, const device_info_t *form_p, const u
     
     /* Update timestamp (expires after 5 seconds) */
     int64_t tm_expire = platform_uptime_get() + 5000;
-    numcst_phy_stamp_tm[idx] = tm_expire;
+    mode_arena.numcast.phy_stamp_tm[idx] = tm_expire;
     
     /* Extract source node address (last 2 bytes of EUI-64) */
     /* Use byte-level access to avoid scalar_storage_order byte swap */
-    numcst_src_node[0] = *((const uint8_t *)&form_p->eui + 6);
-    numcst_src_node[1] = *((const uint8_t *)&form_p->eui + 7);
+    mode_arena.numcast.src_node[0] = *((const uint8_t *)&form_p->eui + 6);
+    mode_arena.numcast.src_node[1] = *((const uint8_t *)&form_p->eui + 7);
     
     /* Record RSSI with expiration timestamp */
     rssi_stamp_t loc_rec = {
@@ -3157,7 +6341,7 @@ static void numcast_packet_evt(uint8_t idx, const device_info_t *form_p, const u
         .rssi = rssi
     };
     
-    numcst_rssi_rec[(numcst_rssi_idx++) & 31] = loc_rec;
+    mode_arena.numcast.rssi_rec[(mode_arena.numcast.rssi_idx++) & (NUMCST_RSSI_REC_LEN - 1)] = loc_rec;
 }
 
 /**
@@ -3373,7 +6557,7 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
     /* Handle sender config-preset progress (pre_cnt = INT16_MIN) */
     else if (INT16_MIN == form_p->pre_cnt) {
         /* Check if this is a new sender or flow */
-        if (0 != memcmp(&rcv_stamp[index], &rcv_stamp_lc, 
+        if (0 != memcmp(&mode_arena.scanner.rcv_stamp[index], &rcv_stamp_lc, 
                        sizeof(rcv_stamp_lc.rec.flow) + 
                        offsetof(recv_stats_t, flow))) {
             rcv_stamp_lc.rec.subtotal = 0;
@@ -3385,16 +6569,34 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
             rssi_avg_procedure(&rcv_stamp_lc, info_rssi);
         }
         
-        rcv_stamp[index] = rcv_stamp_lc;
-        rec_sets[index] = rcv_stamp[index].rec;
+        mode_arena.scanner.rcv_stamp[index] = rcv_stamp_lc;
+        rec_sets[index] = mode_arena.scanner.rcv_stamp[index].rec;
         subtotal = sub_total_rcv[index] = 0;
     }
     /* Handle burst counting (0 < pre_cnt < INT16_MAX) */
     else if (0 < form_p->pre_cnt && INT16_MAX != form_p->pre_cnt) {
         subtotal = ++sub_total_rcv[index];
+        rx_queue_stream = index;
+        rptq_mon_period(&rx_queue, index, 1000u * (value_interval[round_adv_param_index][1] + 5));
+        if (mode_arena.scanner.trace_n < RX_TRACE_LEN) {
+            mode_arena.scanner.trace[mode_arena.scanner.trace_n++] = (losstst_trace_entry_t){
+                .t_us = platform_uptime_us(),
+                .pre_cnt = form_p->pre_cnt,
+                .rssi = (int8_t)info_rssi,
+                .phy = index,
+            };
+        } else if (mode_arena.scanner.trace_lost < UINT16_MAX) {
+            mode_arena.scanner.trace_lost++;
+        }
         rcv_ratio_val[index][0] = subtotal;
         rcv_ratio_val[index][1] = LOSS_TEST_BURST_COUNT * rcv_stamp_lc.rec.flow;
-        precnt_rcv[index] = form_p->pre_cnt;
+        precnt_update(index, form_p->pre_cnt);
+        if (round_channel_sweep && 0 < rcv_stamp_lc.rec.flow) {
+            chsweep_rcv[index][chsweep_channel(rcv_stamp_lc.rec.flow)]++;
+            if (rcv_stamp_lc.rec.flow > chsweep_flow[index]) {
+                chsweep_flow[index] = rcv_stamp_lc.rec.flow;
+            }
+        }
         sndr_id = rcv_stamp_lc.rec.node;
         sndr_txpower = rcv_stamp_lc.rec.tx_pwr;
     }
@@ -3410,11 +6612,11 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
     /* Update RSSI statistics if flow is valid and matches */
     if (0 == rcv_stamp_lc.rec.flow || 201 < rcv_stamp_lc.rec.flow) {
         /* Skip invalid flow */
-    } else if (0 == memcmp(&rcv_stamp[index], &rcv_stamp_lc, 
+    } else if (0 == memcmp(&mode_arena.scanner.rcv_stamp[index], &rcv_stamp_lc, 
                           offsetof(recv_stats_t, flow))) {
         /* Same sender, same session */
-        if (rcv_stamp[index].rec.flow == rcv_stamp_lc.rec.flow) {
-            rcv_stamp_lc = rcv_stamp[index];
+        if (mode_arena.scanner.rcv_stamp[index].rec.flow == rcv_stamp_lc.rec.flow) {
+            rcv_stamp_lc = mode_arena.scanner.rcv_stamp[index];
             rcv_stamp_lc.rec.subtotal = subtotal;
             rssi_avg_procedure(&rcv_stamp_lc, info_rssi);
 
@@ -3425,7 +6627,8 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
                 rec_sets[index] = rcv_stamp_lc.rec;
             } else if (0 == form_p->pre_cnt) {
                 /* Sender side burst completed */
-                precnt_rcv[index] = 0;
+                precnt_update(index, 0);
+                rptq_mon_period(&rx_queue, index, 0);
                 remote_resp_form[index] = *form_p;
                 if (!rcv_stamp_lc.rec.dump_rcvinfo) {
                     rcv_stamp_lc.rec.dump_rcvinfo = 1;
@@ -3433,10 +6636,10 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
                 }
                 rec_sets[index] = rcv_stamp_lc.rec;
             } else if (0 > form_p->pre_cnt) {
-                precnt_rcv[index] = form_p->pre_cnt;
+                precnt_update(index, form_p->pre_cnt);
             }
             
-            rcv_stamp[index] = rcv_stamp_lc;
+            mode_arena.scanner.rcv_stamp[index] = rcv_stamp_lc;
             rcv_rssi_val[index][0] = rcv_stamp_lc.rec.rssi;
             rcv_rssi_val[index][1] = (1 >= rcv_stamp_lc.rssi_idx) ? 
                                      rcv_stamp_lc.rec.rssi : 
@@ -3448,31 +6651,31 @@ static void tst_form_packet_rcv(sl_adv_info_t *info_p, device_info_t *form_p)
                    sizeof(peek_rcv_rssi[index]));
         } else {
             /* New flow from same sender */
-            rcv_rssi_val[index][0] = rcv_stamp[index].rec.rssi = 
-                rcv_stamp[index].rssi_acc / rcv_stamp[index].rssi_idx;
-            rcv_rssi_val[index][1] = (1 >= rcv_stamp[index].rssi_idx) ? 
-                                     rcv_stamp[index].rec.rssi : 
-                                     rcv_stamp[index].rec.rssi_lower;
-            rcv_rssi_val[index][2] = (1 >= rcv_stamp[index].rssi_idx) ? 
-                                     rcv_stamp[index].rec.rssi : 
-                                     rcv_stamp[index].rec.rssi_upper;
+            rcv_rssi_val[index][0] = mode_arena.scanner.rcv_stamp[index].rec.rssi = 
+                mode_arena.scanner.rcv_stamp[index].rssi_acc / mode_arena.scanner.rcv_stamp[index].rssi_idx;
+            rcv_rssi_val[index][1] = (1 >= mode_arena.scanner.rcv_stamp[index].rssi_idx) ? 
+                                     mode_arena.scanner.rcv_stamp[index].rec.rssi : 
+                                     mode_arena.scanner.rcv_stamp[index].rec.rssi_lower;
+            rcv_rssi_val[index][2] = (1 >= mode_arena.scanner.rcv_stamp[index].rssi_idx) ? 
+                                     mode_arena.scanner.rcv_stamp[index].rec.rssi : 
+                                     mode_arena.scanner.rcv_stamp[index].rec.rssi_upper;
             memcpy(peek_rcv_rssi[index], rcv_rssi_val[index], 
                    sizeof(peek_rcv_rssi[index]));
-            remote_tx_pwr[index] = rcv_stamp[index].rec.tx_pwr;
+            remote_tx_pwr[index] = mode_arena.scanner.rcv_stamp[index].rec.tx_pwr;
 
-            if (!rcv_stamp[index].rec.dump_rcvinfo) {
-                rcv_stamp[index].rec.dump_rcvinfo = 1;
+            if (!mode_arena.scanner.rcv_stamp[index].rec.dump_rcvinfo) {
+                mode_arena.scanner.rcv_stamp[index].rec.dump_rcvinfo = 1;
                 rcvinfo_output_req = true;
-                rec_sets[index] = rcv_stamp[index].rec;
+                rec_sets[index] = mode_arena.scanner.rcv_stamp[index].rec;
             }
 
             rssi_idx_init(&rcv_stamp_lc, info_rssi);
-            rcv_stamp[index] = rcv_stamp_lc;
+            mode_arena.scanner.rcv_stamp[index] = rcv_stamp_lc;
         }
     } else {
         /* New sender detected */
         rssi_idx_init(&rcv_stamp_lc, info_rssi);
-        rcv_stamp[index] = rcv_stamp_lc;
+        mode_arena.scanner.rcv_stamp[index] = rcv_stamp_lc;
         
         /* Log new sender info */
         char *dst_p = ('\0' == *rcv_msg_str[0]) ? rcv_msg_str[0] : 
@@ -3542,7 +6745,7 @@ static bool test_form_parser(adv_data_t *data, void *user_data)
     if (BT_DATA_FLAGS == data->type) {
         if (0 == dev_chr_p->step_raw) {
             dev_chr_p->step_flag++;
-            DEBUG_PRINT("[PARSE] FLAGS found\n");
+            PARSE_PRINT("[PARSE] FLAGS found\n");
         } else {
             dev_chr_p->step_fail = 1;
         }
@@ -3551,7 +6754,7 @@ static bool test_form_parser(adv_data_t *data, void *user_data)
     else if (1 == dev_chr_p->step_flag && BT_DATA_MANUFACTURER_DATA == data->type) {
         device_info_t *rcv_data_p = (device_info_t *)data->data;
         
-        DEBUG_PRINT("[PARSE] Manu data: man_id=0x%04X, form_id=0x%04X (expect 0x%04X, 0x%04X)\n",
+        PARSE_PRINT("[PARSE] Manu data: man_id=0x%04X, form_id=0x%04X (expect 0x%04X, 0x%04X)\n",
                     rcv_data_p->man_id, rcv_data_p->form_id, 
                     MANUFACTURER_ID, LOSS_TEST_FORM_ID);
         
@@ -3559,11 +6762,11 @@ static bool test_form_parser(adv_data_t *data, void *user_data)
         if (MANUFACTURER_ID == rcv_data_p->man_id && 
             LOSS_TEST_FORM_ID == rcv_data_p->form_id) {
             sl_adv_info_t *adv_info_p = dev_chr_p->adv_info_p;
-            DEBUG_PRINT("[PARSE] Valid packet! pre_cnt=%d\n", rcv_data_p->pre_cnt);
+            PARSE_PRINT("[PARSE] Valid packet! pre_cnt=%d\n", rcv_data_p->pre_cnt);
             tst_form_packet_rcv(adv_info_p, rcv_data_p);
             dev_chr_p->step_success = 1;
         } else {
-            DEBUG_PRINT("[PARSE] ID mismatch - REJECTED\n");
+            PARSE_PRINT("[PARSE] ID mismatch - REJECTED\n");
             dev_chr_p->step_fail = 1;
         }
     } else {
@@ -3724,7 +6927,9 @@ static void device_found(sl_adv_info_t *adv_info, const uint8_t *ad_data, uint16
             .expired_tm = platform_uptime_get() + 60000,  /* 60 second expiry */
             .rssi = rssi_clamped
         };
-        env_rssi_rec[idx][(ARRAY_SIZE(env_rssi_rec[idx]) - 1) & env_rssi_idx[idx]++] = loc_rec;
+        mode_arena.envmon.rssi_rec[idx][(ARRAY_SIZE(mode_arena.envmon.rssi_rec[idx]) - 1) & mode_arena.envmon.rssi_idx[idx]++] = loc_rec;
+        topk_add(&mode_arena.envmon.top, adv_info->address.addr, adv_info->address_type, (uint8_t)idx,
+                 ad_len, rssi_clamped);
         
         if (9999999ul < ++env_stats[idx]) {
             env_stats[idx] = 9999999ul;  /* Cap at max value */
@@ -3754,6 +6959,33 @@ static void device_found(sl_adv_info_t *adv_info, const uint8_t *ad_data, uint16
         }
     }
     
+    /* Try ping parser if initiator or responder (scanner) task is active */
+    if (0 != ping_task_tgr(0) || 0 != scanner_task_tgr(0)) {
+        dev_chr.step_raw = 0;
+        sl_bt_data_parse(ad_data, ad_len, ping_form_parser, &dev_chr);
+        if (dev_chr.step_success) {
+            return;  /* Successfully parsed as ping packet */
+        }
+    }
+    
+    /* Try throughput source parser if the sink is searching */
+    if (0 != tput_task_tgr(0)) {
+        dev_chr.step_raw = 0;
+        sl_bt_data_parse(ad_data, ad_len, tput_form_parser, &dev_chr);
+        if (dev_chr.step_success) {
+            return;  /* Successfully parsed as throughput source */
+        }
+    }
+    
+    /* Try time beacon parser (legacy advertising) */
+    if (3 == idx) {
+        dev_chr.step_raw = 0;
+        sl_bt_data_parse(ad_data, ad_len, time_form_parser, &dev_chr);
+        if (dev_chr.step_success) {
+            return;  /* Successfully parsed as time beacon */
+        }
+    }
+    
     /* Try remote control parser (only for 1M PHY) */
     /* TODO: Implement remote_ctrl_parser if needed
     if (1 == idx) {
@@ -3769,11 +7001,12 @@ static void device_found(sl_adv_info_t *adv_info, const uint8_t *ad_data, uint16
  * @brief Silicon Labs device found callback for legacy advertising
  * 
  * @param addr Device address (bd_addr*)
+ * @param addr_type Address type (sl_bt_gap_address_type_t)
  * @param rssi RSSI value in dBm
  * @param ad_data Advertising data buffer
  * @param ad_len Advertising data length
  */
-static void device_found_legacy(const bd_addr *addr, int8_t rssi,
+static void device_found_legacy(const bd_addr *addr, uint8_t addr_type, int8_t rssi,
                                const uint8_t *ad_data, uint16_t ad_len)
 {
     /* Create advertising info structure for legacy advertising (BLE4) */
@@ -3782,7 +7015,7 @@ static void device_found_legacy(const bd_addr *addr, int8_t rssi,
         .tx_power = 127,  /* Unknown TX power */
         .prim_phy = 1,    /* 1M PHY */
         .sec_phy = 0,     /* No secondary PHY (legacy) */
-        .address_type = 0,
+        .address_type = addr_type,
         .address = *addr
     };
     
@@ -3794,6 +7027,7 @@ static void device_found_legacy(const bd_addr *addr, int8_t rssi,
  * @brief Silicon Labs device found callback for extended advertising
  * 
  * @param addr Device address (bd_addr*)
+ * @param addr_type Address type (sl_bt_gap_address_type_t)
  * @param rssi RSSI value in dBm
  * @param tx_power TX power in dBm
  * @param prim_phy Primary PHY (1=1M, 3=Coded)
@@ -3801,7 +7035,7 @@ static void device_found_legacy(const bd_addr *addr, int8_t rssi,
  * @param ad_data Advertising data buffer
  * @param ad_len Advertising data length
  */
-static void device_found_extended(const bd_addr *addr, int8_t rssi, int8_t tx_power,
+static void device_found_extended(const bd_addr *addr, uint8_t addr_type, int8_t rssi, int8_t tx_power,
                                  uint8_t prim_phy, uint8_t sec_phy,
                                  const uint8_t *ad_data, uint16_t ad_len)
 {
@@ -3811,7 +7045,7 @@ static void device_found_extended(const bd_addr *addr, int8_t rssi, int8_t tx_po
         .tx_power = tx_power,
         .prim_phy = prim_phy,
         .sec_phy = sec_phy,
-        .address_type = 0,
+        .address_type = addr_type,
         .address = *addr
     };
     
@@ -3835,6 +7069,7 @@ static void device_found_extended(const bd_addr *addr, int8_t rssi, int8_t tx_po
  *             
  *             sl_bt_scanner_process_legacy_report(
  *                 &scan_evt->address,
+ *                 scan_evt->address_type,
  *                 scan_evt->rssi,
  *                 scan_evt->data.data,
  *                 scan_evt->data.len
@@ -3848,6 +7083,7 @@ static void device_found_extended(const bd_addr *addr, int8_t rssi, int8_t tx_po
  *             
  *             sl_bt_scanner_process_extended_report(
  *                 &scan_evt->address,
+ *                 scan_evt->address_type,
  *                 scan_evt->rssi,
  *                 scan_evt->tx_power,
  *                 scan_evt->primary_phy,
@@ -3860,15 +7096,19 @@ static void device_found_extended(const bd_addr *addr, int8_t rssi, int8_t tx_po
  *     }
  * }
  */
-void sl_bt_scanner_process_legacy_report(const bd_addr *addr, int8_t rssi,
+void sl_bt_scanner_process_legacy_report(const bd_addr *addr, uint8_t addr_type, int8_t rssi,
                                         const uint8_t *ad_data, uint16_t ad_len)
 {
-    device_found_legacy(addr, rssi, ad_data, ad_len);
+    rx_queue_stream = -1;
+    device_found_legacy(addr, addr_type, rssi, ad_data, ad_len);
+    rptq_mon_report(&rx_queue, rx_queue_stream, platform_uptime_us());
 }
 
-void sl_bt_scanner_process_extended_report(const bd_addr *addr, int8_t rssi, int8_t tx_power,
+void sl_bt_scanner_process_extended_report(const bd_addr *addr, uint8_t addr_type, int8_t rssi, int8_t tx_power,
                                           uint8_t prim_phy, uint8_t sec_phy,
                                           const uint8_t *ad_data, uint16_t ad_len)
 {
-    device_found_extended(addr, rssi, tx_power, prim_phy, sec_phy, ad_data, ad_len);
+    rx_queue_stream = -1;
+    device_found_extended(addr, addr_type, rssi, tx_power, prim_phy, sec_phy, ad_data, ad_len);
+    rptq_mon_report(&rx_queue, rx_queue_stream, platform_uptime_us());
 }
\ No newline at end of file
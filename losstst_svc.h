@@ -16,9 +16,24 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "sl_bt_api.h"
+#include "wallclock.h"
+#include "topk.h"
 
 /* ================== Type Definitions ================== */
 
+/* Controller scheduler priority profiles (losstst_prio_apply) */
+#define LOSSTST_PRIO_DEFAULT          0     /**< Project configuration (sl_btctrl_scheduler_priority_config.h) */
+#define LOSSTST_PRIO_SCAN_EXCLUSIVE   1     /**< Scanner first; connections win only near supervision timeout */
+#define LOSSTST_PRIO_ADV_EXCLUSIVE    2     /**< Advertiser first; connections win only near supervision timeout */
+#define LOSSTST_PRIO_SHARED           3     /**< Scanner and advertiser escalate from the same level */
+#define LOSSTST_PRIO_LOG_FRIENDLY     4     /**< Connections (log link) above scanning and advertising */
+#define LOSSTST_PRIO_COUNT            5
+#define LOSSTST_PRIO_AUTO             0xFF  /**< test_param_t: profile of the test mode */
+
+/* Controller behaviour switches (losstst_ctrl_apply) */
+#define LOSSTST_CTRL_EARLY_ABORT      0x01  /**< Scanner aborts receptions that would run into a higher priority task */
+#define LOSSTST_CTRL_ADAPTIVITY       0x02  /**< Channel map adaptivity of AFH */
+
 /**
  * @brief Test parameter structure
  * 
@@ -38,12 +53,240 @@ typedef struct {
     bool inhibit_ch38;         /**< Disable advertising channel 38 */
     bool inhibit_ch39;         /**< Disable advertising channel 39 */
     bool non_ANONYMOUS;        /**< Use non-anonymous advertising */
+    bool concurrent_burst;     /**< Burst Coded and uncoded PHYs in the same cycle */
+    bool short_countdown;      /**< Shorten countdown once the scanner acknowledged */
+    bool channel_sweep;        /**< Rotate single-channel maps (37/38/39) per burst */
+    bool soak;                 /**< Scanner: run rounds continuously with change detection */
+    bool tput_source;          /**< Throughput test role: true = stream (peripheral), false = measure (central) */
+    uint16_t gen_devices;      /**< Generator: devices to emulate */
+    uint16_t gen_interval_ms;  /**< Generator: advertising interval of each emulated device */
+    uint8_t gen_payload;       /**< Generator: manufacturer data size (bytes) */
+    uint8_t gen_duty;          /**< Generator: on-time per second (%) */
+    uint8_t prio_profile;      /**< Scheduler priority profile (LOSSTST_PRIO_*, LOSSTST_PRIO_AUTO = per mode) */
+    uint8_t ctrl_switches;     /**< Controller behaviour (LOSSTST_CTRL_*) */
     void *envmon_abort;        /**< Environment monitor abort callback */
     void *sender_abort;        /**< Sender abort callback */
     void *scanner_abort;       /**< Scanner abort callback */
     void *numcast_abort;       /**< Number cast abort callback */
+    void *ping_abort;          /**< Ping abort callback */
+    void *tput_abort;          /**< Throughput test abort callback */
+    void *gen_abort;           /**< Traffic generator abort callback */
 } test_param_t;
 
+/**
+ * @brief Received/expected packet pair
+ */
+typedef struct {
+    uint16_t rcv;              /**< Packets received */
+    uint16_t exp;              /**< Packets expected */
+} losstst_count_t;
+
+/**
+ * @brief Scanner result record for one PHY
+ * 
+ * Per-channel counts are only filled in channel sweep mode, where every
+ * burst is sent on a single primary advertising channel. The loss is
+ * split into reports dropped by a full controller queue (host loss) and
+ * the rest (RF loss).
+ */
+typedef struct {
+    uint16_t rcv;              /**< Packets received */
+    uint16_t exp;              /**< Packets expected */
+    uint16_t rf_lost;          /**< Lost on air (exp - rcv - host_lost) */
+    uint16_t host_lost;        /**< Estimated drops in the controller report queue */
+    losstst_count_t ch[3];     /**< Per advertising channel (0=37, 1=38, 2=39) */
+} losstst_result_t;
+
+/**
+ * @brief Scanner report queue statistics of the current round
+ * 
+ * A drain is a run of reports delivered back-to-back after a host stall;
+ * a drain that reaches the queue depth means reports were dropped.
+ * Controller counters are 16 bit and cover all advertisers.
+ */
+typedef struct {
+    uint8_t queue_depth;       /**< SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS */
+    uint32_t reports;          /**< Reports delivered to the host */
+    uint32_t drains;           /**< Back-to-back runs */
+    uint32_t sat_drains;       /**< Runs that filled the queue */
+    uint16_t max_drain;        /**< Longest run */
+    uint16_t ctrl_rx;          /**< Controller: packets received */
+    uint16_t ctrl_crc;         /**< Controller: CRC errors */
+    uint16_t ctrl_fail;        /**< Controller: radio failures (aborts, scheduling) */
+} losstst_rxq_stats_t;
+
+/**
+ * @brief Ping round-trip statistics for one PHY
+ * 
+ * RTT excludes the responder processing delay reported in each echo.
+ */
+typedef struct {
+    uint16_t sent;             /**< Requests sent */
+    uint16_t echoed;           /**< Echoes received */
+    uint16_t rtt_min;          /**< Minimum RTT (ms) */
+    uint16_t rtt_median;       /**< Median RTT (ms) */
+    uint16_t rtt_p99;          /**< 99th percentile RTT (ms, nearest rank) */
+} losstst_ping_stats_t;
+
+/**
+ * @brief Connection throughput result for one transport
+ * 
+ * Filled on the sink; the source only fills bytes and backpressure.
+ * Utilisation relates goodput to the capacity of the negotiated PHY and
+ * data length if every connection event ran for the whole interval.
+ */
+typedef struct {
+    uint32_t bytes;            /**< Payload bytes received (sink) or sent (source) */
+    uint32_t goodput_bps;      /**< Goodput over the phase (bit/s) */
+    uint32_t win_min_bps;      /**< Lowest window throughput (bit/s) */
+    uint32_t win_max_bps;      /**< Highest window throughput (bit/s) */
+    uint32_t capacity_bps;     /**< Theoretical capacity of the link (bit/s) */
+    uint32_t backpressure;     /**< Sends refused for lack of buffers (source) */
+    uint16_t stalls;           /**< Delivery gaps above the stall threshold */
+    uint16_t stall_ms;         /**< Total time stalled (ms) */
+    uint16_t max_gap_ms;       /**< Longest delivery gap (ms) */
+    uint16_t seq_lost;         /**< Sequence numbers never received */
+    uint16_t conn_interval;    /**< Connection interval (1.25 ms units) */
+    uint16_t data_len;         /**< Link layer data length (octets) */
+    uint16_t mtu;              /**< ATT MTU */
+    uint8_t phy;               /**< Connection PHY (sl_bt_gap_phy_t) */
+    uint8_t util_pct;          /**< Connection event utilisation (%) */
+} losstst_tput_result_t;
+
+/**
+ * @brief Traffic generator rates
+ * 
+ * Rates are in 1/1000 packets/s. The achieved rate counts advertising
+ * events of completed on-windows since setup.
+ */
+typedef struct {
+    uint8_t sets;              /**< Advertising sets in use */
+    uint32_t events;           /**< Advertising events completed */
+    uint32_t overruns;         /**< On-windows that did not complete */
+    uint32_t target_mpps;      /**< Requested rate (N devices / interval) */
+    uint32_t planned_mpps;     /**< Rate of the set plan incl. duty cycle */
+    uint32_t achieved_mpps;    /**< Measured rate */
+} losstst_gen_stats_t;
+
+/**
+ * @brief Link budget of one PHY from a tx power sweep
+ * 
+ * Levels are in 0.1 dB. Sensitivities are the RSSI at which the fitted
+ * logistic PER curve reaches 30.8 % (spec reference), 10 % and 1 % PER.
+ * The margin is the RSSI expected at the highest swept tx power above
+ * the 30.8 % sensitivity.
+ */
+typedef struct {
+    uint8_t points;            /**< Tx power levels collected */
+    int8_t tx_max;             /**< Highest swept tx power (dBm) */
+    int16_t path_loss;         /**< Mean tx power - RSSI */
+    int16_t sens[3];           /**< Sensitivity at 30.8 %, 10 %, 1 % PER */
+    int16_t margin;            /**< Link budget margin */
+} losstst_link_fit_t;
+
+/**
+ * @brief Soak run summary for one PHY
+ * 
+ * PER is in 1/1000. A round without any packet counts as PER 1000 and
+ * is excluded from the RSSI figures.
+ */
+typedef struct {
+    uint32_t rounds;           /**< Rounds evaluated */
+    uint32_t silent;           /**< Rounds without any packet */
+    uint32_t per_sum;          /**< Sum of round PER (mean = per_sum / rounds) */
+    uint16_t per_min;          /**< Lowest round PER */
+    uint16_t per_max;          /**< Highest round PER */
+    uint16_t per_last;         /**< PER of the last round */
+    int8_t rssi_min;           /**< Lowest round mean RSSI (dBm) */
+    int8_t rssi_max;           /**< Highest round mean RSSI (dBm) */
+    int8_t rssi_last;          /**< Mean RSSI of the last round with packets (dBm) */
+    uint16_t change_points;    /**< Change points detected */
+} losstst_soak_summary_t;
+
+/**
+ * @brief Soak change point, as persisted in NVM3
+ */
+typedef struct {
+    uint32_t round;            /**< Round the change was detected in */
+    uint32_t uptime_s;         /**< Uptime at detection (s) */
+    uint8_t phy;               /**< PHY index: 0=2M, 1=1M, 2=Coded(S8), 3=BLE4.x */
+    uint8_t metric;            /**< 0=PER, 1=mean RSSI */
+    uint8_t detector;          /**< 0=CUSUM, 1=Page-Hinkley */
+    int8_t dir;                /**< 1=increase, -1=decrease */
+    int16_t value;             /**< Round value that fired (PER 1/1000 or RSSI dBm) */
+} losstst_soak_event_t;
+
+/**
+ * @brief Radio scheduling conflicts of the current round
+ * 
+ * The controller counts a radio failure for every task it could not run
+ * because a higher priority task held the radio. The scanner relates the
+ * failures to the scan windows scheduled since the round started; the
+ * sender estimates the advertising events each set lost in its last
+ * burst from the burst duration (a pre-empted event is not counted
+ * against the event budget, so the burst runs longer).
+ */
+typedef struct {
+    uint8_t profile;           /**< Priority profile in effect (LOSSTST_PRIO_*) */
+    uint16_t ctrl_fail;        /**< Controller radio failures */
+    uint16_t scan_windows;     /**< Scan windows scheduled (scanner) */
+    uint16_t adv_skipped[4];   /**< Events missing per set in the last burst (sender) */
+} losstst_prio_stats_t;
+
+/**
+ * @brief Round result record of the flash result store
+ */
+typedef struct {
+    uint32_t uptime_s;         /**< Uptime at the end of the round (s) */
+    uint8_t phy_sel;           /**< Bit per PHY index scanned */
+    uint16_t trace_lost;       /**< Packets that did not fit the trace buffer */
+    int8_t tx_pwr[4];          /**< Sender tx power per PHY (dBm) */
+    int8_t rssi[4];            /**< Mean RSSI per PHY (dBm) */
+    losstst_result_t result[4]; /**< Per PHY result */
+    uint8_t prio_profile;      /**< Scheduler priority profile of the round */
+    uint16_t ctrl_fail;        /**< Controller radio failures (pre-emptions) */
+    uint16_t scan_windows;     /**< Scan windows scheduled */
+    uint8_t ctrl_switches;     /**< Controller behaviour in effect (LOSSTST_CTRL_*) */
+    uint32_t wall_s;           /**< UTC at the end of the round (s since 1970, 0 = not set) */
+    uint16_t wall_ms;          /**< Milliseconds of wall_s */
+    uint8_t wall_src;          /**< Time source of wall_s (WALLCLOCK_SRC_*) */
+    uint8_t partial;           /**< 1: cut short by a reset, committed from the RAM journal */
+} losstst_store_result_t;
+
+/**
+ * @brief Per-packet trace entry of the flash result store
+ */
+typedef struct {
+    uint32_t t_us;             /**< Arrival (uptime us, wraps) */
+    int16_t pre_cnt;           /**< Burst countdown of the packet */
+    int8_t rssi;               /**< RSSI (dBm) */
+    uint8_t phy;               /**< PHY index */
+} losstst_trace_entry_t;
+
+/**
+ * @brief Flash result store status
+ */
+typedef struct {
+    uint32_t size;             /**< Flash size (bytes) */
+    uint32_t last_round;       /**< Round id of the last record */
+    uint32_t records;          /**< Records written since mount */
+    uint32_t erase_max;        /**< Highest sector erase count */
+    uint32_t skipped;          /**< Torn records/sectors found at mount */
+} losstst_store_stats_t;
+
+/**
+ * @brief Result store query callback
+ *
+ * @param ctx User context
+ * @param type 1 = losstst_store_result_t, 2 = losstst_trace_entry_t array
+ * @param round Round id
+ * @param data Record data
+ * @param len Data length
+ * @return true to continue, false to stop
+ */
+typedef bool (*losstst_store_cb_t)(void *ctx, uint8_t type, uint32_t round,
+                                   const void *data, uint16_t len);
+
 /* ================== Platform Abstraction Layer ================== */
 
 /**
@@ -89,7 +332,9 @@ typedef struct {
 /**
  * @brief Initialize BLE loss test service
  * 
- * Must be called once at startup before any other functions.
+ * Must be called once at startup before any other functions. Checks the
+ * round journal in retained RAM; a scanner round cut short by the reset
+ * is committed by losstst_store_init().
  * 
  * @return 0 on success, negative error code on failure
  */
@@ -152,6 +397,38 @@ int numcast_setup(const test_param_t *param);
  */
 int envmon_setup(const test_param_t *param);
 
+/**
+ * @brief Setup ping (round-trip latency) initiator mode
+ * 
+ * Any device in scanner mode acts as responder.
+ * 
+ * @param param Test parameters
+ * @return 0 on success, negative error code on failure
+ */
+int ping_setup(const test_param_t *param);
+
+/**
+ * @brief Setup connection throughput test mode
+ * 
+ * The source advertises connectable and streams once the sink subscribed;
+ * the sink connects, negotiates PHY, data length and MTU and measures.
+ * 
+ * @param param Test parameters (tput_source selects the role)
+ * @return 0 on success, negative error code on failure
+ */
+int tput_setup(const test_param_t *param);
+
+/**
+ * @brief Setup traffic generator mode
+ * 
+ * Emulates gen_devices background devices advertising every
+ * gen_interval_ms on all advertising sets with random addresses.
+ * 
+ * @param param Test parameters
+ * @return 0 on success, negative error code on failure
+ */
+int gen_setup(const test_param_t *param);
+
 /* ================== Test Mode Execution Functions ================== */
 
 /**
@@ -190,6 +467,34 @@ int losstst_numcast(void);
  */
 int losstst_envmon(void);
 
+/**
+ * @brief Execute ping test iteration
+ * 
+ * Should be called repeatedly in main loop when ping task is active.
+ * 
+ * @return >0: continue, 0: finished, <0: error/aborted
+ */
+int losstst_ping(void);
+
+/**
+ * @brief Execute throughput test iteration
+ * 
+ * Should be called repeatedly in main loop when throughput task is active.
+ * 
+ * @return >0: continue, 0: finished, <0: error/aborted
+ */
+int losstst_tput(void);
+
+/**
+ * @brief Execute traffic generator iteration
+ * 
+ * Runs until aborted. Should be called repeatedly in main loop when
+ * generator task is active.
+ * 
+ * @return >0: continue, <0: error/aborted
+ */
+int losstst_generator(void);
+
 /* ================== Task Trigger Functions ================== */
 
 /**
@@ -224,6 +529,30 @@ int8_t numcst_task_tgr(int8_t set);
  */
 int8_t envmon_task_tgr(int8_t set);
 
+/**
+ * @brief Get/Set ping task trigger
+ * 
+ * @param set If 0: get current value, if >0: set trigger, if <0: clear trigger
+ * @return Current trigger value
+ */
+int8_t ping_task_tgr(int8_t set);
+
+/**
+ * @brief Get/Set throughput task trigger
+ * 
+ * @param set If 0: get current value, if >0: set trigger, if <0: clear trigger
+ * @return Current trigger value
+ */
+int8_t tput_task_tgr(int8_t set);
+
+/**
+ * @brief Get/Set traffic generator task trigger
+ * 
+ * @param set If 0: get current value, if >0: set trigger, if <0: clear trigger
+ * @return Current trigger value
+ */
+int8_t gen_task_tgr(int8_t set);
+
 /* ================== Configuration Enumeration Functions ================== */
 
 /**
@@ -300,6 +629,288 @@ bool get_uni_cast_method(void);
 
 /* ================== Utility Functions ================== */
 
+/**
+ * @brief Get scanner result record of a PHY
+ * 
+ * @param index PHY index: 0=2M, 1=1M, 2=Coded(S8), 3=BLE4.x
+ * @param result Output result record
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int losstst_get_result(uint8_t index, losstst_result_t *result);
+
+/**
+ * @brief Get report queue statistics of the current scanner round
+ * 
+ * @param stats Output statistics
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -EIO if the controller counters could not be read
+ */
+int losstst_get_rxq_stats(losstst_rxq_stats_t *stats);
+
+/**
+ * @brief Get ping RTT statistics of a PHY
+ * 
+ * @param index PHY index: 0=2M, 1=1M, 2=Coded(S8), 3=BLE4.x
+ * @param stats Output statistics
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int losstst_get_ping_stats(uint8_t index, losstst_ping_stats_t *stats);
+
+/**
+ * @brief Get connection throughput result of a transport
+ * 
+ * @param transport 0=GATT notifications, 1=L2CAP credit based channel
+ * @param result Output result
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int losstst_get_tput_result(uint8_t transport, losstst_tput_result_t *result);
+
+/**
+ * @brief Get traffic generator rates
+ * 
+ * @param stats Output rates
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int losstst_get_gen_stats(losstst_gen_stats_t *stats);
+
+/**
+ * @brief Get the advertisers with the most reports in the envmon run
+ * 
+ * Counts are Space-Saving estimates (topk.h): the true report count of
+ * an item lies between count - err and count.
+ * 
+ * @param items Output, by descending report count
+ * @param max Size of items
+ * @param total Reports counted since envmon started (may be NULL)
+ * @return Items written
+ */
+uint8_t losstst_get_env_top(topk_item_t *items, uint8_t max, uint32_t *total);
+
+/**
+ * @brief Add the tuples of a finished scanner round to the link fit
+ * 
+ * Call after losstst_scanner() ended a round that was not aborted.
+ * Rounds at the same sender tx power are merged.
+ * 
+ * @return 0 on success, -ENODATA if no packet told the sender tx power
+ */
+int losstst_link_fit_round(void);
+
+/**
+ * @brief Discard all collected link fit tuples
+ */
+void losstst_link_fit_reset(void);
+
+/**
+ * @brief Fit the link budget of a PHY
+ * 
+ * @param index PHY index: 0=2M, 1=1M, 2=Coded(S8), 3=BLE4.x
+ * @param fit Output link budget (points is set even on error)
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -EAGAIN with fewer than 3 tx power levels,
+ *         -EDOM if PER does not fall with RSSI (e.g. no loss at any level)
+ */
+int losstst_get_link_fit(uint8_t index, losstst_link_fit_t *fit);
+
+/**
+ * @brief Evaluate a finished soak round and start the next one
+ * 
+ * Call after losstst_scanner() ended a round (returned <=0) that was not
+ * aborted. Feeds the round PER and mean RSSI of every selected PHY to the
+ * change detectors, logs change points to NVM3 and rearms the scanner.
+ * 
+ * @return 0 on success, -EINVAL if soak is not enabled
+ */
+int losstst_soak_round(void);
+
+/**
+ * @brief Get the soak summary of a PHY
+ * 
+ * @param index PHY index: 0=2M, 1=1M, 2=Coded(S8), 3=BLE4.x
+ * @param summary Output summary
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int losstst_get_soak_summary(uint8_t index, losstst_soak_summary_t *summary);
+
+/**
+ * @brief Read a logged soak change point
+ * 
+ * Change points are numbered from 0 across runs; the NVM3 ring keeps the
+ * last 32.
+ * 
+ * @param seq Sequence number of the change point
+ * @param event Output change point
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -ENOENT if not logged or already overwritten, -EIO on NVM3 error
+ */
+int losstst_get_soak_event(uint32_t seq, losstst_soak_event_t *event);
+
+/**
+ * @brief Mount the result store on the serial flash
+ * 
+ * Commits the round found in the retained RAM journal, if any, as a
+ * partial result (once: a round that is already stored is dropped).
+ * 
+ * @return 0 on success, -ENODEV without flash, or a negative errno
+ */
+int losstst_store_init(void);
+
+/**
+ * @brief Write the result and packet trace of a finished scanner round
+ * 
+ * @return Round id on success, -ENODEV if the store is not mounted,
+ *         or a negative errno
+ */
+int32_t losstst_store_round(void);
+
+/**
+ * @brief Read stored rounds
+ * 
+ * @param round_lo First round id
+ * @param round_hi Last round id
+ * @param cb Callback per record, oldest first
+ * @param ctx User context
+ * @return Records visited, or a negative errno
+ */
+int losstst_store_query(uint32_t round_lo, uint32_t round_hi, losstst_store_cb_t cb, void *ctx);
+
+/**
+ * @brief Get the result store status
+ * 
+ * @param stats Output status
+ * @return 0 on success, -EINVAL on invalid argument, -ENODEV if not mounted
+ */
+int losstst_get_store_stats(losstst_store_stats_t *stats);
+
+/**
+ * @brief Restore the wall clock checkpoint from NVM3
+ * 
+ * The restored time is a lower bound (the time spent in reset is lost);
+ * a time beacon or a phone overrides it.
+ * 
+ * @return 0 on success, -ENOENT without checkpoint, -EIO on NVM3 error
+ */
+int losstst_time_init(void);
+
+/**
+ * @brief Set the wall clock from a Current Time characteristic write
+ * 
+ * The node then broadcasts its time to the others (time beacon).
+ * 
+ * @param val Characteristic value
+ * @param len Value length
+ * @return 0 on success, -EINVAL on an invalid value
+ */
+int losstst_time_set(const uint8_t *val, uint16_t len);
+
+/**
+ * @brief Get the wall clock
+ * 
+ * @param stamp Current time
+ * @return Time source (WALLCLOCK_SRC_*) on success, -EINVAL on invalid
+ *         argument, -EAGAIN if the clock is not set
+ */
+int losstst_time_get(wallclock_stamp_t *stamp);
+
+/**
+ * @brief Send the time beacon and checkpoint the clock when due
+ * 
+ * Call on every application wakeup.
+ */
+void losstst_time_poll(void);
+
+/**
+ * @brief Check if the time beacon holds an advertising set
+ * 
+ * The set is allocated on the first beacon and kept.
+ * 
+ * @return true if the set is allocated
+ */
+bool losstst_time_beacon_alloc(void);
+
+/**
+ * @brief Apply a controller scheduler priority profile
+ * 
+ * Copies the profile's priority table over the controller's table
+ * (sl_bt_system_linklayer_config_key_set_priority_table). Lower values
+ * win the radio; scanner and advertiser escalate from min towards max by
+ * their step after every pre-empted window or event, connections as the
+ * supervision timeout comes closer.
+ * 
+ * @param profile LOSSTST_PRIO_*
+ * @return 0 on success, -EINVAL on invalid profile,
+ *         -EIO if the controller rejected the table
+ */
+int losstst_prio_apply(uint8_t profile);
+
+/**
+ * @brief Name of a priority profile
+ * 
+ * @param profile LOSSTST_PRIO_*
+ * @return Name, "?" for an invalid profile
+ */
+const char *losstst_prio_name(uint8_t profile);
+
+/**
+ * @brief Switch controller behaviours for the next round
+ * 
+ * Early abort is a controller configuration flag
+ * (SL_BTCTRL_CONFIG_FLAG_SCANNER_RECEPTION_EARLY_ABORT), adaptivity the
+ * channel map flag of AFH; both are set through
+ * sl_bt_system_linklayer_configure(). Only switches that changed are sent.
+ * Active or passive AFH is chosen at controller init and stays as built.
+ * Call while the scanner is stopped.
+ * 
+ * @param switches LOSSTST_CTRL_* to enable, the others are disabled
+ * @return 0 on success, -ENOTSUP if the controller refused a switch
+ *         (losstst_ctrl_active() tells what is in effect)
+ */
+int losstst_ctrl_apply(uint8_t switches);
+
+/**
+ * @brief Controller behaviours in effect
+ * 
+ * @return LOSSTST_CTRL_* mask
+ */
+uint8_t losstst_ctrl_active(void);
+
+/**
+ * @brief Controller behaviours of the build configuration
+ * 
+ * @return LOSSTST_CTRL_* mask (config/sl_btctrl_config.h)
+ */
+uint8_t losstst_ctrl_default(void);
+
+/**
+ * @brief Get the scheduling conflicts of the current round
+ * 
+ * @param stats Output statistics
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -EIO if the controller counters could not be read
+ */
+int losstst_get_prio_stats(losstst_prio_stats_t *stats);
+
+/**
+ * @brief Connection event handler of the throughput test
+ * 
+ * Call first from sl_bt_on_event(). Consumes the events of the test
+ * connection so the application does not treat it as a log link, also
+ * after an abort until the connection is closed.
+ * 
+ * @param evt Bluetooth stack event
+ * @return true if the event belonged to the throughput test
+ */
+bool losstst_tput_event(sl_bt_msg_t *evt);
+
+/**
+ * @brief Check if the throughput test connection is open
+ * 
+ * The connection may outlive the test until the peer closes it.
+ * 
+ * @return true while the connection is open
+ */
+bool losstst_tput_connected(void);
+
 /**
  * @brief Advertising sent event handler
  * 
@@ -322,10 +933,10 @@ void losstst_adv_sent_handler(uint8_t adv_handle);
  */
 void sender_finit(void);
 
-void sl_bt_scanner_process_legacy_report(const bd_addr *addr, int8_t rssi,
+void sl_bt_scanner_process_legacy_report(const bd_addr *addr, uint8_t addr_type, int8_t rssi,
                                         const uint8_t *ad_data, uint16_t ad_len);
 
-void sl_bt_scanner_process_extended_report(const bd_addr *addr, int8_t rssi,
+void sl_bt_scanner_process_extended_report(const bd_addr *addr, uint8_t addr_type, int8_t rssi,
                                          int8_t tx_power, uint8_t primary_phy,
                                          uint8_t secondary_phy,
                                          const uint8_t *ad_data, uint16_t ad_len);
@@ -0,0 +1,350 @@
+/**
+ * @file mx25.c
+ * @brief MX25 Serial NOR Flash Driver
+ *
+ * Implementation of mx25.h on the EUSART, GPIO and DMADRV drivers. Pins
+ * and the EUSART instance come from the mx25_flash_shutdown configuration.
+ */
+
+#include "mx25.h"
+#include "sl_component_catalog.h"
+#include "sl_mx25_flash_shutdown_eusart_config.h"
+#include "sl_common.h"
+#include "sl_clock_manager.h"
+#include "sl_device_peripheral.h"
+#include "sl_gpio.h"
+#include "sl_hal_eusart.h"
+#include "sl_udelay.h"
+#include "sl_sleeptimer.h"
+#include "dmadrv.h"
+#include "cmsis_os2.h"
+#if defined(SL_CATALOG_MEMLCD_EUSART_PRESENT)
+#include "sl_memlcd.h"
+#endif
+#include <stddef.h>
+#include <errno.h>
+
+/* ================== Commands ================== */
+
+#define MX25_CMD_READ           0x03
+#define MX25_CMD_PP             0x02    /* Page program */
+#define MX25_CMD_SE             0x20    /* 4 KB sector erase */
+#define MX25_CMD_WREN           0x06
+#define MX25_CMD_RDSR           0x05
+#define MX25_CMD_RDSCUR         0x2B    /* Security register: program/erase fail */
+#define MX25_CMD_RDID           0x9F
+#define MX25_CMD_RDP            0xAB    /* Release from deep power down */
+#define MX25_CMD_DP             0xB9    /* Deep power down */
+
+#define MX25_SR_WIP             0x01
+#define MX25_SCUR_P_FAIL        0x20
+#define MX25_SCUR_E_FAIL        0x40
+#define MX25_MFR_MACRONIX       0xC2
+
+#define MX25_PP_TIMEOUT_MS      10
+#define MX25_SE_TIMEOUT_MS      400
+#define MX25_DMA_TIMEOUT_MS     100
+#define MX25_T_RES1_US          35      /* Wake-up from deep power down */
+
+#define MX25_EUSART             SL_MX25_FLASH_SHUTDOWN_PERIPHERAL
+#define MX25_EUSART_NO          SL_MX25_FLASH_SHUTDOWN_PERIPHERAL_NO
+#define MX25_BUS_CLOCK          SL_CONCAT_PASTER_2(SL_BUS_CLOCK_EUSART, MX25_EUSART_NO)
+#define MX25_PERIPHERAL         SL_CONCAT_PASTER_2(SL_PERIPHERAL_EUSART, MX25_EUSART_NO)
+#define MX25_DMA_RX_SIGNAL      SL_CONCAT_PASTER_3(dmadrvPeripheralSignal_EUSART, MX25_EUSART_NO, _RXDATAV)
+#define MX25_DMA_TX_SIGNAL      SL_CONCAT_PASTER_3(dmadrvPeripheralSignal_EUSART, MX25_EUSART_NO, _TXBL)
+
+static const sl_gpio_t mx25_cs = {
+    .port = SL_MX25_FLASH_SHUTDOWN_CS_PORT,
+    .pin = SL_MX25_FLASH_SHUTDOWN_CS_PIN,
+};
+
+static uint32_t mx25_bytes;
+static unsigned int dma_rx_ch;
+static unsigned int dma_tx_ch;
+static bool dma_ready;
+
+/* ================== Bus Helpers ================== */
+
+static void mx25_cs_low(void)
+{
+    sl_gpio_clear_pin(&mx25_cs);
+}
+
+static void mx25_cs_high(void)
+{
+    sl_gpio_set_pin(&mx25_cs);
+}
+
+static uint8_t mx25_xfer(uint8_t byte)
+{
+    return (uint8_t)sl_hal_eusart_spi_tx_rx(MX25_EUSART, byte);
+}
+
+/**
+ * @brief Start a command with a 24-bit address (CS stays low)
+ */
+static void mx25_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    mx25_cs_low();
+    mx25_xfer(cmd);
+    mx25_xfer((uint8_t)(addr >> 16));
+    mx25_xfer((uint8_t)(addr >> 8));
+    mx25_xfer((uint8_t)addr);
+}
+
+/**
+ * @brief Single byte command
+ */
+static void mx25_cmd(uint8_t cmd)
+{
+    mx25_cs_low();
+    mx25_xfer(cmd);
+    mx25_cs_high();
+}
+
+/**
+ * @brief Read a one byte register
+ */
+static uint8_t mx25_read_reg(uint8_t cmd)
+{
+    uint8_t val;
+
+    mx25_cs_low();
+    mx25_xfer(cmd);
+    val = mx25_xfer(0xFF);
+    mx25_cs_high();
+    return val;
+}
+
+static uint32_t mx25_elapsed_ms(uint32_t start_tick)
+{
+    return sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count() - start_tick);
+}
+
+/**
+ * @brief Wait for the end of a program/erase and check its result
+ *
+ * @param timeout_ms Longest operation time
+ * @param yield Sleep between polls (for erases)
+ */
+static int mx25_wait_done(uint32_t timeout_ms, bool yield)
+{
+    uint32_t start = sl_sleeptimer_get_tick_count();
+
+    while (mx25_read_reg(MX25_CMD_RDSR) & MX25_SR_WIP) {
+        if (mx25_elapsed_ms(start) > timeout_ms) {
+            return -ETIMEDOUT;
+        }
+        if (yield && osKernelGetState() == osKernelRunning) {
+            osDelay(1);
+        }
+    }
+
+    if (mx25_read_reg(MX25_CMD_RDSCUR) & (MX25_SCUR_P_FAIL | MX25_SCUR_E_FAIL)) {
+        return -EIO;
+    }
+    return 0;
+}
+
+/**
+ * @brief Clock len bytes in over DMA (CS already low)
+ */
+static int mx25_dma_read(uint8_t *buf, uint32_t len)
+{
+    static uint8_t dummy = 0xFF;
+
+    /* Drop what the command bytes left in the RX FIFO */
+    while (MX25_EUSART->STATUS & EUSART_STATUS_RXFL) {
+        sl_hal_eusart_rx(MX25_EUSART);
+    }
+
+    while (len) {
+        uint32_t chunk = (len > DMADRV_MAX_XFER_COUNT) ? DMADRV_MAX_XFER_COUNT : len;
+        uint32_t start = sl_sleeptimer_get_tick_count();
+        bool done = false;
+
+        if (ECODE_EMDRV_DMADRV_OK != DMADRV_PeripheralMemory(dma_rx_ch, MX25_DMA_RX_SIGNAL, buf,
+                                                             (void *)&MX25_EUSART->RXDATA, true,
+                                                             (int)chunk, dmadrvDataSize1, NULL, NULL) ||
+            ECODE_EMDRV_DMADRV_OK != DMADRV_MemoryPeripheral(dma_tx_ch, MX25_DMA_TX_SIGNAL,
+                                                             (void *)&MX25_EUSART->TXDATA, &dummy, false,
+                                                             (int)chunk, dmadrvDataSize1, NULL, NULL)) {
+            DMADRV_StopTransfer(dma_rx_ch);
+            return -EIO;
+        }
+
+        while (!done) {
+            DMADRV_TransferDone(dma_rx_ch, &done);
+            if (!done && mx25_elapsed_ms(start) > MX25_DMA_TIMEOUT_MS) {
+                DMADRV_StopTransfer(dma_tx_ch);
+                DMADRV_StopTransfer(dma_rx_ch);
+                return -EIO;
+            }
+        }
+
+        buf += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/* ================== Public Functions ================== */
+
+void mx25_acquire(void)
+{
+    sl_hal_eusart_spi_config_t init = SL_HAL_EUSART_SPI_MASTER_INIT_DEFAULT_HF;
+    sl_hal_eusart_spi_advanced_config_t adv = SL_HAL_EUSART_SPI_ADVANCED_INIT_DEFAULT;
+    uint32_t ref_freq = 0;
+
+    sl_clock_manager_enable_bus_clock(SL_BUS_CLOCK_GPIO);
+    sl_clock_manager_enable_bus_clock(MX25_BUS_CLOCK);
+    sl_clock_manager_get_clock_branch_frequency(sl_device_peripheral_get_clock_branch(MX25_PERIPHERAL),
+                                                &ref_freq);
+
+    adv.msb_first = true;
+    adv.auto_cs_enable = false;
+    init.advanced_config = &adv;
+    init.clock_div = sl_hal_eusart_spi_calculate_clock_div(ref_freq, MX25_BAUDRATE);
+    init.clock_mode = SL_HAL_EUSART_CLOCK_MODE_0;
+
+    sl_hal_eusart_init_spi(MX25_EUSART, &init);
+    sl_hal_eusart_enable(MX25_EUSART);
+    sl_hal_eusart_enable_tx(MX25_EUSART);
+    sl_hal_eusart_enable_rx(MX25_EUSART);
+
+    sl_gpio_set_pin_mode(&(sl_gpio_t) {SL_MX25_FLASH_SHUTDOWN_TX_PORT, SL_MX25_FLASH_SHUTDOWN_TX_PIN },
+                         SL_GPIO_MODE_PUSH_PULL, 1);
+    sl_gpio_set_pin_mode(&(sl_gpio_t) {SL_MX25_FLASH_SHUTDOWN_RX_PORT, SL_MX25_FLASH_SHUTDOWN_RX_PIN },
+                         SL_GPIO_MODE_INPUT, 0);
+    sl_gpio_set_pin_mode(&(sl_gpio_t) {SL_MX25_FLASH_SHUTDOWN_SCLK_PORT, SL_MX25_FLASH_SHUTDOWN_SCLK_PIN },
+                         SL_GPIO_MODE_PUSH_PULL, 0);
+    sl_gpio_set_pin_mode(&mx25_cs, SL_GPIO_MODE_PUSH_PULL, 1);
+
+    GPIO->EUSARTROUTE[MX25_EUSART_NO].SCLKROUTE = (SL_MX25_FLASH_SHUTDOWN_SCLK_PORT << _GPIO_EUSART_SCLKROUTE_PORT_SHIFT)
+                                                  | (SL_MX25_FLASH_SHUTDOWN_SCLK_PIN << _GPIO_EUSART_SCLKROUTE_PIN_SHIFT);
+    GPIO->EUSARTROUTE[MX25_EUSART_NO].RXROUTE = (SL_MX25_FLASH_SHUTDOWN_RX_PORT << _GPIO_EUSART_RXROUTE_PORT_SHIFT)
+                                                | (SL_MX25_FLASH_SHUTDOWN_RX_PIN << _GPIO_EUSART_RXROUTE_PIN_SHIFT);
+    GPIO->EUSARTROUTE[MX25_EUSART_NO].TXROUTE = (SL_MX25_FLASH_SHUTDOWN_TX_PORT << _GPIO_EUSART_TXROUTE_PORT_SHIFT)
+                                                | (SL_MX25_FLASH_SHUTDOWN_TX_PIN << _GPIO_EUSART_TXROUTE_PIN_SHIFT);
+    GPIO->EUSARTROUTE[MX25_EUSART_NO].ROUTEEN = GPIO_EUSART_ROUTEEN_RXPEN | GPIO_EUSART_ROUTEEN_TXPEN
+                                                | GPIO_EUSART_ROUTEEN_SCLKPEN;
+
+    /* The shutdown component left the flash in deep power down */
+    mx25_cmd(MX25_CMD_RDP);
+    sl_udelay_wait(MX25_T_RES1_US);
+}
+
+void mx25_release(void)
+{
+    mx25_cmd(MX25_CMD_DP);
+
+    GPIO->EUSARTROUTE[MX25_EUSART_NO].ROUTEEN &= ~GPIO_EUSART_ROUTEEN_RXPEN;
+    sl_gpio_set_pin_mode(&(sl_gpio_t) {SL_MX25_FLASH_SHUTDOWN_RX_PORT, SL_MX25_FLASH_SHUTDOWN_RX_PIN },
+                         SL_GPIO_MODE_DISABLED, 0);
+
+#if defined(SL_CATALOG_MEMLCD_EUSART_PRESENT)
+    /* Restore the LCD bit rate on the shared EUSART */
+    const sl_memlcd_t *lcd = sl_memlcd_get();
+    if (lcd != NULL) {
+        sl_memlcd_refresh(lcd);
+    }
+#endif
+}
+
+int mx25_init(void)
+{
+    uint8_t id[3];
+    Ecode_t ecode;
+
+    if (mx25_bytes) {
+        return 0;
+    }
+
+    mx25_acquire();
+    mx25_cs_low();
+    mx25_xfer(MX25_CMD_RDID);
+    for (uint8_t i = 0; i < sizeof(id); i++) {
+        id[i] = mx25_xfer(0xFF);
+    }
+    mx25_cs_high();
+    mx25_release();
+
+    /* Manufacturer, memory type, capacity (2^n bytes) */
+    if (MX25_MFR_MACRONIX != id[0] || id[2] < 16 || id[2] > 26) {
+        return -ENODEV;
+    }
+
+    ecode = DMADRV_Init();
+    if (ECODE_EMDRV_DMADRV_OK != ecode && ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED != ecode) {
+        return -EBUSY;
+    }
+    if (ECODE_EMDRV_DMADRV_OK != DMADRV_AllocateChannel(&dma_rx_ch, NULL)) {
+        return -EBUSY;
+    }
+    if (ECODE_EMDRV_DMADRV_OK != DMADRV_AllocateChannel(&dma_tx_ch, NULL)) {
+        DMADRV_FreeChannel(dma_rx_ch);
+        return -EBUSY;
+    }
+
+    dma_ready = true;
+    mx25_bytes = 1UL << id[2];
+    return 0;
+}
+
+uint32_t mx25_size(void)
+{
+    return mx25_bytes;
+}
+
+int mx25_read(uint32_t addr, void *buf, uint32_t len)
+{
+    uint8_t *p = buf;
+    int err = 0;
+
+    if (buf == NULL || addr >= mx25_bytes || len > mx25_bytes - addr) {
+        return -EINVAL;
+    }
+
+    mx25_cmd_addr(MX25_CMD_READ, addr);
+    if (len >= MX25_DMA_MIN_LEN && dma_ready) {
+        err = mx25_dma_read(p, len);
+    } else {
+        for (uint32_t i = 0; i < len; i++) {
+            p[i] = mx25_xfer(0xFF);
+        }
+    }
+    mx25_cs_high();
+    return err;
+}
+
+int mx25_program(uint32_t addr, const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+
+    if (data == NULL || 0 == len || addr >= mx25_bytes || len > mx25_bytes - addr ||
+        addr / MX25_PAGE_SIZE != (addr + len - 1) / MX25_PAGE_SIZE) {
+        return -EINVAL;
+    }
+
+    mx25_cmd(MX25_CMD_WREN);
+    mx25_cmd_addr(MX25_CMD_PP, addr);
+    for (uint32_t i = 0; i < len; i++) {
+        mx25_xfer(p[i]);
+    }
+    mx25_cs_high();
+
+    return mx25_wait_done(MX25_PP_TIMEOUT_MS, false);
+}
+
+int mx25_erase(uint32_t addr)
+{
+    if (addr >= mx25_bytes) {
+        return -EINVAL;
+    }
+
+    mx25_cmd(MX25_CMD_WREN);
+    mx25_cmd_addr(MX25_CMD_SE, addr & ~(uint32_t)(MX25_SECTOR_SIZE - 1));
+    mx25_cs_high();
+
+    return mx25_wait_done(MX25_SE_TIMEOUT_MS, true);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file mx25.h
+ * @brief MX25 Serial NOR Flash Driver
+ *
+ * Drives the board's MX25 SPI flash on the EUSART that the
+ * mx25_flash_shutdown component configures (config/
+ * sl_mx25_flash_shutdown_eusart_config.h). That EUSART is shared with the
+ * memory LCD, so flash access is bracketed by mx25_acquire() and
+ * mx25_release(): acquire sets the bus up for the flash and wakes it from
+ * deep power down, release puts the flash back to deep power down and
+ * hands the bus back to the LCD driver.
+ *
+ * Features:
+ * - Reads of any length, bursts over EUSART DMA (DMADRV)
+ * - Page program and 4 KB sector erase with program/erase fail check
+ * - Capacity from the JEDEC ID
+ *
+ * @note Not thread safe; call from the application task only, like the
+ *       LCD functions
+ */
+
+#ifndef MX25_H
+#define MX25_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MX25_PAGE_SIZE          256
+#define MX25_SECTOR_SIZE        4096
+#define MX25_BAUDRATE           8000000     /* Read (0x03) is specified up to 33 MHz */
+#define MX25_DMA_MIN_LEN        16          /* Shorter reads go byte by byte */
+
+/**
+ * @brief Detect the flash and allocate the DMA channels
+ *
+ * Leaves the flash in deep power down.
+ *
+ * @return 0 on success, -ENODEV if no MX25 answers,
+ *         -EBUSY if no DMA channel is free
+ */
+int mx25_init(void);
+
+/**
+ * @brief Flash capacity
+ *
+ * @return Size in bytes, 0 before a successful mx25_init()
+ */
+uint32_t mx25_size(void);
+
+/**
+ * @brief Take the bus and wake the flash
+ */
+void mx25_acquire(void);
+
+/**
+ * @brief Power the flash down and return the bus to the LCD
+ */
+void mx25_release(void);
+
+/**
+ * @brief Read
+ *
+ * @param addr Flash address
+ * @param buf Destination
+ * @param len Length
+ * @return 0 on success, -EINVAL on invalid argument, -EIO on DMA error
+ */
+int mx25_read(uint32_t addr, void *buf, uint32_t len);
+
+/**
+ * @brief Program within one page
+ *
+ * @param addr Flash address
+ * @param data Data
+ * @param len Length (addr..addr+len-1 in one page)
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -ETIMEDOUT if the flash stays busy, -EIO on program failure
+ */
+int mx25_program(uint32_t addr, const void *data, uint32_t len);
+
+/**
+ * @brief Erase one 4 KB sector
+ *
+ * @param addr Address in the sector
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -ETIMEDOUT if the flash stays busy, -EIO on erase failure
+ */
+int mx25_erase(uint32_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MX25_H
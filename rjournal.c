@@ -0,0 +1,93 @@
+/**
+ * @file rjournal.c
+ * @brief Retained RAM Journal
+ *
+ * Implementation of rjournal.h. The CRC is the one of the result store
+ * (rstore_crc32()); the magic is written last, so a slot is only taken
+ * as valid once its CRC is in place.
+ */
+
+#include "rjournal.h"
+#include "rstore.h"
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#define RJOURNAL_MAGIC          0x4C4E524Au     /* "JRNL" */
+
+static uint32_t slot_crc(const rjournal_slot_t *s)
+{
+    return rstore_crc32(0, &s->seq, offsetof(rjournal_slot_t, crc) - offsetof(rjournal_slot_t, seq));
+}
+
+static bool slot_valid(const rjournal_slot_t *s)
+{
+    return RJOURNAL_MAGIC == s->magic && s->len <= RJOURNAL_MAX_DATA && slot_crc(s) == s->crc;
+}
+
+/**
+ * @brief Index of the newest valid slot, -1 if none
+ */
+static int slot_newest(const rjournal_t *j)
+{
+    bool v0 = slot_valid(&j->slot[0]);
+    bool v1 = slot_valid(&j->slot[1]);
+
+    if (v0 && v1) {
+        return ((int32_t)(j->slot[1].seq - j->slot[0].seq) > 0) ? 1 : 0;
+    }
+    return v0 ? 0 : (v1 ? 1 : -1);
+}
+
+void rjournal_clear(rjournal_t *j)
+{
+    if (j == NULL) {
+        return;
+    }
+
+    j->slot[0].magic = 0;
+    j->slot[1].magic = 0;
+}
+
+int rjournal_write(rjournal_t *j, const void *data, uint16_t len)
+{
+    int newest;
+    rjournal_slot_t *s;
+
+    if (j == NULL || (data == NULL && len) || len > RJOURNAL_MAX_DATA) {
+        return -EINVAL;
+    }
+
+    newest = slot_newest(j);
+    s = &j->slot[(0 == newest) ? 1 : 0];
+    s->magic = 0;
+    s->seq = (newest < 0) ? 1 : j->slot[newest].seq + 1;
+    s->len = len;
+    s->reserved = 0;
+    if (len) {
+        memcpy(s->data, data, len);
+    }
+    memset(&s->data[len], 0, RJOURNAL_MAX_DATA - len);
+    s->crc = slot_crc(s);
+    s->magic = RJOURNAL_MAGIC;
+    return 0;
+}
+
+int rjournal_read(const rjournal_t *j, void *data, uint16_t size)
+{
+    int newest;
+
+    if (j == NULL || data == NULL) {
+        return -EINVAL;
+    }
+
+    newest = slot_newest(j);
+    if (newest < 0) {
+        return -ENOENT;
+    }
+    if (j->slot[newest].len > size) {
+        return -ENOSPC;
+    }
+    memcpy(data, j->slot[newest].data, j->slot[newest].len);
+    return j->slot[newest].len;
+}
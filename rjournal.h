@@ -0,0 +1,86 @@
+/**
+ * @file rjournal.h
+ * @brief Retained RAM Journal
+ *
+ * Keeps the latest copy of a small record in RAM that survives a reset
+ * (the .noinit section is not cleared by the startup code). Meant for
+ * state that changes too often for flash: the record is rewritten in RAM
+ * every time and only committed to flash after a reset.
+ *
+ * Two slots take the writes in turn, each with a sequence number and a
+ * CRC over the sequence number, length and data. A reset in the middle of
+ * a write leaves that slot with a bad CRC, and the other slot still holds
+ * the previous copy. RAM that lost its contents (power-on, deep brown-out)
+ * fails the magic or the CRC, so no slot is valid.
+ *
+ * @note No Bluetooth stack dependency, so torn writes can be simulated by
+ *       stopping a write at any byte on a host build
+ */
+
+#ifndef RJOURNAL_H
+#define RJOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RJOURNAL_MAX_DATA       128     /* Largest record (multiple of 4) */
+
+/**
+ * @brief One copy of the record
+ */
+typedef struct {
+    uint32_t magic;             /**< RJOURNAL_MAGIC when written */
+    uint32_t seq;               /**< Write sequence number */
+    uint16_t len;               /**< Data length */
+    uint16_t reserved;
+    uint8_t data[RJOURNAL_MAX_DATA];
+    uint32_t crc;               /**< CRC-32 of seq, len, reserved and data */
+} rjournal_slot_t;
+
+/**
+ * @brief Journal (place in a section that is not cleared at reset)
+ */
+typedef struct {
+    rjournal_slot_t slot[2];
+} rjournal_t;
+
+/**
+ * @brief Drop the record
+ *
+ * @param j Journal
+ */
+void rjournal_clear(rjournal_t *j);
+
+/**
+ * @brief Write a new copy of the record
+ *
+ * Overwrites the older slot; the newer one stays valid until this write
+ * is complete.
+ *
+ * @param j Journal
+ * @param data Record
+ * @param len Record length (<= RJOURNAL_MAX_DATA)
+ * @return 0 on success, -EINVAL on invalid argument
+ */
+int rjournal_write(rjournal_t *j, const void *data, uint16_t len);
+
+/**
+ * @brief Read the newest valid copy of the record
+ *
+ * @param j Journal
+ * @param data Record
+ * @param size Size of data
+ * @return Record length, -EINVAL on invalid argument, -ENOENT if no slot
+ *         is valid, -ENOSPC if the record does not fit data
+ */
+int rjournal_read(const rjournal_t *j, void *data, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RJOURNAL_H
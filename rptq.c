@@ -0,0 +1,103 @@
+/**
+ * @file rptq.c
+ * @brief Advertising Report Queue Monitor
+ *
+ * Implementation of rptq.h. Times are 32-bit microseconds and differences
+ * are taken unsigned, so a wrapping clock is handled.
+ */
+
+#include "rptq.h"
+#include <string.h>
+
+/**
+ * @brief Host loss of a run for one stream
+ */
+static uint32_t rptq_run_lost(const rptq_mon_t *m, uint8_t stream)
+{
+    uint32_t expected;
+
+    if (m->run < m->depth || 0 == m->period_us[stream]) {
+        return 0;
+    }
+
+    expected = m->stall_us / m->period_us[stream];
+    return (expected > m->run_cnt[stream]) ? expected - m->run_cnt[stream] : 0;
+}
+
+/**
+ * @brief Close the open run
+ */
+static void rptq_run_close(rptq_mon_t *m)
+{
+    if (m->run >= 2) {
+        m->drains++;
+    }
+    if (m->run >= m->depth) {
+        m->sat_drains++;
+        for (uint8_t s = 0; s < RPTQ_MAX_STREAMS; s++) {
+            m->host_lost[s] += rptq_run_lost(m, s);
+        }
+    }
+    if (m->run > m->max_run) {
+        m->max_run = m->run;
+    }
+}
+
+void rptq_mon_init(rptq_mon_t *m, uint8_t depth, uint32_t drain_gap_us)
+{
+    if (m == NULL) {
+        return;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->depth = (0 == depth) ? 1 : depth;
+    m->drain_gap_us = drain_gap_us;
+}
+
+void rptq_mon_period(rptq_mon_t *m, uint8_t stream, uint32_t period_us)
+{
+    if (m == NULL || stream >= RPTQ_MAX_STREAMS) {
+        return;
+    }
+
+    m->period_us[stream] = period_us;
+}
+
+void rptq_mon_report(rptq_mon_t *m, int8_t stream, uint32_t now_us)
+{
+    uint32_t gap;
+
+    if (m == NULL) {
+        return;
+    }
+
+    gap = now_us - m->last_us;
+    if (!m->started || gap >= m->drain_gap_us) {
+        /* Spaced delivery: a new run starts after this gap */
+        if (m->started) {
+            rptq_run_close(m);
+        }
+        m->stall_us = m->started ? gap : 0;
+        m->started = true;
+        m->run = 0;
+        memset(m->run_cnt, 0, sizeof(m->run_cnt));
+    }
+
+    m->last_us = now_us;
+    m->reports++;
+    if (m->run < UINT16_MAX) {
+        m->run++;
+    }
+    if (0 <= stream && stream < RPTQ_MAX_STREAMS && m->run_cnt[stream] < UINT16_MAX) {
+        m->run_cnt[stream]++;
+    }
+}
+
+uint32_t rptq_mon_host_lost(const rptq_mon_t *m, uint8_t stream)
+{
+    if (m == NULL || stream >= RPTQ_MAX_STREAMS) {
+        return 0;
+    }
+
+    return m->host_lost[stream] + (m->started ? rptq_run_lost(m, stream) : 0);
+}
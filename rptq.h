@@ -0,0 +1,100 @@
+/**
+ * @file rptq.h
+ * @brief Advertising Report Queue Monitor
+ *
+ * The controller queues at most SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS
+ * reports and drops further ones while the host does not consume them.
+ * Such drops look like radio loss to the scanner. This module watches the
+ * delivery times of all reports to tell the two apart.
+ *
+ * A host stall shows up as a gap in the delivery followed by a drain: the
+ * queued reports arrive back-to-back. A drain of at least the queue depth
+ * means the queue ran full, so reports were dropped. For every burst
+ * stream the packets expected during the stall (stall time / event
+ * period) minus those found in the drain count as host loss. Drains
+ * shorter than the queue depth dropped nothing.
+ *
+ * Features:
+ * - Drain detection over all reports, including foreign advertisers
+ * - Per stream host loss estimate from the expected event period
+ * - Drain statistics (count, saturated count, longest drain)
+ *
+ * @note No Bluetooth stack dependency, so the classifier can be fed from
+ *       recorded traces on a host build as well
+ */
+
+#ifndef RPTQ_H
+#define RPTQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RPTQ_MAX_STREAMS        4
+#define RPTQ_DRAIN_GAP_US       2000    /* Deliveries closer than this belong to a drain */
+
+/**
+ * @brief Report queue monitor state
+ */
+typedef struct {
+    uint8_t depth;                              /**< Controller queue depth */
+    uint32_t drain_gap_us;                      /**< Spacing of back-to-back deliveries */
+    bool started;                               /**< A report was seen */
+    uint32_t last_us;                           /**< Last delivery */
+    uint32_t stall_us;                          /**< Delivery gap before the open run */
+    uint16_t run;                               /**< Deliveries in the open run */
+    uint16_t run_cnt[RPTQ_MAX_STREAMS];         /**< Stream deliveries in the open run */
+    uint32_t period_us[RPTQ_MAX_STREAMS];       /**< Expected event period (0 = idle) */
+    uint32_t host_lost[RPTQ_MAX_STREAMS];       /**< Host loss of closed runs */
+    uint32_t reports;                           /**< Reports delivered */
+    uint32_t drains;                            /**< Runs of at least 2 deliveries */
+    uint32_t sat_drains;                        /**< Runs that reached the queue depth */
+    uint16_t max_run;                           /**< Longest run */
+} rptq_mon_t;
+
+/**
+ * @brief Reset the monitor
+ *
+ * @param m Monitor state
+ * @param depth Controller queue depth (SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS)
+ * @param drain_gap_us Max spacing of deliveries within a drain
+ */
+void rptq_mon_init(rptq_mon_t *m, uint8_t depth, uint32_t drain_gap_us);
+
+/**
+ * @brief Set the expected event period of a stream
+ *
+ * @param m Monitor state
+ * @param stream Stream index (< RPTQ_MAX_STREAMS)
+ * @param period_us Mean event spacing, 0 while the stream is not bursting
+ */
+void rptq_mon_period(rptq_mon_t *m, uint8_t stream, uint32_t period_us);
+
+/**
+ * @brief Account one delivered report
+ *
+ * @param m Monitor state
+ * @param stream Stream index, negative for reports of other advertisers
+ * @param now_us Delivery time (us, wraps at 2^32)
+ */
+void rptq_mon_report(rptq_mon_t *m, int8_t stream, uint32_t now_us);
+
+/**
+ * @brief Estimated host loss of a stream
+ *
+ * Includes the open run, so it can be read at any time.
+ *
+ * @param m Monitor state
+ * @param stream Stream index
+ * @return Reports of the stream dropped in the controller queue
+ */
+uint32_t rptq_mon_host_lost(const rptq_mon_t *m, uint8_t stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RPTQ_H
@@ -0,0 +1,443 @@
+/**
+ * @file rstore.c
+ * @brief Log-Structured Result Store
+ *
+ * Implementation of rstore.h. On-flash structures are little-endian and
+ * 4-byte aligned; every CRC covers the fields in front of it.
+ */
+
+#include "rstore.h"
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#define RSTORE_SECTOR_MAGIC     0x52534C47u     /* "GLSR" */
+#define RSTORE_REC_MAGIC        0xA5
+#define RSTORE_SCAN_CHUNK       64              /* Stack buffer for CRC checks */
+
+/* ================== On-Flash Layout ================== */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t erase_cnt;
+    uint32_t crc;
+} rstore_shdr_t;
+
+typedef struct {
+    uint32_t round_lo;
+    uint32_t round_hi;
+    uint32_t count;
+    uint32_t crc;
+} rstore_seal_t;
+
+typedef struct {
+    uint32_t round;
+    uint32_t crc;               /* Data CRC */
+    uint16_t len;
+    uint8_t type;
+    uint8_t magic;
+    uint32_t hcrc;
+} rstore_rhdr_t;
+
+_Static_assert(sizeof(rstore_shdr_t) + sizeof(rstore_seal_t) == RSTORE_HDR_SIZE, "sector header size");
+_Static_assert(sizeof(rstore_rhdr_t) == RSTORE_REC_HDR_SIZE, "record header size");
+
+/* ================== Helpers ================== */
+
+uint32_t rstore_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    static const uint32_t nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t *p = data;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static uint32_t rstore_addr(const rstore_t *st, uint16_t sector, uint16_t off)
+{
+    return st->flash->base + (uint32_t)sector * RSTORE_SECTOR_SIZE + off;
+}
+
+static uint16_t rstore_rec_size(uint16_t len)
+{
+    return (uint16_t)(RSTORE_REC_HDR_SIZE + ((len + 3u) & ~3u));
+}
+
+static bool rstore_blank(const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+
+    while (len--) {
+        if (*p++ != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Program in page sized pieces
+ */
+static int rstore_program(const rstore_t *st, uint32_t addr, const void *data, uint32_t len)
+{
+    const uint8_t *p = data;
+
+    while (len) {
+        uint32_t chunk = RSTORE_PAGE_SIZE - (addr % RSTORE_PAGE_SIZE);
+        int err;
+
+        if (chunk > len) {
+            chunk = len;
+        }
+        err = st->flash->program(st->flash->ctx, addr, p, chunk);
+        if (err) {
+            return err;
+        }
+        addr += chunk;
+        p += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read a record header
+ *
+ * @return 1 if valid, 0 if erased (end of the log), -EILSEQ if torn,
+ *         or the flash error
+ */
+static int rstore_read_rhdr(const rstore_t *st, uint16_t sector, uint16_t off, rstore_rhdr_t *rh)
+{
+    int err;
+
+    if (off + RSTORE_REC_HDR_SIZE > RSTORE_SECTOR_SIZE) {
+        return 0;
+    }
+    err = st->flash->read(st->flash->ctx, rstore_addr(st, sector, off), rh, sizeof(*rh));
+    if (err) {
+        return err;
+    }
+    if (rstore_blank(rh, sizeof(*rh))) {
+        return 0;
+    }
+    if (RSTORE_REC_MAGIC != rh->magic || 0xFF == rh->type ||
+        rh->hcrc != rstore_crc32(0, rh, offsetof(rstore_rhdr_t, hcrc)) ||
+        rh->len > RSTORE_MAX_DATA || off + rstore_rec_size(rh->len) > RSTORE_SECTOR_SIZE) {
+        return -EILSEQ;
+    }
+    return 1;
+}
+
+/**
+ * @brief Rebuild the index entry of a sector without seal
+ *
+ * @param end Offset after the last record, RSTORE_SECTOR_SIZE if torn
+ * @param count Records found
+ */
+static int rstore_scan(rstore_t *st, uint16_t sector, uint16_t *end, uint16_t *count)
+{
+    rstore_sector_t *idx = &st->index[sector];
+    uint16_t off = RSTORE_HDR_SIZE;
+    rstore_rhdr_t rh;
+    int ret;
+
+    *count = 0;
+    while ((ret = rstore_read_rhdr(st, sector, off, &rh)) > 0) {
+        idx->round_lo = (rh.round < idx->round_lo) ? rh.round : idx->round_lo;
+        idx->round_hi = (rh.round > idx->round_hi) ? rh.round : idx->round_hi;
+        (*count)++;
+        off += rstore_rec_size(rh.len);
+    }
+    if (-EILSEQ == ret) {
+        /* Torn header: the rest of the sector is lost */
+        st->skipped++;
+        off = RSTORE_SECTOR_SIZE;
+    } else if (ret < 0) {
+        return ret;
+    }
+    *end = off;
+    return 0;
+}
+
+/**
+ * @brief Seal the head sector and open the next one
+ */
+static int rstore_open(rstore_t *st)
+{
+    const rstore_flash_t *f = st->flash;
+
+    if (st->index[st->head].seq != 0 && st->head_count > 0) {
+        rstore_seal_t seal = {
+            .round_lo = st->index[st->head].round_lo,
+            .round_hi = st->index[st->head].round_hi,
+            .count = st->head_count,
+        };
+        seal.crc = rstore_crc32(0, &seal, offsetof(rstore_seal_t, crc));
+        /* A lost seal only costs a scan at the next mount */
+        (void)rstore_program(st, rstore_addr(st, st->head, sizeof(rstore_shdr_t)), &seal, sizeof(seal));
+    }
+
+    /* Next sector of the ring; a sector that fails erase or program is skipped */
+    for (uint16_t i = 1; i <= f->sectors; i++) {
+        uint16_t s = (uint16_t)((st->head + i) % f->sectors);
+        rstore_shdr_t sh;
+        uint32_t erase_cnt = st->erase_max;
+        int err;
+
+        err = f->read(f->ctx, rstore_addr(st, s, 0), &sh, sizeof(sh));
+        if (0 == err && RSTORE_SECTOR_MAGIC == sh.magic &&
+            sh.crc == rstore_crc32(0, &sh, offsetof(rstore_shdr_t, crc))) {
+            erase_cnt = sh.erase_cnt;
+        }
+
+        st->index[s].seq = 0;
+        if (f->erase(f->ctx, rstore_addr(st, s, 0))) {
+            continue;
+        }
+
+        sh.magic = RSTORE_SECTOR_MAGIC;
+        sh.seq = st->next_seq;
+        sh.erase_cnt = erase_cnt + 1;
+        sh.crc = rstore_crc32(0, &sh, offsetof(rstore_shdr_t, crc));
+        if (rstore_program(st, rstore_addr(st, s, 0), &sh, sizeof(sh))) {
+            continue;
+        }
+
+        st->index[s].seq = st->next_seq++;
+        st->index[s].round_lo = UINT32_MAX;
+        st->index[s].round_hi = 0;
+        st->erase_max = (sh.erase_cnt > st->erase_max) ? sh.erase_cnt : st->erase_max;
+        st->head = s;
+        st->head_off = RSTORE_HDR_SIZE;
+        st->head_count = 0;
+        return 0;
+    }
+    return -EIO;
+}
+
+/* ================== Public Functions ================== */
+
+int rstore_mount(rstore_t *st, const rstore_flash_t *flash, rstore_sector_t *index)
+{
+    uint32_t seq_max = 0;
+    uint16_t end, count;
+    int err;
+
+    if (st == NULL || flash == NULL || index == NULL || flash->sectors < 2 ||
+        flash->read == NULL || flash->program == NULL || flash->erase == NULL ||
+        flash->base % RSTORE_SECTOR_SIZE) {
+        return -EINVAL;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->flash = flash;
+    st->index = index;
+    st->head = flash->sectors - 1;
+    st->head_off = RSTORE_SECTOR_SIZE;      /* No open sector */
+
+    for (uint16_t s = 0; s < flash->sectors; s++) {
+        struct {
+            rstore_shdr_t sh;
+            rstore_seal_t seal;
+        } hdr;
+
+        index[s].seq = 0;
+        index[s].round_lo = UINT32_MAX;
+        index[s].round_hi = 0;
+
+        err = flash->read(flash->ctx, rstore_addr(st, s, 0), &hdr, sizeof(hdr));
+        if (err) {
+            return err;
+        }
+        if (RSTORE_SECTOR_MAGIC != hdr.sh.magic || 0 == hdr.sh.seq ||
+            hdr.sh.crc != rstore_crc32(0, &hdr.sh, offsetof(rstore_shdr_t, crc))) {
+            continue;
+        }
+
+        index[s].seq = hdr.sh.seq;
+        st->erase_max = (hdr.sh.erase_cnt > st->erase_max) ? hdr.sh.erase_cnt : st->erase_max;
+        if (hdr.sh.seq > seq_max) {
+            seq_max = hdr.sh.seq;
+            st->head = s;
+        }
+
+        if (hdr.seal.crc == rstore_crc32(0, &hdr.seal, offsetof(rstore_seal_t, crc))) {
+            index[s].round_lo = hdr.seal.round_lo;
+            index[s].round_hi = hdr.seal.round_hi;
+        } else if (!rstore_blank(&hdr.seal, sizeof(hdr.seal))) {
+            st->skipped++;                  /* Torn seal */
+        }
+    }
+
+    /* Unsealed sectors: the head, or a seal lost on power failure */
+    for (uint16_t s = 0; s < flash->sectors; s++) {
+        if (0 == index[s].seq || index[s].round_lo <= index[s].round_hi) {
+            continue;
+        }
+        err = rstore_scan(st, s, &end, &count);
+        if (err) {
+            return err;
+        }
+        if (s == st->head) {
+            st->head_off = end;
+            st->head_count = count;
+        }
+    }
+
+    for (uint16_t s = 0; s < flash->sectors; s++) {
+        if (index[s].seq != 0 && index[s].round_lo <= index[s].round_hi &&
+            index[s].round_hi > st->last_round) {
+            st->last_round = index[s].round_hi;
+        }
+    }
+
+    st->next_seq = seq_max + 1;
+    st->mounted = true;
+    return 0;
+}
+
+int rstore_format(rstore_t *st)
+{
+    int err;
+
+    if (st == NULL || !st->mounted) {
+        return -EINVAL;
+    }
+
+    for (uint16_t s = 0; s < st->flash->sectors; s++) {
+        st->index[s].seq = 0;
+        err = st->flash->erase(st->flash->ctx, rstore_addr(st, s, 0));
+        if (err) {
+            return err;
+        }
+    }
+    return rstore_mount(st, st->flash, st->index);
+}
+
+int rstore_append(rstore_t *st, uint8_t type, uint32_t round, const void *data, uint16_t len)
+{
+    rstore_sector_t *idx;
+    rstore_rhdr_t rh;
+    uint32_t addr;
+    int err;
+
+    if (st == NULL || !st->mounted || 0 == type || 0xFF == type ||
+        len > RSTORE_MAX_DATA || (data == NULL && len)) {
+        return -EINVAL;
+    }
+
+    if (st->head_off + rstore_rec_size(len) > RSTORE_SECTOR_SIZE) {
+        err = rstore_open(st);
+        if (err) {
+            return err;
+        }
+    }
+
+    rh.round = round;
+    rh.crc = rstore_crc32(0, data, len);
+    rh.len = len;
+    rh.type = type;
+    rh.magic = RSTORE_REC_MAGIC;
+    rh.hcrc = rstore_crc32(0, &rh, offsetof(rstore_rhdr_t, hcrc));
+
+    /* Header before data: a torn data write is caught by the data CRC */
+    addr = rstore_addr(st, st->head, st->head_off);
+    err = rstore_program(st, addr, &rh, sizeof(rh));
+    if (0 == err) {
+        err = rstore_program(st, addr + sizeof(rh), data, len);
+    }
+    if (err) {
+        st->head_off = RSTORE_SECTOR_SIZE;  /* Give up the sector */
+        return err;
+    }
+
+    idx = &st->index[st->head];
+    idx->round_lo = (round < idx->round_lo) ? round : idx->round_lo;
+    idx->round_hi = (round > idx->round_hi) ? round : idx->round_hi;
+    st->head_off += rstore_rec_size(len);
+    st->head_count++;
+    st->last_round = round;
+    st->records++;
+    return 0;
+}
+
+int rstore_query(rstore_t *st, uint32_t round_lo, uint32_t round_hi,
+                 void *buf, uint16_t buf_len, rstore_cb_t cb, void *ctx)
+{
+    const rstore_flash_t *f;
+    int visited = 0;
+
+    if (st == NULL || !st->mounted || cb == NULL || (buf == NULL && buf_len)) {
+        return -EINVAL;
+    }
+    f = st->flash;
+
+    /* Ring order after the head is sequence order */
+    for (uint16_t i = 1; i <= f->sectors; i++) {
+        uint16_t s = (uint16_t)((st->head + i) % f->sectors);
+        const rstore_sector_t *idx = &st->index[s];
+        uint16_t off = RSTORE_HDR_SIZE;
+        rstore_rhdr_t rh;
+        int ret;
+
+        if (0 == idx->seq || idx->round_hi < round_lo || idx->round_lo > round_hi) {
+            continue;
+        }
+
+        while ((ret = rstore_read_rhdr(st, s, off, &rh)) > 0) {
+            rstore_rec_t rec = {
+                .type = rh.type,
+                .len = rh.len,
+                .round = rh.round,
+                .addr = rstore_addr(st, s, off + RSTORE_REC_HDR_SIZE),
+            };
+            uint32_t crc = 0;
+            int err;
+
+            off += rstore_rec_size(rh.len);
+            if (rh.round < round_lo || rh.round > round_hi) {
+                continue;
+            }
+
+            /* Whole record into buf, or a CRC check in pieces */
+            if (rh.len <= buf_len) {
+                err = f->read(f->ctx, rec.addr, buf, rh.len);
+                crc = rstore_crc32(0, buf, rh.len);
+            } else {
+                uint8_t chunk[RSTORE_SCAN_CHUNK];
+
+                err = 0;
+                for (uint16_t pos = 0; pos < rh.len && 0 == err; pos += RSTORE_SCAN_CHUNK) {
+                    uint16_t n = (rh.len - pos < RSTORE_SCAN_CHUNK) ? rh.len - pos : RSTORE_SCAN_CHUNK;
+
+                    err = f->read(f->ctx, rec.addr + pos, chunk, n);
+                    crc = rstore_crc32(crc, chunk, n);
+                }
+            }
+            if (err) {
+                return err;
+            }
+            if (crc != rh.crc) {
+                continue;                   /* Torn data */
+            }
+
+            visited++;
+            if (!cb(ctx, &rec, (rh.len <= buf_len) ? buf : NULL)) {
+                return visited;
+            }
+        }
+        if (ret < 0 && ret != -EILSEQ) {
+            return ret;
+        }
+    }
+    return visited;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file rstore.h
+ * @brief Log-Structured Result Store
+ *
+ * Append-only record log on NOR flash with 4 KB erase sectors and 256 byte
+ * program pages. Sectors are used as a ring: the head sector takes new
+ * records, and when the ring is full the oldest sector is erased for the
+ * next one. Every sector is erased once per lap, so wear is level without
+ * moving data.
+ *
+ * Sector layout:
+ * - Header (16 bytes): magic, sequence number, erase count, CRC
+ * - Seal (16 bytes): round range and record count, programmed when the
+ *   sector is full; left erased in the head sector
+ * - Records: 16 byte header (magic, type, length, round id, header CRC,
+ *   data CRC) and data, padded to 4 bytes
+ *
+ * Power-fail safety: a record header is programmed before its data, so a
+ * torn data write fails the data CRC and the record is skipped on read. A
+ * torn header or sector header fails its own CRC; the rest of that sector
+ * is given up and the next append opens a new sector. Mount finds the
+ * head from the sector sequence numbers and scans only the head sector
+ * (and sectors that lost their seal).
+ *
+ * The RAM index keeps the round range of every sector, so a range query
+ * reads only the sectors that overlap.
+ *
+ * @note No Bluetooth stack dependency; flash access goes through
+ *       rstore_flash_t, so the store runs on a file-backed flash model
+ *       on a host build as well
+ */
+
+#ifndef RSTORE_H
+#define RSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RSTORE_SECTOR_SIZE      4096
+#define RSTORE_PAGE_SIZE        256
+#define RSTORE_HDR_SIZE         32      /* Sector header and seal */
+#define RSTORE_REC_HDR_SIZE     16
+#define RSTORE_MAX_DATA         (RSTORE_SECTOR_SIZE - RSTORE_HDR_SIZE - RSTORE_REC_HDR_SIZE)
+
+/* Record types */
+#define RSTORE_TYPE_RESULT      1       /* Round result */
+#define RSTORE_TYPE_TRACE       2       /* Per-packet trace of a round */
+
+/**
+ * @brief Flash access
+ *
+ * All functions return 0 on success or a negative errno.
+ */
+typedef struct {
+    int (*read)(void *ctx, uint32_t addr, void *buf, uint32_t len);
+    int (*program)(void *ctx, uint32_t addr, const void *buf, uint32_t len); /**< Within one page */
+    int (*erase)(void *ctx, uint32_t addr);                                  /**< One sector */
+    void *ctx;                                  /**< Passed to the functions */
+    uint32_t base;                              /**< Store start (sector aligned) */
+    uint16_t sectors;                           /**< Store size in sectors (>= 2) */
+} rstore_flash_t;
+
+/**
+ * @brief Index entry of one sector
+ */
+typedef struct {
+    uint32_t seq;                               /**< Sequence number (0 = free) */
+    uint32_t round_lo;                          /**< Lowest round id */
+    uint32_t round_hi;                          /**< Highest round id */
+} rstore_sector_t;
+
+/**
+ * @brief Store state
+ */
+typedef struct {
+    const rstore_flash_t *flash;
+    rstore_sector_t *index;                     /**< One entry per sector */
+    uint16_t head;                              /**< Head sector */
+    uint16_t head_off;                          /**< Next record offset in the head sector */
+    uint16_t head_count;                        /**< Records in the head sector */
+    bool mounted;
+    uint32_t next_seq;                          /**< Sequence number of the next sector */
+    uint32_t erase_max;                         /**< Highest erase count seen */
+    uint32_t last_round;                        /**< Round id of the last record */
+    uint32_t records;                           /**< Records appended since mount */
+    uint32_t skipped;                           /**< Torn records and sectors found */
+} rstore_t;
+
+/**
+ * @brief Record seen by a query
+ */
+typedef struct {
+    uint8_t type;                               /**< RSTORE_TYPE_* */
+    uint16_t len;                               /**< Data length */
+    uint32_t round;                             /**< Round id */
+    uint32_t addr;                              /**< Flash address of the data */
+} rstore_rec_t;
+
+/**
+ * @brief Query callback
+ *
+ * @param ctx User context
+ * @param rec Record
+ * @param data Record data, NULL if it is longer than the query buffer
+ * @return true to continue, false to stop the query
+ */
+typedef bool (*rstore_cb_t)(void *ctx, const rstore_rec_t *rec, const void *data);
+
+/**
+ * @brief Mount the store and recover the head
+ *
+ * @param st Store state
+ * @param flash Flash access (must stay valid)
+ * @param index Index with flash->sectors entries (must stay valid)
+ * @return 0 on success, -EINVAL on invalid argument, or the flash error
+ */
+int rstore_mount(rstore_t *st, const rstore_flash_t *flash, rstore_sector_t *index);
+
+/**
+ * @brief Erase the whole store
+ *
+ * @param st Mounted store
+ * @return 0 on success, or the flash error
+ */
+int rstore_format(rstore_t *st);
+
+/**
+ * @brief Append a record
+ *
+ * Opens a new sector if the record does not fit the head sector, erasing
+ * the oldest one when no sector is free.
+ *
+ * @param st Mounted store
+ * @param type Record type (1-254)
+ * @param round Round id
+ * @param data Record data
+ * @param len Data length (<= RSTORE_MAX_DATA)
+ * @return 0 on success, -EINVAL on invalid argument, or the flash error
+ */
+int rstore_append(rstore_t *st, uint8_t type, uint32_t round, const void *data, uint16_t len);
+
+/**
+ * @brief Visit the valid records of a round range, oldest first
+ *
+ * @param st Mounted store
+ * @param round_lo First round id
+ * @param round_hi Last round id
+ * @param buf Data buffer
+ * @param buf_len Buffer size
+ * @param cb Callback
+ * @param ctx User context
+ * @return Records visited, or a negative errno
+ */
+int rstore_query(rstore_t *st, uint32_t round_lo, uint32_t round_hi,
+                 void *buf, uint16_t buf_len, rstore_cb_t cb, void *ctx);
+
+/**
+ * @brief CRC-32 (IEEE 802.3)
+ *
+ * @param crc Previous value, 0 to start
+ * @param data Data
+ * @param len Length
+ * @return Updated CRC
+ */
+uint32_t rstore_crc32(uint32_t crc, const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSTORE_H
@@ -0,0 +1,165 @@
+/**
+ * @file scan_phase.c
+ * @brief Scanner PHY Scheduling from the Sender Countdown
+ *
+ * Implementation of scan_phase.h.
+ */
+
+#include "scan_phase.h"
+
+#define PHY_BIT(idx)    (1u << (idx))
+
+void scan_phase_reset(scan_phase_t *sp)
+{
+    sp->method = 0;
+    sp->start_tm = 0;
+    sp->end_tm = 0;
+    sp->expire_tm = 0;
+}
+
+void scan_phase_round(scan_phase_t *sp, uint8_t phy_sel, uint32_t burst_ms)
+{
+    sp->phy_sel = phy_sel;
+    sp->burst_ms = burst_ms;
+}
+
+void scan_phase_precnt(scan_phase_t *sp, uint8_t index, int16_t pre_cnt, int64_t now_ms)
+{
+    if (sp->pre_cnt[index] != pre_cnt) {
+        sp->pre_cnt_tm[index] = now_ms;
+    }
+    sp->pre_cnt[index] = pre_cnt;
+}
+
+int64_t scan_phase_burst_start(const scan_phase_t *sp, uint8_t index)
+{
+    int16_t pre_cnt = sp->pre_cnt[index];
+
+    if (0 <= pre_cnt || SCAN_PHASE_PRE_CNT_IDLE == pre_cnt) {
+        return 0;
+    }
+    return sp->pre_cnt_tm[index] + (int64_t)(-pre_cnt) * SCAN_PHASE_PRE_CNT_MS
+           + SCAN_PHASE_GUARD_MS;
+}
+
+int64_t scan_phase_burst_end(const scan_phase_t *sp, uint8_t index, int64_t start_tm)
+{
+    int16_t pre_cnt = sp->pre_cnt[index];
+
+    if (0 < pre_cnt && SCAN_PHASE_PRE_CNT_DONE != pre_cnt) {
+        return sp->pre_cnt_tm[index] + (int64_t)pre_cnt * SCAN_PHASE_PRE_CNT_MS;
+    }
+    if (0 == start_tm) {
+        return 0;
+    }
+    return start_tm + (int64_t)sp->burst_ms;
+}
+
+int8_t scan_phase_next_method(const scan_phase_t *sp, uint8_t done, const uint16_t *flow)
+{
+    uint16_t uncoded = UINT16_MAX;
+    uint16_t coded = UINT16_MAX;
+    bool uncoded_pending = false;
+
+    for (int idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        if (!(sp->phy_sel & PHY_BIT(idx)) || (done & PHY_BIT(idx))
+            || SCAN_PHASE_PRE_CNT_DONE == sp->pre_cnt[idx]) {
+            continue;
+        }
+        if (SCAN_PHASE_CODED == idx) {
+            coded = flow[idx];
+        } else {
+            uncoded_pending = true;
+            /* BLE4 bursts with the uncoded group but does not pace it */
+            if (3 != idx && flow[idx] < uncoded) {
+                uncoded = flow[idx];
+            }
+        }
+    }
+
+    if (UINT16_MAX == coded) {
+        return uncoded_pending ? 1 : 0;
+    }
+    if (!uncoded_pending) {
+        return 2;
+    }
+    return (uncoded <= coded) ? 1 : 2;
+}
+
+bool scan_phase_concurrent(const scan_phase_t *sp, int64_t now_ms)
+{
+    bool active[2] = {false, false};
+
+    for (int idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        int16_t pre_cnt = sp->pre_cnt[idx];
+
+        if (!(sp->phy_sel & PHY_BIT(idx)) || 0 == pre_cnt
+            || SCAN_PHASE_PRE_CNT_IDLE == pre_cnt || SCAN_PHASE_PRE_CNT_DONE == pre_cnt) {
+            continue;
+        }
+        if (now_ms - sp->pre_cnt_tm[idx] > SCAN_PHASE_STALE_MS) {
+            continue;
+        }
+        active[(SCAN_PHASE_CODED == idx) ? 1 : 0] = true;
+    }
+    return active[0] && active[1];
+}
+
+int64_t scan_phase_barrier(scan_phase_t *sp, int8_t method, int64_t barrier, int64_t now_ms)
+{
+    sp->start_tm = 0;
+    sp->end_tm = 0;
+
+    for (uint8_t idx = 0; idx < SCAN_PHASE_PHYS; idx++) {
+        if (!(sp->phy_sel & PHY_BIT(idx))
+            || (0 != method && (SCAN_PHASE_CODED == idx) != (2 == method))) {
+            continue;
+        }
+        /* Countdown and burst seconds tick every second; older stamps are stale */
+        if (now_ms - sp->pre_cnt_tm[idx] > SCAN_PHASE_STALE_MS) {
+            continue;
+        }
+        int64_t start_tm = scan_phase_burst_start(sp, idx);
+        int64_t end_tm = scan_phase_burst_end(sp, idx, start_tm);
+        if (start_tm && (0 == sp->start_tm || start_tm < sp->start_tm)) {
+            sp->start_tm = start_tm;
+        }
+        if (end_tm > sp->end_tm) {
+            sp->end_tm = end_tm;
+        }
+    }
+
+    if (sp->end_tm && sp->end_tm + SCAN_PHASE_TAIL_MS < barrier) {
+        return sp->end_tm + SCAN_PHASE_TAIL_MS;
+    }
+    return barrier;
+}
+
+int8_t scan_phase_window_method(const scan_phase_t *sp, int8_t method, int64_t now_ms)
+{
+    if (scan_phase_concurrent(sp, now_ms)) {
+        return 0;
+    }
+    if (sp->start_tm && now_ms < sp->start_tm - SCAN_PHASE_SETTLE_MS) {
+        return 0;
+    }
+    return method;
+}
+
+void scan_phase_hold(scan_phase_t *sp, int8_t method, int64_t end_tm, int64_t now_ms)
+{
+    if (0 == end_tm || end_tm > now_ms) {
+        end_tm = now_ms;
+    }
+    sp->method = method;
+    sp->expire_tm = end_tm + SCAN_PHASE_HOLD_MS;
+}
+
+int8_t scan_phase_method(scan_phase_t *sp, int8_t discovery_method, int64_t now_ms)
+{
+    if (0 != sp->method && now_ms < sp->expire_tm) {
+        return sp->method;
+    }
+    sp->method = 0;
+    return discovery_method;
+}
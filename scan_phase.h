@@ -0,0 +1,197 @@
+/**
+ * @file scan_phase.h
+ * @brief Scanner PHY Scheduling from the Sender Countdown
+ *
+ * The sender alternates between the Coded group (PHY index 2) and the
+ * uncoded group (2M, 1M, BLE4: index 0/1/3) per burst cycle. Scanning both
+ * primary PHYs splits the scan windows between them, so the scanner would
+ * miss part of whatever the sender is bursting. Instead the burst window
+ * is predicted from the countdown (pre_cnt < 0, one step per second) and
+ * the remaining burst seconds (pre_cnt > 0), only the PHY of the active
+ * group is scanned, and the group the sender bursts next is held after a
+ * burst end. Dual-PHY scanning is left for discovery.
+ *
+ * The hold ends within the pause the sender keeps after a burst before its
+ * next countdown, so a wrong prediction never costs the countdown of the
+ * other group: the scanner is back on dual-PHY scanning when it starts.
+ *
+ * Within a reception window both PHYs are scanned until shortly before the
+ * predicted burst start, so a sender that bursts both groups in the same
+ * cycle is heard on both countdowns before the window settles on one.
+ *
+ * Scan methods: 0 both groups (1M+Coded), 1 uncoded group, 2 Coded group.
+ *
+ * @note No Bluetooth stack dependency; all times are passed in, so the
+ *       schedule runs against a simulated sender on a host build as well
+ */
+
+#ifndef SCAN_PHASE_H
+#define SCAN_PHASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCAN_PHASE_PHYS         4       /* PHY indices (0=2M, 1=1M, 2=Coded, 3=BLE4) */
+#define SCAN_PHASE_CODED        2       /* PHY index of the Coded group */
+#define SCAN_PHASE_PRE_CNT_MS   1000    /* Sender countdown step */
+#define SCAN_PHASE_GUARD_MS     100     /* Sender guard between countdown and burst */
+#define SCAN_PHASE_TAIL_MS      800     /* Listen past predicted burst end (reports) */
+#define SCAN_PHASE_HOLD_MS      900     /* Single-PHY hold after a burst end */
+#define SCAN_PHASE_SETTLE_MS    500     /* Single-PHY decision before the burst start */
+#define SCAN_PHASE_STALE_MS     (4 * SCAN_PHASE_PRE_CNT_MS) /* Countdown stamp outdated */
+
+/* pre_cnt values without a timing meaning */
+#define SCAN_PHASE_PRE_CNT_DONE INT16_MAX   /* PHY finished the round */
+#define SCAN_PHASE_PRE_CNT_IDLE INT16_MIN   /* Sender set up, not counting down yet */
+
+/**
+ * @brief Scan phase state
+ */
+typedef struct {
+    int16_t pre_cnt[SCAN_PHASE_PHYS];       /**< Last received pre_cnt per PHY */
+    int64_t pre_cnt_tm[SCAN_PHASE_PHYS];    /**< Uptime (ms) when pre_cnt last changed value */
+    uint8_t phy_sel;                        /**< PHYs of the round (bit per index) */
+    uint32_t burst_ms;                      /**< Burst length of the interval group */
+    int8_t method;                          /**< Held method (0: none) */
+    int64_t start_tm;                       /**< Predicted burst start (0: unknown) */
+    int64_t end_tm;                         /**< Predicted burst end (0: unknown) */
+    int64_t expire_tm;                      /**< Hold valid until (before the next countdown) */
+} scan_phase_t;
+
+/**
+ * @brief Drop the prediction and the hold
+ *
+ * The received countdown values are kept.
+ *
+ * @param sp State
+ */
+void scan_phase_reset(scan_phase_t *sp);
+
+/**
+ * @brief Set the PHYs and burst length of the round
+ *
+ * @param sp State
+ * @param phy_sel PHYs of the round (bit per index)
+ * @param burst_ms Burst length implied by the interval group (ms)
+ */
+void scan_phase_round(scan_phase_t *sp, uint8_t phy_sel, uint32_t burst_ms);
+
+/**
+ * @brief Record a received pre_cnt
+ *
+ * The first packet carrying a new countdown value marks the start of that
+ * 1-second step on the sender side, so the time is stamped on a change.
+ *
+ * @param sp State
+ * @param index PHY index
+ * @param pre_cnt Received pre_cnt field
+ * @param now_ms Uptime (ms)
+ */
+void scan_phase_precnt(scan_phase_t *sp, uint8_t index, int16_t pre_cnt, int64_t now_ms);
+
+/**
+ * @brief Predict the burst start of a PHY from its countdown
+ *
+ * @param sp State
+ * @param index PHY index
+ * @return Uptime (ms) of the predicted burst start, 0 if no countdown seen
+ */
+int64_t scan_phase_burst_start(const scan_phase_t *sp, uint8_t index);
+
+/**
+ * @brief Predict the burst end of a PHY
+ *
+ * Uses the remaining burst seconds while bursting, otherwise the burst
+ * length of the interval group from the predicted start.
+ *
+ * @param sp State
+ * @param index PHY index
+ * @param start_tm Predicted burst start (0 if unknown)
+ * @return Uptime (ms) of the predicted burst end, 0 if unknown
+ */
+int64_t scan_phase_burst_end(const scan_phase_t *sp, uint8_t index, int64_t start_tm);
+
+/**
+ * @brief Predict which group the sender bursts next
+ *
+ * Mirrors the selection in the sender: the uncoded group is chosen while
+ * its least advanced PHY (2M/1M) has not overtaken the Coded PHY. Flow
+ * counts of the scanner stand in for the sender's sub totals.
+ *
+ * @param sp State
+ * @param done PHYs that completed their records (bit per index)
+ * @param flow Flows received per PHY index
+ * @return 1 for the uncoded group, 2 for the Coded group, 0 if unknown
+ */
+int8_t scan_phase_next_method(const scan_phase_t *sp, uint8_t done, const uint16_t *flow);
+
+/**
+ * @brief Check whether both groups count down or burst together
+ *
+ * A sender in concurrent burst mode runs the Coded and uncoded sets in
+ * the same cycle; only dual-PHY scanning receives both.
+ *
+ * @param sp State
+ * @param now_ms Uptime (ms)
+ * @return true if a Coded and an uncoded PHY are active within the last steps
+ */
+bool scan_phase_concurrent(const scan_phase_t *sp, int64_t now_ms);
+
+/**
+ * @brief Bound a reception window by the predicted burst of a group
+ *
+ * Re-evaluated while receiving, so the remaining burst seconds refine the
+ * estimate taken from the countdown. Updates start_tm and end_tm.
+ *
+ * @param sp State
+ * @param method Active scan method (0: both groups of a concurrent burst)
+ * @param barrier Window end derived from the interval group alone
+ * @param now_ms Uptime (ms)
+ * @return Predicted burst end plus tail, or barrier if that is earlier
+ */
+int64_t scan_phase_barrier(scan_phase_t *sp, int8_t method, int64_t barrier, int64_t now_ms);
+
+/**
+ * @brief Scan method inside a reception window
+ *
+ * Both PHYs while the countdown runs (until SCAN_PHASE_SETTLE_MS before the
+ * predicted burst start, as of the last scan_phase_barrier()) or while both
+ * groups are active, else the method of the window's group.
+ *
+ * @param sp State
+ * @param method Method of the group that opened the window
+ * @param now_ms Uptime (ms)
+ * @return Scan method
+ */
+int8_t scan_phase_window_method(const scan_phase_t *sp, int8_t method, int64_t now_ms);
+
+/**
+ * @brief Hold the scan method of the group predicted next
+ *
+ * @param sp State
+ * @param method Predicted method (scan_phase_next_method())
+ * @param end_tm Uptime (ms) of the burst end: the pre_cnt 0 stamp, else
+ *               the predicted end, else 0 for now
+ * @param now_ms Uptime (ms)
+ */
+void scan_phase_hold(scan_phase_t *sp, int8_t method, int64_t end_tm, int64_t now_ms);
+
+/**
+ * @brief Scan method for the idle period between bursts
+ *
+ * @param sp State
+ * @param discovery_method Method to use when nothing is held
+ * @param now_ms Uptime (ms)
+ * @return Held single-group method, or discovery_method
+ */
+int8_t scan_phase_method(scan_phase_t *sp, int8_t discovery_method, int64_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCAN_PHASE_H
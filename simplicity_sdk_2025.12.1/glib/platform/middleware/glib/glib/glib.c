@@ -398,9 +398,12 @@ EMSTATUS GLIB_drawPixel(GLIB_Context_t *pContext, int32_t x, int32_t y)
     return GLIB_ERROR_NOTHING_TO_DRAW;
   }
 
-  /* Translate color and draw pixel */
+  /* Translate color and draw pixel. The driver clipping area is the
+   * clipping region, so the pixel is addressed relative to its origin. */
   GLIB_colorTranslate24bppInl(pContext->foregroundColor, &red, &green, &blue);
-  return DMD_writeColor(x, y, red, green, blue, 1);
+  return DMD_writeColor(x - pContext->clippingRegion.xMin,
+                        y - pContext->clippingRegion.yMin,
+                        red, green, blue, 1);
 }
 
 /**************************************************************************//**
@@ -436,7 +439,9 @@ EMSTATUS GLIB_drawPixelColor(GLIB_Context_t *pContext, int32_t x, int32_t y,
 
   /* Translate color and draw pixel */
   GLIB_colorTranslate24bppInl(color, &red, &green, &blue);
-  return DMD_writeColor(x, y, red, green, blue, 1);
+  return DMD_writeColor(x - pContext->clippingRegion.xMin,
+                        y - pContext->clippingRegion.yMin,
+                        red, green, blue, 1);
 }
 
 /**************************************************************************//**
@@ -475,5 +480,7 @@ EMSTATUS GLIB_drawPixelRGB(GLIB_Context_t *pContext, int32_t x, int32_t y,
   }
 
   /* Call Display driver function */
-  return DMD_writeColor(x, y, red, green, blue, 1);
+  return DMD_writeColor(x - pContext->clippingRegion.xMin,
+                        y - pContext->clippingRegion.yMin,
+                        red, green, blue, 1);
 }
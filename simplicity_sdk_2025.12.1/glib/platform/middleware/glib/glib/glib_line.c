@@ -38,10 +38,19 @@
 /* GLIB Header files */
 #include "glib.h"
 
+/* Shortest vertical run of a steep line that is written through a one pixel
+ * wide driver clipping area. Shorter runs are written pixel by pixel, which
+ * leaves the driver clipping area as is. */
+#define GLIB_LINE_MIN_CLIPPED_RUN  3
+
 /* Local function prototypes */
 static uint8_t GLIB_getClipCode(GLIB_Context_t *pContext, int32_t x, int32_t y);
 static bool GLIB_clipLine(GLIB_Context_t *pContext, int32_t *pX1, int32_t *pY1,
                           int32_t *pX2, int32_t *pY2);
+static EMSTATUS GLIB_drawLineRun(GLIB_Context_t *pContext, bool steepLine,
+                                 int32_t x, int32_t y, int32_t length,
+                                 uint8_t red, uint8_t green, uint8_t blue,
+                                 bool *pClipChanged);
 
 /**************************************************************************//**
 *  @brief
@@ -326,6 +335,77 @@ static bool GLIB_clipLine(GLIB_Context_t *pContext, int32_t *pX1,
   }
 }
 
+/**************************************************************************//**
+*  @brief
+*  Draws a run of pixels of a line that lie on the same row, or on the same
+*  column for a steep line
+*
+*  The driver clipping area is expected to be the GLIB clipping region. A row
+*  is written with a single display driver write. A long enough column is
+*  written through a one pixel wide driver clipping area, in which case
+*  pClipChanged is set and the caller must restore the clipping region.
+*
+*  @param pContext
+*  Pointer to the GLIB_Context_t which holds the clipping region
+*  @param steepLine
+*  True if x and y are swapped, i.e. the run is a column
+*  @param x
+*  Start coordinate along the major axis of the line
+*  @param y
+*  Coordinate along the minor axis of the line
+*  @param length
+*  Number of pixels in the run
+*  @param red
+*  Red color component
+*  @param green
+*  Green color component
+*  @param blue
+*  Blue color component
+*  @param pClipChanged
+*  Set to true if the driver clipping area was changed
+*
+*  @return
+*  Returns DMD_OK on success, or else error code
+******************************************************************************/
+static EMSTATUS GLIB_drawLineRun(GLIB_Context_t *pContext, bool steepLine,
+                                 int32_t x, int32_t y, int32_t length,
+                                 uint8_t red, uint8_t green, uint8_t blue,
+                                 bool *pClipChanged)
+{
+  EMSTATUS status;
+  int32_t xMin = pContext->clippingRegion.xMin;
+  int32_t yMin = pContext->clippingRegion.yMin;
+
+  if (!steepLine) {
+    return DMD_writeColor(x - xMin, y - yMin, red, green, blue, length);
+  }
+
+  if (length >= GLIB_LINE_MIN_CLIPPED_RUN) {
+    *pClipChanged = true;
+    status = DMD_setClippingArea(y, x, 1, length);
+    if (status != DMD_OK) {
+      return status;
+    }
+    return DMD_writeColor(0, 0, red, green, blue, length);
+  }
+
+  if (*pClipChanged) {
+    status = GLIB_applyClippingRegion(pContext);
+    if (status != DMD_OK) {
+      return status;
+    }
+    *pClipChanged = false;
+  }
+  for (; length > 0; length--, x++) {
+    status = DMD_writeColor(y - xMin, x - yMin, red, green, blue, 1);
+    if (status != DMD_OK) {
+      return status;
+    }
+  }
+
+  return DMD_OK;
+}
+
 /**************************************************************************//**
 *  @brief
 *  Draws a line from x1,y1 to x2, y2
@@ -333,6 +413,10 @@ static bool GLIB_clipLine(GLIB_Context_t *pContext, int32_t *pX1,
 *  Draws a straight line using the Bresnham's Midpoint Line Algorithm.
 *  Checks for vertical and horizontal line.
 *
+*  The pixels are drawn as runs along the major axis (run-slice): the length
+*  of each run follows from the error term at its first pixel, and a row run
+*  is a single write to the display driver.
+*
 *  @param pContext
 *  Pointer to the GLIB_Context_t which holds the clipping region
 *  @param x1
@@ -351,13 +435,19 @@ EMSTATUS GLIB_drawLine(GLIB_Context_t *pContext, int32_t x1, int32_t y1,
                        int32_t x2, int32_t y2)
 {
   EMSTATUS status;
+  EMSTATUS clipStatus;
   int32_t error;
   int32_t deltaX;
   int32_t deltaY;
   int32_t yMotion;
   int32_t xMotion;
+  int32_t runLength;
   bool steepLine = false;
+  bool clipChanged = false;
   int32_t yStep = 1;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
 
   /* Check arguments */
   if (pContext == NULL) {
@@ -421,26 +511,38 @@ EMSTATUS GLIB_drawLine(GLIB_Context_t *pContext, int32_t x1, int32_t y1,
     yStep = -1;
   }
 
-  /* Loop through all points along the x-axis */
-  for (; x1 <= x2; x1++) {
-    if (steepLine) {
-      /* If steep, swap x and y coordinates */
-      status = GLIB_drawPixel(pContext, y1, x1);
+  GLIB_colorTranslate24bpp(pContext->foregroundColor, &red, &green, &blue);
+
+  /* Loop through the runs along the x-axis. Pixel by pixel, y steps once
+   * error has grown above 0 by deltaY per pixel, so a run starting with
+   * error <= 0 is -error / deltaY + 1 pixels long. */
+  status = DMD_OK;
+  while (x1 <= x2 && status == DMD_OK) {
+    if (deltaY == 0) {
+      runLength = x2 - x1 + 1;
     } else {
-      status = GLIB_drawPixel(pContext, x1, y1);
+      runLength = -error / deltaY + 1;
+      if (runLength > x2 - x1 + 1) {
+        runLength = x2 - x1 + 1;
+      }
     }
 
-    if (status != GLIB_OK) {
-      return status;
-    }
+    status = GLIB_drawLineRun(pContext, steepLine, x1, y1, runLength,
+                              red, green, blue, &clipChanged);
 
-    error += deltaY;
+    x1    += runLength;
+    y1    += yStep;
+    error += runLength * deltaY - deltaX;
+  }
 
-    if (error > 0) {
-      y1    += yStep;
-      error -= deltaX;
+  if (clipChanged) {
+    /* Reset driver clipping area to GLIB clipping region, also after an
+     * error, so later drawing is not confined to a one pixel column */
+    clipStatus = GLIB_applyClippingRegion(pContext);
+    if (status == DMD_OK) {
+      status = clipStatus;
     }
   }
 
-  return GLIB_OK;
+  return status;
 }
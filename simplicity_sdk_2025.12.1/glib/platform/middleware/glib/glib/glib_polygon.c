@@ -42,6 +42,65 @@ enum {
   MAX_CROSSES = 64, /* Maximum intersection points (arbitrary limit) */
 };
 
+/* Polygon edge, from its upper point x0,y0 to x0 + dx, y0 + dy */
+typedef struct {
+  int32_t x0;
+  int32_t y0;
+  int32_t dx;
+  int32_t dy;
+} GLIB_PolygonEdge_t;
+
+/**************************************************************************//**
+ * @brief
+ * Gets edge number edge of a polygon, which goes from point edge - 1
+ * (the last point for edge 0) to point edge, ordered by y.
+ *****************************************************************************/
+static void GLIB_getPolygonEdge(const int32_t *polyPoints, uint32_t numPoints,
+                                uint32_t edge, GLIB_PolygonEdge_t *pEdge)
+{
+  uint32_t prev = (edge == 0) ? numPoints - 1 : edge - 1;
+  int32_t x1 = polyPoints[2 * edge];
+  int32_t y1 = polyPoints[2 * edge + 1];
+  int32_t x2 = polyPoints[2 * prev];
+  int32_t y2 = polyPoints[2 * prev + 1];
+
+  if (y1 <= y2) {
+    pEdge->x0 = x1;
+    pEdge->y0 = y1;
+    pEdge->dx = x2 - x1;
+    pEdge->dy = y2 - y1;
+  } else {
+    pEdge->x0 = x2;
+    pEdge->y0 = y2;
+    pEdge->dx = x1 - x2;
+    pEdge->dy = y1 - y2;
+  }
+}
+
+/**************************************************************************//**
+ * @brief
+ * Gets the y coordinate of the upper point of edge number edge of a polygon
+ *****************************************************************************/
+static int32_t GLIB_getPolygonEdgeTop(const int32_t *polyPoints,
+                                      uint32_t numPoints, uint32_t edge)
+{
+  uint32_t prev = (edge == 0) ? numPoints - 1 : edge - 1;
+  int32_t y1 = polyPoints[2 * edge + 1];
+  int32_t y2 = polyPoints[2 * prev + 1];
+
+  return (y1 < y2) ? y1 : y2;
+}
+
+/**************************************************************************//**
+ * @brief
+ * Gets the pixel where an edge crosses a scan line: its x coordinate
+ * x + rem / dy (0 <= rem < dy) rounded towards zero.
+ *****************************************************************************/
+static inline int32_t GLIB_getPolygonCrossing(int32_t x, int32_t rem)
+{
+  return (x < 0 && rem != 0) ? x + 1 : x;
+}
+
 /**************************************************************************//**
  * @brief
  * Draws a polygon using Bresnham's Midpoint Line Algorithm.
@@ -125,6 +184,13 @@ EMSTATUS GLIB_drawPolygon(GLIB_Context_t *pContext,
  * The first and last point doesn't have to be the same. The function
  * automatically draws a line from the start point to the end point.
  *
+ * The edges are sorted by their upper y coordinate once, and enter the
+ * list of active edges when the scan line reaches them. The x coordinate
+ * of an active edge is stepped from one scan line to the next as an
+ * integer and a remainder of its dy (exact fixed point), and the list is
+ * kept sorted by crossing, so each scan line is filled with one display
+ * driver write per span between two crossings.
+ *
  * @param pContext
  *   Pointer to a GLIB_Context_t where the polygon is drawn.
  *   The polygon drawn using the foreground color.
@@ -141,12 +207,21 @@ EMSTATUS GLIB_drawPolygon(GLIB_Context_t *pContext,
 EMSTATUS GLIB_drawPolygonFilled(GLIB_Context_t *pContext,
                                 uint32_t numPoints, const int32_t *polyPoints)
 {
-  size_t i, j, numcrosses;
-  int32_t clip_y0 = pContext->clippingRegion.yMin;
-  int32_t clip_y1 = pContext->clippingRegion.yMax;
+  EMSTATUS status;
+  GLIB_PolygonEdge_t edge;
+  uint8_t edgeTable[MAX_CROSSES];  /* Edges sorted by upper y */
+  uint8_t activeEdge[MAX_CROSSES]; /* Active edges sorted by crossing */
+  int32_t activeX[MAX_CROSSES];    /* Integer part of x on the scan line */
+  int32_t activeRem[MAX_CROSSES];  /* Fraction of x, in units of 1 / dy */
+  uint32_t numEdges = 0;
+  uint32_t numActive = 0;
+  uint32_t nextEdge = 0;
+  uint32_t i, j, k;
+  int32_t clip_y0, clip_y1;
   int32_t cur_y, min_y, max_y;
-  int32_t cross_x[MAX_CROSSES];
-  int32_t curpoint_y, curpoint_x, prvpoint_y, prvpoint_x;
+  int32_t x, rem, x1, x2;
+  int64_t offset;
+  uint8_t red, green, blue;
 
   /* Check arguments */
   if (pContext == NULL || polyPoints == NULL || numPoints < 2
@@ -154,41 +229,125 @@ EMSTATUS GLIB_drawPolygonFilled(GLIB_Context_t *pContext,
     return GLIB_ERROR_INVALID_ARGUMENT;
   }
 
-  /* Find bounding box (respecting clipping region) */
+  clip_y0 = pContext->clippingRegion.yMin;
+  clip_y1 = pContext->clippingRegion.yMax;
+
+  /* Build the edge table, skipping horizontal edges, and find the bounding
+   * box (respecting clipping region) */
   min_y = max_y = polyPoints[1];
-  for (i = 1; i < numPoints; i++) {
+  for (i = 0; i < numPoints; i++) {
     cur_y = polyPoints[2 * i + 1];
     min_y = (cur_y < min_y) ? cur_y : min_y;
     max_y = (cur_y > max_y) ? cur_y : max_y;
+
+    GLIB_getPolygonEdge(polyPoints, numPoints, i, &edge);
+    if (edge.dy == 0) {
+      continue;
+    }
+    for (j = numEdges;
+         j > 0 && GLIB_getPolygonEdgeTop(polyPoints, numPoints,
+                                         edgeTable[j - 1]) > edge.y0;
+         j--) {
+      edgeTable[j] = edgeTable[j - 1];
+    }
+    edgeTable[j] = (uint8_t)i;
+    numEdges++;
   }
   min_y = (min_y < clip_y0) ? clip_y0 : min_y;
   max_y = (max_y > clip_y1) ? clip_y1 : max_y;
 
-  /* Find intersection points */
+  GLIB_colorTranslate24bpp(pContext->foregroundColor, &red, &green, &blue);
+
   for (cur_y = min_y; cur_y < max_y; cur_y++) {
-    /* Find where the current line intersects each 2-tuple */
-    numcrosses = 0;
-    j = numPoints - 1;
-    for (i = 0; i < numPoints; i++) {
-      curpoint_y = polyPoints[i * 2 + 1];
-      prvpoint_y = polyPoints[j * 2 + 1];
-      if ((curpoint_y < cur_y && prvpoint_y >= cur_y)
-          || (prvpoint_y < cur_y && curpoint_y >= cur_y)) {
-        curpoint_x = polyPoints[i * 2];
-        prvpoint_x = polyPoints[j * 2];
-        cross_x[numcrosses] = (int) (curpoint_x
-                                     + (cur_y - curpoint_y)
-                                     / (float)(prvpoint_y - curpoint_y)
-                                     * (float) (prvpoint_x - curpoint_x));
-        numcrosses++;
+    /* An edge crosses the scan lines below its upper point, down to and
+     * including its lower point. Add the edges reaching this scan line,
+     * with x computed on it directly, as the upper ones may be clipped. */
+    while (nextEdge < numEdges
+           && GLIB_getPolygonEdgeTop(polyPoints, numPoints,
+                                     edgeTable[nextEdge]) < cur_y) {
+      GLIB_getPolygonEdge(polyPoints, numPoints, edgeTable[nextEdge], &edge);
+      if (edge.y0 + edge.dy >= cur_y) {
+        offset = (int64_t)(cur_y - edge.y0) * edge.dx;
+        x = edge.x0 + (int32_t)(offset / edge.dy);
+        rem = (int32_t)(offset % edge.dy);
+        if (rem < 0) {
+          x--;
+          rem += edge.dy;
+        }
+        activeEdge[numActive] = edgeTable[nextEdge];
+        activeX[numActive] = x;
+        activeRem[numActive] = rem;
+        numActive++;
+      }
+      nextEdge++;
+    }
+
+    /* Sort the active edges by crossing. They keep their order between most
+     * scan lines, so this is a single pass in the common case. */
+    for (i = 1; i < numActive; i++) {
+      k = activeEdge[i];
+      x = activeX[i];
+      rem = activeRem[i];
+      x1 = GLIB_getPolygonCrossing(x, rem);
+      for (j = i;
+           j > 0 && GLIB_getPolygonCrossing(activeX[j - 1], activeRem[j - 1]) > x1;
+           j--) {
+        activeEdge[j] = activeEdge[j - 1];
+        activeX[j] = activeX[j - 1];
+        activeRem[j] = activeRem[j - 1];
+      }
+      activeEdge[j] = (uint8_t)k;
+      activeX[j] = x;
+      activeRem[j] = rem;
+    }
+
+    /* Fill the spans between crossing pairs */
+    for (i = 0; i + 1 < numActive; i += 2) {
+      x1 = GLIB_getPolygonCrossing(activeX[i], activeRem[i]);
+      x2 = GLIB_getPolygonCrossing(activeX[i + 1], activeRem[i + 1]);
+
+      /* Clip the span and write it relative to the driver clipping area,
+       * which is the GLIB clipping region */
+      if (x1 < pContext->clippingRegion.xMin) {
+        x1 = pContext->clippingRegion.xMin;
+      }
+      if (x2 > pContext->clippingRegion.xMax) {
+        x2 = pContext->clippingRegion.xMax;
+      }
+      if (x1 > x2) {
+        continue;
+      }
+      status = DMD_writeColor(x1 - pContext->clippingRegion.xMin,
+                              cur_y - clip_y0,
+                              red, green, blue, x2 - x1 + 1);
+      if (status != DMD_OK) {
+        return status;
       }
-      j = i;
     }
 
-    /* Draw horizontal lines between intersection point 2-tuples */
-    for (i = 0; i < numcrosses; i += 2) {
-      GLIB_drawLineH(pContext, cross_x[i], cur_y, cross_x[i + 1]);
+    /* Drop the edges ending on this scan line, and step the others to the
+     * next one: x grows by dx / dy */
+    for (i = 0, j = 0; i < numActive; i++) {
+      GLIB_getPolygonEdge(polyPoints, numPoints, activeEdge[i], &edge);
+      if (edge.y0 + edge.dy <= cur_y) {
+        continue;
+      }
+      x = activeX[i];
+      rem = activeRem[i] + edge.dx;
+      if (rem >= edge.dy || rem < 0) {
+        x += rem / edge.dy;
+        rem %= edge.dy;
+        if (rem < 0) {
+          x--;
+          rem += edge.dy;
+        }
+      }
+      activeEdge[j] = activeEdge[i];
+      activeX[j] = x;
+      activeRem[j] = rem;
+      j++;
     }
+    numActive = j;
   }
 
   return GLIB_OK;
@@ -17,6 +17,7 @@
 #ifndef SLI_INTERNAL_TRUSTED_STORAGE_H
 #define SLI_INTERNAL_TRUSTED_STORAGE_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -44,6 +45,18 @@ psa_status_t sli_psa_its_change_key_id(mbedtls_svc_key_id_t old_id,
  */
 psa_status_t sli_psa_its_encrypted(void);
 
+/**
+ * \brief Zeroize all cached ITS session keys
+ *
+ * \details Derived session keys of recently used encrypted ITS files are
+ *          kept in RAM while the ITS is in use, and are zeroized when
+ *          evicted or when their file is removed. Call this function at the
+ *          end of a period of ITS use (before sleep, before handing over to
+ *          another security domain) to zeroize the remaining ones. Does
+ *          nothing when ITS encryption is not enabled.
+ */
+void sli_psa_its_flush_session_keys(void);
+
 #if defined(SLI_PSA_ITS_ENCRYPTED) && !defined(SEMAILBOX_PRESENT)
 /**
  * \brief Set the root key to be used when deriving session keys for ITS encryption.
@@ -129,6 +142,36 @@ psa_status_t sli_encrypt_its_file(sli_its_file_meta_v2_t *metadata,
                                   size_t *blob_length);
 #endif
 
+// One ITS file of a batch write
+typedef struct {
+  psa_storage_uid_t uid;
+  uint32_t data_length;
+  const void *p_data;
+  psa_storage_create_flags_t create_flags;
+} sli_psa_its_batch_entry_t;
+
+/**
+ * \brief Create or overwrite several ITS files with one ITS lock acquisition
+ *
+ * \details All entries are checked before anything is written: arguments,
+ *          duplicate UIDs, write-once files and free ITS files. If NVM3
+ *          needs a repack, it is then repacked for the size of the whole
+ *          batch, and the files are written in the order of `entries`. Each
+ *          file is written atomically. A power loss or a storage failure
+ *          during the batch leaves the first files of the batch written and
+ *          the others unchanged, so a file that marks the batch as complete
+ *          should be the last entry.
+ *
+ * \param[in] entries  The files to write, in write order
+ * \param[in] count    Number of entries
+ *
+ * \return      PSA_SUCCESS, or the status of psa_its_set() for the entry
+ *              that failed. PSA_ERROR_INVALID_ARGUMENT if a UID appears
+ *              more than once.
+ */
+psa_status_t sli_psa_its_set_batch(const sli_psa_its_batch_entry_t *entries,
+                                   size_t count);
+
 #if defined(SLI_STATIC_TESTABLE) && (SL_PSA_ITS_SUPPORT_V3_DRIVER)
 // in test mode, expose the init function
 void init_cache(void);
@@ -44,6 +44,7 @@
 #include "psa/sli_internal_trusted_storage.h"
 #include "nvm3_default.h"
 #include "mbedtls/platform.h"
+#include "sl_common.h"
 #include <stdbool.h>
 #include <string.h>
 
@@ -166,6 +167,13 @@ void sli_its_release_mutex(void)
 
 #define SLI_PSA_ITS_CACHE_INIT_CHUNK_SIZE 16
 
+// End of a UID index chain
+#define SLI_PSA_ITS_UID_INDEX_NONE (0xFFFFu)
+
+#if (SL_PSA_ITS_MAX_FILES >= 0xFFFF)
+#error "SL_PSA_ITS_MAX_FILES does not fit the 16-bit UID index"
+#endif
+
 // Enable backwards-compatibility with keys stored with a v1 header unless disabled.
 #if !defined(SL_PSA_ITS_REMOVE_V1_HEADER_SUPPORT)
 #define SLI_PSA_ITS_SUPPORT_V1_FORMAT
@@ -195,6 +203,17 @@ void sli_its_release_mutex(void)
 SLI_STATIC bool nvm3_uid_set_cache_initialized = false;
 SLI_STATIC uint32_t nvm3_uid_set_cache[CACHE_WORDS_MAX] = { 0 };
 
+// UID index, built together with nvm3_uid_set_cache. The files are chained
+// in SL_PSA_ITS_MAX_FILES buckets by a hash of their UID, and an 8-bit tag of
+// that hash skips most other files of a bucket without reading them, so a
+// lookup reads the metadata of one file in the common case instead of every
+// file in the range. If a file could not be indexed (metadata read error),
+// lookups fall back to scanning the range.
+SLI_STATIC bool nvm3_uid_index_complete = false;
+SLI_STATIC uint16_t nvm3_uid_index_head[SL_PSA_ITS_MAX_FILES];
+SLI_STATIC uint16_t nvm3_uid_index_next[SL_PSA_ITS_MAX_FILES];
+SLI_STATIC uint8_t nvm3_uid_index_tag[SL_PSA_ITS_MAX_FILES];
+
 typedef struct {
   psa_storage_uid_t uid;
   nvm3_ObjectKey_t object_id;
@@ -223,17 +242,27 @@ static root_key_t g_root_key = {
 };
 #endif // !defined(SEMAILBOX_PRESENT)
 
+// Number of derived session keys kept for reuse
+#if !defined(SL_PSA_ITS_SESSION_KEY_CACHE_SIZE)
+#define SL_PSA_ITS_SESSION_KEY_CACHE_SIZE (4)
+#endif
+
+// A session key is derived from the root key and the IV of the ITS file, so
+// it is cached together with both the UID and the IV it was derived from.
 typedef struct {
   bool active;
   psa_storage_uid_t uid;
+  uint32_t last_use;
+  uint8_t iv[AES_IV_GCM_SIZE];
   uint8_t data[SESSION_KEY_SIZE];
 } session_key_t;
 
-static session_key_t g_cached_session_key = {
-  .active = false,
-  .uid = 0,
-  .data = { 0 },
-};
+SLI_STATIC session_key_t g_cached_session_keys[SL_PSA_ITS_SESSION_KEY_CACHE_SIZE] = { 0 };
+static uint32_t g_session_key_use_count = 0;
+
+// Session key cache hits and misses (key derivations) on decryption
+SLI_STATIC uint32_t session_key_cache_hits = 0;
+SLI_STATIC uint32_t session_key_cache_misses = 0;
 #endif // defined(SLI_PSA_ITS_ENCRYPTED)
 
 // -------------------------------------
@@ -268,6 +297,10 @@ typedef struct {
 
 static nvm3_ObjectKey_t get_nvm3_id(psa_storage_uid_t uid, bool find_empty_slot);
 static nvm3_ObjectKey_t prepare_its_get_nvm3_id(psa_storage_uid_t uid);
+static Ecode_t get_file_metadata(nvm3_ObjectKey_t key,
+                                 sli_its_file_meta_v2_t* metadata,
+                                 size_t* its_file_offset,
+                                 size_t* its_file_size);
 
 #if defined(TFM_CONFIG_SL_SECURE_LIBRARY)
 static inline bool object_lives_in_s(const void *object, size_t object_size);
@@ -341,6 +374,84 @@ static inline bool cache_lookup(nvm3_ObjectKey_t key)
   uint32_t offset = i - 32 * bin;
   return (bool)((nvm3_uid_set_cache[bin] >> offset) & 0x1);
 }
+
+// Find the first NVM3 ID without a file, one cache word at a time.
+static nvm3_ObjectKey_t cache_find_empty(void)
+{
+  for (uint32_t bin = 0; bin < CACHE_WORDS_MAX; bin++) {
+    uint32_t empty = ~nvm3_uid_set_cache[bin];
+    if (empty != 0U) {
+      uint32_t i = 32 * bin + SL_CTZ(empty);
+      if (i < SL_PSA_ITS_MAX_FILES) {
+        return i + SLI_PSA_ITS_NVM3_RANGE_START;
+      }
+      break;
+    }
+  }
+
+  return SLI_PSA_ITS_NVM3_RANGE_END + 1U;
+}
+
+// Mix the 64 bits of a UID into 32 (MurmurHash3 finalizer).
+static inline uint32_t uid_index_hash(psa_storage_uid_t uid)
+{
+  uint64_t h = uid;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  return (uint32_t)h;
+}
+
+static void uid_index_insert(nvm3_ObjectKey_t key, psa_storage_uid_t uid)
+{
+  uint32_t hash = uid_index_hash(uid);
+  uint32_t bucket = hash % SL_PSA_ITS_MAX_FILES;
+  uint16_t i = (uint16_t)(key - SLI_PSA_ITS_NVM3_RANGE_START);
+
+  nvm3_uid_index_tag[i] = (uint8_t)(hash >> 24);
+  nvm3_uid_index_next[i] = nvm3_uid_index_head[bucket];
+  nvm3_uid_index_head[bucket] = i;
+}
+
+static void uid_index_remove(nvm3_ObjectKey_t key, psa_storage_uid_t uid)
+{
+  uint16_t *link = &nvm3_uid_index_head[uid_index_hash(uid) % SL_PSA_ITS_MAX_FILES];
+  uint16_t i = (uint16_t)(key - SLI_PSA_ITS_NVM3_RANGE_START);
+
+  while (*link != SLI_PSA_ITS_UID_INDEX_NONE) {
+    if (*link == i) {
+      *link = nvm3_uid_index_next[i];
+      return;
+    }
+    link = &nvm3_uid_index_next[*link];
+  }
+}
+
+// Find the NVM3 ID of a UID in the index. Only the files of the UID's
+// bucket with a matching tag have their metadata read.
+static nvm3_ObjectKey_t uid_index_lookup(psa_storage_uid_t uid)
+{
+  uint32_t hash = uid_index_hash(uid);
+  uint8_t tag = (uint8_t)(hash >> 24);
+  sli_its_file_meta_v2_t key_meta;
+  Ecode_t status;
+
+  for (uint16_t i = nvm3_uid_index_head[hash % SL_PSA_ITS_MAX_FILES];
+       i != SLI_PSA_ITS_UID_INDEX_NONE;
+       i = nvm3_uid_index_next[i]) {
+    if (nvm3_uid_index_tag[i] != tag) {
+      continue;
+    }
+    status = get_file_metadata(i + SLI_PSA_ITS_NVM3_RANGE_START, &key_meta, NULL, NULL);
+    if ((status == ECODE_NVM3_OK
+         || status == SLI_PSA_ITS_ECODE_NEEDS_UPGRADE)
+        && key_meta.uid == uid) {
+      return i + SLI_PSA_ITS_NVM3_RANGE_START;
+    }
+  }
+
+  return SLI_PSA_ITS_NVM3_RANGE_END + 1U;
+}
 #if defined(SLI_STATIC_TESTABLE)
 bool cache_initialized(void)
 {
@@ -355,6 +466,14 @@ static void init_cache(void)
 #endif
   size_t num_keys_referenced_by_nvm3;
   nvm3_ObjectKey_t keys_referenced_by_nvm3[SLI_PSA_ITS_CACHE_INIT_CHUNK_SIZE] = { 0 };
+  sli_its_file_meta_v2_t key_meta;
+  Ecode_t status;
+
+  // Rebuild everything from what NVM3 holds, also when called again
+  memset(nvm3_uid_set_cache, 0, sizeof(nvm3_uid_set_cache));
+  memset(nvm3_uid_index_head, 0xFF, sizeof(nvm3_uid_index_head));
+  nvm3_uid_index_complete = true;
+  previous_lookup.set = false;
 
   for (nvm3_ObjectKey_t range_start = SLI_PSA_ITS_NVM3_RANGE_START;
        range_start < SLI_PSA_ITS_NVM3_RANGE_END;
@@ -371,7 +490,28 @@ static void init_cache(void)
                                                    range_end - 1);
 
     for (size_t i = 0; i < num_keys_referenced_by_nvm3; i++) {
-      cache_set(keys_referenced_by_nvm3[i]);
+      nvm3_ObjectKey_t object_id = keys_referenced_by_nvm3[i];
+
+      status = get_file_metadata(object_id, &key_meta, NULL, NULL);
+      if (status == ECODE_NVM3_OK
+          || status == SLI_PSA_ITS_ECODE_NEEDS_UPGRADE) {
+        cache_set(object_id);
+        uid_index_insert(object_id, key_meta.uid);
+        continue;
+      }
+
+      if (status == SLI_PSA_ITS_ECODE_NO_VALID_HEADER
+          || status == ECODE_NVM3_ERR_READ_DATA_SIZE) {
+        // Same cleanup as in get_nvm3_id(): only PSA ITS files are expected
+        // in our range.
+        if (nvm3_deleteObject(nvm3_defaultHandle, object_id) == ECODE_NVM3_OK) {
+          continue;
+        }
+      }
+
+      // Keep the slot taken, and have lookups scan the range for it.
+      cache_set(object_id);
+      nvm3_uid_index_complete = false;
     }
   }
 
@@ -465,11 +605,7 @@ static nvm3_ObjectKey_t get_nvm3_id(psa_storage_uid_t uid, bool find_empty_slot)
   sli_its_file_meta_v2_t key_meta;
 
   if (find_empty_slot) {
-    for (size_t i = 0; i < SL_PSA_ITS_MAX_FILES; i++) {
-      if (!cache_lookup(i + SLI_PSA_ITS_NVM3_RANGE_START)) {
-        return i + SLI_PSA_ITS_NVM3_RANGE_START;
-      }
-    }
+    return cache_find_empty();
   } else {
     if (previous_lookup.set) {
       if (previous_lookup.uid == uid) {
@@ -477,6 +613,16 @@ static nvm3_ObjectKey_t get_nvm3_id(psa_storage_uid_t uid, bool find_empty_slot)
       }
     }
 
+    if (nvm3_uid_index_complete) {
+      nvm3_ObjectKey_t object_id = uid_index_lookup(uid);
+      if (object_id <= SLI_PSA_ITS_NVM3_RANGE_END) {
+        previous_lookup.set = true;
+        previous_lookup.object_id = object_id;
+        previous_lookup.uid = uid;
+      }
+      return object_id;
+    }
+
     for (size_t i = 0; i < SL_PSA_ITS_MAX_FILES; i++) {
       if (!cache_lookup(i + SLI_PSA_ITS_NVM3_RANGE_START)) {
         continue;
@@ -536,12 +682,72 @@ static nvm3_ObjectKey_t prepare_its_get_nvm3_id(psa_storage_uid_t uid)
 }
 
 #if defined(SLI_PSA_ITS_ENCRYPTED)
-static inline void cache_session_key(uint8_t *session_key, psa_storage_uid_t uid)
+static session_key_t *find_session_key(psa_storage_uid_t uid, const uint8_t *iv)
+{
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    session_key_t *entry = &g_cached_session_keys[i];
+    if (entry->active
+        && entry->uid == uid
+        && memcmp(entry->iv, iv, sizeof(entry->iv)) == 0) {
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+static inline void cache_session_key(uint8_t *session_key, psa_storage_uid_t uid, const uint8_t *iv)
+{
+  session_key_t *entry = NULL;
+
+  // Reuse the entry of this UID (its file was rewritten with a new IV), else
+  // take a free entry, else evict the least recently used one.
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    session_key_t *candidate = &g_cached_session_keys[i];
+    if (candidate->active && candidate->uid == uid) {
+      entry = candidate;
+      break;
+    }
+    if (entry == NULL
+        || (entry->active
+            && (!candidate->active
+                || (int32_t)(candidate->last_use - entry->last_use) < 0))) {
+      entry = candidate;
+    }
+  }
+
+  // Cache the session key. The evicted key is fully overwritten.
+  memcpy(entry->data, session_key, sizeof(entry->data));
+  memcpy(entry->iv, iv, sizeof(entry->iv));
+  entry->uid = uid;
+  entry->last_use = ++g_session_key_use_count;
+  entry->active = true;
+}
+
+// Copy the cached session key of an ITS file, if any.
+static inline bool get_cached_session_key(psa_storage_uid_t uid, const uint8_t *iv, uint8_t *session_key)
+{
+  session_key_t *entry = find_session_key(uid, iv);
+
+  if (entry == NULL) {
+    session_key_cache_misses++;
+    return false;
+  }
+
+  memcpy(session_key, entry->data, sizeof(entry->data));
+  entry->last_use = ++g_session_key_use_count;
+  session_key_cache_hits++;
+  return true;
+}
+
+// Zeroize the cached session key of a UID, once its file is gone.
+static inline void drop_session_key(psa_storage_uid_t uid)
 {
-  // Cache the session key
-  memcpy(g_cached_session_key.data, session_key, sizeof(g_cached_session_key.data));
-  g_cached_session_key.uid = uid;
-  g_cached_session_key.active = true;
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    if (g_cached_session_keys[i].active && g_cached_session_keys[i].uid == uid) {
+      memset(&g_cached_session_keys[i], 0, sizeof(g_cached_session_keys[i]));
+    }
+  }
 }
 
 /**
@@ -688,7 +894,7 @@ static psa_status_t encrypt_its_file(sli_its_file_meta_v2_t *metadata,
     return psa_status;
   }
 
-  cache_session_key(session_key, metadata->uid);
+  cache_session_key(session_key, metadata->uid, blob->iv);
 
   // Retrieve data to be encrypted
   if (plaintext_size != 0U) {
@@ -766,15 +972,13 @@ static psa_status_t decrypt_its_file(sli_its_file_meta_v2_t *metadata,
   psa_status_t psa_status = PSA_ERROR_CORRUPTION_DETECTED;
   uint8_t session_key[SESSION_KEY_SIZE];
 
-  if (g_cached_session_key.active && g_cached_session_key.uid == metadata->uid) {
-    // Use cached session key if it's already set and UID matches
-    memcpy(session_key, g_cached_session_key.data, sizeof(session_key));
-  } else {
+  if (!get_cached_session_key(metadata->uid, blob->iv, session_key)) {
+    // No session key cached for this file (UID and IV), derive it
     psa_status = derive_session_key(blob->iv, AES_IV_GCM_SIZE, session_key, sizeof(session_key));
     if (psa_status != PSA_SUCCESS) {
       return psa_status;
     }
-    cache_session_key(session_key, metadata->uid);
+    cache_session_key(session_key, metadata->uid, blob->iv);
   }
 
   // Decrypt and authenticate blob
@@ -950,6 +1154,7 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
   Ecode_t status;
   psa_status_t ret = PSA_SUCCESS;
   sli_its_file_meta_v2_t* its_file_meta;
+  bool new_file = false;
 
 #if defined(SLI_PSA_ITS_ENCRYPTED)
   psa_storage_uid_t authenticated_uid;
@@ -972,6 +1177,7 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
   its_file_meta = (sli_its_file_meta_v2_t *)its_file_buffer;
   if (nvm3_object_id > SLI_PSA_ITS_NVM3_RANGE_END) {
     // ITS UID was not found. Request a new.
+    new_file = true;
     nvm3_object_id = get_nvm3_id(0ULL, true);
     if (nvm3_object_id > SLI_PSA_ITS_NVM3_RANGE_END) {
       // The storage is full, or an error was returned during cleanup.
@@ -1051,6 +1257,9 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
     // Power-loss might occur, however upon boot, the look-up table will be
     // re-filled as long as the data has been successfully written to NVM3.
     cache_set(nvm3_object_id);
+    if (new_file) {
+      uid_index_insert(nvm3_object_id, uid);
+    }
   } else {
     ret = PSA_ERROR_STORAGE_FAILURE;
   }
@@ -1391,6 +1600,10 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
       previous_lookup.set = false;
     }
     cache_clear(nvm3_object_id);
+    uid_index_remove(nvm3_object_id, uid);
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+    drop_session_key(uid);
+#endif
 
     psa_status = PSA_SUCCESS;
   } else {
@@ -1548,12 +1761,17 @@ psa_status_t sli_psa_its_change_key_id(mbedtls_svc_key_id_t old_id,
                           its_file_buffer,
                           its_file_size);
   if (status == ECODE_NVM3_OK) {
-    // Update last lookup and report success
+    // Update last lookup and the UID index, and report success
     if (previous_lookup.set) {
       if (previous_lookup.uid == old_uid) {
         previous_lookup.uid = new_uid;
       }
     }
+    uid_index_remove(nvm3_object_id, old_uid);
+    uid_index_insert(nvm3_object_id, new_uid);
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+    drop_session_key(old_uid);
+#endif
     psa_status = PSA_SUCCESS;
   } else {
     psa_status = PSA_ERROR_STORAGE_FAILURE;
@@ -1581,6 +1799,18 @@ psa_status_t sli_psa_its_encrypted(void)
   #endif
 }
 
+/**
+ * \brief Zeroize all cached ITS session keys.
+ */
+void sli_psa_its_flush_session_keys(void)
+{
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+  sli_its_acquire_mutex();
+  memset(g_cached_session_keys, 0, sizeof(g_cached_session_keys));
+  sli_its_release_mutex();
+#endif
+}
+
 #if defined(SLI_PSA_ITS_ENCRYPTED) && !defined(SEMAILBOX_PRESENT)
 /**
  * \brief Set the root key to be used when deriving session keys for ITS encryption.
@@ -1626,6 +1856,8 @@ psa_status_t sli_psa_its_set_root_key(uint8_t *root_key, size_t root_key_size)
 #define SLI_PSA_ITS_V2_DRIVER_FLAG_NVM3_ID  (SLI_PSA_ITS_NVM3_RANGE_START - 1)
 #define SLI_PSA_ITS_NVM3_INVALID_KEY        (0)
 #define SLI_PSA_ITS_NVM3_UNKNOWN_KEY        (1)
+// Largest NVM3 object header, for the space needed by a batch of ITS files
+#define SLI_PSA_ITS_NVM3_OBJ_HEADER_SIZE    (8U)
 
 #define SLI_PSA_ITS_CACHE_INIT_CHUNK_SIZE 16
 
@@ -1663,17 +1895,27 @@ static root_key_t g_root_key = {
 };
 #endif // !defined(SEMAILBOX_PRESENT)
 
+// Number of derived session keys kept for reuse
+#if !defined(SL_PSA_ITS_SESSION_KEY_CACHE_SIZE)
+#define SL_PSA_ITS_SESSION_KEY_CACHE_SIZE (4)
+#endif
+
+// A session key is derived from the root key and the IV of the ITS file, so
+// it is cached together with both the UID and the IV it was derived from.
 typedef struct {
   bool active;
   psa_storage_uid_t uid;
+  uint32_t last_use;
+  uint8_t iv[AES_GCM_IV_SIZE];
   uint8_t data[SESSION_KEY_SIZE];
 } session_key_t;
 
-static session_key_t g_cached_session_key = {
-  .active = false,
-  .uid = 0,
-  .data = { 0 },
-};
+SLI_STATIC session_key_t g_cached_session_keys[SL_PSA_ITS_SESSION_KEY_CACHE_SIZE] = { 0 };
+static uint32_t g_session_key_use_count = 0;
+
+// Session key cache hits and misses (key derivations) on decryption
+SLI_STATIC uint32_t session_key_cache_hits = 0;
+SLI_STATIC uint32_t session_key_cache_misses = 0;
 #endif // defined(SLI_PSA_ITS_ENCRYPTED)
 
 // -------------------------------------
@@ -2497,12 +2739,72 @@ static psa_status_t find_nvm3_id(psa_storage_uid_t uid,
 }
 
 #if defined(SLI_PSA_ITS_ENCRYPTED)
-static inline void cache_session_key(uint8_t *session_key, psa_storage_uid_t uid)
+static session_key_t *find_session_key(psa_storage_uid_t uid, const uint8_t *iv)
+{
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    session_key_t *entry = &g_cached_session_keys[i];
+    if (entry->active
+        && entry->uid == uid
+        && memcmp(entry->iv, iv, sizeof(entry->iv)) == 0) {
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+static inline void cache_session_key(uint8_t *session_key, psa_storage_uid_t uid, const uint8_t *iv)
+{
+  session_key_t *entry = NULL;
+
+  // Reuse the entry of this UID (its file was rewritten with a new IV), else
+  // take a free entry, else evict the least recently used one.
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    session_key_t *candidate = &g_cached_session_keys[i];
+    if (candidate->active && candidate->uid == uid) {
+      entry = candidate;
+      break;
+    }
+    if (entry == NULL
+        || (entry->active
+            && (!candidate->active
+                || (int32_t)(candidate->last_use - entry->last_use) < 0))) {
+      entry = candidate;
+    }
+  }
+
+  // Cache the session key. The evicted key is fully overwritten.
+  memcpy(entry->data, session_key, sizeof(entry->data));
+  memcpy(entry->iv, iv, sizeof(entry->iv));
+  entry->uid = uid;
+  entry->last_use = ++g_session_key_use_count;
+  entry->active = true;
+}
+
+// Copy the cached session key of an ITS file, if any.
+static inline bool get_cached_session_key(psa_storage_uid_t uid, const uint8_t *iv, uint8_t *session_key)
 {
-  // Cache the session key
-  memcpy(g_cached_session_key.data, session_key, sizeof(g_cached_session_key.data));
-  g_cached_session_key.uid = uid;
-  g_cached_session_key.active = true;
+  session_key_t *entry = find_session_key(uid, iv);
+
+  if (entry == NULL) {
+    session_key_cache_misses++;
+    return false;
+  }
+
+  memcpy(session_key, entry->data, sizeof(entry->data));
+  entry->last_use = ++g_session_key_use_count;
+  session_key_cache_hits++;
+  return true;
+}
+
+// Zeroize the cached session key of a UID, once its file is gone.
+static inline void drop_session_key(psa_storage_uid_t uid)
+{
+  for (size_t i = 0; i < SL_PSA_ITS_SESSION_KEY_CACHE_SIZE; i++) {
+    if (g_cached_session_keys[i].active && g_cached_session_keys[i].uid == uid) {
+      memset(&g_cached_session_keys[i], 0, sizeof(g_cached_session_keys[i]));
+    }
+  }
 }
 
 /**
@@ -2649,7 +2951,7 @@ psa_status_t sli_encrypt_its_file(sli_its_file_meta_v2_t *metadata,
     return psa_status;
   }
 
-  cache_session_key(session_key, metadata->uid);
+  cache_session_key(session_key, metadata->uid, blob->iv);
 
   // Retrieve data to be encrypted
   if (plaintext_size != 0U) {
@@ -2727,15 +3029,13 @@ static psa_status_t sli_decrypt_its_file(sli_its_file_meta_v2_t *metadata,
   psa_status_t psa_status = PSA_ERROR_CORRUPTION_DETECTED;
   uint8_t session_key[SESSION_KEY_SIZE];
 
-  if (g_cached_session_key.active && g_cached_session_key.uid == metadata->uid) {
-    // Use cached session key if it's already set and UID matches
-    memcpy(session_key, g_cached_session_key.data, sizeof(session_key));
-  } else {
+  if (!get_cached_session_key(metadata->uid, blob->iv, session_key)) {
+    // No session key cached for this file (UID and IV), derive it
     psa_status = derive_session_key(blob->iv, AES_GCM_IV_SIZE, session_key, sizeof(session_key));
     if (psa_status != PSA_SUCCESS) {
       return psa_status;
     }
-    cache_session_key(session_key, metadata->uid);
+    cache_session_key(session_key, metadata->uid, blob->iv);
   }
 
   // Decrypt and authenticate blob
@@ -2856,33 +3156,10 @@ static psa_status_t authenticate_its_file(nvm3_ObjectKey_t nvm3_object_id,
 }
 #endif // defined(SLI_PSA_ITS_ENCRYPTED)
 
-// -------------------------------------
-// Global function definitions
-
-/**
- * \brief create a new or modify an existing uid/value pair
- *
- * \param[in] uid           the identifier for the data
- * \param[in] data_length   The size in bytes of the data in `p_data`
- * \param[in] p_data        A buffer containing the data
- * \param[in] create_flags  The flags that the data will be stored with
- *
- * \return      A status indicating the success/failure of the operation
- *
- * \retval      PSA_SUCCESS                      The operation completed successfully
- * \retval      PSA_ERROR_NOT_PERMITTED          The operation failed because the provided `uid` value was already created with PSA_STORAGE_FLAG_WRITE_ONCE
- * \retval      PSA_ERROR_NOT_SUPPORTED          The operation failed because one or more of the flags provided in `create_flags` is not supported or is not valid
- * \retval      PSA_ERROR_INSUFFICIENT_STORAGE   The operation failed because there was insufficient space on the storage medium
- * \retval      PSA_ERROR_STORAGE_FAILURE        The operation failed because the physical storage has failed (Fatal error)
- * \retval      PSA_ERROR_INVALID_ARGUMENT       The operation failed because one of the provided pointers(`p_data`)
- *                                               is invalid, for example is `NULL` or references memory the caller cannot access
- * \retval      PSA_ERROR_HARDWARE_FAILURE       The operation failed because an internal cryptographic operation failed.
- * \retval      PSA_ERROR_INVALID_SIGNATURE      The operation failed because the provided `uid` doesnt match the autenticated uid from the storage
- */
-psa_status_t psa_its_set(psa_storage_uid_t uid,
-                         uint32_t data_length,
-                         const void *p_data,
-                         psa_storage_create_flags_t create_flags)
+// Check the arguments of psa_its_set()
+static psa_status_t check_set_arguments(uint32_t data_length,
+                                        const void *p_data,
+                                        psa_storage_create_flags_t create_flags)
 {
   if ((data_length != 0U) && (p_data == NULL)) {
     return PSA_ERROR_INVALID_ARGUMENT;
@@ -2908,6 +3185,25 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
   }
 #endif
 
+  return PSA_SUCCESS;
+}
+
+// Size of the NVM3 object of an ITS file, including the NVM3 object header
+static inline size_t its_object_size(uint32_t data_length)
+{
+  size_t size = sizeof(sli_its_file_meta_v2_t) + data_length;
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+  size += SLI_ITS_ENCRYPTED_BLOB_SIZE_OVERHEAD;
+#endif
+  return ((size + 3U) & ~3U) + SLI_PSA_ITS_NVM3_OBJ_HEADER_SIZE;
+}
+
+// Create or overwrite an ITS file. The ITS mutex must be held.
+static psa_status_t write_its_file(psa_storage_uid_t uid,
+                                   uint32_t data_length,
+                                   const void *p_data,
+                                   psa_storage_create_flags_t create_flags)
+{
   Ecode_t status;
   psa_status_t psa_status = PSA_ERROR_CORRUPTION_DETECTED;
   sli_its_file_meta_v2_t* its_file_meta;
@@ -2928,7 +3224,6 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
 
   its_file_meta = (sli_its_file_meta_v2_t *)its_file_buffer;
 
-  sli_its_acquire_mutex();
   psa_status = find_nvm3_id(uid, true, its_file_meta, NULL, NULL, &nvm3_object_id);
   if (psa_status != PSA_SUCCESS) {
     if (psa_status == PSA_ERROR_DOES_NOT_EXIST) {
@@ -2986,6 +3281,44 @@ psa_status_t psa_its_set(psa_storage_uid_t uid,
   // Clear and free key buffer before return.
   memset(its_file_buffer, 0, its_file_size + sizeof(sli_its_file_meta_v2_t));
   mbedtls_free(its_file_buffer);
+  return psa_status;
+}
+
+// -------------------------------------
+// Global function definitions
+
+/**
+ * \brief create a new or modify an existing uid/value pair
+ *
+ * \param[in] uid           the identifier for the data
+ * \param[in] data_length   The size in bytes of the data in `p_data`
+ * \param[in] p_data        A buffer containing the data
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return      A status indicating the success/failure of the operation
+ *
+ * \retval      PSA_SUCCESS                      The operation completed successfully
+ * \retval      PSA_ERROR_NOT_PERMITTED          The operation failed because the provided `uid` value was already created with PSA_STORAGE_FLAG_WRITE_ONCE
+ * \retval      PSA_ERROR_NOT_SUPPORTED          The operation failed because one or more of the flags provided in `create_flags` is not supported or is not valid
+ * \retval      PSA_ERROR_INSUFFICIENT_STORAGE   The operation failed because there was insufficient space on the storage medium
+ * \retval      PSA_ERROR_STORAGE_FAILURE        The operation failed because the physical storage has failed (Fatal error)
+ * \retval      PSA_ERROR_INVALID_ARGUMENT       The operation failed because one of the provided pointers(`p_data`)
+ *                                               is invalid, for example is `NULL` or references memory the caller cannot access
+ * \retval      PSA_ERROR_HARDWARE_FAILURE       The operation failed because an internal cryptographic operation failed.
+ * \retval      PSA_ERROR_INVALID_SIGNATURE      The operation failed because the provided `uid` doesnt match the autenticated uid from the storage
+ */
+psa_status_t psa_its_set(psa_storage_uid_t uid,
+                         uint32_t data_length,
+                         const void *p_data,
+                         psa_storage_create_flags_t create_flags)
+{
+  psa_status_t psa_status = check_set_arguments(data_length, p_data, create_flags);
+  if (psa_status != PSA_SUCCESS) {
+    return psa_status;
+  }
+
+  sli_its_acquire_mutex();
+  psa_status = write_its_file(uid, data_length, p_data, create_flags);
   sli_its_release_mutex();
   return psa_status;
 }
@@ -3240,6 +3573,9 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
   if (status == ECODE_NVM3_OK) {
     // Power-loss might occur, however upon boot, the look-up table will be
     // re-filled as long as the data has been successfully written to NVM3.
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+    drop_session_key(uid);
+#endif
     if ((NVM3_KEY_INVALID != clear_cache(nvm3_object_id))
         && (NVM3_KEY_INVALID != set_tomb(nvm3_object_id))) {
       psa_status = PSA_SUCCESS;
@@ -3326,6 +3662,127 @@ psa_status_t sli_psa_its_change_key_id(mbedtls_svc_key_id_t old_id,
   return status;
 }
 
+/**
+ * \brief Create or overwrite several ITS files with one ITS lock acquisition.
+ *
+ * \param[in] entries  The files to write, in write order
+ * \param[in] count    Number of entries
+ *
+ * \return      A status indicating the success/failure of the operation
+ *
+ * \retval      PSA_SUCCESS                      All files were written
+ * \retval      PSA_ERROR_INVALID_ARGUMENT       An entry is invalid, or a UID appears more than once
+ * \retval      PSA_ERROR_NOT_SUPPORTED          An entry has unsupported create flags
+ * \retval      PSA_ERROR_NOT_PERMITTED          A file of the batch exists with PSA_STORAGE_FLAG_WRITE_ONCE
+ * \retval      PSA_ERROR_INSUFFICIENT_STORAGE   The new files of the batch do not fit in the ITS
+ * \retval      PSA_ERROR_STORAGE_FAILURE        The physical storage has failed
+ */
+psa_status_t sli_psa_its_set_batch(const sli_psa_its_batch_entry_t *entries,
+                                   size_t count)
+{
+  psa_status_t psa_status = PSA_SUCCESS;
+  sli_its_file_meta_v2_t its_file_meta;
+  nvm3_ObjectKey_t nvm3_object_id;
+  nvm3_MemInfo_t mem_info;
+  size_t max_repacks;
+  size_t required_memory = 0;
+  size_t new_files = 0;
+  size_t free_files = SL_PSA_ITS_MAX_FILES;
+
+  if (count == 0U) {
+    return PSA_SUCCESS;
+  }
+  if (entries == NULL) {
+    return PSA_ERROR_INVALID_ARGUMENT;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    psa_status = check_set_arguments(entries[i].data_length,
+                                     entries[i].p_data,
+                                     entries[i].create_flags);
+    if (psa_status != PSA_SUCCESS) {
+      return psa_status;
+    }
+    for (size_t j = 0; j < i; j++) {
+      if (entries[j].uid == entries[i].uid) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+      }
+    }
+    required_memory += its_object_size(entries[i].data_length);
+  }
+
+  sli_its_acquire_mutex();
+
+  // Check every file before the first write, so that the batch is not
+  // stopped half-way by a write-once file, a file that fails authentication
+  // or a full ITS.
+  for (size_t i = 0; i < count; i++) {
+    psa_status = find_nvm3_id(entries[i].uid, false, &its_file_meta, NULL, NULL, &nvm3_object_id);
+    if (psa_status == PSA_ERROR_DOES_NOT_EXIST) {
+      new_files++;
+      continue;
+    }
+    if (psa_status != PSA_SUCCESS) {
+      goto exit;
+    }
+    if (its_file_meta.flags == PSA_STORAGE_FLAG_WRITE_ONCE
+#if defined(TFM_CONFIG_SL_SECURE_LIBRARY)
+        || its_file_meta.flags == PSA_STORAGE_FLAG_WRITE_ONCE_SECURE_ACCESSIBLE
+#endif
+        ) {
+      psa_status = PSA_ERROR_NOT_PERMITTED;
+      goto exit;
+    }
+  }
+
+  for (size_t i = 0; i < CACHE_WORDS_MAX; i++) {
+    free_files -= SL_POPCOUNT32(nvm3_uid_set_cache[i]);
+  }
+  if (new_files > free_files) {
+    psa_status = PSA_ERROR_INSUFFICIENT_STORAGE;
+    goto exit;
+  }
+
+  // Repack now for the whole batch, rather than in the middle of it when a
+  // write crosses the repack threshold. NVM3 only repacks below its own
+  // threshold, and one repack step can move objects without freeing memory
+  // yet, so keep going while NVM3 needs it, up to two steps per page. NVM3
+  // still repacks during the writes if it has to.
+  if (nvm3_getMemInfo(nvm3_defaultHandle, &mem_info) != ECODE_NVM3_OK) {
+    psa_status = PSA_ERROR_STORAGE_FAILURE;
+    goto exit;
+  }
+  max_repacks = 2U * (nvm3_defaultInit->nvmSize / FLASH_PAGE_SIZE);
+  for (size_t i = 0;
+       i < max_repacks
+       && mem_info.availableMemory < required_memory
+       && nvm3_repackNeeded(nvm3_defaultHandle);
+       i++) {
+    if (nvm3_repack(nvm3_defaultHandle) != ECODE_NVM3_OK
+        || nvm3_getMemInfo(nvm3_defaultHandle, &mem_info) != ECODE_NVM3_OK) {
+      psa_status = PSA_ERROR_STORAGE_FAILURE;
+      goto exit;
+    }
+  }
+
+  // An NVM3 write is atomic, so after a power loss each file holds either its
+  // previous or its new content. The files are written in order: if the batch
+  // is interrupted, the files written are the first ones of the batch.
+  for (size_t i = 0; i < count; i++) {
+    psa_status = write_its_file(entries[i].uid,
+                                entries[i].data_length,
+                                entries[i].p_data,
+                                entries[i].create_flags);
+    if (psa_status != PSA_SUCCESS) {
+      break;
+    }
+  }
+
+  exit:
+  sli_its_release_mutex();
+  return psa_status;
+}
+
 /**
  * \brief Check if the ITS encryption is enabled
  */
@@ -3338,6 +3795,18 @@ psa_status_t sli_psa_its_encrypted(void)
 #endif
 }
 
+/**
+ * \brief Zeroize all cached ITS session keys.
+ */
+void sli_psa_its_flush_session_keys(void)
+{
+#if defined(SLI_PSA_ITS_ENCRYPTED)
+  sli_its_acquire_mutex();
+  memset(g_cached_session_keys, 0, sizeof(g_cached_session_keys));
+  sli_its_release_mutex();
+#endif
+}
+
 #if defined(SLI_PSA_ITS_ENCRYPTED) && !defined(SEMAILBOX_PRESENT)
 /**
  * \brief Set the root key to be used when deriving session keys for ITS encryption.
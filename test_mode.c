@@ -0,0 +1,262 @@
+/**
+ * @file test_mode.c
+ * @brief Test Mode Registry and Scheduler
+ *
+ * Implementation of test_mode.h. Only one task trigger can be set at a
+ * time (losstst_task_tgr), so at most one mode is active; the resource
+ * check guards against a mode starting while the application still holds
+ * a set or a connection the mode needs.
+ */
+
+#include "test_mode.h"
+#include "app.h"
+#include "sl_sleeptimer.h"
+#include <stddef.h>
+#include <errno.h>
+
+/* ================== Scheduler State ================== */
+
+typedef enum {
+    TEST_MODE_IDLE,
+    TEST_MODE_SETTLE_1,        /* First settle period after setup */
+    TEST_MODE_SETTLE_2,        /* Second settle period after the settle hook */
+    TEST_MODE_RUN,
+} test_mode_state_t;
+
+static const test_mode_t *mode_table;
+static uint8_t mode_count;
+static test_mode_in_use_t mode_in_use;
+static const test_mode_t *mode_active;
+static test_mode_state_t mode_state = TEST_MODE_IDLE;
+static uint8_t mode_res_held;
+
+static sl_sleeptimer_timer_handle_t mode_timer;
+static volatile bool mode_timer_fired;
+
+/**
+ * @brief Timer callback: wake the application task
+ */
+static void mode_timer_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+    (void)handle;
+    (void)data;
+
+    mode_timer_fired = true;
+    app_proceed();
+}
+
+/**
+ * @brief (Re)start the scheduler timer
+ */
+static void mode_timer_start(uint32_t ms)
+{
+    mode_timer_fired = false;
+    sl_sleeptimer_restart_timer_ms(&mode_timer, ms, mode_timer_cb, NULL, 0, 0);
+}
+
+/**
+ * @brief Keep an active mode stepping without BLE events
+ */
+static void mode_tick(void)
+{
+    bool running = false;
+
+    sl_sleeptimer_is_timer_running(&mode_timer, &running);
+    if (!running) {
+        mode_timer_start(TEST_MODE_TICK_MS);
+    }
+}
+
+/**
+ * @brief Release the active mode
+ */
+static void mode_release(void)
+{
+    sl_sleeptimer_stop_timer(&mode_timer);
+    losstst_prio_apply(LOSSTST_PRIO_DEFAULT);
+    losstst_ctrl_apply(losstst_ctrl_default());
+    mode_res_held = 0;
+    mode_active = NULL;
+    mode_state = TEST_MODE_IDLE;
+}
+
+/**
+ * @brief Enter the settle period or the run state
+ */
+static void mode_settle(uint8_t phase)
+{
+    if (phase < 2 && mode_active->settle_ms[phase]) {
+        mode_state = phase ? TEST_MODE_SETTLE_2 : TEST_MODE_SETTLE_1;
+        mode_timer_start(mode_active->settle_ms[phase]);
+    } else {
+        mode_state = TEST_MODE_RUN;
+        mode_tick();
+    }
+}
+
+/**
+ * @brief Select and set up a triggered mode
+ */
+static void mode_start(const test_param_t *param)
+{
+    const test_mode_t *mode = NULL;
+
+    for (uint8_t i = 0; i < mode_count; i++) {
+        if (mode_table[i].trigger(0)) {
+            mode = &mode_table[i];
+            break;
+        }
+    }
+    if (mode == NULL) {
+        return;
+    }
+
+    /* Resources held elsewhere: refuse rather than fight over the radio */
+    if (mode_in_use != NULL && (mode_in_use() & mode->resources)) {
+        mode->trigger(-mode->trigger(0));
+        return;
+    }
+
+    mode_active = mode;
+    mode_res_held = mode->resources;
+    
+    /* Priorities in place before setup starts scanning or advertising */
+    losstst_prio_apply((LOSSTST_PRIO_AUTO == param->prio_profile) ? mode->prio : param->prio_profile);
+    losstst_ctrl_apply(param->ctrl_switches);
+
+    if (mode->resources & TEST_MODE_RES_ADV_SETS) {
+        for (uint8_t idx = 0; idx <= 3; idx++) {
+            blocking_adv(idx);
+        }
+    }
+
+    if (mode->setup(param)) {
+        mode->trigger(-mode->trigger(0));
+        mode_release();
+        return;
+    }
+
+    test_mode_resched(true);
+    mode_settle(0);
+}
+
+/* ================== Public Functions ================== */
+
+int test_mode_register(const test_mode_t *table, uint8_t count, test_mode_in_use_t in_use)
+{
+    if (table == NULL || 0 == count) {
+        return -EINVAL;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].trigger == NULL || table[i].setup == NULL || table[i].step == NULL) {
+            return -EINVAL;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            if (table[j].trigger == table[i].trigger) {
+                return -EINVAL;
+            }
+        }
+    }
+
+    mode_table = table;
+    mode_count = count;
+    mode_in_use = in_use;
+    return 0;
+}
+
+void test_mode_run(const test_param_t *param)
+{
+    int err;
+
+    if (mode_table == NULL) {
+        return;
+    }
+
+    switch (mode_state) {
+    case TEST_MODE_IDLE:
+        mode_start(param);
+        break;
+
+    case TEST_MODE_SETTLE_1:
+    case TEST_MODE_SETTLE_2:
+        if (mode_active->abort != NULL && mode_active->abort()) {
+            mode_release();
+            break;
+        }
+        if (!mode_timer_fired) {
+            break;
+        }
+        if (TEST_MODE_SETTLE_1 == mode_state) {
+            if (mode_active->settle != NULL) {
+                mode_active->settle();
+            }
+            mode_settle(1);
+        } else {
+            mode_settle(2);
+        }
+        break;
+
+    case TEST_MODE_RUN:
+        err = mode_active->step();
+        if (err <= 0) {
+            const test_mode_t *mode = mode_active;
+
+            mode->trigger(-mode->trigger(0));
+            mode_release();
+            if (mode->teardown != NULL) {
+                mode->teardown(err);
+            }
+        } else {
+            mode_tick();
+        }
+        break;
+    }
+}
+
+int8_t test_mode_trigger(void)
+{
+    int8_t tgr_val = 0;
+
+    for (uint8_t i = 0; i < mode_count; i++) {
+        int8_t val = mode_table[i].trigger(0);
+        if (val > tgr_val) {
+            tgr_val = val;
+        }
+    }
+    return tgr_val;
+}
+
+int test_mode_resched(bool update)
+{
+    int result = 0;
+    static int8_t tgr_stamp = 0;
+    int8_t tgr_val = test_mode_trigger();
+
+    if (tgr_stamp == 0 && tgr_val != 0) {
+        /* Task trigger activated */
+        result = 2;
+        if (update) {
+            tgr_stamp = tgr_val;
+        }
+    }
+    else if (tgr_stamp != 0 && tgr_val == 0) {
+        /* Task trigger cleared */
+        result = -2;
+        if (update) {
+            tgr_stamp = tgr_val;
+        }
+    }
+
+    return result;
+}
+
+const test_mode_t *test_mode_active(void)
+{
+    return mode_active;
+}
+
+uint8_t test_mode_resources(void)
+{
+    return mode_res_held;
+}
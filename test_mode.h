@@ -0,0 +1,128 @@
+/**
+ * @file test_mode.h
+ * @brief Test Mode Registry and Scheduler
+ *
+ * Each test mode (Sender, Scanner, Ping, ...) is described by a table
+ * entry with its trigger, hooks and the radio resources it occupies.
+ * The scheduler picks the triggered mode, runs setup, an optional settle
+ * period and then the step function until the mode finishes or aborts.
+ *
+ * Features:
+ * - Registry validation (hooks present, triggers unique)
+ * - Resource check: a mode only starts if the application does not
+ *   hold any of its resources (log link, connection advertising, ...)
+ * - Controller scheduler priority profile per mode and the controller
+ *   switches of the test parameters, applied before setup and reverted
+ *   to the build defaults when the mode ends
+ * - Event driven: steps run on every app_proceed() (BLE events, buttons)
+ *   and on a tick timer while a mode is active; settle periods are timed
+ *   without blocking the application task
+ */
+
+#ifndef TEST_MODE_H
+#define TEST_MODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "losstst_svc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Resources ==================== */
+
+#define TEST_MODE_RES_ADV_SETS      0x01    /**< Test advertising sets 0-3 */
+#define TEST_MODE_RES_ADV_STATUS    0x02    /**< Status advertising set 4 */
+#define TEST_MODE_RES_ADV_EXTRA     0x04    /**< Advertising sets beyond 4 */
+#define TEST_MODE_RES_SCANNER       0x08    /**< Scanner */
+#define TEST_MODE_RES_CONNECTION    0x10    /**< A connection of its own */
+
+#define TEST_MODE_TICK_MS           10      /**< Step period without BLE events */
+
+/**
+ * @brief Test mode descriptor
+ *
+ * Hooks other than setup and step may be NULL.
+ */
+typedef struct {
+    const char *name;                           /**< Display name */
+    int8_t (*trigger)(int8_t set);              /**< Task trigger accessor (xxx_task_tgr) */
+    int (*setup)(const test_param_t *param);    /**< 0 on success, negative errno on failure */
+    int (*step)(void);                          /**< >0: continue, 0: finished, <0: error/aborted */
+    bool (*abort)(void);                        /**< True to abort during setup/settle */
+    void (*settle)(void);                       /**< Called between the two settle periods */
+    void (*teardown)(int result);               /**< Called with the last step result */
+    uint8_t resources;                          /**< TEST_MODE_RES_* claimed while active */
+    uint8_t prio;                               /**< Scheduler priority profile (LOSSTST_PRIO_*) */
+    uint16_t settle_ms[2];                      /**< Wait before the first step (0 = none) */
+} test_mode_t;
+
+/**
+ * @brief Resources in use outside the test modes
+ *
+ * @return TEST_MODE_RES_* mask
+ */
+typedef uint8_t (*test_mode_in_use_t)(void);
+
+/**
+ * @brief Register the mode table
+ *
+ * Table order is the selection priority when several triggers are set.
+ * A triggered mode whose resources overlap in_use() is refused and its
+ * trigger cleared.
+ *
+ * @param table Mode descriptors (must stay valid)
+ * @param count Number of descriptors
+ * @param in_use Resources held by the application (NULL = none)
+ * @return 0 on success, -EINVAL if a descriptor lacks trigger, setup or
+ *         step, or two descriptors share a trigger
+ */
+int test_mode_register(const test_mode_t *table, uint8_t count, test_mode_in_use_t in_use);
+
+/**
+ * @brief Run one scheduler pass
+ *
+ * Call on every application wakeup.
+ *
+ * @param param Test parameters passed to setup
+ */
+void test_mode_run(const test_param_t *param);
+
+/**
+ * @brief Highest task trigger of all registered modes
+ *
+ * @return Trigger value (0 if none set)
+ */
+int8_t test_mode_trigger(void);
+
+/**
+ * @brief Check if the task trigger changed
+ *
+ * Detects trigger changes from the LCD menu or other external sources;
+ * abort hooks of running modes are built on it.
+ *
+ * @param update If true, remember the current trigger as reference
+ * @return 2: task trigger set, -2: task trigger cleared, 0: no change
+ */
+int test_mode_resched(bool update);
+
+/**
+ * @brief Mode currently scheduled
+ *
+ * @return Descriptor, NULL if idle
+ */
+const test_mode_t *test_mode_active(void);
+
+/**
+ * @brief Resources held by the active mode
+ *
+ * @return TEST_MODE_RES_* mask
+ */
+uint8_t test_mode_resources(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_MODE_H
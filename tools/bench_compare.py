@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Host microbenchmark regression check.
+
+Runs the host_bench executable of the cmake_host build (or reads a result
+file it wrote), and compares every benchmark with the checked-in baseline
+(cmake_host/bench_baseline.json). Both files use the Google Benchmark JSON
+format.
+
+Times are normalised by the calibration benchmark of the same run
+(context "calibration", a fixed arithmetic loop), so a baseline taken on
+one machine holds on a faster or slower one: what is compared is the cost
+relative to the machine, not nanoseconds.
+
+A benchmark regresses when its normalised time exceeds the baseline by
+more than its tolerance: the "tolerance" field of the baseline entry, or
+--tolerance (default 0.75, i.e. 75 % slower). Benchmarks missing from
+either side are listed but do not fail. Results of a different build type
+than the baseline are not compared.
+
+Exit status: 0 when nothing regressed, 1 on a regression, 2 on a usage
+or run error.
+
+--update writes the run as the new baseline, keeping the tolerances of
+the old one. Commit it with the change that moved the numbers.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+DEFAULT_TOLERANCE = 0.75
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def run_bench(exe, out, extra):
+    cmd = [exe, "--benchmark_out=" + out] + extra
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    sys.stdout.write(res.stdout)
+    if res.returncode != 0:
+        raise RuntimeError("%s exited with %d" % (exe, res.returncode))
+    return load(out)
+
+
+def times(result):
+    """Name -> real time (ns) of the iteration runs"""
+    out = {}
+    for b in result.get("benchmarks", []):
+        if b.get("run_type", "iteration") != "iteration":
+            continue
+        scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[b.get("time_unit", "ns")]
+        out[b["name"]] = b["real_time"] * scale
+    return out
+
+
+def calibration(result, t):
+    name = result.get("context", {}).get("calibration")
+    if not name or name not in t or t[name] <= 0:
+        raise RuntimeError("no calibration benchmark in the result")
+    return name, t[name]
+
+
+def compare(base, cur, default_tol):
+    bt = times(base)
+    ct = times(cur)
+    cal_name, b_cal = calibration(base, bt)
+    _, c_cal = calibration(cur, ct)
+    tol = {b["name"]: b.get("tolerance", default_tol) for b in base.get("benchmarks", [])}
+
+    print("# Calibration: baseline %.1f ns, this run %.1f ns (x%.2f)"
+          % (b_cal, c_cal, c_cal / b_cal))
+    print("%-32s %12s %12s %8s %7s  %s" % ("benchmark", "base (ns)", "now (ns)", "change",
+                                           "limit", "result"))
+    regressions = []
+    for name in sorted(set(bt) | set(ct)):
+        if name == cal_name:
+            continue
+        if name not in bt:
+            print("%-32s %12s %12.1f %8s %7s  new" % (name, "-", ct[name], "", ""))
+            continue
+        if name not in ct:
+            print("%-32s %12.1f %12s %8s %7s  not run" % (name, bt[name], "-", "", ""))
+            continue
+        change = (ct[name] / c_cal) / (bt[name] / b_cal) - 1.0
+        limit = tol[name]
+        verdict = "ok"
+        if change > limit:
+            verdict = "REGRESSION"
+            regressions.append(name)
+        elif change < -limit:
+            verdict = "faster (update the baseline)"
+        print("%-32s %12.1f %12.1f %+7.0f%% %+6.0f%%  %s"
+              % (name, bt[name], ct[name], change * 100, limit * 100, verdict))
+    return regressions
+
+
+def update(base_path, base, cur):
+    tol = {}
+    if base:
+        tol = {b["name"]: b["tolerance"] for b in base.get("benchmarks", []) if "tolerance" in b}
+    for b in cur.get("benchmarks", []):
+        if b["name"] in tol:
+            b["tolerance"] = tol[b["name"]]
+    with open(base_path, "w") as f:
+        json.dump(cur, f, indent=2)
+        f.write("\n")
+    print("# Baseline written to %s" % base_path)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--bench", help="host_bench executable to run")
+    src.add_argument("--result", help="result JSON of an earlier run")
+    ap.add_argument("--baseline", required=True, help="baseline JSON")
+    ap.add_argument("--out", default="bench_output.json",
+                    help="where the run writes its JSON (with --bench)")
+    ap.add_argument("--tolerance", type=float, default=DEFAULT_TOLERANCE,
+                    help="allowed slowdown without a per-benchmark tolerance (default %(default)s)")
+    ap.add_argument("--update", action="store_true", help="write the run as the new baseline")
+    ap.add_argument("bench_args", nargs="*", help="extra host_bench options (after --)")
+    args = ap.parse_args()
+
+    try:
+        if args.bench:
+            cur = run_bench(args.bench, args.out, args.bench_args)
+        else:
+            cur = load(args.result)
+        base = load(args.baseline) if os.path.exists(args.baseline) else None
+
+        if args.update:
+            update(args.baseline, base, cur)
+            return 0
+        if base is None:
+            print("# No baseline %s, nothing to compare (write one with --update)" % args.baseline)
+            return 0
+
+        b_type = base.get("context", {}).get("library_build_type")
+        c_type = cur.get("context", {}).get("library_build_type")
+        if b_type != c_type:
+            print("# Baseline is a %s build, this is a %s build: not compared" % (b_type, c_type))
+            return 0
+
+        regressions = compare(base, cur, args.tolerance)
+    except (OSError, ValueError, KeyError, RuntimeError) as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 2
+
+    if regressions:
+        print("# %d benchmark(s) regressed: %s" % (len(regressions), ", ".join(regressions)))
+        return 1
+    print("# No regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+"""PTI packet trace decoder and loss cross-check.
+
+Decodes the Packet Trace Interface stream of the radio
+(config/sl_rail_util_pti_config.h: UART mode, 1.6 Mbaud, PC4/PC5) into
+per-packet RX/TX events and checks the loss test counters of the app
+against them. The PTI stream holds every frame the radio demodulated,
+including CRC failures and aborted receptions, so it tells apart:
+
+  sync miss   expected - frames seen on air (radio never detected the frame)
+  CRC error   frame detected, CRC failed
+  RX abort    frame detected, reception aborted
+  host drop   frame received OK but never counted by the app
+
+Frame layout (UART PTI, EFR32 appended info):
+
+  start | PDU ... | radio cfg | RSSI | radio info | status | info cfg | end
+
+  start       0xF8 RX start, 0xFC TX start
+  end         0xF9 RX end, 0xFA RX abort, 0xFD TX end, 0xFE TX abort
+  info cfg    bit 6 RX, bits 5:3 version, bits 2:0 appended bytes before it
+  status      bits 7:4 error code (0 OK, 1 CRC error, 2 abort), 3:0 protocol
+  radio info  bits 5:0 channel, bit 6 sync word, bit 7 antenna
+  RSSI        int8 dBm, RX only
+  radio cfg   bits 1:0 BLE PHY (0 1M, 1 2M, 2 coded), version >= 1 only
+
+The appended bytes are read backwards from the info cfg byte, so older
+layouts without radio cfg decode as well. Marker bytes inside a frame are
+escaped with 0xF5 followed by the byte XOR 0x20. The hand-assembled
+frames in cmake_host/test/test_pti.py pin this layout; the protocol id
+is RAIL_PTI_PROTOCOL_BLE of the SDK. Should a capture disagree with it,
+APPENDED and the marker constants are the only places to adjust, and the
+capture replaces those frames; "encode" output decodes with the same
+tables.
+
+Timestamps: UART PTI carries none. Captures from a timestamping logger
+are read as text lines "t_us hexbytes" (--timed); for a plain binary
+capture the time is the byte offset at the PTI baud rate, which is only
+a lower bound because idle gaps are not recorded.
+
+Loss test frames are recognised by the manufacturer data of the app
+(man_id 0xFFFF, form_id 0xBAAB, optionally a device EUI-64 with --eui).
+CRC failed frames whose marker got corrupted cannot be attributed and are
+reported as foreign CRC errors.
+
+Commands:
+  decode   print the decoded events
+  check    compare a capture with the "[SCAN] <phy>: rcv/exp" log lines
+  trace    write the report arrival trace for tools/rptq_size.py
+  encode   write a synthetic capture with given loss causes
+"""
+
+import argparse
+import random
+import re
+import struct
+import sys
+from collections import Counter, namedtuple
+
+BAUD = 1600000
+BYTE_US = 10 * 1e6 / BAUD           # 8N1
+
+RX_START, RX_END, RX_ABORT = 0xF8, 0xF9, 0xFA
+TX_START, TX_END, TX_ABORT = 0xFC, 0xFD, 0xFE
+ESCAPE = 0xF5
+MARKERS = {RX_START, RX_END, RX_ABORT, TX_START, TX_END, TX_ABORT, ESCAPE}
+
+ERR_OK, ERR_CRC, ERR_ABORT = 0, 1, 2
+PROTOCOL_BLE = 3
+
+# Appended bytes before info cfg, oldest first: (name, rx only, min version)
+APPENDED = (("radio_cfg", False, 1), ("rssi", True, 0),
+            ("radio_info", False, 0), ("status", False, 0))
+
+PHYS = {0: "1M", 1: "2M", 2: "S8"}
+PHY_IDS = {v: k for k, v in PHYS.items()}
+
+# Manufacturer data of the loss test burst: man_id, form_id (little-endian)
+LOSS_MARKER = bytes((0xFF, 0xFF, 0xAB, 0xBA))
+
+Event = namedtuple("Event", "t_us rx ok err channel rssi phy pdu")
+
+
+# ==================== Decoder ====================
+
+def unescape(data):
+    out = bytearray()
+    it = iter(data)
+    for b in it:
+        out.append((next(it, 0x20) ^ 0x20) if b == ESCAPE else b)
+    return bytes(out)
+
+
+def parse_frame(t_us, start, body, end):
+    """Event of one start..end frame, None if it is malformed."""
+    body = unescape(body)
+    rx = start == RX_START
+    if not body or rx != (end in (RX_END, RX_ABORT)):
+        return None
+    cfg = body[-1]
+    count = cfg & 0x07
+    version = (cfg >> 3) & 0x07
+    if bool(cfg & 0x40) != rx or count + 1 > len(body):
+        return None
+
+    names = [n for n, rx_only, ver in APPENDED if (rx or not rx_only) and version >= ver]
+    names = names[len(names) - count:] if count <= len(names) else None
+    if names is None:
+        return None
+    info = dict(zip(names, body[len(body) - 1 - count:-1]))
+    pdu = body[:len(body) - 1 - count]
+
+    status = info.get("status", 0)
+    err = status >> 4
+    if end in (RX_ABORT, TX_ABORT) and err == ERR_OK:
+        err = ERR_ABORT
+    rssi = info.get("rssi")
+    return Event(t_us=t_us, rx=rx, ok=err == ERR_OK, err=err,
+                 channel=info.get("radio_info", 0) & 0x3F,
+                 rssi=None if rssi is None else struct.unpack("b", bytes((rssi,)))[0],
+                 phy=PHYS.get(info["radio_cfg"] & 0x03) if "radio_cfg" in info else None,
+                 pdu=pdu)
+
+
+def decode(chunks):
+    """Decode (t_us, bytes) chunks; yields Events, resyncing on stray markers."""
+    start = None
+    body = bytearray()
+    t0 = 0.0
+    for t_us, data in chunks:
+        for i, b in enumerate(data):
+            t = t_us + i * BYTE_US
+            if b in (RX_START, TX_START):
+                start, t0 = b, t
+                body.clear()
+            elif b in (RX_END, RX_ABORT, TX_END, TX_ABORT):
+                if start is not None:
+                    ev = parse_frame(t0, start, bytes(body), b)
+                    if ev is not None:
+                        yield ev
+                start = None
+            elif start is not None:
+                body.append(b)
+
+
+def read_capture(path, timed):
+    if not timed:
+        with open(path, "rb") as f:
+            return [(0.0, f.read())]
+    chunks = []
+    with open(path) as f:
+        for line in f:
+            parts = line.split(None, 1)
+            if len(parts) != 2 or parts[0].startswith("#"):
+                continue
+            try:
+                chunks.append((float(parts[0]), bytes.fromhex(parts[1].strip())))
+            except ValueError:
+                continue
+    return chunks
+
+
+# ==================== BLE Payload ====================
+
+def adv_data(pdu):
+    """AdvData of a legacy ADV_* or AUX_ADV_IND PDU, None for other PDUs."""
+    if len(pdu) < 2:
+        return None
+    kind = pdu[0] & 0x0F
+    if kind in (0x0, 0x2, 0x6):
+        return pdu[8:2 + pdu[1]]
+    if kind == 0x7 and len(pdu) >= 3:
+        hdr_len = pdu[2] & 0x3F
+        return pdu[3 + hdr_len:2 + pdu[1]]
+    return None
+
+
+def loss_packet(ev, eui=None):
+    """True if the event carries the loss test burst (of the given EUI-64)."""
+    data = adv_data(ev.pdu)
+    if data is None:
+        return False
+    i = data.find(LOSS_MARKER)
+    if i < 0:
+        return False
+    # man_id, form_id, pre_cnt, flw_cnt, eui (big-endian)
+    tail = data[i + 8:i + 16]
+    return eui is None or (len(tail) == 8 and int.from_bytes(tail, "big") == eui)
+
+
+# ==================== Cross-check ====================
+
+SCAN_RE = re.compile(r"\[SCAN\] (\w+): (\d+)/(\d+)")
+
+
+def read_log(path):
+    """Sum the per-PHY rcv/exp of all "[SCAN]" result lines."""
+    totals = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = SCAN_RE.search(line)
+            if m:
+                rcv, exp = totals.get(m.group(1), (0, 0))
+                totals[m.group(1)] = (rcv + int(m.group(2)), exp + int(m.group(3)))
+    return totals
+
+
+def classify(events, eui=None):
+    """Per-PHY Counter of ok/crc/abort test frames plus foreign CRC errors."""
+    stats = {}
+    foreign_crc = 0
+    for ev in events:
+        if not ev.rx:
+            continue
+        if not loss_packet(ev, eui):
+            foreign_crc += ev.err == ERR_CRC
+            continue
+        phy = "BLE4" if ev.phy == "1M" and (ev.pdu[0] & 0x0F) != 0x7 else (ev.phy or "all")
+        kind = "ok" if ev.ok else "crc" if ev.err == ERR_CRC else "abort"
+        stats.setdefault(phy, Counter())[kind] += 1
+    return stats, foreign_crc
+
+
+def check(stats, foreign_crc, log):
+    print("phy   exp    rcv  | air ok  crc  abort | sync miss  crc  abort  host drop")
+    if "all" in stats:
+        # Capture without PHY info: compare against the sum of all PHYs
+        log = {"all": tuple(map(sum, zip(*log.values())))} if log else {}
+    for phy in sorted(set(stats) | set(log)):
+        rcv, exp = log.get(phy, (0, 0))
+        c = stats.get(phy, Counter())
+        seen = c["ok"] + c["crc"] + c["abort"]
+        print(f"{phy:4s} {exp:5d} {rcv:6d}  | {c['ok']:6d} {c['crc']:4d} {c['abort']:6d} "
+              f"| {max(exp - seen, 0):9d} {c['crc']:4d} {c['abort']:6d} {c['ok'] - rcv:10d}")
+    print(f"\nCRC errors without loss test marker: {foreign_crc}")
+
+
+# ==================== Encoder ====================
+
+def escape(data):
+    out = bytearray()
+    for b in data:
+        out += bytes((ESCAPE, b ^ 0x20)) if b in MARKERS else bytes((b,))
+    return bytes(out)
+
+
+def encode_frame(pdu, rx=True, err=ERR_OK, channel=37, rssi=-60, phy="1M", version=1):
+    """One PTI frame; inverse of parse_frame()."""
+    values = {"radio_cfg": PHY_IDS.get(phy, 0), "rssi": rssi & 0xFF,
+              "radio_info": channel & 0x3F, "status": (err << 4) | PROTOCOL_BLE}
+    info = bytes(values[n] for n, rx_only, ver in APPENDED
+                 if (rx or not rx_only) and version >= ver)
+    cfg = (0x40 if rx else 0) | (version << 3) | len(info)
+    if rx:
+        start, end = RX_START, RX_ABORT if err == ERR_ABORT else RX_END
+    else:
+        start, end = TX_START, TX_ABORT if err == ERR_ABORT else TX_END
+    return bytes((start,)) + escape(pdu + info + bytes((cfg,))) + bytes((end,))
+
+
+def loss_pdu(pre_cnt, eui, ext, adv_addr=b"\x01\x02\x03\x04\x05\xc6"):
+    """ADV_NONCONN_IND (ext=False) or AUX_ADV_IND with the loss test burst."""
+    manu = struct.pack("<HHhH", 0xFFFF, 0xBAAB, pre_cnt, 0) + eui.to_bytes(8, "big")
+    data = bytes((2, 0x01, 0x06, len(manu) + 1, 0xFF)) + manu
+    if ext:
+        payload = bytes((1 + 6, 0x01)) + adv_addr + data
+        return bytes((0x07, len(payload))) + payload
+    payload = adv_addr + data
+    return bytes((0x42, len(payload))) + payload
+
+
+def synth(args):
+    """Synthetic capture plus the counts the app would log."""
+    rng = random.Random(args.seed)
+    chunks, t = [], 0.0
+    ext = args.phy != "BLE4"
+    phy = "1M" if args.phy == "BLE4" else args.phy
+    counts = Counter()
+    for n in range(args.packets):
+        t += args.interval_ms * 1000.0
+        if rng.random() < args.noise:
+            pdu = bytes((0x40, 6)) + rng.randbytes(6)
+            chunks.append((t - 300, encode_frame(pdu, err=ERR_CRC, phy=phy)))
+        r = rng.random()
+        if r < args.sync_miss:
+            counts["sync"] += 1
+            continue
+        pdu = loss_pdu(args.packets - n, args.eui, ext)
+        r -= args.sync_miss
+        if r < args.crc:
+            err = ERR_CRC
+        elif r < args.crc + args.abort:
+            err = ERR_ABORT
+        else:
+            err = ERR_OK
+        counts[("ok", "crc", "abort")[err]] += 1
+        chunks.append((t, encode_frame(pdu, err=err, channel=rng.choice((37, 38, 39)) if not ext
+                                       else rng.randrange(37), rssi=rng.randint(-90, -40), phy=phy)))
+        if err == ERR_OK and rng.random() >= args.host_drop:
+            counts["rcv"] += 1
+    return chunks, counts
+
+
+# ==================== Main ====================
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    for name in ("decode", "check", "trace"):
+        s = sub.add_parser(name)
+        s.add_argument("capture", help="PTI capture (binary, or text with --timed)")
+        s.add_argument("--timed", action="store_true", help='capture lines "t_us hexbytes"')
+        s.add_argument("--eui", type=lambda v: int(v, 16), help="EUI-64 of the sender (hex)")
+        if name == "check":
+            s.add_argument("log", help="app debug output with [SCAN] result lines")
+        if name == "trace":
+            s.add_argument("--all", action="store_true",
+                           help="include foreign advertisers (the controller queues them too)")
+
+    s = sub.add_parser("encode")
+    s.add_argument("out", help="output capture (timed text)")
+    s.add_argument("--packets", type=int, default=250)
+    s.add_argument("--interval-ms", type=float, default=20.0)
+    s.add_argument("--phy", choices=("2M", "1M", "S8", "BLE4"), default="1M")
+    s.add_argument("--eui", type=lambda v: int(v, 16), default=0x0011223344556677)
+    s.add_argument("--sync-miss", type=float, default=0.02, help="probability per packet")
+    s.add_argument("--crc", type=float, default=0.02, help="probability per packet")
+    s.add_argument("--abort", type=float, default=0.005, help="probability per packet")
+    s.add_argument("--host-drop", type=float, default=0.01, help="probability per OK packet")
+    s.add_argument("--noise", type=float, default=0.05, help="foreign CRC errors per packet")
+    s.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    if args.cmd == "encode":
+        chunks, counts = synth(args)
+        with open(args.out, "w") as f:
+            for t, data in chunks:
+                f.write(f"{t:.0f} {data.hex()}\n")
+        print(f"[SCAN] {args.phy}: {counts['rcv']}/{args.packets}, "
+              f"sync miss {counts['sync']}, crc {counts['crc']}, abort {counts['abort']}, "
+              f"host drop {counts['ok'] - counts['rcv']}")
+        return
+
+    events = list(decode(read_capture(args.capture, args.timed)))
+    if not events:
+        sys.exit("no PTI frames decoded")
+
+    if args.cmd == "decode":
+        print("t_us        dir  status  ch  rssi  phy  test  len")
+        for ev in events:
+            status = ("OK", "CRC", "ABORT")[ev.err] if ev.err <= ERR_ABORT else f"E{ev.err}"
+            print(f"{ev.t_us:10.0f}  {'RX' if ev.rx else 'TX'}  {status:6s} {ev.channel:3d} "
+                  f"{'' if ev.rssi is None else ev.rssi:>5}  {ev.phy or '-':3s}  "
+                  f"{'yes' if loss_packet(ev, args.eui) else 'no':4s}  {len(ev.pdu)}")
+    elif args.cmd == "check":
+        stats, foreign_crc = classify(events, args.eui)
+        check(stats, foreign_crc, read_log(args.log))
+    else:
+        print("# t_us,len")
+        for ev in events:
+            if ev.rx and ev.ok and (args.all or loss_packet(ev, args.eui)):
+                data = adv_data(ev.pdu)
+                print(f"{ev.t_us:.0f},{len(ev.pdu) if data is None else len(data)}")
+
+
+if __name__ == "__main__":
+    main()
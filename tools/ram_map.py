@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""Static RAM map and budget check.
+
+Reads the GNU ld map file of the cmake_gcc build
+(bt_soc_empty_micriumos.map, written by -Map in bt_soc_empty_micriumos.cmake)
+and attributes every byte of RAM to a module and a symbol:
+
+  data     initialised variables (.data, copied from flash at boot)
+  bss      zeroed variables (.bss, COMMON)
+  noinit   variables kept over a reset (.noinit)
+  other    any other input section placed in RAM
+  [stack]  main stack (.stack, SL_STACK_SIZE)
+  [heap]   memory manager heap (.memory_manager_heap): all RAM left over.
+           The Bluetooth buffers (SL_BT_CONFIG_BUFFER_SIZE,
+           SL_BT_CONTROLLER_BUFFER_MEMORY), the RTOS task stacks and the
+           kernel objects are allocated from it at run time, so a static
+           variable added anywhere comes out of the heap.
+
+Module names:
+
+  losstst_svc                   app source in the repository root
+  autogen                       other app directories (first directory)
+  sdk/<path>                    Simplicity SDK object, source directory
+                                without a trailing src/inc
+  libbluetooth.a                archive member (prebuilt libraries, libc)
+  [toolchain]                   loose objects outside the tree (crt*.o)
+  [fill]                        alignment padding
+
+Symbols come from the section name of -fdata-sections builds
+(.bss.env_top -> env_top, static variables included) or, for plain .bss,
+.data and COMMON sections, from the symbol lines of the map.
+
+Budget file: one "module bytes" line per module (data + bss + noinit +
+other), "[heap] >=bytes" for the heap that must remain, and "total bytes"
+for all static RAM. Lines starting with '#' are comments. The exit status
+is 1 if a budget is exceeded, so the build fails.
+
+Baseline: --write-baseline stores the per-symbol map as CSV; --baseline
+reads such a file back and prints what changed per module and symbol.
+"""
+
+import argparse
+import csv
+import os
+import re
+import sys
+from collections import defaultdict
+
+# Output section to kind
+KINDS = {
+    ".data": "data",
+    ".bss": "bss",
+    ".noinit": "noinit",
+    ".stack": "[stack]",
+    ".memory_manager_heap": "[heap]",
+}
+STATIC_KINDS = ("data", "bss", "noinit", "other")
+
+RE_REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S+))?\s*$")
+RE_OUT_SECTION = re.compile(r"^(\.?[\w.$]+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+RE_IN_SECTION = re.compile(r"^ (\*fill\*|COMMON|\.[^\s*(]*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*))?$")
+RE_WRAPPED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+RE_SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_$][\w$.]*)\s*$")
+SDK_DIRS = ("simplicity_sdk", "gecko_sdk")
+SOURCE_DIRS = ("src", "source", "inc", "config")
+
+
+def module_of(obj):
+    """Module name of an object path from the map."""
+    m = re.match(r"^(.*)\(([^)]*)\)$", obj)
+    if m:
+        return os.path.basename(m.group(1))
+    path = obj.replace("\\", "/")
+    if ".dir/" in path:
+        path = path.split(".dir/", 1)[1]      # CMake object directory
+    elif os.path.isabs(path):
+        return "[toolchain]"
+    parts = [p for p in path.split("/") if p not in ("", ".", "..", "__")]
+    for i, p in enumerate(parts):
+        if p.startswith(SDK_DIRS):
+            d = parts[i + 1:-1]
+            while d and d[-1] in SOURCE_DIRS:
+                d.pop()
+            return "sdk/" + "/".join(d) if d else "sdk"
+    if len(parts) == 1:
+        return re.sub(r"(\.c|\.cpp|\.s|\.S)?\.(obj|o)$", "", parts[0])
+    return parts[0]
+
+
+def symbol_of(section):
+    """Variable name of a -fdata-sections input section, or None."""
+    for prefix in (".data.", ".bss.", ".noinit.", ".sbss.", ".sdata."):
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    return None
+
+
+class RamMap:
+    def __init__(self):
+        self.regions = []       # (name, origin, length)
+        self.items = []         # (kind, module, symbol, bytes)
+        self.reserved = {}      # "[stack]"/"[heap]" -> bytes
+
+    def in_ram(self, addr):
+        return any(o <= addr < o + l for _, o, l in self.regions)
+
+    def ram_size(self):
+        return sum(l for _, _, l in self.regions)
+
+    def rows(self):
+        """Items with the stack and heap, as written to a baseline."""
+        return self.items + [(n, n, n, s) for n, s in sorted(self.reserved.items())]
+
+
+def read_map(path, region_names):
+    with open(path, errors="replace") as f:
+        lines = f.read().splitlines()
+
+    rmap = RamMap()
+    i = 0
+    # Memory Configuration: name origin length attributes
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = RE_REGION.match(lines[i])
+        if m and m.group(1) not in ("Name", "*default*"):
+            name, attrs = m.group(1), m.group(4) or ""
+            if (region_names and name in region_names) or (not region_names and "w" in attrs):
+                rmap.regions.append((name, int(m.group(2), 16), int(m.group(3), 16)))
+        i += 1
+    if not rmap.regions:
+        sys.exit(f"{path}: no RAM region in the Memory Configuration")
+
+    out_kind = None
+    pending = None              # Input section name of a wrapped line
+    current = None              # [kind, module, section, addr, size, symbols]
+
+    def flush():
+        if current is None:
+            return
+        kind, module, section, addr, size, symbols = current
+        name = symbol_of(section)
+        if name or not symbols:
+            rmap.items.append((kind, module, name or section, size))
+            return
+        # Split the section at its symbols
+        symbols = sorted(s for s in symbols if addr <= s[0] < addr + size)
+        if not symbols or symbols[0][0] > addr:
+            symbols.insert(0, (addr, section))
+        for n, (a, sym) in enumerate(symbols):
+            end = symbols[n + 1][0] if n + 1 < len(symbols) else addr + size
+            if end > a:
+                rmap.items.append((kind, module, sym, end - a))
+
+    def start(section, addr, size, obj):
+        nonlocal current
+        flush()
+        current = None
+        if out_kind is None or out_kind.startswith("[") or size == 0 or not rmap.in_ram(addr):
+            return
+        module = "[fill]" if section == "*fill*" else module_of(obj.strip())
+        current = [out_kind, module, section, addr, size, []]
+
+    for line in lines[i + 1:]:
+        if line.startswith("OUTPUT(") or line.startswith("Cross Reference Table"):
+            break
+        if not line.strip():
+            continue
+        if not line[0].isspace():
+            flush()
+            current = None
+            pending = None
+            m = RE_OUT_SECTION.match(line)
+            if not m or "=" in line:
+                out_kind = None
+                continue
+            name = m.group(1)
+            out_kind = KINDS.get(name, "other")
+            if m.group(2) is not None:
+                addr, size = int(m.group(2), 16), int(m.group(3), 16)
+                if out_kind.startswith("[") and size and rmap.in_ram(addr):
+                    rmap.reserved[out_kind] = rmap.reserved.get(out_kind, 0) + size
+            else:
+                pending = ("out", name)
+            continue
+        if pending is not None:
+            m = RE_WRAPPED.match(line)
+            if m:
+                addr, size = int(m.group(1), 16), int(m.group(2), 16)
+                if pending[0] == "out":
+                    if out_kind.startswith("[") and size and rmap.in_ram(addr):
+                        rmap.reserved[out_kind] = rmap.reserved.get(out_kind, 0) + size
+                else:
+                    start(pending[1], addr, size, m.group(3))
+                pending = None
+                continue
+            pending = None
+        m = RE_IN_SECTION.match(line)
+        if m:
+            if m.group(2) is None:
+                flush()
+                current = None
+                pending = ("in", m.group(1))
+            else:
+                start(m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+            continue
+        m = RE_SYMBOL.match(line)
+        if m and current is not None:
+            current[5].append((int(m.group(1), 16), m.group(2)))
+    flush()
+    return rmap
+
+
+def read_budget(path):
+    budget = {}
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            try:
+                module, value = line.split()
+                minimum = value.startswith(">=")
+                budget[module] = (int(value[2:] if minimum else value, 0), minimum)
+            except ValueError:
+                sys.exit(f"{path}:{n}: expected 'module bytes' or 'module >=bytes'")
+    return budget
+
+
+def read_baseline(path):
+    items = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            items.append((row["kind"], row["module"], row["symbol"], int(row["bytes"])))
+    return items
+
+
+def module_totals(items):
+    totals = defaultdict(lambda: defaultdict(int))
+    for kind, module, _, size in items:
+        totals[module][kind] += size
+    return totals
+
+
+def print_map(rmap, top_symbols):
+    totals = module_totals(rmap.items)
+    static = sum(s for _, _, _, s in rmap.items)
+    print(f"{'module':44} {'data':>7} {'bss':>7} {'noinit':>7} {'other':>7} {'total':>7}")
+    for module in sorted(totals, key=lambda m: -sum(totals[m].values())):
+        t = totals[module]
+        print(f"{module:44} {t['data']:7} {t['bss']:7} {t['noinit']:7} {t['other']:7} "
+              f"{sum(t.values()):7}")
+    print(f"{'static RAM':44} {'':7} {'':7} {'':7} {'':7} {static:7}")
+    for name in ("[stack]", "[heap]"):
+        print(f"{name:44} {'':7} {'':7} {'':7} {'':7} {rmap.reserved.get(name, 0):7}")
+    size = rmap.ram_size()
+    free = size - static - sum(rmap.reserved.values())
+    regions = ", ".join(f"{n} {l}" for n, _, l in rmap.regions)
+    print(f"# RAM {size} ({regions}), unaccounted {free}")
+
+    if top_symbols:
+        print(f"\n{'symbol':36} {'module':32} {'kind':6} {'bytes':>7}")
+        for kind, module, sym, size in sorted(rmap.items, key=lambda x: -x[3])[:top_symbols]:
+            print(f"{sym[:36]:36} {module[:32]:32} {kind:6} {size:7}")
+
+
+def print_diff(items, base, top_symbols):
+    now_mod = {m: sum(t.values()) for m, t in module_totals(items).items()}
+    old_mod = {m: sum(t.values()) for m, t in module_totals(base).items()}
+    changed = [(m, old_mod.get(m, 0), now_mod.get(m, 0)) for m in set(now_mod) | set(old_mod)
+               if now_mod.get(m, 0) != old_mod.get(m, 0)]
+    total_old, total_now = sum(old_mod.values()), sum(now_mod.values())
+    print(f"\n# Change against the baseline: {total_now - total_old:+d} bytes "
+          f"({total_old} -> {total_now})")
+    if not changed:
+        return
+    print(f"{'module':44} {'baseline':>8} {'now':>8} {'change':>8}")
+    for m, old, now in sorted(changed, key=lambda x: -abs(x[2] - x[1])):
+        print(f"{m:44} {old:8} {now:8} {now - old:+8}")
+
+    def by_symbol(lst):
+        d = defaultdict(int)
+        for _, module, sym, size in lst:
+            d[(module, sym)] += size
+        return d
+
+    now_sym, old_sym = by_symbol(items), by_symbol(base)
+    sym_changed = [(k, old_sym.get(k, 0), now_sym.get(k, 0)) for k in set(now_sym) | set(old_sym)
+                   if now_sym.get(k, 0) != old_sym.get(k, 0)]
+    print(f"\n{'symbol':36} {'module':32} {'baseline':>8} {'now':>8}")
+    for (module, sym), old, now in sorted(sym_changed, key=lambda x: -abs(x[2] - x[1]))[:top_symbols or 20]:
+        print(f"{sym[:36]:36} {module[:32]:32} {old:8} {now:8}")
+
+
+def check_budget(rmap, budget):
+    totals = {m: sum(t.values()) for m, t in module_totals(rmap.items).items()}
+    totals["total"] = sum(s for _, _, _, s in rmap.items)
+    totals.update(rmap.reserved)
+    failed = 0
+    for module, (limit, minimum) in sorted(budget.items()):
+        used = totals.get(module, 0)
+        if (used < limit) if minimum else (used > limit):
+            rel = "below" if minimum else "above"
+            print(f"error: {module}: {used} bytes, {abs(used - limit)} {rel} the budget of {limit}",
+                  file=sys.stderr)
+            failed += 1
+    unbudgeted = sorted(m for m in totals if m not in budget and not m.startswith(("sdk", "[", "lib"))
+                        and m != "total")
+    if unbudgeted:
+        print(f"# Modules without a budget: {', '.join(unbudgeted)}")
+    return failed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0],
+                                 epilog="See the module docstring for the file formats.")
+    ap.add_argument("map", help="linker map file")
+    ap.add_argument("--region", action="append", default=[],
+                    help="RAM region name (repeatable, default: all writable regions)")
+    ap.add_argument("--symbols", type=int, default=0, help="list the N largest symbols")
+    ap.add_argument("--budget", help="budget file; exit status 1 if a budget is exceeded")
+    ap.add_argument("--baseline", help="baseline CSV to compare with (a missing file is skipped)")
+    ap.add_argument("--write-baseline", metavar="CSV", help="write the symbol map as a baseline")
+    ap.add_argument("--quiet", action="store_true", help="only print the budget check and the diff")
+    args = ap.parse_args()
+
+    rmap = read_map(args.map, args.region)
+    if not args.quiet:
+        print_map(rmap, args.symbols)
+    if args.baseline and os.path.exists(args.baseline):
+        print_diff(rmap.rows(), read_baseline(args.baseline), args.symbols)
+    if args.write_baseline:
+        with open(args.write_baseline, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(["kind", "module", "symbol", "bytes"])
+            for item in sorted(rmap.rows(), key=lambda x: (x[1], x[2])):
+                w.writerow(item)
+    if args.budget and check_budget(rmap, read_budget(args.budget)):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
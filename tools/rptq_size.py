@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Advertising report queue sizing.
+
+Replays a trace of advertising report arrivals through a model of the
+controller report queue and recommends SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS
+and SL_BT_CONTROLLER_BUFFER_MEMORY (config/sl_btctrl_config.h).
+
+Model: reports enter a FIFO of depth Q when they are received on air. The
+host takes one report at a time and needs --service-us per report; during
+a stall it takes none. A report that finds Q reports waiting is dropped,
+as the controller does.
+
+Trace: CSV with one report per line, "t_us[,len]". t_us is the air
+arrival time in microseconds, e.g. from a PTI capture (tools/pti.py) or a
+sniffer; len is the advertising data length (default --len). Lines
+starting with '#' and a header line are ignored.
+
+Stalls: "start_us:duration_us" with --stall (repeatable) or a CSV file
+with "start_us,duration_us" lines via --stall-file.
+
+Buffer memory is an estimate: every queued report is assumed to take
+len + --overhead bytes, and --acl-bytes stay reserved for connections.
+"""
+
+import argparse
+import bisect
+import csv
+import sys
+from collections import deque
+
+
+def load_trace(path, default_len):
+    reports = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].lstrip().startswith("#"):
+                continue
+            try:
+                t = int(float(row[0]))
+            except ValueError:
+                continue  # header
+            length = int(row[1]) if len(row) > 1 and row[1].strip() else default_len
+            reports.append((t, length))
+    reports.sort()
+    return reports
+
+
+def load_stalls(args):
+    stalls = []
+    for spec in args.stall:
+        start, dur = spec.split(":")
+        stalls.append((int(start), int(dur)))
+    if args.stall_file:
+        with open(args.stall_file, newline="") as f:
+            for row in csv.reader(f):
+                if not row or row[0].lstrip().startswith("#"):
+                    continue
+                try:
+                    stalls.append((int(float(row[0])), int(float(row[1]))))
+                except ValueError:
+                    continue
+    stalls.sort()
+    return stalls
+
+
+class Host:
+    """Host consumer with stall windows."""
+
+    def __init__(self, stalls):
+        self.starts = [s for s, _ in stalls]
+        self.stalls = stalls
+
+    def next_free(self, t):
+        """Earliest time >= t outside any stall."""
+        i = bisect.bisect_right(self.starts, t) - 1
+        while 0 <= i < len(self.stalls):
+            start, dur = self.stalls[i]
+            if start <= t < start + dur:
+                t = start + dur
+                i += 1
+            elif start > t:
+                break
+            else:
+                i += 1
+        return t
+
+
+def simulate(reports, depth, service_us, host):
+    """Return (drops, peak reports queued, peak bytes queued)."""
+    queue = deque()
+    queued_bytes = 0
+    free_at = 0
+    drops = 0
+    peak = 0
+    peak_bytes = 0
+
+    for t, length in reports:
+        # Deliver what the host could take before this arrival
+        while queue:
+            start = host.next_free(max(free_at, queue[0][0]))
+            if start > t:
+                break
+            _, done_len = queue.popleft()
+            queued_bytes -= done_len
+            free_at = start + service_us
+
+        if len(queue) >= depth:
+            drops += 1
+            continue
+        queue.append((t, length))
+        queued_bytes += length
+        peak = max(peak, len(queue))
+        peak_bytes = max(peak_bytes, queued_bytes)
+
+    return drops, peak, peak_bytes
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    p.add_argument("trace", help="report arrival trace (CSV: t_us[,len])")
+    p.add_argument("--service-us", type=int, default=300,
+                   help="host processing time per report (default 300)")
+    p.add_argument("--stall", action="append", default=[],
+                   help="host stall start_us:duration_us (repeatable)")
+    p.add_argument("--stall-file", help="CSV of start_us,duration_us stalls")
+    p.add_argument("--len", type=int, default=31,
+                   help="data length of reports without one in the trace")
+    p.add_argument("--overhead", type=int, default=24,
+                   help="assumed controller bytes per queued report besides data")
+    p.add_argument("--acl-bytes", type=int, default=1602,
+                   help="buffer memory kept for connections (default 3 x 2 x 267)")
+    p.add_argument("--max-drops", type=int, default=0,
+                   help="acceptable drops for the recommendation (default 0)")
+    p.add_argument("--max-depth", type=int, default=255,
+                   help="largest queue depth to try (config limit 255)")
+    args = p.parse_args()
+
+    reports = load_trace(args.trace, args.len)
+    if not reports:
+        sys.exit("empty trace")
+    host = Host(load_stalls(args))
+    reports_ovh = [(t, n + args.overhead) for t, n in reports]
+
+    print("depth  drops  drop%  peak  peak_bytes")
+    recommended = None
+    for depth in range(1, args.max_depth + 1):
+        drops, peak, peak_bytes = simulate(reports_ovh, depth, args.service_us, host)
+        if depth <= 16 or depth % 8 == 0 or (recommended is None and drops <= args.max_drops):
+            print(f"{depth:5d}  {drops:5d}  {100.0 * drops / len(reports):5.2f}  {peak:4d}  {peak_bytes:10d}")
+        if recommended is None and drops <= args.max_drops:
+            recommended = (depth, peak_bytes)
+            break
+
+    if recommended is None:
+        print(f"\nNo depth up to {args.max_depth} keeps drops <= {args.max_drops}: "
+              "the host is slower than the report rate, shorten --service-us or the stalls")
+        sys.exit(1)
+
+    depth, peak_bytes = recommended
+    memory = -(-(peak_bytes + args.acl_bytes) // 256) * 256
+    print(f"\n#define SL_BT_CONFIG_MAX_QUEUED_ADV_REPORTS     ({depth})")
+    print(f"#define SL_BT_CONTROLLER_BUFFER_MEMORY     ({max(memory, 8192)})"
+          f"  /* estimate: {peak_bytes} B of reports + {args.acl_bytes} B ACL */")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""Controller scheduler model for the priority profiles.
+
+Estimates how much of a test mode's radio time each scheduler priority
+profile (losstst_prio_apply() in losstst_svc.c) gives away: scan coverage
+lost to advertising and connection events, advertising events skipped and
+connection events skipped, including a supervision timeout of the log link.
+
+Model:
+- Lower priority value wins the radio.
+- The scanner runs windows of --scan-window-ms every --scan-interval-ms.
+  A task that wins against the scanner takes its airtime plus --switch-us
+  out of the window; the window counts as pre-empted. After a pre-empted
+  window the scanner priority moves by scan_step towards scan_max, after a
+  clean window it returns to scan_min.
+- Advertising events start every interval + advDelay (0-10 ms, uniform).
+  A skipped event moves the set by adv_step towards adv_max; a sent one
+  returns it to adv_min.
+- Connection events start every --conn-interval-ms. The priority moves
+  linearly from conn_min to conn_max as the time since the last event
+  that took place approaches --conn-timeout-ms; a gap longer than the
+  timeout is counted as a link drop (and the link assumed re-established).
+- Two overlapping advertising or connection events: the one with the
+  lower priority value takes place, the other is skipped (the earlier one
+  on a tie).
+
+The profile table mirrors prio_profiles[] in losstst_svc.c; keep the two in
+sync. The default row is sl_btctrl_scheduler_priority_config.h.
+
+Airtimes are estimates for this application's packets; pass --adv for
+other payloads, e.g. "--adv 30:1800" for a 30 ms set with 1.8 ms events.
+"""
+
+import argparse
+import heapq
+import random
+import sys
+
+PROFILES = {
+    #                    scan min/max/step  adv min/max/step  conn min/max
+    "default":              ((191, 143, 4), (175, 127, 4), (135, 0)),
+    "scanner-exclusive":    ((20, 10, 4),   (220, 200, 4), (240, 5)),
+    "advertiser-exclusive": ((220, 200, 4), (20, 10, 4),   (240, 5)),
+    "shared":               ((160, 100, 8), (160, 100, 8), (200, 0)),
+    "log-friendly":         ((191, 143, 4), (175, 127, 4), (40, 0)),
+}
+
+# Event airtime per PHY of the loss-test advertising sets (us): three
+# primary channel packets with the auxiliary packet, or three legacy packets
+ADV_EVENT_US = {"2M": 1500, "1M": 1800, "S8": 5200, "BLE4": 1400}
+
+# Test mode timing (app.c test_modes[], passive_scan_control() and
+# value_interval[] of losstst_svc.c)
+MODES = {
+    "scanner": {"scan": (60, 60), "adv": [(1000, 1400)]},
+    "envmon": {"scan": (60, 60), "adv": []},
+    "numcast": {"scan": (180, 90), "adv": [(100, 1800)]},
+    "ping": {"scan": (60, 60), "adv": [(100, 1800)]},
+    "sender": {"scan": None, "adv": [(30, ADV_EVENT_US["2M"]), (30, ADV_EVENT_US["1M"]),
+                                     (30, ADV_EVENT_US["S8"]), (30, ADV_EVENT_US["BLE4"])]},
+}
+
+
+class Scanner:
+    """Scan windows with priority escalation."""
+
+    def __init__(self, interval_us, window_us, prio):
+        self.interval = interval_us
+        self.window = window_us
+        self.p_min, self.p_max, self.step = prio
+        self.prio = self.p_min
+        self.k = 0              # Window being accumulated
+        self.lost = 0           # Time lost in window k
+        self.windows = 0
+        self.preempted = 0
+        self.lost_total = 0
+
+    def advance(self, t):
+        """Close the windows that ended before t."""
+        while (self.k * self.interval + self.window) <= t:
+            self.windows += 1
+            if self.lost:
+                self.preempted += 1
+                self.lost_total += min(self.lost, self.window)
+                self.prio = max(self.prio - self.step, self.p_max)
+            else:
+                self.prio = self.p_min
+            self.k += 1
+            self.lost = 0
+
+    def overlap(self, start, end):
+        """Scan time in [start, end) of the windows from k on."""
+        total = 0
+        k = self.k
+        while k * self.interval < end:
+            ws = k * self.interval
+            we = ws + self.window
+            total += max(0, min(end, we) - max(start, ws))
+            k += 1
+        return total
+
+
+def simulate(profile, args, scan, adv_sets, rng):
+    (scan_p, adv_p, conn_p) = PROFILES[profile]
+    duration = int(args.duration_s * 1e6)
+    scanner = Scanner(scan[0] * 1000, scan[1] * 1000, scan_p) if scan else None
+
+    # Discrete tasks: (start, seq, kind, index)
+    heap = []
+    seq = 0
+    adv_prio = [adv_p[0]] * len(adv_sets)
+    adv_sent = [0] * len(adv_sets)
+    adv_skip = [0] * len(adv_sets)
+    for i, (intv_ms, _) in enumerate(adv_sets):
+        heapq.heappush(heap, (rng.randrange(0, intv_ms * 1000), seq, "adv", i))
+        seq += 1
+    conn = args.conn_interval_ms > 0
+    conn_last = 0
+    conn_done = conn_skip = conn_drops = 0
+    conn_gap = 0
+    if conn:
+        heapq.heappush(heap, (rng.randrange(0, args.conn_interval_ms * 1000), seq, "conn", 0))
+        seq += 1
+
+    busy_until = 0
+    owner = None                # Undo record of the event holding the radio
+    while heap:
+        t, _, kind, i = heapq.heappop(heap)
+        if t >= duration:
+            break
+        if scanner:
+            scanner.advance(t)
+
+        if kind == "adv":
+            dur = adv_sets[i][1]
+            prio = adv_prio[i]
+        else:
+            dur = args.conn_us
+            elapsed = t - conn_last
+            frac = min(1.0, elapsed / (args.conn_timeout_ms * 1000))
+            prio = int(conn_p[0] - (conn_p[0] - conn_p[1]) * frac)
+
+        run = t >= busy_until or (owner is not None and prio < owner["prio"])
+        scan_lost = 0
+        if run and scanner and scanner.overlap(t, t + dur):
+            if prio < scanner.prio:
+                scan_lost = scanner.overlap(t, t + dur + args.switch_us)
+            else:
+                run = False
+        if run and t < busy_until:
+            # Pre-empts the event that was planned on the radio
+            o = owner
+            if scanner and scanner.k == o["k"]:
+                scanner.lost -= o["scan_lost"]
+            if o["kind"] == "adv":
+                adv_sent[o["i"]] -= 1
+                adv_skip[o["i"]] += 1
+                adv_prio[o["i"]] = max(o["prio"] - adv_p[2], adv_p[1])
+            else:
+                conn_done -= 1
+                conn_skip += 1
+                conn_last, conn_gap = o["last"], o["gap"]
+        if scan_lost:
+            scanner.lost += scan_lost
+
+        prev_last = prev_gap = None
+        if kind == "adv":
+            if run:
+                adv_sent[i] += 1
+                adv_prio[i] = adv_p[0]
+            else:
+                adv_skip[i] += 1
+                adv_prio[i] = max(adv_prio[i] - adv_p[2], adv_p[1])
+            nxt = t + adv_sets[i][0] * 1000 + rng.randrange(0, 10001)
+        else:
+            prev_last, prev_gap = conn_last, conn_gap
+            if run:
+                conn_gap = max(conn_gap, t - conn_last)
+                conn_last = t
+                conn_done += 1
+            else:
+                conn_skip += 1
+                if t - conn_last > args.conn_timeout_ms * 1000:
+                    conn_drops += 1
+                    conn_gap = max(conn_gap, t - conn_last)
+                    conn_last = t
+            nxt = t + args.conn_interval_ms * 1000
+        if run:
+            busy_until = t + dur
+            owner = {"kind": kind, "i": i, "prio": prio, "k": scanner.k if scanner else 0,
+                     "scan_lost": scan_lost, "last": prev_last, "gap": prev_gap}
+        heapq.heappush(heap, (nxt, seq, kind, i))
+        seq += 1
+
+    result = {
+        "adv_sent": sum(adv_sent),
+        "adv_skip": sum(adv_skip),
+        "conn_done": conn_done,
+        "conn_skip": conn_skip,
+        "conn_drops": conn_drops,
+        "conn_gap_ms": conn_gap / 1000,
+    }
+    if scanner:
+        scanner.advance(duration)
+        scan_time = scanner.windows * scanner.window
+        result["scan_windows"] = scanner.windows
+        result["scan_preempted"] = scanner.preempted
+        result["scan_lost_pct"] = 100.0 * scanner.lost_total / scan_time if scan_time else 0.0
+    return result
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--mode", choices=sorted(MODES), default="scanner",
+                    help="Test mode timing preset (default: scanner)")
+    ap.add_argument("--profile", action="append", choices=sorted(PROFILES),
+                    help="Profile to evaluate (repeatable, default: all)")
+    ap.add_argument("--scan-interval-ms", type=int, help="Override the mode's scan interval")
+    ap.add_argument("--scan-window-ms", type=int, help="Override the mode's scan window")
+    ap.add_argument("--adv", action="append", default=[],
+                    help="Advertising set 'interval_ms:event_us' (repeatable, replaces the mode's sets)")
+    ap.add_argument("--conn-interval-ms", type=float, default=30,
+                    help="Log connection interval, 0 for no connection (default: 30)")
+    ap.add_argument("--conn-timeout-ms", type=int, default=2000,
+                    help="Log connection supervision timeout (default: 2000)")
+    ap.add_argument("--conn-us", type=int, default=1500,
+                    help="Connection event airtime (default: 1500)")
+    ap.add_argument("--switch-us", type=int, default=200,
+                    help="Scan time lost around a pre-emption (default: 200)")
+    ap.add_argument("--duration-s", type=float, default=60, help="Simulated time (default: 60)")
+    ap.add_argument("--seed", type=int, default=1, help="advDelay random seed (default: 1)")
+    args = ap.parse_args()
+
+    preset = MODES[args.mode]
+    scan = preset["scan"]
+    if args.scan_interval_ms or args.scan_window_ms:
+        interval = args.scan_interval_ms or (scan[0] if scan else 60)
+        scan = (interval, args.scan_window_ms or interval)
+    if scan and scan[1] > scan[0]:
+        sys.exit("scan window longer than the interval")
+    adv_sets = preset["adv"]
+    if args.adv:
+        adv_sets = []
+        for spec in args.adv:
+            intv, dur = spec.split(":")
+            adv_sets.append((int(intv), int(dur)))
+    args.conn_interval_ms = int(args.conn_interval_ms)
+
+    print(f"# mode {args.mode}: scan {scan or '-'} ms, adv {adv_sets or '-'}, "
+          f"conn {args.conn_interval_ms or '-'} ms / {args.conn_timeout_ms} ms, "
+          f"{args.duration_s:g} s")
+    print(f"{'profile':22} {'scan lost':>9} {'win pre-empt':>14} {'adv skipped':>14} "
+          f"{'conn skipped':>14} {'max gap':>8} {'drops':>5}")
+    for profile in args.profile or PROFILES:
+        r = simulate(profile, args, scan, adv_sets, random.Random(args.seed))
+        scan_col = f"{r['scan_lost_pct']:8.2f}%" if scan else f"{'-':>9}"
+        win_col = f"{r['scan_preempted']}/{r['scan_windows']}" if scan else "-"
+        adv_total = r["adv_sent"] + r["adv_skip"]
+        conn_total = r["conn_done"] + r["conn_skip"]
+        print(f"{profile:22} {scan_col} {win_col:>14} {r['adv_skip']:>6}/{adv_total:<7} "
+              f"{r['conn_skip']:>6}/{conn_total:<7} {r['conn_gap_ms']:7.0f}m {r['conn_drops']:>5}")
+
+
+if __name__ == "__main__":
+    main()
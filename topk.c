@@ -0,0 +1,228 @@
+/**
+ * @file topk.c
+ * @brief Top-K Advertisers (Space-Saving)
+ *
+ * Implementation of topk.h. Buckets form a list in ascending count order
+ * and hold a list of their entries. Counts only grow by one, so an entry
+ * always moves to the next bucket or to a new bucket right after its own.
+ */
+
+#include "topk.h"
+#include <string.h>
+#include <stddef.h>
+
+/**
+ * @brief Hash chain of a key (FNV-1a)
+ */
+static uint8_t key_hash(const uint8_t *addr, uint8_t addr_type)
+{
+    uint32_t h = 2166136261u;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        h = (h ^ addr[i]) * 16777619u;
+    }
+    h = (h ^ addr_type) * 16777619u;
+    return (uint8_t)((h ^ (h >> 16)) & (TOPK_HASH_SIZE - 1));
+}
+
+static bool key_equal(const topk_item_t *item, const uint8_t *addr, uint8_t addr_type)
+{
+    return item->addr_type == addr_type && 0 == memcmp(item->addr, addr, sizeof(item->addr));
+}
+
+/**
+ * @brief Take a bucket from the free list and link it after prev
+ *
+ * @param prev Bucket to follow, TOPK_NONE for the lowest position
+ */
+static uint8_t bucket_insert(topk_t *tk, uint8_t prev, uint32_t count)
+{
+    uint8_t b = tk->free;
+    topk_bucket_t *bk = &tk->bucket[b];
+
+    tk->free = bk->next;
+    bk->count = count;
+    bk->head = TOPK_NONE;
+    bk->prev = prev;
+    bk->next = (TOPK_NONE == prev) ? tk->low : tk->bucket[prev].next;
+    if (TOPK_NONE == prev) {
+        tk->low = b;
+    } else {
+        tk->bucket[prev].next = b;
+    }
+    if (TOPK_NONE == bk->next) {
+        tk->high = b;
+    } else {
+        tk->bucket[bk->next].prev = b;
+    }
+    return b;
+}
+
+/**
+ * @brief Unlink an empty bucket and return it to the free list
+ */
+static void bucket_remove(topk_t *tk, uint8_t b)
+{
+    topk_bucket_t *bk = &tk->bucket[b];
+
+    if (TOPK_NONE == bk->prev) {
+        tk->low = bk->next;
+    } else {
+        tk->bucket[bk->prev].next = bk->next;
+    }
+    if (TOPK_NONE == bk->next) {
+        tk->high = bk->prev;
+    } else {
+        tk->bucket[bk->next].prev = bk->prev;
+    }
+    bk->next = tk->free;
+    tk->free = b;
+}
+
+static void entry_push(topk_t *tk, uint8_t e, uint8_t b)
+{
+    topk_entry_t *en = &tk->entry[e];
+    topk_bucket_t *bk = &tk->bucket[b];
+
+    en->bucket = b;
+    en->prev = TOPK_NONE;
+    en->next = bk->head;
+    if (TOPK_NONE != bk->head) {
+        tk->entry[bk->head].prev = e;
+    }
+    bk->head = e;
+}
+
+static void entry_unlink(topk_t *tk, uint8_t e)
+{
+    topk_entry_t *en = &tk->entry[e];
+
+    if (TOPK_NONE == en->prev) {
+        tk->bucket[en->bucket].head = en->next;
+    } else {
+        tk->entry[en->prev].next = en->next;
+    }
+    if (TOPK_NONE != en->next) {
+        tk->entry[en->next].prev = en->prev;
+    }
+}
+
+/**
+ * @brief Move an entry to the bucket of count + 1
+ */
+static void entry_increment(topk_t *tk, uint8_t e)
+{
+    uint8_t b = tk->entry[e].bucket;
+    uint8_t nb = tk->bucket[b].next;
+    uint32_t count = tk->bucket[b].count + 1;
+
+    if (TOPK_NONE == nb || tk->bucket[nb].count != count) {
+        nb = bucket_insert(tk, b, count);
+    }
+    entry_unlink(tk, e);
+    if (TOPK_NONE == tk->bucket[b].head) {
+        bucket_remove(tk, b);
+    }
+    entry_push(tk, e, nb);
+    tk->entry[e].item.count = count;
+}
+
+static void chain_remove(topk_t *tk, uint8_t e)
+{
+    uint8_t *link = &tk->hash[key_hash(tk->entry[e].item.addr, tk->entry[e].item.addr_type)];
+
+    while (*link != e) {
+        link = &tk->entry[*link].chain;
+    }
+    *link = tk->entry[e].chain;
+}
+
+void topk_reset(topk_t *tk)
+{
+    if (tk == NULL) {
+        return;
+    }
+
+    memset(tk, 0, sizeof(*tk));
+    memset(tk->hash, TOPK_NONE, sizeof(tk->hash));
+    for (uint8_t b = 0; b < TOPK_SIZE + 1; b++) {
+        tk->bucket[b].next = (b < TOPK_SIZE) ? b + 1 : TOPK_NONE;
+    }
+    tk->low = TOPK_NONE;
+    tk->high = TOPK_NONE;
+}
+
+void topk_add(topk_t *tk, const uint8_t *addr, uint8_t addr_type, uint8_t phy,
+              uint16_t bytes, int8_t rssi)
+{
+    uint8_t h;
+    uint8_t e;
+    bool fresh = true;
+    topk_entry_t *en;
+
+    if (tk == NULL || addr == NULL) {
+        return;
+    }
+
+    tk->total++;
+    h = key_hash(addr, addr_type);
+    for (e = tk->hash[h]; TOPK_NONE != e; e = tk->entry[e].chain) {
+        if (key_equal(&tk->entry[e].item, addr, addr_type)) {
+            break;
+        }
+    }
+
+    if (TOPK_NONE != e) {
+        entry_increment(tk, e);
+        fresh = false;
+    } else if (tk->used < TOPK_SIZE) {
+        /* Free entry: count 1 at the low end */
+        e = tk->used++;
+        if (TOPK_NONE == tk->low || 1 != tk->bucket[tk->low].count) {
+            bucket_insert(tk, TOPK_NONE, 1);
+        }
+        entry_push(tk, e, tk->low);
+        memset(&tk->entry[e].item, 0, sizeof(tk->entry[e].item));
+        tk->entry[e].item.count = 1;
+        tk->entry[e].rssi_sum = 0;
+    } else {
+        /* Take over an entry with the lowest count */
+        e = tk->bucket[tk->low].head;
+        chain_remove(tk, e);
+        memset(&tk->entry[e].item, 0, sizeof(tk->entry[e].item));
+        tk->entry[e].item.err = tk->bucket[tk->low].count;
+        tk->entry[e].rssi_sum = 0;
+        entry_increment(tk, e);
+    }
+
+    en = &tk->entry[e];
+    if (fresh) {
+        memcpy(en->item.addr, addr, sizeof(en->item.addr));
+        en->item.addr_type = addr_type;
+        en->chain = tk->hash[h];
+        tk->hash[h] = e;
+    }
+    en->item.phy_mask |= (uint8_t)(1u << (phy & 7));
+    en->item.bytes += bytes;
+    en->rssi_sum += rssi;
+}
+
+uint8_t topk_get(const topk_t *tk, topk_item_t *items, uint8_t max)
+{
+    uint8_t n = 0;
+
+    if (tk == NULL || items == NULL) {
+        return 0;
+    }
+
+    for (uint8_t b = tk->high; TOPK_NONE != b && n < max; b = tk->bucket[b].prev) {
+        for (uint8_t e = tk->bucket[b].head; TOPK_NONE != e && n < max; e = tk->entry[e].next) {
+            const topk_entry_t *en = &tk->entry[e];
+
+            items[n] = en->item;
+            items[n].rssi = (int8_t)(en->rssi_sum / (int32_t)(en->item.count - en->item.err));
+            n++;
+        }
+    }
+    return n;
+}
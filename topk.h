@@ -0,0 +1,123 @@
+/**
+ * @file topk.h
+ * @brief Top-K Advertisers (Space-Saving)
+ *
+ * Finds the advertisers that send the most reports with a fixed table of
+ * TOPK_SIZE entries (Space-Saving, Metwally et al.). A report of an
+ * address not in the table takes over the entry with the lowest count
+ * when the table is full; the new owner inherits that count as its error
+ * bound.
+ *
+ * Guarantees after N reports:
+ * - count - err <= true reports <= count
+ * - err <= N / TOPK_SIZE
+ * - Every address with more than N / TOPK_SIZE reports has an entry
+ *
+ * Entries hang in count buckets (stream summary), so a report costs a hash
+ * lookup and a move to the neighbouring bucket: O(1) without a scan of the
+ * table. Bytes, PHYs and RSSI are counted from the takeover on.
+ *
+ * @note No Bluetooth stack dependency, so the error bounds can be checked
+ *       against exact counts of synthetic traces on a host build
+ */
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TOPK_SIZE
+#define TOPK_SIZE           32      /* Entries (<= 254) */
+#endif
+#define TOPK_HASH_SIZE      64      /* Hash chains (power of 2, >= TOPK_SIZE) */
+#define TOPK_NONE           0xFF
+
+/**
+ * @brief Advertiser as reported by topk_get()
+ */
+typedef struct {
+    uint8_t addr[6];           /**< Address (little endian, as in bd_addr) */
+    uint8_t addr_type;         /**< Address type */
+    uint8_t phy_mask;          /**< Bit per PHY index seen */
+    uint32_t count;            /**< Reports, upper bound */
+    uint32_t err;              /**< count - err is the lower bound */
+    uint32_t bytes;            /**< Advertising data bytes of the counted reports */
+    int8_t rssi;               /**< Mean RSSI of the counted reports (dBm) */
+} topk_item_t;
+
+/**
+ * @brief Table entry
+ */
+typedef struct {
+    topk_item_t item;
+    int32_t rssi_sum;          /**< RSSI sum of the count - err reports */
+    uint8_t prev;              /**< Previous entry in the bucket */
+    uint8_t next;              /**< Next entry in the bucket */
+    uint8_t bucket;            /**< Count bucket */
+    uint8_t chain;             /**< Next entry of the hash chain */
+} topk_entry_t;
+
+/**
+ * @brief Entries with the same count
+ */
+typedef struct {
+    uint32_t count;
+    uint8_t head;              /**< First entry */
+    uint8_t prev;              /**< Bucket with the next lower count */
+    uint8_t next;              /**< Bucket with the next higher count (free list link) */
+} topk_bucket_t;
+
+/**
+ * @brief Table state
+ */
+typedef struct {
+    topk_entry_t entry[TOPK_SIZE];
+    topk_bucket_t bucket[TOPK_SIZE + 1];    /**< One spare during a move */
+    uint8_t hash[TOPK_HASH_SIZE];           /**< Chain heads */
+    uint8_t used;                           /**< Entries in use */
+    uint8_t low;                            /**< Bucket with the lowest count */
+    uint8_t high;                           /**< Bucket with the highest count */
+    uint8_t free;                           /**< Free bucket list */
+    uint32_t total;                         /**< Reports seen (N) */
+} topk_t;
+
+/**
+ * @brief Empty the table
+ *
+ * @param tk Table
+ */
+void topk_reset(topk_t *tk);
+
+/**
+ * @brief Count a report
+ *
+ * @param tk Table
+ * @param addr Address (6 bytes)
+ * @param addr_type Address type (part of the key)
+ * @param phy PHY index (0-7)
+ * @param bytes Advertising data length
+ * @param rssi RSSI (dBm)
+ */
+void topk_add(topk_t *tk, const uint8_t *addr, uint8_t addr_type, uint8_t phy,
+              uint16_t bytes, int8_t rssi);
+
+/**
+ * @brief Advertisers by descending count
+ *
+ * @param tk Table
+ * @param items Output
+ * @param max Size of items
+ * @return Items written
+ */
+uint8_t topk_get(const topk_t *tk, topk_item_t *items, uint8_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOPK_H
@@ -0,0 +1,180 @@
+/**
+ * @file tput_stats.c
+ * @brief Windowed Throughput and Stall Statistics
+ *
+ * Implementation of tput_stats.h. All times are 32-bit milliseconds and
+ * differences are taken unsigned, so a wrapping clock is handled.
+ */
+
+#include "tput_stats.h"
+#include <string.h>
+
+#define TPUT_T_IFS_US  150u     /* Inter frame space */
+
+/**
+ * @brief Record a closed window
+ */
+static void tput_stats_record(tput_stats_t *st, uint32_t bps)
+{
+    if (0 == st->win_cnt) {
+        st->win_min_bps = bps;
+        st->win_max_bps = bps;
+    } else {
+        if (bps < st->win_min_bps) {
+            st->win_min_bps = bps;
+        }
+        if (bps > st->win_max_bps) {
+            st->win_max_bps = bps;
+        }
+    }
+    st->win_last_bps = bps;
+    st->win_cnt++;
+}
+
+/**
+ * @brief Close all windows elapsed up to now_ms
+ *
+ * The open window carries its bytes, any further elapsed windows were idle.
+ */
+static void tput_stats_close_windows(tput_stats_t *st, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - st->win_start_ms;
+    uint32_t n;
+
+    if (!st->started || elapsed < st->window_ms) {
+        return;
+    }
+
+    n = elapsed / st->window_ms;
+    tput_stats_record(st, (uint32_t)(((uint64_t)st->win_bytes * 8u * 1000u) / st->window_ms));
+    if (n > 1) {
+        tput_stats_record(st, 0);
+        st->win_cnt += n - 2;
+    }
+    st->win_start_ms += n * st->window_ms;
+    st->win_bytes = 0;
+}
+
+/**
+ * @brief Account a delivery gap
+ */
+static void tput_stats_gap(tput_stats_t *st, uint32_t gap)
+{
+    if (gap > st->max_gap_ms) {
+        st->max_gap_ms = gap;
+    }
+    if (gap >= st->stall_ms) {
+        st->stalls++;
+        st->stall_total_ms += gap;
+    }
+}
+
+void tput_stats_init(tput_stats_t *st, uint32_t window_ms, uint32_t stall_ms)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->window_ms = (0 == window_ms) ? 1 : window_ms;
+    st->stall_ms = (0 == stall_ms) ? 1 : stall_ms;
+}
+
+void tput_stats_feed(tput_stats_t *st, uint32_t now_ms, uint16_t bytes)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    if (!st->started) {
+        st->started = true;
+        st->start_ms = now_ms;
+        st->win_start_ms = now_ms;
+        st->first_bytes = bytes;
+    } else {
+        tput_stats_gap(st, now_ms - st->last_ms);
+        tput_stats_close_windows(st, now_ms);
+    }
+
+    st->last_ms = now_ms;
+    st->total_bytes += bytes;
+    st->win_bytes += bytes;
+    st->packets++;
+}
+
+void tput_stats_tick(tput_stats_t *st, uint32_t now_ms)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    tput_stats_close_windows(st, now_ms);
+}
+
+void tput_stats_finish(tput_stats_t *st, uint32_t now_ms)
+{
+    if (st == NULL || !st->started) {
+        return;
+    }
+
+    tput_stats_close_windows(st, now_ms);
+    tput_stats_gap(st, now_ms - st->last_ms);
+}
+
+uint32_t tput_stats_goodput_bps(const tput_stats_t *st)
+{
+    uint32_t span;
+
+    if (st == NULL || st->packets < 2) {
+        return 0;
+    }
+
+    /* Bytes of the first delivery arrived before the measured span */
+    span = st->last_ms - st->start_ms;
+    if (0 == span) {
+        return 0;
+    }
+    return (uint32_t)(((st->total_bytes - st->first_bytes) * 8u * 1000u) / span);
+}
+
+/**
+ * @brief Air time of a data PDU including preamble, access address and CRC
+ */
+static uint32_t tput_pdu_us(uint8_t phy, uint16_t octets)
+{
+    switch (phy) {
+    case TPUT_PHY_1M:
+        return (octets + 10u) * 8u;             /* Preamble 1, AA 4, header 2, CRC 3 */
+    case TPUT_PHY_2M:
+        return (octets + 11u) * 4u;             /* Preamble 2 */
+    case TPUT_PHY_CODED:
+        return 400u + (octets + 5u) * 64u;      /* FEC block 1 + TERM2, S=8 coding */
+    default:
+        return 0;
+    }
+}
+
+uint32_t tput_stats_capacity_bps(uint8_t phy, uint16_t ll_octets, uint16_t payload)
+{
+    uint32_t cycle_us = tput_pdu_us(phy, ll_octets);
+
+    if (0 == cycle_us) {
+        return 0;
+    }
+
+    /* Data PDU, T_IFS, empty acknowledgement, T_IFS */
+    cycle_us += TPUT_T_IFS_US + tput_pdu_us(phy, 0) + TPUT_T_IFS_US;
+    return (uint32_t)(((uint64_t)payload * 8u * 1000000u) / cycle_us);
+}
+
+uint8_t tput_stats_utilisation(const tput_stats_t *st, uint32_t capacity_bps)
+{
+    uint64_t pct;
+
+    if (0 == capacity_bps) {
+        return 0;
+    }
+
+    pct = ((uint64_t)tput_stats_goodput_bps(st) * 100u) / capacity_bps;
+    return (pct > 100u) ? 100u : (uint8_t)pct;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file tput_stats.h
+ * @brief Windowed Throughput and Stall Statistics
+ *
+ * Platform independent accounting for the connection throughput test.
+ * Every delivered payload is fed with its arrival time; the module keeps
+ * tumbling-window throughput, overall goodput and delivery gaps.
+ *
+ * Features:
+ * - Tumbling windows with min/max/last throughput (idle windows count as 0)
+ * - Stall detection: a delivery gap of at least stall_ms is one stall
+ * - Theoretical link capacity of a PHY / data length for utilisation
+ *
+ * @note No Bluetooth stack dependency, so it can be fed from recorded
+ *       event traces on a host build as well
+ */
+
+#ifndef TPUT_STATS_H
+#define TPUT_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PHY identifiers, same values as sl_bt_gap_phy_t */
+#define TPUT_PHY_1M     0x1
+#define TPUT_PHY_2M     0x2
+#define TPUT_PHY_CODED  0x4     /* S=8 */
+
+/**
+ * @brief Throughput statistics state
+ */
+typedef struct {
+    uint32_t window_ms;        /**< Tumbling window length */
+    uint32_t stall_ms;         /**< Delivery gap counted as stall */
+    uint32_t start_ms;         /**< First delivery */
+    uint32_t last_ms;          /**< Last delivery */
+    uint32_t win_start_ms;     /**< Start of the open window */
+    uint32_t win_bytes;        /**< Bytes in the open window */
+    uint32_t win_cnt;          /**< Closed windows */
+    uint32_t win_min_bps;      /**< Lowest closed window throughput */
+    uint32_t win_max_bps;      /**< Highest closed window throughput */
+    uint32_t win_last_bps;     /**< Last closed window throughput */
+    uint64_t total_bytes;      /**< Bytes delivered */
+    uint16_t first_bytes;      /**< Size of the first delivery */
+    uint32_t packets;          /**< Deliveries */
+    uint32_t stalls;           /**< Gaps of at least stall_ms */
+    uint32_t stall_total_ms;   /**< Sum of stall gaps */
+    uint32_t max_gap_ms;       /**< Longest delivery gap */
+    bool started;              /**< First delivery seen */
+} tput_stats_t;
+
+/**
+ * @brief Reset statistics
+ *
+ * @param st Statistics state
+ * @param window_ms Tumbling window length (ms, >0)
+ * @param stall_ms Gap between deliveries counted as a stall (ms, >0)
+ */
+void tput_stats_init(tput_stats_t *st, uint32_t window_ms, uint32_t stall_ms);
+
+/**
+ * @brief Account one delivered payload
+ *
+ * @param st Statistics state
+ * @param now_ms Arrival time (ms, monotonic, wraps at 2^32)
+ * @param bytes Payload size
+ */
+void tput_stats_feed(tput_stats_t *st, uint32_t now_ms, uint16_t bytes);
+
+/**
+ * @brief Close windows that elapsed without traffic
+ *
+ * Call periodically so an idle link shows up as zero-throughput windows.
+ *
+ * @param st Statistics state
+ * @param now_ms Current time (ms)
+ */
+void tput_stats_tick(tput_stats_t *st, uint32_t now_ms);
+
+/**
+ * @brief End of measurement
+ *
+ * Closes elapsed windows and counts a trailing gap as stall.
+ *
+ * @param st Statistics state
+ * @param now_ms End time (ms)
+ */
+void tput_stats_finish(tput_stats_t *st, uint32_t now_ms);
+
+/**
+ * @brief Goodput between first and last delivery
+ *
+ * @param st Statistics state
+ * @return Goodput in bit/s (0 before the second delivery)
+ */
+uint32_t tput_stats_goodput_bps(const tput_stats_t *st);
+
+/**
+ * @brief Theoretical one-way capacity of a connection
+ *
+ * Assumes every connection event runs for the whole interval and each
+ * data PDU is acknowledged by an empty PDU, both after T_IFS.
+ *
+ * @param phy TPUT_PHY_1M, TPUT_PHY_2M or TPUT_PHY_CODED
+ * @param ll_octets Link layer payload per PDU (data length, 27-251)
+ * @param payload Application bytes carried per PDU
+ * @return Capacity in bit/s (0 on invalid PHY)
+ */
+uint32_t tput_stats_capacity_bps(uint8_t phy, uint16_t ll_octets, uint16_t payload);
+
+/**
+ * @brief Connection event utilisation
+ *
+ * @param st Statistics state
+ * @param capacity_bps Capacity from tput_stats_capacity_bps()
+ * @return Goodput as percentage of capacity (0-100)
+ */
+uint8_t tput_stats_utilisation(const tput_stats_t *st, uint32_t capacity_bps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TPUT_STATS_H
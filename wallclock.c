@@ -0,0 +1,173 @@
+/**
+ * @file wallclock.c
+ * @brief Wall Clock and UTC Calendar
+ *
+ * Implementation of wallclock.h. The calendar counts days from
+ * 0000-03-01 of the proleptic Gregorian calendar, so the leap day is the
+ * last day of a counted year and month lengths follow from (153 m + 2) / 5.
+ * Every division is by a constant and compiles to a multiply on Cortex-M.
+ */
+
+#include "wallclock.h"
+#include <stddef.h>
+#include <errno.h>
+
+#define SEC_PER_DAY         86400u
+#define DAYS_0000_TO_1970   719468u     /* 0000-03-01 to 1970-01-01 */
+#define DAYS_PER_ERA        146097u     /* 400 years */
+
+static const char *source_names[] = {"none", "restored", "beacon", "gatt"};
+
+/**
+ * @brief Days since 1970-01-01 of a date in 1970-2106 (fields checked)
+ */
+static uint32_t days_from_civil(uint16_t year, uint8_t month, uint8_t day)
+{
+    uint32_t y = year - (month <= 2);
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t doy = (153u * (month > 2 ? month - 3u : month + 9u) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * DAYS_PER_ERA + doe - DAYS_0000_TO_1970;
+}
+
+static bool is_leap_year(uint16_t year)
+{
+    return (0 == year % 4) && ((0 != year % 100) || (0 == year % 400));
+}
+
+void wallclock_init(wallclock_t *wc)
+{
+    if (wc == NULL) {
+        return;
+    }
+
+    wc->offset_ms = 0;
+    wc->set_ms = 0;
+    wc->source = WALLCLOCK_SRC_NONE;
+}
+
+int wallclock_set(wallclock_t *wc, int64_t uptime_ms, const wallclock_stamp_t *now, uint8_t source)
+{
+    if (wc == NULL || now == NULL || now->ms > 999
+        || WALLCLOCK_SRC_NONE == source || source > WALLCLOCK_SRC_GATT) {
+        return -EINVAL;
+    }
+
+    if (source < wc->source && uptime_ms - wc->set_ms < WALLCLOCK_HOLD_MS) {
+        return -EPERM;
+    }
+
+    wc->offset_ms = (int64_t)now->sec * 1000 + now->ms - uptime_ms;
+    wc->set_ms = uptime_ms;
+    wc->source = source;
+    return 0;
+}
+
+int wallclock_now(const wallclock_t *wc, int64_t uptime_ms, wallclock_stamp_t *stamp)
+{
+    int64_t t;
+    uint64_t sec;
+
+    if (wc == NULL || stamp == NULL) {
+        return -EINVAL;
+    }
+    if (WALLCLOCK_SRC_NONE == wc->source) {
+        return -EAGAIN;
+    }
+
+    t = wc->offset_ms + uptime_ms;
+    if (t < 0) {
+        return -ERANGE;
+    }
+    sec = (uint64_t)t / 1000;
+    if (sec > UINT32_MAX) {
+        return -ERANGE;
+    }
+    stamp->sec = (uint32_t)sec;
+    stamp->ms = (uint16_t)((uint64_t)t - sec * 1000);
+    return 0;
+}
+
+uint8_t wallclock_source(const wallclock_t *wc)
+{
+    return (wc == NULL) ? WALLCLOCK_SRC_NONE : wc->source;
+}
+
+const char *wallclock_source_name(uint8_t source)
+{
+    return (source < sizeof(source_names) / sizeof(source_names[0])) ? source_names[source] : "?";
+}
+
+void wallclock_to_date(uint32_t sec, wallclock_date_t *date)
+{
+    uint32_t days = sec / SEC_PER_DAY;
+    uint32_t rem = sec - days * SEC_PER_DAY;
+    uint32_t z = days + DAYS_0000_TO_1970;
+    uint32_t era = z / DAYS_PER_ERA;
+    uint32_t doe = z - era * DAYS_PER_ERA;                          /* 0-146096 */
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;   /* 0-399 */
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);         /* 0-365, from March 1 */
+    uint32_t mp = (5 * doy + 2) / 153;                              /* 0-11, from March */
+
+    if (date == NULL) {
+        return;
+    }
+
+    date->day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    date->month = (uint8_t)((mp < 10) ? mp + 3 : mp - 9);
+    date->year = (uint16_t)(era * 400 + yoe + (date->month <= 2));
+    date->hour = (uint8_t)(rem / 3600);
+    rem -= date->hour * 3600u;
+    date->min = (uint8_t)(rem / 60);
+    date->sec = (uint8_t)(rem - date->min * 60u);
+    date->wday = (uint8_t)((days + 4) % 7);                         /* 1970-01-01 was a Thursday */
+}
+
+int wallclock_from_date(const wallclock_date_t *date, uint32_t *sec)
+{
+    static const uint8_t month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    uint64_t t;
+
+    if (date == NULL || sec == NULL
+        || date->year < WALLCLOCK_YEAR_MIN || date->year > WALLCLOCK_YEAR_MAX + 1
+        || date->month < 1 || date->month > 12 || date->day < 1
+        || date->hour > 23 || date->min > 59 || date->sec > 59) {
+        return -EINVAL;
+    }
+    if (date->day > month_days[date->month - 1] + (2 == date->month && is_leap_year(date->year))) {
+        return -EINVAL;
+    }
+
+    t = (uint64_t)days_from_civil(date->year, date->month, date->day) * SEC_PER_DAY
+        + date->hour * 3600u + date->min * 60u + date->sec;
+    if (t > UINT32_MAX) {
+        return -EINVAL;
+    }
+    *sec = (uint32_t)t;
+    return 0;
+}
+
+int wallclock_from_cts(const uint8_t *val, uint16_t len, wallclock_stamp_t *stamp)
+{
+    wallclock_date_t date;
+    int err;
+
+    if (val == NULL || stamp == NULL || len < WALLCLOCK_CTS_LEN - 1) {
+        return -EINVAL;
+    }
+
+    date.year = (uint16_t)(val[0] | (val[1] << 8));
+    date.month = val[2];
+    date.day = val[3];
+    date.hour = val[4];
+    date.min = val[5];
+    date.sec = val[6];
+    err = wallclock_from_date(&date, &stamp->sec);
+    if (err) {
+        return err;
+    }
+    stamp->ms = (uint16_t)((val[8] * 125u) >> 5);                  /* 1/256 s to ms */
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file wallclock.h
+ * @brief Wall Clock and UTC Calendar
+ *
+ * Keeps UTC time as an offset to the uptime counter. The offset is set
+ * from a time source (a phone writing the Current Time characteristic, a
+ * coordinator's time beacon, or the checkpoint restored after a reset);
+ * a source only overrides one of equal or higher rank, unless the time it
+ * got from that source is older than WALLCLOCK_HOLD_MS.
+ *
+ * Features:
+ * - Compact stamps: 32-bit seconds since 1970-01-01 UTC and milliseconds,
+ *   valid up to February 2106
+ * - Calendar conversion without tables or loops; only divisions by
+ *   constants (days from/to civil date after H. Hinnant, the same
+ *   Gregorian rules as the sl_sleeptimer date functions)
+ * - Bluetooth Current Time characteristic (10 bytes) parsing
+ *
+ * Times are UTC; there is no time zone or daylight saving rule.
+ *
+ * @note No Bluetooth stack dependency, so the calendar can be checked
+ *       against the C library's gmtime() on a host build
+ */
+
+#ifndef WALLCLOCK_H
+#define WALLCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WALLCLOCK_YEAR_MIN      1970
+#define WALLCLOCK_YEAR_MAX      2105                /* Last full year of a 32-bit stamp */
+#define WALLCLOCK_HOLD_MS       (6 * 3600 * 1000LL) /* Lower ranked source may take over after */
+#define WALLCLOCK_CTS_LEN       10                  /* Current Time characteristic length */
+
+/* Time sources, ascending rank */
+#define WALLCLOCK_SRC_NONE      0                   /* Not set */
+#define WALLCLOCK_SRC_RESTORED  1                   /* Checkpoint from before a reset (lower bound) */
+#define WALLCLOCK_SRC_BEACON    2                   /* Coordinator time beacon */
+#define WALLCLOCK_SRC_GATT      3                   /* Written over GATT by a phone */
+
+/**
+ * @brief Point in time
+ */
+typedef struct {
+    uint32_t sec;              /**< Seconds since 1970-01-01 00:00:00 UTC */
+    uint16_t ms;               /**< Milliseconds (0-999) */
+} wallclock_stamp_t;
+
+/**
+ * @brief Calendar date and time of day (UTC)
+ */
+typedef struct {
+    uint16_t year;             /**< 1970-2106 */
+    uint8_t month;             /**< 1-12 */
+    uint8_t day;               /**< 1-31 */
+    uint8_t hour;              /**< 0-23 */
+    uint8_t min;               /**< 0-59 */
+    uint8_t sec;               /**< 0-59 */
+    uint8_t wday;              /**< Day of the week, 0 = Sunday */
+} wallclock_date_t;
+
+/**
+ * @brief Clock state
+ */
+typedef struct {
+    int64_t offset_ms;         /**< UTC ms since 1970 minus uptime ms */
+    int64_t set_ms;            /**< Uptime of the last set (ms) */
+    uint8_t source;            /**< WALLCLOCK_SRC_* of the last set */
+} wallclock_t;
+
+/**
+ * @brief Reset to not set
+ *
+ * @param wc Clock
+ */
+void wallclock_init(wallclock_t *wc);
+
+/**
+ * @brief Set the clock
+ *
+ * @param wc Clock
+ * @param uptime_ms Uptime at which now was valid
+ * @param now Time at uptime_ms
+ * @param source WALLCLOCK_SRC_* (not NONE)
+ * @return 0 on success, -EINVAL on invalid argument,
+ *         -EPERM if a higher ranked source set the clock within
+ *         WALLCLOCK_HOLD_MS
+ */
+int wallclock_set(wallclock_t *wc, int64_t uptime_ms, const wallclock_stamp_t *now, uint8_t source);
+
+/**
+ * @brief Current time
+ *
+ * @param wc Clock
+ * @param uptime_ms Uptime
+ * @param stamp Time at uptime_ms
+ * @return 0 on success, -EINVAL on invalid argument, -EAGAIN if not set,
+ *         -ERANGE if the time does not fit a stamp
+ */
+int wallclock_now(const wallclock_t *wc, int64_t uptime_ms, wallclock_stamp_t *stamp);
+
+/**
+ * @brief Source of the current time
+ *
+ * @param wc Clock
+ * @return WALLCLOCK_SRC_*
+ */
+uint8_t wallclock_source(const wallclock_t *wc);
+
+/**
+ * @brief Source name
+ *
+ * @param source WALLCLOCK_SRC_*
+ * @return Short name, "?" if unknown
+ */
+const char *wallclock_source_name(uint8_t source);
+
+/**
+ * @brief Convert seconds since 1970 to a date
+ *
+ * @param sec Seconds since 1970-01-01 00:00:00 UTC
+ * @param date Date
+ */
+void wallclock_to_date(uint32_t sec, wallclock_date_t *date);
+
+/**
+ * @brief Convert a date to seconds since 1970
+ *
+ * The day of the week is ignored.
+ *
+ * @param date Date
+ * @param sec Seconds since 1970-01-01 00:00:00 UTC
+ * @return 0 on success, -EINVAL if a field is out of range or the date
+ *         does not fit 32 bits
+ */
+int wallclock_from_date(const wallclock_date_t *date, uint32_t *sec);
+
+/**
+ * @brief Parse a Current Time characteristic value
+ *
+ * Exact Time 256 (year LE, month, day, hours, minutes, seconds, day of
+ * week, 1/256 s fractions) followed by the adjust reason, which is ignored
+ * like the day of the week.
+ *
+ * @param val Characteristic value
+ * @param len Value length (>= WALLCLOCK_CTS_LEN - 1)
+ * @param stamp Parsed time
+ * @return 0 on success, -EINVAL if too short, a field is unknown (0) or
+ *         out of range
+ */
+int wallclock_from_cts(const uint8_t *val, uint16_t len, wallclock_stamp_t *stamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WALLCLOCK_H